@@ -17,11 +17,21 @@ SOURCES += \
     src/chesspiece.cpp \
     src/chessboard.cpp \
     src/chessengine.cpp \
+    src/timemanager.cpp \
+    src/uciprotocol.cpp \
+    src/ucioptions.cpp \
+    src/engineresources.cpp \
+    src/evalcache.cpp \
+    src/engineworkerpool.cpp \
+    src/enginepool.cpp \
+    src/gameanalyzer.cpp \
+    src/benchmark.cpp \
     src/soundsettingsdialog.cpp \
     src/pieceiconsettingsdialog.cpp \
     src/boardcolorsettingsdialog.cpp \
     src/updatechecker.cpp \
     src/networkmanager.cpp \
+    src/binaryprotocol.cpp \
     src/onlinedialog.cpp
 
 HEADERS += \
@@ -29,12 +39,22 @@ HEADERS += \
     src/chesspiece.h \
     src/chessboard.h \
     src/chessengine.h \
+    src/timemanager.h \
+    src/uciprotocol.h \
+    src/ucioptions.h \
+    src/engineresources.h \
+    src/evalcache.h \
+    src/engineworkerpool.h \
+    src/enginepool.h \
+    src/gameanalyzer.h \
+    src/benchmark.h \
     src/soundsettingsdialog.h \
     src/pieceiconsettingsdialog.h \
     src/boardcolorsettingsdialog.h \
     src/theme.h \
     src/updatechecker.h \
     src/networkmanager.h \
+    src/binaryprotocol.h \
     src/onlinedialog.h
 
 FORMS += \
@@ -1,46 +1,135 @@
 const WebSocket = require('ws');
+const { performance } = require('perf_hooks');
+const crypto = require('crypto');
 
 // 使用 Render 自動提供的 PORT
 const wss = new WebSocket.Server({ port: process.env.PORT || 3000 });
 
 // 房間資料
 // rooms[roomId] = [ws1, ws2, ...]
-// 注意：陣列中第一個元素 (index 0) 始終為房主
+// 注意：陣列中第一個元素 (index 0) 始終為房主；對局中斷線、等待續連的玩家為 null
 const rooms = {};
 
+// 續連憑證：sessions[roomId] 與 rooms[roomId] 一一對應
+const sessions = {};
+
+// 對局訊息記錄：gameLogs[roomId] = { lastSeq, entries: [{ seq, payload, senderSeat }] }
+// 每則對局訊息都帶有序號，續連時重送客戶端最後收到的序號之後的訊息
+const gameLogs = {};
+const RESUME_GRACE_MS = 60000;          // 對局中斷線後保留座位的時間
+
 // 遊戲計時狀態
-const gameTimers = {}; // gameTimers[roomId] = { timeA, timeB, currentPlayer, lastSwitchTime, whiteIsA }
+const gameTimers = {}; // gameTimers[roomId] = { timeA, timeB, currentPlayer, lastSwitchTime, whiteIsA, lagBudgetA, lagBudgetB }
+
+// 伺服器時鐘：單調遞增的毫秒數（不受系統時間調整影響），以啟動時的 UNIX 時間為基準
+const clockEpochMs = Date.now() - performance.now();
+function serverTimeMs() {
+    return Math.round(clockEpochMs + performance.now());
+}
+
+// 延遲補償：走棋方上傳這步棋的單程延遲（半個往返時間）不計入用時
+const PING_INTERVAL_MS = 2000;          // 量測往返時間的間隔
+const MAX_LAG_COMPENSATION_MS = 500;    // 每步最多補償的延遲
+const LAG_BUDGET_PER_GAME_MS = 10000;   // 每位玩家每盤棋最多補償的延遲總和
+
+function lagCompensation(ws, timer, moverIsA) {
+    const budgetKey = moverIsA ? "lagBudgetA" : "lagBudgetB";
+    if(!(ws.rttMs > 0) || timer[budgetKey] <= 0){
+        return 0;
+    }
+    const compensation = Math.min(ws.rttMs / 2, MAX_LAG_COMPENSATION_MS, timer[budgetKey]);
+    timer[budgetKey] -= compensation;
+    return compensation;
+}
 
-// 生成 4 位數字房號
-function generateRoomId() {
-    return Math.floor(1000 + Math.random() * 9000).toString();
+// lastSwitchTime 保留秒數給舊版客戶端；新版客戶端使用毫秒欄位
+function timerStateJson(timer) {
+    return {
+        timeA: timer.timeA,
+        timeB: timer.timeB,
+        currentPlayer: timer.currentPlayer,
+        lastSwitchTime: timer.lastSwitchTime === null ? null : Math.ceil(timer.lastSwitchTime / 1000),
+        lastSwitchTimeMs: timer.lastSwitchTime,
+        serverTimeMs: serverTimeMs()
+    };
+}
+
+// 房號分配：六位數的房號空間以固定步長走訪（步長與空間大小互質），
+// 一整輪之內每個房號只會出現一次，不需要隨機重試；只有繞回一輪後才需要略過仍在使用的房號
+const ROOM_ID_MIN = 100000;
+const ROOM_ID_SPACE = 900000;
+const ROOM_ID_STRIDE = 387799;          // 與 900000 = 2^5 * 3^2 * 5^5 互質
+let roomIdCounter = crypto.randomInt(ROOM_ID_SPACE);
+
+function allocateRoomId() {
+    for(let attempts = 0; attempts < ROOM_ID_SPACE; attempts++){
+        const roomId = (ROOM_ID_MIN + (roomIdCounter * ROOM_ID_STRIDE) % ROOM_ID_SPACE).toString();
+        roomIdCounter = (roomIdCounter + 1) % ROOM_ID_SPACE;
+        if(!rooms[roomId]){
+            return roomId;
+        }
+    }
+    return null;  // 所有房號都在使用中
+}
+
+function generateSessionId() {
+    return crypto.randomBytes(8).toString('hex');
+}
+
+// 加上序號並記錄，返回要廣播的 JSON（對局開始前不記錄）
+// sender 為只轉送給對手的訊息的送出者：另外回覆序號讓它的 lastSeq 連續，續連時也不重送給它
+function sequenceGameMessage(roomId, msg, sender) {
+    const log = gameLogs[roomId];
+    if(!log){
+        return JSON.stringify(msg);
+    }
+    msg.seq = ++log.lastSeq;
+    const payload = JSON.stringify(msg);
+    const senderSeat = sender ? rooms[roomId].indexOf(sender) : -1;
+    log.entries.push({ seq: msg.seq, payload: payload, senderSeat: senderSeat });
+    if(sender && sender.readyState === WebSocket.OPEN){
+        sender.send(JSON.stringify({ action: "ack", room: roomId, seq: msg.seq }));
+    }
+    return payload;
+}
+
+// 同一份資料送給房間內的玩家（略過 exclude 與斷線中的座位）
+function broadcastToRoom(roomId, payload, exclude) {
+    rooms[roomId].forEach(client => {
+        if(client && client !== exclude && client.readyState === WebSocket.OPEN){
+            client.send(payload);
+        }
+    });
 }
 
 // 處理玩家離開房間的共用邏輯
 // 此函數處理玩家明確離開或斷線的情況
-// 注意：目前設計為 2 人房間，因此 includes() 的 O(n) 複雜度是可接受的
+// 每個連線以 ws.rooms 記錄所在的房間，不需要走訪所有房間；房間最多 2 人，indexOf() 為常數時間
 function handlePlayerLeaveRoom(ws, roomId) {
-    if(!rooms[roomId] || !rooms[roomId].includes(ws)) {
+    if(!rooms[roomId] || !ws.rooms.has(roomId)) {
         return; // 玩家不在此房間
     }
-    
+    removePlayer(roomId, rooms[roomId].indexOf(ws));
+}
+
+function removePlayer(roomId, index) {
+    const ws = rooms[roomId][index];
+
     // 檢查離開的玩家是否為房主 (index 0)
-    const wasHost = rooms[roomId][0] === ws;
+    const wasHost = index === 0;
     
     // 通知房間內其他玩家
-    rooms[roomId].forEach(client => {
-        if(client !== ws && client.readyState === WebSocket.OPEN){
-            client.send(JSON.stringify({ action: "playerLeft", room: roomId }));
-        }
-    });
+    broadcastToRoom(roomId, JSON.stringify({ action: "playerLeft", room: roomId }), ws);
     
     // 從房間移除離開的玩家
-    rooms[roomId] = rooms[roomId].filter(c => c !== ws);
+    if(ws) ws.rooms.delete(roomId);
+    rooms[roomId].splice(index, 1);
+    sessions[roomId].splice(index, 1);
     
     // 如果房主離開且房間內還有其他玩家，通知新房主
     if(wasHost && rooms[roomId].length > 0){
         const newHost = rooms[roomId][0];
-        if(newHost.readyState === WebSocket.OPEN){
+        if(newHost && newHost.readyState === WebSocket.OPEN){
             newHost.send(JSON.stringify({ 
                 action: "promotedToHost", 
                 room: roomId 
@@ -51,31 +140,113 @@ function handlePlayerLeaveRoom(ws, roomId) {
     // 如果房間空了，刪除房間
     if(rooms[roomId].length === 0){
         delete rooms[roomId];
+        delete sessions[roomId];
         delete gameTimers[roomId];  // 清理計時器狀態
+        delete gameLogs[roomId];
     }
 }
 
+// 對局中斷線：保留座位、計時器與訊息記錄（時鐘照常走），寬限期內沒有續連才視為離開
+function suspendPlayer(roomId, index) {
+    rooms[roomId][index] = null;
+    broadcastToRoom(roomId, JSON.stringify({ action: "opponentConnectionLost", room: roomId, graceMs: RESUME_GRACE_MS }));
+
+    const session = sessions[roomId][index];
+    setTimeout(() => {
+        if(!rooms[roomId]) return;
+        const seat = sessions[roomId].indexOf(session);
+        if(seat >= 0 && rooms[roomId][seat] === null){
+            removePlayer(roomId, seat);
+        }
+    }, RESUME_GRACE_MS);
+}
+
+// 續連：憑證必須對應一個正在等待續連的座位
+function handleResume(ws, msg) {
+    const roomId = msg.room;
+    const seat = rooms[roomId] && msg.session ? sessions[roomId].indexOf(msg.session) : -1;
+    if(seat < 0 || rooms[roomId][seat] !== null){
+        ws.send(JSON.stringify({
+            action: "resumeFailed",
+            room: roomId,
+            reason: seat < 0 ? "unknown session" : "session already connected"
+        }));
+        return;
+    }
+    rooms[roomId][seat] = ws;
+    ws.rooms.add(roomId);
+
+    // 依序重送遺漏的訊息，最後附上目前的計時器狀態
+    const log = gameLogs[roomId];
+    const lastSeen = msg.lastSeq || 0;
+    if(log){
+        log.entries.forEach(entry => {
+            if(entry.seq > lastSeen && entry.senderSeat !== seat){
+                ws.send(entry.payload);
+            }
+        });
+    }
+    ws.send(JSON.stringify({
+        action: "resumed",
+        room: roomId,
+        seq: log ? log.lastSeq : 0,
+        timerState: gameTimers[roomId] ? timerStateJson(gameTimers[roomId]) : null
+    }));
+    broadcastToRoom(roomId, JSON.stringify({ action: "opponentReconnected", room: roomId }), ws);
+}
+
+// 定期 ping 每個連線，以指數平滑量測往返時間
+setInterval(() => {
+    wss.clients.forEach(ws => {
+        if(ws.readyState === WebSocket.OPEN){
+            ws.pingSentAt = performance.now();
+            ws.ping();
+        }
+    });
+}, PING_INTERVAL_MS);
+
 wss.on('connection', ws => {
+    ws.rttMs = -1;
+    ws.rooms = new Set();  // 此連線所在的房間
+
+    ws.on('pong', () => {
+        if(ws.pingSentAt === undefined) return;
+        const sample = performance.now() - ws.pingSentAt;
+        ws.rttMs = ws.rttMs < 0 ? sample : (ws.rttMs * 7 + sample) / 8;
+    });
+
     ws.on('message', message => {
         const msg = JSON.parse(message);
 
+        // 時鐘同步：立即回覆伺服器時間，客戶端以往返時間估計偏移
+        if(msg.type === "Ping"){
+            ws.send(JSON.stringify({ type: "Pong", clientTime: msg.clientTime, serverTime: serverTimeMs() }));
+            return;
+        }
+
         // 創建房間
         if(msg.action === "createRoom"){
-            let roomId;
-            do {
-                roomId = generateRoomId();
-            } while(rooms[roomId]); // 確保不重複
+            const roomId = allocateRoomId();
+            if(roomId === null){
+                ws.send(JSON.stringify({ action: "error", message: "伺服器房間已滿" }));
+                return;
+            }
 
             rooms[roomId] = [ws];
-            ws.send(JSON.stringify({ action: "roomCreated", room: roomId }));
+            ws.rooms.add(roomId);
+            sessions[roomId] = [generateSessionId()];
+            ws.send(JSON.stringify({ action: "roomCreated", room: roomId, session: sessions[roomId][0] }));
         }
 
         // 加入房間
         else if(msg.action === "joinRoom"){
             const roomId = msg.room;
             if(rooms[roomId]){
+                const session = generateSessionId();
                 rooms[roomId].push(ws);
-                ws.send(JSON.stringify({ action: "joinedRoom", room: roomId }));
+                sessions[roomId].push(session);
+                ws.rooms.add(roomId);
+                ws.send(JSON.stringify({ action: "joinedRoom", room: roomId, session: session }));
                 
                 // 通知房主有玩家加入
                 const host = rooms[roomId][0];
@@ -106,8 +277,12 @@ wss.on('connection', ws => {
                     currentPlayer: "White",  // 白方先手
                     lastSwitchTime: null,  // 設為 null，等待第一步棋才開始計時
                     whiteIsA: whiteIsA,  // 記錄白方是否為房主
-                    incrementMs: msg.incrementMs || 0
+                    incrementMs: msg.incrementMs || 0,
+                    lagBudgetA: LAG_BUDGET_PER_GAME_MS,
+                    lagBudgetB: LAG_BUDGET_PER_GAME_MS,
+                    finished: false  // 投降或議和後為 true
                 };
+                gameLogs[roomId] = { lastSeq: 0, entries: [] };
                 
                 // 加上伺服器時間戳記以確保同步
                 // 使用未來時間（當前時間 + 500ms）以補償網路延遲
@@ -118,22 +293,14 @@ wss.on('connection', ws => {
                     blackTimeMs: blackTimeMs,
                     incrementMs: msg.incrementMs,
                     hostColor: msg.hostColor,
-                    serverTimestamp: Date.now() + 500,  // 添加 500ms 緩衝以補償網路延遲
+                    serverTimestamp: serverTimeMs() + 500,  // 添加 500ms 緩衝以補償網路延遲
                     // 發送初始計時器狀態
-                    timerState: {
-                        timeA: gameTimers[roomId].timeA,
-                        timeB: gameTimers[roomId].timeB,
-                        currentPlayer: gameTimers[roomId].currentPlayer,
-                        lastSwitchTime: gameTimers[roomId].lastSwitchTime
-                    }
+                    timerState: timerStateJson(gameTimers[roomId]),
+                    seq: 0
                 };
                 
                 // 廣播給房間內所有玩家
-                rooms[roomId].forEach(client => {
-                    if(client.readyState === WebSocket.OPEN){
-                        client.send(JSON.stringify(startMessage));
-                    }
-                });
+                broadcastToRoom(roomId, JSON.stringify(startMessage));
             }
         }
 
@@ -142,84 +309,49 @@ wss.on('connection', ws => {
             const roomId = msg.room;
             if(rooms[roomId] && gameTimers[roomId]){
                 const timer = gameTimers[roomId];
-                const currentTime = Math.floor(Date.now() / 1000);  // UNIX 秒數
-                
-                // 檢查是否為第一步棋（計時器尚未啟動）
-                const isFirstMove = (timer.lastSwitchTime === null);
-                
-                // 計算經過的時間
-                let elapsedMs = 0;
-                if (!isFirstMove) {
-                    // 不是第一步，計算經過的時間
-                    const elapsed = currentTime - timer.lastSwitchTime;
-                    elapsedMs = elapsed * 1000;
-                }
-                // 如果是第一步，elapsedMs 保持為 0，不扣除時間
+                const currentTime = serverTimeMs();  // 單調時鐘的毫秒數
                 
                 // currentPlayer 表示當前輪到誰（正在思考的玩家）
                 // 當收到移動訊息時，表示 currentPlayer 剛走完棋
                 // 所以要從 currentPlayer 的時間中扣除 elapsed，然後切換到對手
+                const whiteMoved = (timer.currentPlayer === "White");
+                const moverIsA = (whiteMoved === timer.whiteIsA);
                 
-                const playerWhoJustMoved = timer.currentPlayer;
+                // 第一步棋（計時器尚未啟動）不扣時間；之後扣除經過時間減去走棋方的延遲補償
+                let elapsedMs = 0;
+                if (timer.lastSwitchTime !== null) {
+                    const compensation = lagCompensation(ws, timer, moverIsA);
+                    elapsedMs = Math.max(0, currentTime - timer.lastSwitchTime - compensation);
+                }
                 
-                if(playerWhoJustMoved === "White"){
-                    // 白方剛走棋，從白方時間扣除
-                    const whiteTime = timer.whiteIsA ? timer.timeA : timer.timeB;
-                    const newWhiteTime = Math.max(0, whiteTime - elapsedMs) + timer.incrementMs;
-                    
-                    if(timer.whiteIsA){
-                        timer.timeA = newWhiteTime;
-                    } else {
-                        timer.timeB = newWhiteTime;
-                    }
-                    
-                    // 切換到黑方
-                    timer.currentPlayer = "Black";
+                if(moverIsA){
+                    timer.timeA = Math.round(Math.max(0, timer.timeA - elapsedMs) + timer.incrementMs);
                 } else {
-                    // 黑方剛走棋，從黑方時間扣除
-                    const blackTime = timer.whiteIsA ? timer.timeB : timer.timeA;
-                    const newBlackTime = Math.max(0, blackTime - elapsedMs) + timer.incrementMs;
-                    
-                    if(timer.whiteIsA){
-                        timer.timeB = newBlackTime;
-                    } else {
-                        timer.timeA = newBlackTime;
-                    }
-                    
-                    // 切換到白方
-                    timer.currentPlayer = "White";
+                    timer.timeB = Math.round(Math.max(0, timer.timeB - elapsedMs) + timer.incrementMs);
                 }
+                timer.currentPlayer = whiteMoved ? "Black" : "White";
                 
                 // 更新最後切換時間（如果是第一步，這裡開始計時）
-                // 加上緩衝時間以補償網路延遲，確保客戶端收到訊息時不會扣錯時間
-                timer.lastSwitchTime = currentTime + 1;  // 加 1 秒緩衝
+                timer.lastSwitchTime = currentTime;
                 
                 // 廣播移動訊息和計時器狀態
                 const moveMessage = {
                     ...msg,
-                    timerState: {
-                        timeA: timer.timeA,
-                        timeB: timer.timeB,
-                        currentPlayer: timer.currentPlayer,
-                        lastSwitchTime: timer.lastSwitchTime
-                    }
+                    timerState: timerStateJson(timer)
                 };
                 
-                rooms[roomId].forEach(client => {
-                    if(client.readyState === WebSocket.OPEN){
-                        client.send(JSON.stringify(moveMessage));
-                    }
-                });
+                broadcastToRoom(roomId, sequenceGameMessage(roomId, moveMessage));
             } else if(rooms[roomId]){
                 // 如果沒有計時器狀態，只廣播移動（向後兼容）
-                rooms[roomId].forEach(client => {
-                    if(client !== ws && client.readyState === WebSocket.OPEN){
-                        client.send(JSON.stringify(msg));
-                    }
-                });
+                broadcastToRoom(roomId, JSON.stringify(msg), ws);
             }
         }
 
+        // 斷線後續連
+        else if(msg.action === "resume"){
+            handleResume(ws, msg);
+        }
+
         // 離開房間（遊戲開始前）
         else if(msg.action === "leaveRoom"){
             const roomId = msg.room;
@@ -230,11 +362,8 @@ wss.on('connection', ws => {
         else if(msg.action === "surrender"){
             const roomId = msg.room;
             if(rooms[roomId]){
-                rooms[roomId].forEach(client => {
-                    if(client !== ws && client.readyState === WebSocket.OPEN){
-                        client.send(JSON.stringify(msg));
-                    }
-                });
+                if(gameTimers[roomId]) gameTimers[roomId].finished = true;
+                broadcastToRoom(roomId, sequenceGameMessage(roomId, msg, ws), ws);
             }
         }
 
@@ -242,11 +371,7 @@ wss.on('connection', ws => {
         else if(msg.action === "drawOffer"){
             const roomId = msg.room;
             if(rooms[roomId]){
-                rooms[roomId].forEach(client => {
-                    if(client !== ws && client.readyState === WebSocket.OPEN){
-                        client.send(JSON.stringify(msg));
-                    }
-                });
+                broadcastToRoom(roomId, sequenceGameMessage(roomId, msg, ws), ws);
             }
         }
 
@@ -254,19 +379,22 @@ wss.on('connection', ws => {
         else if(msg.action === "drawResponse"){
             const roomId = msg.room;
             if(rooms[roomId]){
-                rooms[roomId].forEach(client => {
-                    if(client !== ws && client.readyState === WebSocket.OPEN){
-                        client.send(JSON.stringify(msg));
-                    }
-                });
+                if(msg.accepted && gameTimers[roomId]) gameTimers[roomId].finished = true;
+                broadcastToRoom(roomId, sequenceGameMessage(roomId, msg, ws), ws);
             }
         }
     });
 
-    // 玩家斷線
+    // 玩家斷線：對局進行中保留座位等待續連，其他情況從房間移除
     ws.on('close', () => {
-        for(const roomId in rooms){
-            handlePlayerLeaveRoom(ws, roomId);
+        for(const roomId of ws.rooms){
+            const index = rooms[roomId] ? rooms[roomId].indexOf(ws) : -1;
+            if(index < 0) continue;
+            if(gameTimers[roomId] && !gameTimers[roomId].finished){
+                suspendPlayer(roomId, index);
+            } else {
+                removePlayer(roomId, index);
+            }
         }
     });
 });
@@ -0,0 +1,186 @@
+#include "benchmark.h"
+#include "chessengine.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QStandardPaths>
+#include <QTimer>
+
+namespace {
+const int BENCH_PERFT_DEPTH = 3;
+const int BENCH_ENGINE_DEPTH = 13;
+const int BENCH_ENGINE_THREADS = 1;        // 多執行緒搜尋的節點數不固定
+const int BENCH_ENGINE_HASH_MB = 16;
+const int BENCH_ENGINE_TIMEOUT_MS = 600000;
+
+const PieceType PROMOTION_TYPES[] = {PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight};
+}
+
+const QStringList& Benchmark::positions()
+{
+    // 修改這個列表會改變節點簽章
+    static const QStringList list = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+        "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+    };
+    return list;
+}
+
+qint64 Benchmark::perft(const ChessBoard& board, int depth)
+{
+    if (depth <= 0) return 1;
+
+    qint64 nodes = 0;
+    PieceColor side = board.getCurrentPlayer();
+    int promotionRow = (side == PieceColor::White) ? 0 : 7;
+
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            const ChessPiece& piece = board.getPiece(row, col);
+            if (piece.getColor() != side || piece.getType() == PieceType::None) continue;
+
+            QPoint from(col, row);
+            bool canPromote = piece.getType() == PieceType::Pawn;
+            for (int toRow = 0; toRow < 8; ++toRow) {
+                for (int toCol = 0; toCol < 8; ++toCol) {
+                    QPoint to(toCol, toRow);
+                    if (!board.isValidMove(from, to)) continue;
+
+                    bool promotion = canPromote && toRow == promotionRow;
+                    // 最後一層只計數，不必實際走棋
+                    if (depth == 1) {
+                        nodes += promotion ? 4 : 1;
+                        continue;
+                    }
+
+                    ChessBoard next = board;
+                    next.movePiece(from, to);
+                    if (!promotion) {
+                        nodes += perft(next, depth - 1);
+                        continue;
+                    }
+                    for (PieceType type : PROMOTION_TYPES) {
+                        ChessBoard promoted = next;
+                        promoted.promotePawn(to, type);
+                        nodes += perft(promoted, depth - 1);
+                    }
+                }
+            }
+        }
+    }
+    return nodes;
+}
+
+BenchResult Benchmark::runPerft(int depth)
+{
+    BenchResult result;
+    QElapsedTimer timer;
+    timer.start();
+    for (const QString& fen : positions()) {
+        ChessBoard board;
+        if (!board.loadFromFEN(fen)) return result;
+        result.nodes += perft(board, depth);
+    }
+    result.elapsedMs = timer.elapsed();
+    result.ok = true;
+    return result;
+}
+
+BenchResult Benchmark::runEngine(const QString& enginePath, int depth)
+{
+    BenchResult result;
+
+    // 不使用評分快取：每個局面都必須真正搜尋
+    EngineResourceProfile profile;
+    profile.threads = BENCH_ENGINE_THREADS;
+    profile.hashMb = BENCH_ENGINE_HASH_MB;
+
+    ChessEngine engine;
+    engine.setDifficulty(20);
+    engine.setResourceProfile(profile);
+
+    QEventLoop loop;
+    QElapsedTimer searchTimer;
+    int index = 0;
+    bool started = false;
+    SearchLimits limits;
+    limits.depth = depth;
+
+    auto searchNext = [&]() {
+        engine.newGame();
+        engine.setPosition(positions()[index]);
+        searchTimer.start();
+        engine.requestSearch(limits);
+    };
+
+    // 就緒後才開始第一個局面，行程啟動與 UCI 握手不算進第一個局面的時間
+    QObject::connect(&engine, &ChessEngine::engineReady, &loop, [&]() {
+        if (started) return;
+        started = true;
+        searchNext();
+    });
+    QObject::connect(&engine, &ChessEngine::bestMoveFound, &loop, [&](const QString&) {
+        result.nodes += engine.getLastInfo().nodes;
+        result.elapsedMs += searchTimer.elapsed();
+        if (++index < positions().size()) {
+            searchNext();
+        } else {
+            result.ok = true;
+            loop.quit();
+        }
+    });
+    QObject::connect(&engine, &ChessEngine::engineError, &loop, [&](const QString& error) {
+        qWarning() << "[Benchmark] Engine error:" << error;
+        loop.quit();
+    });
+    QTimer::singleShot(BENCH_ENGINE_TIMEOUT_MS, &loop, &QEventLoop::quit);
+
+    if (!engine.startEngine(enginePath)) return result;
+    loop.exec();
+
+    engine.stopEngine();
+    return result;
+}
+
+QString Benchmark::defaultEnginePath()
+{
+    // 依序尋找程式目錄、engine/ 子目錄，最後是 PATH
+    QString appDir = QCoreApplication::applicationDirPath();
+    QString path = QStandardPaths::findExecutable("stockfish", {appDir, appDir + "/engine"});
+    if (path.isEmpty()) path = QStandardPaths::findExecutable("stockfish");
+    return path;
+}
+
+int Benchmark::run(const QString& enginePath)
+{
+    BenchResult perftResult = runPerft(BENCH_PERFT_DEPTH);
+    qInfo().noquote() << QString("Perft depth %1 over %2 positions")
+                         .arg(BENCH_PERFT_DEPTH).arg(positions().size());
+    qInfo().noquote() << QString("Perft nodes      : %1").arg(perftResult.nodes);
+    qInfo().noquote() << QString("Perft time (ms)  : %1").arg(perftResult.elapsedMs);
+    qInfo().noquote() << QString("Perft nodes/sec  : %1").arg(perftResult.nodesPerSecond());
+
+    if (enginePath.isEmpty()) {
+        qInfo() << "No engine found, skipping engine bench";
+        return perftResult.ok ? 0 : 1;
+    }
+
+    BenchResult engineResult = runEngine(enginePath, BENCH_ENGINE_DEPTH);
+    if (!engineResult.ok) {
+        qWarning() << "Engine bench failed";
+        return 1;
+    }
+    qInfo().noquote() << QString("Engine depth %1, %2 thread, %3 MB hash")
+                         .arg(BENCH_ENGINE_DEPTH).arg(BENCH_ENGINE_THREADS).arg(BENCH_ENGINE_HASH_MB);
+    qInfo().noquote() << QString("Engine nodes     : %1").arg(engineResult.nodes);
+    qInfo().noquote() << QString("Engine time (ms) : %1").arg(engineResult.elapsedMs);
+    qInfo().noquote() << QString("Engine nodes/sec : %1").arg(engineResult.nodesPerSecond());
+    return perftResult.ok ? 0 : 1;
+}
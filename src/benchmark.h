@@ -0,0 +1,35 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+#include "chessboard.h"
+
+// 基準測試結果
+struct BenchResult {
+    qint64 nodes = 0;           // 節點簽章：搜尋或走法產生沒有改變時必須維持不變
+    qint64 elapsedMs = 0;
+    bool ok = false;
+
+    qint64 nodesPerSecond() const { return elapsedMs > 0 ? nodes * 1000 / elapsedMs : 0; }
+};
+
+// 確定性的基準測試：固定局面、固定深度
+// - perft：以 ChessBoard 的走法產生計算節點數，測量走法產生和合法性檢查的速度
+// - 引擎：每個局面前送 ucinewgame，以單執行緒、固定置換表大小搜尋到固定深度，加總引擎回報的節點數
+class Benchmark
+{
+public:
+    static const QStringList& positions();
+
+    static qint64 perft(const ChessBoard& board, int depth);
+    static BenchResult runPerft(int depth);
+    static BenchResult runEngine(const QString& enginePath, int depth);  // 在區域事件迴圈中同步執行
+
+    static QString defaultEnginePath();     // 程式目錄、engine/ 子目錄、PATH 中的 stockfish，找不到時為空字串
+
+    // --bench 命令列入口：輸出結果並返回程式結束碼；enginePath 為空時只執行 perft
+    static int run(const QString& enginePath);
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,161 @@
+#include "binaryprotocol.h"
+
+namespace BinaryProtocol {
+
+namespace {
+const int MAX_VARINT_BYTES = 10;
+const quint8 FLAG_WHITE_TO_MOVE = 0x01;
+const quint8 FLAG_CLOCK_RUNNING = 0x02;
+const int RESULT_SHIFT = 2;
+
+bool onBoard(const QPoint& square)
+{
+    return square.x() >= 0 && square.x() < 8 && square.y() >= 0 && square.y() < 8;
+}
+
+void writeUint16(QByteArray& out, quint16 value)
+{
+    out.append(static_cast<char>(value >> 8));
+    out.append(static_cast<char>(value & 0xFF));
+}
+
+bool readUint16(const QByteArray& in, int& pos, quint16& value)
+{
+    if (pos + 2 > in.size()) return false;
+    value = static_cast<quint16>((static_cast<quint8>(in.at(pos)) << 8) | static_cast<quint8>(in.at(pos + 1)));
+    pos += 2;
+    return true;
+}
+
+bool readMoveBody(const QByteArray& data, int& pos, MoveFrame& frame)
+{
+    quint16 packed = 0;
+    return readVarint(data, pos, frame.roomId)
+        && readUint16(data, pos, packed)
+        && unpackMove(packed, frame.from, frame.to, frame.promotionType);
+}
+
+void writeMoveBody(QByteArray& out, const MoveFrame& frame)
+{
+    writeVarint(out, frame.roomId);
+    writeUint16(out, packMove(frame.from, frame.to, frame.promotionType));
+}
+}
+
+quint16 packMove(const QPoint& from, const QPoint& to, PieceType promotionType)
+{
+    quint16 fromSquare = static_cast<quint16>(from.y() * 8 + from.x());
+    quint16 toSquare = static_cast<quint16>(to.y() * 8 + to.x());
+    return static_cast<quint16>((fromSquare << 10) | (toSquare << 4) | (static_cast<quint16>(promotionType) << 1));
+}
+
+bool unpackMove(quint16 packed, QPoint& from, QPoint& to, PieceType& promotionType)
+{
+    int fromSquare = (packed >> 10) & 0x3F;
+    int toSquare = (packed >> 4) & 0x3F;
+    int promotion = (packed >> 1) & 0x07;
+    if (promotion > static_cast<int>(PieceType::King)) return false;
+
+    from = QPoint(fromSquare % 8, fromSquare / 8);
+    to = QPoint(toSquare % 8, toSquare / 8);
+    promotionType = static_cast<PieceType>(promotion);
+    return true;
+}
+
+void writeVarint(QByteArray& out, quint64 value)
+{
+    // LEB128：每個位元組 7 位元資料，最高位元表示後面還有資料
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+bool readVarint(const QByteArray& in, int& pos, quint64& value)
+{
+    value = 0;
+    for (int i = 0; i < MAX_VARINT_BYTES && pos < in.size(); ++i) {
+        quint8 byte = static_cast<quint8>(in.at(pos++));
+        value |= static_cast<quint64>(byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+QByteArray encodeMove(const MoveFrame& frame)
+{
+    QByteArray out;
+    out.reserve(16);
+    out.append(static_cast<char>(OpMove));
+    writeMoveBody(out, frame);
+    return out;
+}
+
+QByteArray encodeMoveRelay(const MoveRelayFrame& frame)
+{
+    quint8 flags = static_cast<quint8>(frame.result) << RESULT_SHIFT;
+    if (frame.whiteToMove) flags |= FLAG_WHITE_TO_MOVE;
+    if (frame.sinceSwitchMs >= 0) flags |= FLAG_CLOCK_RUNNING;
+
+    QByteArray out;
+    out.reserve(32);
+    out.append(static_cast<char>(OpMoveRelay));
+    writeMoveBody(out, frame.move);
+    out.append(static_cast<char>(flags));
+    writeVarint(out, frame.seq);
+    writeVarint(out, static_cast<quint64>(qMax<qint64>(0, frame.timeA)));
+    writeVarint(out, static_cast<quint64>(qMax<qint64>(0, frame.timeB)));
+    writeVarint(out, static_cast<quint64>(qMax<qint64>(0, frame.serverTimeMs)));
+    if (frame.sinceSwitchMs >= 0) {
+        writeVarint(out, static_cast<quint64>(frame.sinceSwitchMs));
+    }
+    return out;
+}
+
+bool decodeMove(const QByteArray& data, MoveFrame& frame)
+{
+    int pos = 1;
+    return opcode(data) == OpMove && readMoveBody(data, pos, frame)
+        && onBoard(frame.from) && onBoard(frame.to);
+}
+
+bool decodeMoveRelay(const QByteArray& data, MoveRelayFrame& frame)
+{
+    int pos = 1;
+    if (opcode(data) != OpMoveRelay || !readMoveBody(data, pos, frame.move) || pos >= data.size()) {
+        return false;
+    }
+
+    quint8 flags = static_cast<quint8>(data.at(pos++));
+    quint64 timeA = 0;
+    quint64 timeB = 0;
+    quint64 serverTime = 0;
+    if (!readVarint(data, pos, frame.seq) || !readVarint(data, pos, timeA)
+        || !readVarint(data, pos, timeB) || !readVarint(data, pos, serverTime)) {
+        return false;
+    }
+    frame.timeA = static_cast<qint64>(timeA);
+    frame.timeB = static_cast<qint64>(timeB);
+    frame.serverTimeMs = static_cast<qint64>(serverTime);
+    frame.whiteToMove = flags & FLAG_WHITE_TO_MOVE;
+    frame.result = static_cast<RelayResult>((flags >> RESULT_SHIFT) & 0x03);
+
+    frame.sinceSwitchMs = -1;
+    if (flags & FLAG_CLOCK_RUNNING) {
+        quint64 sinceSwitch = 0;
+        if (!readVarint(data, pos, sinceSwitch)) return false;
+        frame.sinceSwitchMs = static_cast<qint64>(sinceSwitch);
+    }
+    return true;
+}
+
+bool roomIdFromString(const QString& room, quint64& roomId)
+{
+    bool ok = false;
+    roomId = room.toULongLong(&ok);
+    // 前導零會在轉換後遺失，這種房號不能往返
+    return ok && QString::number(roomId) == room;
+}
+
+}
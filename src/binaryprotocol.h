@@ -0,0 +1,69 @@
+#ifndef BINARYPROTOCOL_H
+#define BINARYPROTOCOL_H
+
+#include <QByteArray>
+#include <QPoint>
+#include <QString>
+#include "chesspiece.h"
+
+// 精簡的二進位走棋協議（WebSocket binary frame）
+// 連線後客戶端送出 JSON {"action":"hello","binary":VERSION}，伺服器回覆相同訊息後雙方才使用二進位訊框；
+// 沒有回覆的舊伺服器（以及沒有送出 hello 的舊客戶端）繼續使用 JSON
+//
+// 訊框格式：1 位元組操作碼 + varint 房號 + 2 位元組打包走法（大端序），
+// 伺服器轉送時再加上 1 位元組旗標、varint 序號與 varint 毫秒時間
+// 版本 2 加入序號（斷線續連時用來判斷重送的訊息），版本 1 的客戶端改用 JSON
+namespace BinaryProtocol {
+
+const int VERSION = 2;
+
+enum Opcode : quint8 {
+    OpMove = 0x01,          // 客戶端 -> 伺服器：走棋
+    OpMoveRelay = 0x02      // 伺服器 -> 房間內玩家：走棋與計時器狀態
+};
+
+// 伺服器轉送的對局結果（旗標的第 2-3 位元）
+enum RelayResult : quint8 {
+    ResultNone = 0,
+    ResultWhiteWins = 1,
+    ResultBlackWins = 2,
+    ResultDraw = 3
+};
+
+struct MoveFrame {
+    quint64 roomId = 0;
+    QPoint from;
+    QPoint to;
+    PieceType promotionType = PieceType::None;
+};
+
+struct MoveRelayFrame {
+    MoveFrame move;
+    quint64 seq = 0;                // 房間內對局訊息的序號
+    qint64 timeA = 0;               // 房主的剩餘時間（毫秒）
+    qint64 timeB = 0;               // 房客的剩餘時間（毫秒）
+    bool whiteToMove = true;        // 走完這步後輪到白方
+    qint64 serverTimeMs = 0;        // 伺服器送出時的時間
+    qint64 sinceSwitchMs = -1;      // 送出時距離最後切換的時間，-1 表示計時器尚未啟動
+    RelayResult result = ResultNone;
+};
+
+// 走法打包成 16 位元：起點格（6）| 終點格（6）| 升變棋子（3），格子編號為 row * 8 + col
+quint16 packMove(const QPoint& from, const QPoint& to, PieceType promotionType);
+bool unpackMove(quint16 packed, QPoint& from, QPoint& to, PieceType& promotionType);
+
+void writeVarint(QByteArray& out, quint64 value);
+bool readVarint(const QByteArray& in, int& pos, quint64& value);
+
+QByteArray encodeMove(const MoveFrame& frame);
+QByteArray encodeMoveRelay(const MoveRelayFrame& frame);
+bool decodeMove(const QByteArray& data, MoveFrame& frame);
+bool decodeMoveRelay(const QByteArray& data, MoveRelayFrame& frame);
+
+// 房號在 JSON 中是十進位字串；非數字的房號不能使用二進位協議
+bool roomIdFromString(const QString& room, quint64& roomId);
+inline quint8 opcode(const QByteArray& data) { return data.isEmpty() ? 0 : static_cast<quint8>(data.at(0)); }
+
+}
+
+#endif // BINARYPROTOCOL_H
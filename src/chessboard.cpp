@@ -1,8 +1,13 @@
 #include "chessboard.h"
+#include <algorithm>
 
 ChessBoard::ChessBoard()
-    : m_board(8, std::vector<ChessPiece>(8)), m_currentPlayer(PieceColor::White), m_enPassantTarget(-1, -1), m_gameResult(GameResult::InProgress)
+    : m_board(8, std::vector<ChessPiece>(8)), m_currentPlayer(PieceColor::White), m_enPassantTarget(-1, -1), m_gameResult(GameResult::InProgress),
+      m_recordMoves(true)
 {
+    // 每方最多被吃 15 個棋子，預先配置避免走棋時配置記憶體
+    m_capturedWhite.reserve(15);
+    m_capturedBlack.reserve(15);
     initializeBoard();
 }
 
@@ -97,8 +102,11 @@ bool ChessBoard::isInCheck(PieceColor color) const {
 }
 
 bool ChessBoard::wouldBeInCheck(const QPoint& from, const QPoint& to, PieceColor color) const {
-    // 複製棋盤並模擬移動
-    std::vector<std::vector<ChessPiece>> tempBoard = m_board;
+    // 在堆疊上的模擬棋盤執行移動：不配置記憶體，也不寫入共用狀態，多個執行緒可以同時查詢同一個棋盤
+    PieceGrid tempBoard;
+    for (int row = 0; row < 8; ++row) {
+        std::copy(m_board[row].begin(), m_board[row].end(), tempBoard[row].begin());
+    }
     
     // 在臨時棋盤上執行移動
     // 注意：QPoint(x, y) 對應到 board[y][x]，因為 x=列，y=行
@@ -245,7 +253,9 @@ bool ChessBoard::movePiece(const QPoint& from, const QPoint& to) {
     m_board[from.y()][from.x()] = ChessPiece(PieceType::None, PieceColor::None);
     
     // 記錄移動（在切換玩家之前，因為 recordMove 需要檢查對手是否被將軍）
-    recordMove(from, to, isCapture, isCastling, isEnPassant);
+    if (m_recordMoves) {
+        recordMove(from, to, isCapture, isCastling, isEnPassant);
+    }
     
     switchPlayer();
     return true;
@@ -643,3 +653,168 @@ void ChessBoard::clearCapturedPieces() {
     m_capturedWhite.clear();
     m_capturedBlack.clear();
 }
+
+bool ChessBoard::loadFromFEN(const QString& fen) {
+    QStringList fields = fen.trimmed().split(' ', Qt::SkipEmptyParts);
+    if (fields.size() < 2) return false;
+    
+    QStringList ranks = fields[0].split('/');
+    if (ranks.size() != 8) return false;
+    
+    std::vector<std::vector<ChessPiece>> board(8, std::vector<ChessPiece>(8));
+    for (int row = 0; row < 8; ++row) {
+        int col = 0;
+        for (QChar c : ranks[row]) {
+            if (c.isDigit()) {
+                col += c.digitValue();
+                continue;
+            }
+            if (col >= 8) return false;
+            
+            PieceType type = PieceType::None;
+            switch (c.toLower().toLatin1()) {
+                case 'k': type = PieceType::King; break;
+                case 'q': type = PieceType::Queen; break;
+                case 'r': type = PieceType::Rook; break;
+                case 'b': type = PieceType::Bishop; break;
+                case 'n': type = PieceType::Knight; break;
+                case 'p': type = PieceType::Pawn; break;
+                default: return false;
+            }
+            PieceColor color = c.isUpper() ? PieceColor::White : PieceColor::Black;
+            ChessPiece piece(type, color);
+            // 兵只有在起始行才能前進兩格
+            if (type == PieceType::Pawn) {
+                int startRow = (color == PieceColor::White) ? 6 : 1;
+                piece.setMoved(row != startRow);
+            }
+            board[row][col++] = piece;
+        }
+        if (col != 8) return false;
+    }
+    
+    // 王車易位權利以國王和車的「已移動」標記表示
+    QString castling = fields.size() > 2 ? fields[2] : QString("-");
+    auto setCastlingFlags = [&board, &castling](int row, PieceColor color, QChar kingSide, QChar queenSide) {
+        bool canKingSide = castling.contains(kingSide);
+        bool canQueenSide = castling.contains(queenSide);
+        for (int col = 0; col < 8; ++col) {
+            ChessPiece& piece = board[row][col];
+            if (piece.getColor() != color) continue;
+            if (piece.getType() == PieceType::King) {
+                piece.setMoved(!(col == 4 && (canKingSide || canQueenSide)));
+            } else if (piece.getType() == PieceType::Rook) {
+                piece.setMoved(!((col == 7 && canKingSide) || (col == 0 && canQueenSide)));
+            }
+        }
+    };
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            ChessPiece& piece = board[row][col];
+            if (piece.getType() == PieceType::King || piece.getType() == PieceType::Rook) {
+                piece.setMoved(true);
+            }
+        }
+    }
+    setCastlingFlags(7, PieceColor::White, 'K', 'Q');
+    setCastlingFlags(0, PieceColor::Black, 'k', 'q');
+    
+    QPoint enPassant(-1, -1);
+    if (fields.size() > 3 && fields[3].size() == 2) {
+        int col = fields[3][0].toLatin1() - 'a';
+        int row = '8' - fields[3][1].toLatin1();
+        if (col >= 0 && col < 8 && row >= 0 && row < 8) {
+            enPassant = QPoint(col, row);
+        }
+    }
+    
+    m_board = board;
+    m_currentPlayer = (fields[1] == "b") ? PieceColor::Black : PieceColor::White;
+    m_enPassantTarget = enPassant;
+    m_gameResult = GameResult::InProgress;
+    clearMoveHistory();
+    clearCapturedPieces();
+    return true;
+}
+
+bool ChessBoard::findMoveFromSAN(const QString& san, QPoint& from, QPoint& to, PieceType& promotionType) const {
+    // 移除將軍、將殺及註解符號
+    QString move = san.trimmed();
+    while (!move.isEmpty() && QString("+#!?").contains(move.back())) {
+        move.chop(1);
+    }
+    if (move.isEmpty()) return false;
+    
+    promotionType = PieceType::None;
+    int backRow = (m_currentPlayer == PieceColor::White) ? 7 : 0;
+    
+    // 王車易位
+    if (move == "O-O" || move == "0-0" || move == "O-O-O" || move == "0-0-0") {
+        from = QPoint(4, backRow);
+        to = QPoint(move.size() == 3 ? 6 : 2, backRow);
+        return isValidMove(from, to);
+    }
+    
+    // 升變（"e8=Q" 或 "e8Q"）
+    auto notationToType = [](QChar c) {
+        switch (c.toUpper().toLatin1()) {
+            case 'K': return PieceType::King;
+            case 'Q': return PieceType::Queen;
+            case 'R': return PieceType::Rook;
+            case 'B': return PieceType::Bishop;
+            case 'N': return PieceType::Knight;
+            default:  return PieceType::None;
+        }
+    };
+    if (move.size() >= 3 && move.back().isLetter() && move.back().isUpper()) {
+        promotionType = notationToType(move.back());
+        if (promotionType == PieceType::None || promotionType == PieceType::King) return false;
+        move.chop(1);
+        if (move.endsWith('=')) move.chop(1);
+    }
+    
+    if (move.size() < 2) return false;
+    int toCol = move[move.size() - 2].toLatin1() - 'a';
+    int toRow = '8' - move[move.size() - 1].toLatin1();
+    if (toCol < 0 || toCol >= 8 || toRow < 0 || toRow >= 8) return false;
+    to = QPoint(toCol, toRow);
+    
+    // 棋子類型（大寫字母開頭），其餘為兵
+    PieceType pieceType = PieceType::Pawn;
+    int start = 0;
+    if (move[0].isUpper()) {
+        pieceType = notationToType(move[0]);
+        if (pieceType == PieceType::None) return false;
+        start = 1;
+    }
+    
+    // 消歧義：起始列及/或起始行
+    int fromCol = -1;
+    int fromRow = -1;
+    for (int i = start; i < move.size() - 2; ++i) {
+        QChar c = move[i];
+        if (c >= 'a' && c <= 'h') {
+            fromCol = c.toLatin1() - 'a';
+        } else if (c >= '1' && c <= '8') {
+            fromRow = '8' - c.toLatin1();
+        } else if (c != 'x' && c != '-') {
+            return false;
+        }
+    }
+    
+    for (int row = 0; row < 8; ++row) {
+        if (fromRow >= 0 && row != fromRow) continue;
+        for (int col = 0; col < 8; ++col) {
+            if (fromCol >= 0 && col != fromCol) continue;
+            const ChessPiece& piece = m_board[row][col];
+            if (piece.getType() != pieceType || piece.getColor() != m_currentPlayer) continue;
+            
+            QPoint candidate(col, row);
+            if (isValidMove(candidate, to)) {
+                from = candidate;
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -36,12 +36,15 @@ public:
     ChessBoard();
     
     void initializeBoard();
+    bool loadFromFEN(const QString& fen);  // 從 FEN 載入局面（清除棋譜記錄），格式錯誤時返回 false
     const ChessPiece& getPiece(int row, int col) const;
     ChessPiece& getPiece(int row, int col);
     void setPiece(int row, int col, const ChessPiece& piece);  // 安全地設置棋子
     
     bool movePiece(const QPoint& from, const QPoint& to);
     bool isValidMove(const QPoint& from, const QPoint& to) const;
+    // 將當前玩家的標準代數記譜（SAN，例如 "Nbd7"、"exd8=Q+"、"O-O"）轉換為起點與終點
+    bool findMoveFromSAN(const QString& san, QPoint& from, QPoint& to, PieceType& promotionType) const;
     
     PieceColor getCurrentPlayer() const { return m_currentPlayer; }
     void setCurrentPlayer(PieceColor player) { m_currentPlayer = player; }
@@ -61,6 +64,8 @@ public:
     const std::vector<MoveRecord>& getMoveHistory() const { return m_moveHistory; }
     void clearMoveHistory();
     void setMoveHistory(const std::vector<MoveRecord>& history);
+    // 關閉後 movePiece 不產生棋譜記錄與記譜字串（伺服器驗證等只需要規則判定的場合）
+    void setMoveRecording(bool enabled) { m_recordMoves = enabled; }
     QString getMoveNotation(int moveIndex) const;
     QStringList getAllMoveNotations() const;
     
@@ -81,6 +86,7 @@ private:
     GameResult m_gameResult; // 遊戲結果
     std::vector<ChessPiece> m_capturedWhite; // 被吃掉的白色棋子
     std::vector<ChessPiece> m_capturedBlack; // 被吃掉的黑色棋子
+    bool m_recordMoves; // 是否記錄棋譜
     
     void switchPlayer();
     bool wouldBeInCheck(const QPoint& from, const QPoint& to, PieceColor color) const;
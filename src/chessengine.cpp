@@ -5,6 +5,16 @@
 #include <QDir>
 #include <QFileInfo>
 
+namespace {
+const int DEFAULT_ANALYSIS_UPDATE_HZ = 10;  // analysisUpdated 信號的預設最高頻率
+const int MAX_MULTI_PV = 5;                // 分析模式最多同時顯示的變例數
+const int QUIT_KILL_TIMEOUT_MS = 3000;     // 送出 quit 後多久仍未結束就強制終止行程
+const int WATCHDOG_GRACE_MS = 5000;        // 搜尋期限之後再等待多久才判定引擎無回應
+const int MAX_CONSECUTIVE_RESTARTS = 3;    // 連續重新啟動仍失敗時放棄
+const int RESTART_WINDOW_MS = 60000;       // 距離上次重新啟動超過此時間就重新計算連續次數
+const int MAX_SKILL_LEVEL = 20;
+}
+
 ChessEngine::ChessEngine(QObject *parent)
     : QObject(parent)
     , m_process(nullptr)
@@ -12,19 +22,59 @@ ChessEngine::ChessEngine(QObject *parent)
     , m_skillLevel(0)  // 預設初學者難度
     , m_thinkingTimeMs(50)  // 預設 50ms 思考時間
     , m_searchDepth(1)  // 預設搜尋深度 1
-    , m_isReady(false)
+    , m_state(EngineState::Stopped)
+    , m_startupLatencyMs(-1)
     , m_isThinking(false)
+    , m_ponderEnabled(false)
+    , m_isPondering(false)
+    , m_staleBestMoves(0)
+    , m_ponderHits(0)
+    , m_ponderSearches(0)
+    , m_resources(EngineResourceProfile::detect())
+    , m_isAnalyzing(false)
+    , m_multiPv(1)
+    , m_hardLimitTimer(new QTimer(this))
+    , m_watchdogTimer(new QTimer(this))
+    , m_lastSearchSide(PieceColor::None)
+    , m_lastSearchFixed(false)
+    , m_watchdogDeadlineMs(-1)
+    , m_searchClocksPending(false)
+    , m_recovering(false)
+    , m_resumeSearch(false)
+    , m_resumeMultiPv(1)
+    , m_restartCount(0)
+    , m_consecutiveRestarts(0)
+    , m_totalDowntimeMs(0)
+    , m_analysisTimer(new QTimer(this))
+    , m_analysisIntervalMs(1000 / DEFAULT_ANALYSIS_UPDATE_HZ)
+    , m_analysisDirty(false)
+    , m_evalCache(nullptr)
+    , m_cachedInfoDepth(0)
 {
+    m_hardLimitTimer->setSingleShot(true);
+    connect(m_hardLimitTimer, &QTimer::timeout, this, &ChessEngine::onHardLimitReached);
+    
+    m_watchdogTimer->setSingleShot(true);
+    connect(m_watchdogTimer, &QTimer::timeout, this, &ChessEngine::onWatchdogTimeout);
+    
+    m_analysisTimer->setSingleShot(true);
+    connect(m_analysisTimer, &QTimer::timeout, this, &ChessEngine::flushAnalysis);
 }
 
 ChessEngine::~ChessEngine()
 {
-    stopEngine();
+    if (m_process) {
+        // 結束時不再等待引擎回應；QProcess 解構時會終止仍在執行的行程
+        m_process->disconnect(this);
+        if (m_process->state() == QProcess::Running) {
+            writeCommand("quit");
+        }
+    }
 }
 
 bool ChessEngine::startEngine(const QString& enginePath)
 {
-    if (m_process && m_process->state() != QProcess::NotRunning) {
+    if (m_process) {
         stopEngine();
     }
 
@@ -38,6 +88,8 @@ bool ChessEngine::startEngine(const QString& enginePath)
     m_enginePath = enginePath;
     m_process = new QProcess(this);
     
+    connect(m_process, &QProcess::started,
+            this, &ChessEngine::onEngineStarted);
     connect(m_process, &QProcess::readyReadStandardOutput, 
             this, &ChessEngine::onReadyReadStandardOutput);
     connect(m_process, &QProcess::readyReadStandardError, 
@@ -47,46 +99,93 @@ bool ChessEngine::startEngine(const QString& enginePath)
     connect(m_process, &QProcess::errorOccurred,
             this, &ChessEngine::onEngineError);
 
+    // 非阻塞啟動：行程啟動後在 onEngineStarted() 中送出 uci
+    m_pendingCommands.clear();
+    m_options.clear();
+    m_startupLatencyMs = -1;
+    m_startupClock.start();
+    setState(EngineState::Starting);
     m_process->start(enginePath, QStringList());
     
-    if (!m_process->waitForStarted(5000)) {
-        emit engineError(QString("無法啟動引擎：%1").arg(m_process->errorString()));
-        delete m_process;
-        m_process = nullptr;
-        return false;
-    }
-
-    // 初始化 UCI 協議
-    sendCommand("uci");
-    
     return true;
 }
 
 void ChessEngine::stopEngine()
 {
     if (m_process) {
-        if (m_isThinking) {
-            sendCommand("stop");
-            m_isThinking = false;
-        }
-        sendCommand("quit");
+        QProcess* process = m_process;
+        m_process = nullptr;
         
-        if (!m_process->waitForFinished(3000)) {
-            m_process->kill();
-            m_process->waitForFinished(1000);
+        // 舊行程與本物件脫鉤，自行結束並釋放，不阻塞呼叫端
+        process->disconnect(this);
+        if (process->state() == QProcess::NotRunning) {
+            process->deleteLater();
+            setState(EngineState::Stopped);
+        } else {
+            setState(EngineState::Stopping);
+            connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                    this, [this]() {
+                        if (m_state == EngineState::Stopping) setState(EngineState::Stopped);
+                    });
+            connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                    process, &QObject::deleteLater);
+            
+            if (process->state() == QProcess::Running) {
+                if (m_isThinking || m_isPondering || m_isAnalyzing) {
+                    process->write("stop\n");
+                }
+                process->write("quit\n");
+            }
+            // 引擎未在期限內結束時強制終止（以行程為 context，行程已釋放時不會觸發）
+            QTimer::singleShot(QUIT_KILL_TIMEOUT_MS, process, &QProcess::kill);
         }
-        
-        delete m_process;
-        m_process = nullptr;
     }
     
-    m_isReady = false;
+    m_hardLimitTimer->stop();
+    m_watchdogTimer->stop();
+    m_searchClocksPending = false;
+    m_timeManager.reset();
+    m_pendingCommands.clear();
     m_isThinking = false;
+    m_isPondering = false;
+    m_isAnalyzing = false;
+    m_multiPv = 1;
+    m_staleBestMoves = 0;
+    m_ponderResult.clear();
+    m_readBuffer.clear();
+    clearAnalysis();
 }
 
 bool ChessEngine::isEngineRunning() const
 {
-    return m_process && m_process->state() == QProcess::Running && m_isReady;
+    return m_process && (m_state == EngineState::Ready || m_state == EngineState::Searching);
+}
+
+bool ChessEngine::isEngineStarting() const
+{
+    return m_process && (m_state == EngineState::Starting || m_state == EngineState::UciOk);
+}
+
+bool ChessEngine::acceptsCommands() const
+{
+    return isEngineRunning() || isEngineStarting();
+}
+
+void ChessEngine::setState(EngineState state)
+{
+    if (m_state == state) return;
+    
+    m_state = state;
+    emit stateChanged(m_state);
+}
+
+void ChessEngine::updateSearchState()
+{
+    if (m_state != EngineState::Ready && m_state != EngineState::Searching) return;
+    
+    // 被中止的搜尋在回報 bestmove 之前，引擎仍在搜尋
+    bool searching = m_isThinking || m_isPondering || m_isAnalyzing || m_staleBestMoves > 0;
+    setState(searching ? EngineState::Searching : EngineState::Ready);
 }
 
 void ChessEngine::setGameMode(GameMode mode)
@@ -96,8 +195,14 @@ void ChessEngine::setGameMode(GameMode mode)
 
 void ChessEngine::setDifficulty(int level)
 {
-    m_skillLevel = qBound(0, level, 20);
-    configureEngine();
+    m_skillLevel = qBound(0, level, MAX_SKILL_LEVEL);
+    applySkillLevel();
+}
+
+void ChessEngine::setResourceProfile(const EngineResourceProfile& profile)
+{
+    m_resources = profile;
+    applyResourceProfile();
 }
 
 void ChessEngine::setThinkingTime(int milliseconds)
@@ -112,68 +217,448 @@ void ChessEngine::setSearchDepth(int depth)
 
 void ChessEngine::newGame()
 {
-    if (!isEngineRunning()) return;
+    if (!acceptsCommands()) return;
     
+    stopPondering();
     sendCommand("ucinewgame");
     m_currentPosition.clear();
     m_bestMove.clear();
+    m_ponderMove.clear();
 }
 
 void ChessEngine::setPosition(const QString& fen)
 {
-    if (!isEngineRunning()) return;
+    if (!acceptsCommands()) return;
     
     m_currentPosition = fen;
-    sendCommand(QString("position fen %1").arg(fen));
+    m_lastPositionCommand = QString("position fen %1").arg(fen);
+    sendCommand(m_lastPositionCommand);
 }
 
-void ChessEngine::setPositionFromMoves(const QStringList& moves)
+void ChessEngine::setPositionFromMoves(const QStringList& moves, const QString& startFen)
 {
-    if (!isEngineRunning()) return;
+    if (!acceptsCommands()) return;
     
-    if (moves.isEmpty()) {
-        sendCommand("position startpos");
-    } else {
-        sendCommand(QString("position startpos moves %1").arg(moves.join(" ")));
+    m_currentPosition.clear();
+    m_lastPositionCommand = startFen.isEmpty() ? QString("position startpos") : QString("position fen %1").arg(startFen);
+    if (!moves.isEmpty()) {
+        m_lastPositionCommand += QString(" moves %1").arg(moves.join(" "));
     }
+    sendCommand(m_lastPositionCommand);
 }
 
 void ChessEngine::requestMove()
 {
-    if (!isEngineRunning()) return;
+    requestMove(SearchLimits(), PieceColor::None);
+}
+
+void ChessEngine::requestMove(const SearchLimits& clock, PieceColor sideToMove)
+{
+    if (!acceptsCommands()) return;
+    
+    stopAnalysis();
+    m_isThinking = true;
+    m_bestMove.clear();
+    emit thinkingStarted();
+    
+    SearchLimits limits = clock;
+    startSearchTiming(limits, sideToMove);
+    clearAnalysis();
+    sendCommand(goCommand(limits));
+    updateSearchState();
+}
+
+void ChessEngine::requestSearch(const SearchLimits& limits)
+{
+    if (!acceptsCommands()) return;
+    
+    stopAnalysis();
+    m_isThinking = true;
+    m_bestMove.clear();
+    emit thinkingStarted();
+    
+    m_lastSearchClock = limits;
+    m_lastSearchSide = PieceColor::None;
+    m_lastSearchFixed = true;
+    m_timeManager.reset();
+    clearAnalysis();
+    
+    // 快取中已有足夠深的結果：不必搜尋，下一個事件迴圈直接回報
+    bool fixedDepth = limits.depth > 0 && limits.nodes <= 0 && limits.moveTimeMs <= 0 && !limits.infinite;
+    EngineInfo cachedInfo;
+    QString cachedMove;
+    if (fixedDepth && probeEvalCache(cachedInfo, cachedMove) && cachedInfo.depth >= limits.depth) {
+        m_latestInfo[1] = cachedInfo;
+        QString ponderMove = cachedInfo.pvMoves().value(1);
+        QTimer::singleShot(0, this, [this, cachedMove, ponderMove]() {
+            if (m_isThinking) finishSearch(cachedMove, ponderMove);
+        });
+        return;
+    }
+    
+    // 只有固定時間的搜尋才有明確期限可以監控
+    m_watchdogDeadlineMs = (limits.moveTimeMs > 0 && !limits.infinite) ? limits.moveTimeMs : -1;
+    startSearchClocks();
+    
+    sendCommand(goCommand(limits));
+    updateSearchState();
+}
+
+void ChessEngine::startSearchTiming(SearchLimits& limits, PieceColor sideToMove)
+{
+    // 記錄原始棋鐘，引擎重新啟動時用來重新搜尋
+    m_lastSearchClock = limits;
+    m_lastSearchSide = sideToMove;
+    m_lastSearchFixed = false;
+    
+    // 深度限制與難度綁定，無論是否有棋鐘都要傳送
+    limits.depth = m_searchDepth;
+    
+    if (!limits.hasClock(sideToMove)) {
+        // 沒有棋鐘（或引擎方不限時）：使用固定思考時間
+        limits.whiteTimeMs = -1;
+        limits.blackTimeMs = -1;
+        limits.moveTimeMs = m_thinkingTimeMs;
+    }
+    
+    // 有棋鐘時由時間管理器決定軟性/硬性上限
+    m_timeManager.start(limits, sideToMove);
+    
+    // 看門狗：超過搜尋期限一段時間仍沒有 bestmove，視為引擎無回應
+    m_watchdogDeadlineMs = m_timeManager.isActive() ? m_timeManager.hardLimitMs() : limits.moveTimeMs;
+    startSearchClocks();
+}
+
+void ChessEngine::startSearchClocks()
+{
+    // 看門狗同時涵蓋引擎啟動卡住的情況，go 實際送出時重新計時
+    if (m_watchdogDeadlineMs > 0) {
+        m_watchdogTimer->start(m_watchdogDeadlineMs + WATCHDOG_GRACE_MS);
+    }
+    
+    if (isEngineStarting()) {
+        // go 會排隊到 readyok：啟動時間不算進搜尋時間，送出時才開始計時
+        m_searchClock.invalidate();
+        m_searchClocksPending = true;
+        return;
+    }
+    
+    m_searchClocksPending = false;
+    m_searchClock.start();
+    if (m_timeManager.isActive()) {
+        m_hardLimitTimer->start(m_timeManager.hardLimitMs());
+    }
+}
+
+void ChessEngine::setPonderEnabled(bool enabled)
+{
+    if (m_ponderEnabled == enabled) return;
+    
+    m_ponderEnabled = enabled;
+    if (!enabled) {
+        stopPondering();
+    }
+    // 啟動中不必送出，收到 uciok 時會一併設定
+    if (canSetOptions()) {
+        writeOption("Ponder", QString(enabled ? "true" : "false"));
+    }
+}
+
+bool ChessEngine::startPondering(const QStringList& moves, const SearchLimits& clock)
+{
+    if (!m_ponderEnabled || !isEngineRunning()) return false;
+    if (m_isThinking || m_isPondering || m_ponderMove.isEmpty()) return false;
+    
+    // 在預測的對手回應之後的局面上思考
+    QStringList ponderMoves = moves;
+    ponderMoves.append(m_ponderMove);
+    setPositionFromMoves(ponderMoves);
+    
+    SearchLimits limits = clock;
+    limits.ponder = true;
+    limits.depth = m_searchDepth;
+    if (limits.whiteTimeMs <= 0 && limits.blackTimeMs <= 0) {
+        limits.moveTimeMs = m_thinkingTimeMs;
+    }
+    
+    m_isPondering = true;
+    m_ponderResult.clear();
+    clearAnalysis();
+    sendCommand(goCommand(limits));
+    updateSearchState();
+    
+    qDebug() << "[ChessEngine] Pondering on expected reply" << m_ponderMove;
+    return true;
+}
+
+void ChessEngine::ponderHit(const SearchLimits& clock, PieceColor sideToMove)
+{
+    if (!m_isPondering) return;
+    
+    m_isPondering = false;
+    m_ponderHits++;
+    m_ponderSearches++;
+    emit ponderStatsChanged(m_ponderHits, m_ponderSearches);
     
     m_isThinking = true;
     m_bestMove.clear();
     emit thinkingStarted();
     
-    // 使用 movetime 和 depth 限制思考
-    sendCommand(QString("go movetime %1 depth %2").arg(m_thinkingTimeMs).arg(m_searchDepth));
+    if (!m_ponderResult.isEmpty()) {
+        // 預測搜尋已經提前完成（例如達到深度上限），直接使用其結果
+        QString move = m_ponderResult;
+        m_ponderResult.clear();
+        QTimer::singleShot(0, this, [this, move]() {
+            if (m_isThinking) finishSearch(move, QString());
+        });
+        return;
+    }
+    
+    // 從現在開始計時：引擎轉為正常搜尋
+    SearchLimits limits = clock;
+    startSearchTiming(limits, sideToMove);
+    sendCommand("ponderhit");
+}
+
+void ChessEngine::stopPondering()
+{
+    if (!m_isPondering) return;
+    
+    m_isPondering = false;
+    m_ponderSearches++;
+    emit ponderStatsChanged(m_ponderHits, m_ponderSearches);
+    
+    // 中止後引擎仍會回報一個 bestmove，必須忽略
+    if (m_ponderResult.isEmpty()) {
+        m_staleBestMoves++;
+        sendCommand("stop");
+    }
+    m_ponderResult.clear();
+}
+
+void ChessEngine::startAnalysis(const QString& fen, int multiPv)
+{
+    if (!isEngineRunning() || m_isThinking || m_isPondering) return;
+    
+    // 中止前一次分析：不等待其 bestmove，只記錄為需要忽略的輸出，
+    // 因此快速切換局面時引擎最多只會有一個正在進行的搜尋
+    if (m_isAnalyzing) {
+        storeSearchResult();
+        m_staleBestMoves++;
+        sendCommand("stop");
+    }
+    
+    multiPv = qBound(1, multiPv, MAX_MULTI_PV);
+    if (multiPv != m_multiPv) {
+        m_multiPv = multiPv;
+        writeOption("MultiPV", m_multiPv);
+    }
+    
+    m_isAnalyzing = true;
+    m_currentPosition = fen;
+    clearAnalysis();
+    sendCommand(QString("position fen %1").arg(fen));
+    
+    // 先顯示快取中的結果，引擎搜尋到更深時才取代
+    EngineInfo cachedInfo;
+    QString cachedMove;
+    if (probeEvalCache(cachedInfo, cachedMove)) {
+        m_latestInfo[1] = cachedInfo;
+        m_cachedInfoDepth = cachedInfo.depth;
+        m_analysisDirty = true;
+        flushAnalysis();
+    }
+    
+    SearchLimits limits;
+    limits.infinite = true;
+    sendCommand(goCommand(limits));
+    updateSearchState();
+}
+
+void ChessEngine::stopAnalysis()
+{
+    if (!m_isAnalyzing) return;
+    
+    storeSearchResult();
+    m_isAnalyzing = false;
+    m_staleBestMoves++;
+    sendCommand("stop");
+    clearAnalysis();
 }
 
 void ChessEngine::stop()
 {
+    m_hardLimitTimer->stop();
+    m_watchdogTimer->stop();
+    m_searchClocksPending = false;
+    m_timeManager.reset();
+    stopPondering();
+    
     if (m_isThinking && m_process) {
         sendCommand("stop");
     }
 }
 
+void ChessEngine::onHardLimitReached()
+{
+    // 引擎超過硬性上限仍未回應：強制停止，避免超時判負
+    if (m_isThinking) {
+        qDebug() << "[ChessEngine] Hard time limit reached after" << m_searchClock.elapsed() << "ms, stopping search";
+        sendCommand("stop");
+    }
+    m_timeManager.reset();
+}
+
+void ChessEngine::onWatchdogTimeout()
+{
+    if (!m_isThinking) return;
+    
+    if (m_searchClocksPending) {
+        qWarning() << "[ChessEngine] Engine never became ready for the queued search, engine is not responding";
+    } else {
+        qWarning() << "[ChessEngine] No bestmove" << m_searchClock.elapsed() << "ms after go, engine is not responding";
+    }
+    recoverEngine("engine hang");
+}
+
+void ChessEngine::recoverEngine(const QString& reason)
+{
+    if (m_enginePath.isEmpty()) return;
+    
+    bool wasThinking = m_isThinking;
+    
+    if (m_lastRestartClock.isValid() && m_lastRestartClock.elapsed() > RESTART_WINDOW_MS) {
+        m_consecutiveRestarts = 0;
+    }
+    
+    if (m_consecutiveRestarts >= MAX_CONSECUTIVE_RESTARTS) {
+        // 引擎每次重新啟動都無法完成搜尋：放棄並通知呼叫端
+        qWarning() << "[ChessEngine] Giving up after" << m_consecutiveRestarts << "consecutive restarts";
+        m_recovering = false;
+        m_resumeSearch = false;
+        m_resumeAnalysisFen.clear();
+        stopEngine();
+        if (wasThinking) emit thinkingStopped();
+        emit engineError(QString("引擎多次重新啟動仍無法運作（%1）").arg(reason));
+        return;
+    }
+    
+    // 記錄需要恢復的狀態（預測思考直接放棄，由 GUI 重新要求走法）
+    m_resumeSearch = wasThinking || m_resumeSearch;
+    if (m_isAnalyzing) {
+        m_resumeAnalysisFen = m_currentPosition;
+        m_resumeMultiPv = m_multiPv;
+    }
+    if (!m_recovering) {
+        m_recovering = true;
+        m_downtimeClock.start();
+    }
+    m_restartCount++;
+    m_consecutiveRestarts++;
+    m_lastRestartClock.start();
+    
+    qWarning() << "[ChessEngine] Restarting engine after" << reason << "(restart" << m_restartCount << ")";
+    
+    // 當掉或無回應的行程不等待 quit，直接終止
+    if (m_process) {
+        m_process->kill();
+    }
+    stopEngine();
+    
+    // 搜尋仍在進行中（對 GUI 而言），就緒後重送 position 和 go
+    m_isThinking = m_resumeSearch;
+    startEngine(m_enginePath);
+}
+
+void ChessEngine::resumeAfterRestart()
+{
+    m_recovering = false;
+    qint64 downtime = m_downtimeClock.elapsed();
+    m_totalDowntimeMs += downtime;
+    qDebug() << "[ChessEngine] Engine recovered after" << downtime << "ms, total restarts:" << m_restartCount;
+    
+    if (m_resumeSearch) {
+        m_resumeSearch = false;
+        m_isThinking = false;
+        if (!m_lastPositionCommand.isEmpty()) {
+            sendCommand(m_lastPositionCommand);
+        }
+        
+        if (m_lastSearchFixed) {
+            requestSearch(m_lastSearchClock);
+            emit engineRestarted(m_restartCount, downtime);
+            return;
+        }
+        
+        // 扣除崩潰前已經使用的時間
+        SearchLimits clock = m_lastSearchClock;
+        qint64 used = m_searchClock.isValid() ? m_searchClock.elapsed() : 0;
+        if (m_lastSearchSide == PieceColor::White && clock.whiteTimeMs > 0) {
+            clock.whiteTimeMs = static_cast<int>(qMax<qint64>(1, clock.whiteTimeMs - used));
+        } else if (m_lastSearchSide == PieceColor::Black && clock.blackTimeMs > 0) {
+            clock.blackTimeMs = static_cast<int>(qMax<qint64>(1, clock.blackTimeMs - used));
+        }
+        requestMove(clock, m_lastSearchSide);
+    } else if (!m_resumeAnalysisFen.isEmpty()) {
+        QString fen = m_resumeAnalysisFen;
+        m_resumeAnalysisFen.clear();
+        startAnalysis(fen, m_resumeMultiPv);
+    }
+    
+    emit engineRestarted(m_restartCount, downtime);
+}
+
 void ChessEngine::sendCommand(const QString& command)
+{
+    if (isEngineStarting()) {
+        // 引擎尚未就緒：排隊，收到 readyok 後依序送出
+        m_pendingCommands.append(command);
+        return;
+    }
+    if (isEngineRunning()) {
+        writeCommand(command);
+    }
+}
+
+void ChessEngine::writeCommand(const QString& command)
 {
     if (m_process && m_process->state() == QProcess::Running) {
-        QString cmd = command + "\n";
-        m_process->write(cmd.toUtf8());
-        m_process->waitForBytesWritten(100);
+        // QProcess 會在事件迴圈中寫出緩衝資料，不需要等待
+        m_process->write((command + "\n").toUtf8());
     }
 }
 
+void ChessEngine::onEngineStarted()
+{
+    qDebug() << "[ChessEngine] Engine process started, initializing UCI";
+    
+    // 初始化 UCI 協議
+    writeCommand("uci");
+}
+
 void ChessEngine::onReadyReadStandardOutput()
 {
     if (!m_process) return;
     
-    while (m_process->canReadLine()) {
-        QString line = QString::fromUtf8(m_process->readLine()).trimmed();
-        parseOutput(line);
+    // 直接在位元組緩衝區上切行，不轉換為 QString
+    m_readBuffer.append(m_process->readAllStandardOutput());
+    int lastNewline = m_readBuffer.lastIndexOf('\n');
+    if (lastNewline < 0) return;
+    
+    QByteArray lines = m_readBuffer.left(lastNewline + 1);
+    m_readBuffer.remove(0, lastNewline + 1);
+    
+    const char* data = lines.constData();
+    int lineStart = 0;
+    for (int i = 0; i < lines.size(); ++i) {
+        if (data[i] == '\n') {
+            parseOutput(data + lineStart, i - lineStart);
+            lineStart = i + 1;
+        }
     }
+    
+    // bestmove 可能結束了搜尋
+    updateSearchState();
 }
 
 void ChessEngine::onReadyReadStandardError()
@@ -191,8 +676,28 @@ void ChessEngine::onEngineFinished(int exitCode, QProcess::ExitStatus exitStatus
     Q_UNUSED(exitCode);
     Q_UNUSED(exitStatus);
     
-    m_isReady = false;
+    qDebug() << "[ChessEngine] Engine process exited unexpectedly";
+    
+    // 行程自行結束（正常的 stopEngine 已先與行程脫鉤，不會進入這裡）：重新啟動並恢復
+    if (!m_enginePath.isEmpty()) {
+        recoverEngine("engine exited");
+        return;
+    }
+    
+    if (m_process) {
+        m_process->deleteLater();
+        m_process = nullptr;
+    }
+    
+    m_hardLimitTimer->stop();
+    m_watchdogTimer->stop();
+    m_searchClocksPending = false;
+    m_pendingCommands.clear();
     m_isThinking = false;
+    m_isPondering = false;
+    m_isAnalyzing = false;
+    m_staleBestMoves = 0;
+    setState(EngineState::Stopped);
 }
 
 void ChessEngine::onEngineError(QProcess::ProcessError error)
@@ -219,52 +724,311 @@ void ChessEngine::onEngineError(QProcess::ProcessError error)
             break;
     }
     
-    emit engineError(errorMsg);
-    m_isReady = false;
+    if (error == QProcess::Crashed) {
+        // 崩潰後會收到 finished 信號，由監控機制重新啟動並恢復
+        qWarning() << "[ChessEngine]" << errorMsg;
+        return;
+    }
+    
+    // 無法啟動時不會收到 finished 信號，在此釋放行程
+    if (error == QProcess::FailedToStart && m_process) {
+        m_process->deleteLater();
+        m_process = nullptr;
+        m_pendingCommands.clear();
+        m_watchdogTimer->stop();
+        m_searchClocksPending = false;
+        m_recovering = false;
+        m_resumeSearch = false;
+        m_resumeAnalysisFen.clear();
+        setState(EngineState::Stopped);
+        if (m_isThinking) emit thinkingStopped();
+        m_staleBestMoves = 0;
+    } else if (m_process && (m_isThinking || m_isPondering || m_isAnalyzing)) {
+        // 行程仍在執行：中止進行中的搜尋，稍後回報的 bestmove 直接捨棄
+        m_hardLimitTimer->stop();
+        m_watchdogTimer->stop();
+        m_searchClocksPending = false;
+        m_timeManager.reset();
+        m_staleBestMoves++;
+        sendCommand("stop");
+    }
+    
+    // 先清除搜尋狀態再通知，呼叫端可以在信號中立即開始新的搜尋
     m_isThinking = false;
+    m_isPondering = false;
+    m_isAnalyzing = false;
+    emit engineError(errorMsg);
 }
 
-void ChessEngine::parseOutput(const QString& line)
+void ChessEngine::parseOutput(const char* data, int size)
 {
-    if (line.isEmpty()) return;
+    UciTokenizer tokens(data, size);
+    UciToken command = tokens.next();
+    if (command.isEmpty()) return;
     
-    // UCI 協議回應
-    if (line == "uciok") {
+    // info 是最頻繁的輸出，優先處理
+    if (command == "info") {
+        handleInfoLine(data, size);
+    }
+    else if (command == "option") {
+        // 記錄引擎宣告的選項，uciok 時依此設定
+        UciOption option;
+        if (UciOption::parse(data, size, option)) {
+            m_options.add(option);
+        }
+    }
+    else if (command == "uciok") {
         // UCI 初始化完成，配置引擎
+        setState(EngineState::UciOk);
         configureEngine();
-        sendCommand("isready");
+        writeCommand("isready");
     }
-    else if (line == "readyok") {
-        m_isReady = true;
+    else if (command == "readyok") {
+        if (m_state != EngineState::UciOk) return;
+        
+        // 送出就緒前排隊的命令
+        setState(EngineState::Ready);
+        const QStringList pending = m_pendingCommands;
+        m_pendingCommands.clear();
+        for (const QString& pendingCommand : pending) {
+            writeCommand(pendingCommand);
+            if (m_searchClocksPending && pendingCommand.startsWith("go")) {
+                startSearchClocks();
+            }
+        }
+        updateSearchState();
+        
+        m_startupLatencyMs = m_startupClock.elapsed();
+        qDebug() << "[ChessEngine] Engine ready" << m_startupLatencyMs << "ms after launch";
+        if (m_recovering) {
+            resumeAfterRestart();
+        }
         emit engineReady();
     }
-    else if (line.startsWith("bestmove")) {
+    else if (command == "bestmove") {
         // 解析最佳走法
-        QStringList parts = line.split(' ', Qt::SkipEmptyParts);
-        if (parts.size() >= 2) {
-            m_bestMove = parts[1];
-            m_isThinking = false;
-            emit thinkingStopped();
-            emit bestMoveFound(m_bestMove);
+        UciToken move = tokens.next();
+        if (move.isEmpty()) return;
+        
+        if (m_staleBestMoves > 0) {
+            // 已中止的預測搜尋結果
+            m_staleBestMoves--;
+            return;
         }
+        if (m_isPondering) {
+            // 預測搜尋提前結束：暫存結果，等待 ponderhit 或 stop
+            m_ponderResult = move.toString();
+            return;
+        }
+        if (m_isAnalyzing) {
+            // 分析自行結束（例如局面已將死或達到最大深度），保留最後的變例
+            storeSearchResult();
+            m_isAnalyzing = false;
+            flushAnalysis();
+            return;
+        }
+        
+        QString ponderMove;
+        if (tokens.next() == "ponder") {
+            ponderMove = tokens.next().toString();
+        }
+        storeSearchResult();
+        flushAnalysis();
+        finishSearch(move.toString(), ponderMove);
     }
-    // 可以添加更多解析，如 info 資訊用於顯示引擎思考
+}
+
+void ChessEngine::finishSearch(const QString& bestMove, const QString& ponderMove)
+{
+    m_hardLimitTimer->stop();
+    m_watchdogTimer->stop();
+    m_searchClocksPending = false;
+    m_consecutiveRestarts = 0;
+    m_timeManager.reset();
+    m_bestMove = bestMove;
+    m_ponderMove = ponderMove;
+    m_isThinking = false;
+    updateSearchState();
+    emit thinkingStopped();
+    emit bestMoveFound(m_bestMove);
+}
+
+void ChessEngine::handleInfoLine(const char* data, int size)
+{
+    // 正在被中止的搜尋輸出沒有意義
+    if (m_staleBestMoves > 0) return;
+    
+    EngineInfo info;
+    if (!EngineInfo::parse(data, size, info)) return;
+    
+    bool isBound = info.lowerBound || info.upperBound;
+    
+    // 時間管理需要每一個完整迭代的結果（不受節流影響）
+    if (m_isThinking && m_timeManager.isActive() && info.multiPv == 1 && !isBound) {
+        if (m_timeManager.onIteration(info.depth, info.comparableScore(), info.bestMove(), m_searchClock.elapsed())) {
+            qDebug() << "[ChessEngine] Time manager stopping search at depth" << info.depth
+                     << "after" << m_searchClock.elapsed() << "ms";
+            m_hardLimitTimer->stop();
+            m_timeManager.reset();
+            sendCommand("stop");
+        }
+    }
+    
+    // 引擎還沒搜尋到快取結果的深度前，保留快取的主要變例
+    if (info.multiPv == 1 && info.depth < m_cachedInfoDepth) return;
+    
+    // 暫存每條變例的最新結果，由節流計時器合併後再通知 GUI
+    m_latestInfo[info.multiPv] = info;
+    m_analysisDirty = true;
+    
+    if (!m_analysisTimer->isActive()) {
+        qint64 sinceLast = m_lastAnalysisEmit.isValid() ? m_lastAnalysisEmit.elapsed() : m_analysisIntervalMs;
+        if (sinceLast >= m_analysisIntervalMs) {
+            flushAnalysis();
+        } else {
+            m_analysisTimer->start(static_cast<int>(m_analysisIntervalMs - sinceLast));
+        }
+    }
+}
+
+void ChessEngine::flushAnalysis()
+{
+    m_analysisTimer->stop();
+    if (!m_analysisDirty) return;
+    
+    m_analysisDirty = false;
+    m_lastAnalysisEmit.start();
+    
+    QVector<EngineInfo> lines;
+    lines.reserve(m_latestInfo.size());
+    for (auto it = m_latestInfo.constBegin(); it != m_latestInfo.constEnd(); ++it) {
+        lines.append(it.value());
+    }
+    emit analysisUpdated(lines);
+}
+
+void ChessEngine::clearAnalysis()
+{
+    m_analysisTimer->stop();
+    m_latestInfo.clear();
+    m_analysisDirty = false;
+    m_cachedInfoDepth = 0;
+}
+
+void ChessEngine::setAnalysisUpdateRate(int hz)
+{
+    m_analysisIntervalMs = 1000 / qBound(1, hz, 60);
+}
+
+bool ChessEngine::usesEvalCache() const
+{
+    // 降低棋力時的走法不代表局面的真正評價，以移動列表設定的局面也沒有 FEN 可以查詢
+    return m_evalCache && m_skillLevel >= MAX_SKILL_LEVEL && !m_currentPosition.isEmpty();
+}
+
+bool ChessEngine::probeEvalCache(EngineInfo& info, QString& bestMove)
+{
+    if (!usesEvalCache()) return false;
+    
+    EvalCacheEntry entry;
+    if (!m_evalCache->probe(m_currentPosition, entry)) return false;
+    
+    info = EngineInfo();
+    info.depth = entry.depth;
+    info.multiPv = 1;
+    info.hasScore = true;
+    info.scoreCp = entry.scoreCp;
+    info.mateIn = entry.mateIn;
+    info.pv = (entry.pv.isEmpty() ? QStringList(entry.bestMove) : entry.pv).join(' ').toLatin1();
+    bestMove = entry.bestMove;
+    return true;
+}
+
+void ChessEngine::storeSearchResult()
+{
+    if (!usesEvalCache()) return;
+    
+    // 只保存完整迭代的主要變例（邊界分數不是準確評分）
+    EngineInfo info = m_latestInfo.value(1);
+    if (!info.hasScore || info.lowerBound || info.upperBound || info.depth <= 0 || info.depth <= m_cachedInfoDepth) return;
+    
+    QStringList pv = info.pvMoves();
+    if (pv.isEmpty()) return;
+    
+    EvalCacheEntry entry;
+    entry.depth = info.depth;
+    entry.scoreCp = info.scoreCp;
+    entry.mateIn = info.mateIn;
+    entry.bestMove = pv.first();
+    entry.pv = pv;
+    m_evalCache->store(m_currentPosition, entry);
+}
+
+EngineInfo ChessEngine::getLastInfo() const
+{
+    return m_latestInfo.value(1);
 }
 
 void ChessEngine::configureEngine()
 {
-    if (!m_process || m_process->state() != QProcess::Running) return;
+    if (!canSetOptions()) return;
+    
+    qDebug() << "[ChessEngine] Engine advertises" << m_options.size() << "options";
+    
+    applyResourceProfile();
+    applySkillLevel();
     
-    // 設定 Stockfish 的技能等級（1-20）
-    // 注意：此選項名稱為 Stockfish 專用，其他引擎可能使用不同名稱
-    sendCommand(QString("setoption name Skill Level value %1").arg(m_skillLevel));
+    // 預測思考（Ponder）依使用者設定開啟
+    writeOption("Ponder", QString(m_ponderEnabled ? "true" : "false"));
+}
+
+void ChessEngine::applySkillLevel()
+{
+    if (!canSetOptions()) return;
     
-    // 設定較小的 hash 表（16MB）以節省記憶體
-    // 對於休閒遊戲來說足夠，同時不會佔用太多系統資源
-    sendCommand("setoption name Hash value 16");
+    if (m_options.has("Skill Level")) {
+        // Stockfish 的技能等級（0-20）
+        writeOption("Skill Level", m_skillLevel);
+    } else if (m_options.has("UCI_LimitStrength") && m_options.has("UCI_Elo")) {
+        // 其他引擎以標準的 ELO 限制強度；最高等級不限制
+        bool limitStrength = m_skillLevel < MAX_SKILL_LEVEL;
+        writeOption("UCI_LimitStrength", QString(limitStrength ? "true" : "false"));
+        if (limitStrength) {
+            writeOption("UCI_Elo", skillToElo(m_skillLevel));
+        }
+    } else {
+        qDebug() << "[ChessEngine] Engine has no strength option, skill level ignored";
+    }
+}
+
+void ChessEngine::applyResourceProfile()
+{
+    if (!canSetOptions()) return;
     
-    // 禁用 Ponder（預測對手走法）以簡化遊戲體驗
-    sendCommand("setoption name Ponder value false");
+    // 數值會被限制在引擎宣告的範圍內；不支援的選項不會送出
+    writeOption("Threads", m_resources.threads);
+    writeOption("Hash", m_resources.hashMb);
+}
+
+bool ChessEngine::canSetOptions() const
+{
+    // 收到 uciok 後選項表才完整
+    return m_process && (m_state == EngineState::UciOk || m_state == EngineState::Ready ||
+                         m_state == EngineState::Searching);
+}
+
+void ChessEngine::writeOption(const QString& name, const QString& value)
+{
+    // 選項必須在 isready 之前送達，因此直接寫入而不排隊
+    QString command = m_options.setOptionCommand(name, value);
+    if (!command.isEmpty()) {
+        writeCommand(command);
+    }
+}
+
+void ChessEngine::writeOption(const QString& name, int value)
+{
+    writeOption(name, QString::number(value));
 }
 
 // 靜態工具函數
@@ -385,6 +1149,29 @@ QString ChessEngine::moveToUCI(const QPoint& from, const QPoint& to, PieceType p
     return uci;
 }
 
+QString ChessEngine::goCommand(const SearchLimits& limits)
+{
+    QString command = limits.ponder ? "go ponder" : "go";
+    if (limits.infinite) {
+        return command + " infinite";
+    }
+    
+    if (limits.whiteTimeMs > 0) {
+        command += QString(" wtime %1").arg(limits.whiteTimeMs);
+        if (limits.whiteIncrementMs > 0) command += QString(" winc %1").arg(limits.whiteIncrementMs);
+    }
+    if (limits.blackTimeMs > 0) {
+        command += QString(" btime %1").arg(limits.blackTimeMs);
+        if (limits.blackIncrementMs > 0) command += QString(" binc %1").arg(limits.blackIncrementMs);
+    }
+    if (limits.movesToGo > 0) command += QString(" movestogo %1").arg(limits.movesToGo);
+    if (limits.moveTimeMs > 0) command += QString(" movetime %1").arg(limits.moveTimeMs);
+    if (limits.depth > 0) command += QString(" depth %1").arg(limits.depth);
+    if (limits.nodes > 0) command += QString(" nodes %1").arg(limits.nodes);
+    
+    return command;
+}
+
 void ChessEngine::uciToMove(const QString& uci, QPoint& from, QPoint& to, PieceType& promotionType)
 {
     if (uci.length() < 4) {
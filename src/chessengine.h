@@ -6,7 +6,15 @@
 #include <QString>
 #include <QPoint>
 #include <QTimer>
+#include <QElapsedTimer>
 #include "chesspiece.h"
+#include <QVector>
+#include <QMap>
+#include "timemanager.h"
+#include "uciprotocol.h"
+#include "ucioptions.h"
+#include "engineresources.h"
+#include "evalcache.h"
 
 class ChessBoard;
 
@@ -19,6 +27,25 @@ enum class EngineDifficulty {
     VeryHard = 20   // 等級 20 - 非常困難
 };
 
+// 技能等級（0-20）對應的 ELO：介面顯示與不支援 Skill Level 的引擎（UCI_Elo）共用同一個對照
+constexpr int SKILL_ELO_BASE = 250;         // 技能等級 0 對應的 ELO
+constexpr int SKILL_ELO_PER_LEVEL = 150;    // 每級增加的 ELO（確保結果能被50整除）
+
+constexpr int skillToElo(int skillLevel)
+{
+    return SKILL_ELO_BASE + skillLevel * SKILL_ELO_PER_LEVEL;
+}
+
+// 引擎行程狀態
+enum class EngineState {
+    Stopped,    // 沒有引擎行程
+    Starting,   // 行程啟動中，等待 uciok
+    UciOk,      // 已收到 uciok，等待 readyok
+    Ready,      // 可以接受搜尋
+    Searching,  // 搜尋中（包含預測思考、分析和等待被中止搜尋的 bestmove）
+    Stopping    // 已送出 quit，等待行程結束
+};
+
 // 遊戲模式
 enum class GameMode {
     HumanVsHuman,       // 雙人對弈
@@ -35,10 +62,18 @@ public:
     explicit ChessEngine(QObject *parent = nullptr);
     ~ChessEngine();
 
-    // 引擎控制
-    bool startEngine(const QString& enginePath);
+    // 引擎控制（非阻塞：結果以 engineReady / engineError / stateChanged 信號通知）
+    bool startEngine(const QString& enginePath);  // 返回 false 表示無法開始啟動（例如檔案不存在）
     void stopEngine();
-    bool isEngineRunning() const;
+    bool isEngineRunning() const;   // 已就緒，可以搜尋
+    bool isEngineStarting() const;  // 啟動中，送出的命令會排隊到就緒後才傳送
+    EngineState getState() const { return m_state; }
+    qint64 getStartupLatencyMs() const { return m_startupLatencyMs; }  // 最近一次從啟動到 readyok 的時間（-1 表示尚未就緒）
+    
+    // 監控：引擎崩潰或搜尋超過期限未回應時自動重新啟動，並恢復局面和進行中的搜尋
+    int getRestartCount() const { return m_restartCount; }
+    qint64 getTotalDowntimeMs() const { return m_totalDowntimeMs; }  // 所有重新啟動累計無法使用的時間
+    bool isThinking() const { return m_isThinking; }
 
     // 遊戲模式和難度設定
     void setGameMode(GameMode mode);
@@ -52,52 +87,163 @@ public:
     
     void setSearchDepth(int depth);  // 設定搜尋深度（1-30）
     int getSearchDepth() const { return m_searchDepth; }
+    
+    // 引擎選項與資源
+    const UciOptionRegistry& getOptions() const { return m_options; }  // 引擎宣告的選項（收到 uciok 後完整）
+    void setResourceProfile(const EngineResourceProfile& profile);
+    EngineResourceProfile getResourceProfile() const { return m_resources; }
+    
+    // 評分快取：完整棋力時，以 FEN 設定的局面在搜尋前先查快取，搜尋完成後寫回（nullptr 表示不使用）
+    void setEvalCache(EvalCache* cache) { m_evalCache = cache; }
 
     // 棋局控制
     void newGame();
     void setPosition(const QString& fen);
-    void setPositionFromMoves(const QStringList& moves);
+    void setPositionFromMoves(const QStringList& moves, const QString& startFen = QString());  // startFen 為空時從初始局面開始
     void requestMove();
+    void requestMove(const SearchLimits& clock, PieceColor sideToMove);  // 依據棋鐘思考（wtime/btime/winc/binc）
+    void requestSearch(const SearchLimits& limits);  // 依照指定限制搜尋（不套用難度的深度和時間設定，用於分析）
     void stop();
 
+    // 預測思考（Ponder）：在玩家思考時搜尋預測的對手回應
+    void setPonderEnabled(bool enabled);
+    bool isPonderEnabled() const { return m_ponderEnabled; }
+    bool startPondering(const QStringList& moves, const SearchLimits& clock);  // moves 為引擎走完後的移動歷史
+    void ponderHit(const SearchLimits& clock, PieceColor sideToMove);          // 玩家走了預測的棋
+    void stopPondering();                                                      // 玩家走了其他棋，放棄預測搜尋
+    bool isPondering() const { return m_isPondering; }
+    QString getPonderMove() const { return m_ponderMove; }
+    int getPonderHits() const { return m_ponderHits; }
+    int getPonderSearches() const { return m_ponderSearches; }
+
+    // 分析模式：在任意局面上無限思考（go infinite），持續回報多條變例
+    void startAnalysis(const QString& fen, int multiPv = 1);  // 重複呼叫會中止前一次分析並改為新局面
+    void stopAnalysis();
+    bool isAnalyzing() const { return m_isAnalyzing; }
+
     // UCI 相關
     QString getBestMove() const { return m_bestMove; }
+    EngineInfo getLastInfo() const;           // 最近一次的主要變例搜尋資訊
+    void setAnalysisUpdateRate(int hz);       // analysisUpdated 信號的最高頻率（次/秒）
 
     // 工具函數 - 將棋盤狀態轉換為 FEN 格式
     static QString boardToFEN(const ChessBoard& board);
     static QString moveToUCI(const QPoint& from, const QPoint& to, PieceType promotionType = PieceType::None);
     static void uciToMove(const QString& uci, QPoint& from, QPoint& to, PieceType& promotionType);
+    static QString goCommand(const SearchLimits& limits);
 
 signals:
     void engineReady();
+    void stateChanged(EngineState state);
+    void engineRestarted(int restartCount, qint64 downtimeMs);  // 重新啟動並恢復完成
     void bestMoveFound(const QString& move);
     void engineError(const QString& error);
     void thinkingStarted();
     void thinkingStopped();
+    void ponderStatsChanged(int hits, int total);  // 預測命中次數／預測總次數
+    void analysisUpdated(const QVector<EngineInfo>& lines);  // 搜尋資訊（已節流，依 multipv 排序）
 
 private slots:
+    void onEngineStarted();
     void onReadyReadStandardOutput();
     void onReadyReadStandardError();
     void onEngineFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onEngineError(QProcess::ProcessError error);
+    void onHardLimitReached();
+    void onWatchdogTimeout();
+    void flushAnalysis();
 
 private:
     QProcess* m_process;
     QString m_enginePath;
     QString m_bestMove;
-    QString m_currentPosition;  // 當前 FEN 或移動列表
+    QString m_currentPosition;  // 當前 FEN（以移動列表設定局面時為空）
     
     GameMode m_gameMode;
     int m_skillLevel;           // 0-20
     int m_thinkingTimeMs;       // 思考時間（毫秒）
     int m_searchDepth;          // 搜尋深度（1-30）
     
-    bool m_isReady;
+    EngineState m_state;
+    QStringList m_pendingCommands;  // 引擎就緒前送出的命令
+    QElapsedTimer m_startupClock;   // 從啟動行程開始計時
+    qint64 m_startupLatencyMs;
     bool m_isThinking;
     
-    void sendCommand(const QString& command);
-    void parseOutput(const QString& line);
+    // 預測思考
+    bool m_ponderEnabled;
+    bool m_isPondering;
+    QString m_ponderMove;           // 引擎預測的對手回應（來自 bestmove ... ponder X）
+    QString m_ponderResult;         // 預測搜尋提前結束時暫存的最佳走法
+    int m_staleBestMoves;           // 已被 stop 中止、需要忽略的 bestmove 數量
+    int m_ponderHits;
+    int m_ponderSearches;
+    
+    // 引擎選項
+    UciOptionRegistry m_options;
+    EngineResourceProfile m_resources;
+    
+    // 分析模式
+    bool m_isAnalyzing;
+    int m_multiPv;                  // 目前已設定給引擎的 MultiPV 數量
+    
+    // 時間管理
+    TimeManager m_timeManager;
+    QElapsedTimer m_searchClock;    // 本次搜尋已經過的時間
+    QTimer* m_hardLimitTimer;       // 硬性時間上限到達時強制停止
+    
+    // 監控與恢復
+    QTimer* m_watchdogTimer;        // 搜尋超過期限仍無 bestmove 時視為無回應
+    QString m_lastPositionCommand;  // 最近送出的 position 命令（重新啟動後重送）
+    SearchLimits m_lastSearchClock; // 最近一次搜尋的棋鐘（重新啟動後重新搜尋）
+    PieceColor m_lastSearchSide;
+    bool m_lastSearchFixed;         // 最近一次搜尋是否來自 requestSearch
+    int m_watchdogDeadlineMs;       // 本次搜尋的期限（-1 表示不監控）
+    bool m_searchClocksPending;     // go 仍在排隊，尚未開始計時
+    bool m_recovering;              // 重新啟動中，就緒後需要恢復狀態
+    bool m_resumeSearch;
+    QString m_resumeAnalysisFen;    // 重新啟動前正在分析的局面
+    int m_resumeMultiPv;
+    int m_restartCount;
+    int m_consecutiveRestarts;      // 沒有成功搜尋結果的連續重新啟動次數
+    qint64 m_totalDowntimeMs;
+    QElapsedTimer m_downtimeClock;
+    QElapsedTimer m_lastRestartClock;
+    
+    // 搜尋資訊解析與節流
+    QByteArray m_readBuffer;        // 尚未讀到換行的引擎輸出
+    QMap<int, EngineInfo> m_latestInfo;  // 每條變例（multipv）的最新資訊
+    QTimer* m_analysisTimer;
+    QElapsedTimer m_lastAnalysisEmit;
+    int m_analysisIntervalMs;
+    bool m_analysisDirty;
+    
+    // 評分快取
+    EvalCache* m_evalCache;
+    int m_cachedInfoDepth;          // 分析開始時從快取顯示的深度，引擎追上之前不覆蓋
+    
+    void sendCommand(const QString& command);   // 就緒前排隊，就緒後直接寫入
+    void writeCommand(const QString& command);  // 直接寫入引擎（不等待寫入完成）
+    void setState(EngineState state);
+    void updateSearchState();
+    bool acceptsCommands() const;
+    void parseOutput(const char* data, int size);
+    void handleInfoLine(const char* data, int size);
+    void clearAnalysis();
+    void startSearchTiming(SearchLimits& limits, PieceColor sideToMove);
+    void startSearchClocks();       // go 送出時開始計時（引擎尚未就緒時延到 readyok）
+    void finishSearch(const QString& bestMove, const QString& ponderMove);
+    bool usesEvalCache() const;
+    bool probeEvalCache(EngineInfo& info, QString& bestMove);
+    void storeSearchResult();
+    void recoverEngine(const QString& reason);
+    void resumeAfterRestart();
     void configureEngine();
+    void applySkillLevel();
+    void applyResourceProfile();
+    bool canSetOptions() const;
+    void writeOption(const QString& name, const QString& value);
+    void writeOption(const QString& name, int value);
 };
 
 #endif // CHESSENGINE_H
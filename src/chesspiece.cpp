@@ -33,8 +33,9 @@ QString ChessPiece::getSymbol() const {
     }
 }
 
+template <typename Board>
 bool ChessPiece::isValidMove(const QPoint& from, const QPoint& to, 
-                              const std::vector<std::vector<ChessPiece>>& board,
+                              const Board& board,
                               const QPoint& enPassantTarget) const {
     if (from == to) return false;
     
@@ -56,8 +57,9 @@ bool ChessPiece::isValidMove(const QPoint& from, const QPoint& to,
     }
 }
 
+template <typename Board>
 bool ChessPiece::isValidPawnMove(const QPoint& from, const QPoint& to, 
-                                  const std::vector<std::vector<ChessPiece>>& board,
+                                  const Board& board,
                                   const QPoint& enPassantTarget) const {
     int direction = (m_color == PieceColor::White) ? -1 : 1;
     int startRow = (m_color == PieceColor::White) ? 6 : 1;
@@ -95,8 +97,9 @@ bool ChessPiece::isValidPawnMove(const QPoint& from, const QPoint& to,
     return false;
 }
 
+template <typename Board>
 bool ChessPiece::isValidRookMove(const QPoint& from, const QPoint& to, 
-                                  const std::vector<std::vector<ChessPiece>>& board) const {
+                                  const Board& board) const {
     if (from.x() != to.x() && from.y() != to.y()) return false;
     return isPathClear(from, to, board);
 }
@@ -107,14 +110,16 @@ bool ChessPiece::isValidKnightMove(const QPoint& from, const QPoint& to) const {
     return (dx == 2 && dy == 1) || (dx == 1 && dy == 2);
 }
 
+template <typename Board>
 bool ChessPiece::isValidBishopMove(const QPoint& from, const QPoint& to, 
-                                    const std::vector<std::vector<ChessPiece>>& board) const {
+                                    const Board& board) const {
     if (abs(to.x() - from.x()) != abs(to.y() - from.y())) return false;
     return isPathClear(from, to, board);
 }
 
+template <typename Board>
 bool ChessPiece::isValidQueenMove(const QPoint& from, const QPoint& to, 
-                                   const std::vector<std::vector<ChessPiece>>& board) const {
+                                   const Board& board) const {
     return isValidRookMove(from, to, board) || isValidBishopMove(from, to, board);
 }
 
@@ -132,8 +137,9 @@ bool ChessPiece::isValidKingMove(const QPoint& from, const QPoint& to) const {
     return false;
 }
 
+template <typename Board>
 bool ChessPiece::isPathClear(const QPoint& from, const QPoint& to, 
-                              const std::vector<std::vector<ChessPiece>>& board) const {
+                              const Board& board) const {
     int dx = (to.x() > from.x()) ? 1 : (to.x() < from.x()) ? -1 : 0;
     int dy = (to.y() > from.y()) ? 1 : (to.y() < from.y()) ? -1 : 0;
     
@@ -148,3 +154,11 @@ bool ChessPiece::isPathClear(const QPoint& from, const QPoint& to,
     
     return true;
 }
+
+// 棋盤的兩種表示各實例化一次
+template bool ChessPiece::isValidMove(const QPoint& from, const QPoint& to,
+                                      const std::vector<std::vector<ChessPiece>>& board,
+                                      const QPoint& enPassantTarget) const;
+template bool ChessPiece::isValidMove(const QPoint& from, const QPoint& to,
+                                      const PieceGrid& board,
+                                      const QPoint& enPassantTarget) const;
@@ -4,6 +4,7 @@
 #include <QString>
 #include <QPoint>
 #include <vector>
+#include <array>
 
 enum class PieceType {
     None,
@@ -33,8 +34,10 @@ public:
     QString getSymbol() const;
     
     // 檢查移動到目標位置是否有效（基本棋子移動規則）
+    // Board 可以是 ChessBoard 的 std::vector 棋盤或 PieceGrid（在 chesspiece.cpp 明確實例化）
+    template <typename Board>
     bool isValidMove(const QPoint& from, const QPoint& to, 
-                     const std::vector<std::vector<ChessPiece>>& board,
+                     const Board& board,
                      const QPoint& enPassantTarget = QPoint(-1, -1)) const;
     
 private:
@@ -42,20 +45,28 @@ private:
     PieceColor m_color;
     bool m_hasMoved;
     
+    template <typename Board>
     bool isValidPawnMove(const QPoint& from, const QPoint& to, 
-                         const std::vector<std::vector<ChessPiece>>& board,
+                         const Board& board,
                          const QPoint& enPassantTarget) const;
+    template <typename Board>
     bool isValidRookMove(const QPoint& from, const QPoint& to, 
-                         const std::vector<std::vector<ChessPiece>>& board) const;
+                         const Board& board) const;
     bool isValidKnightMove(const QPoint& from, const QPoint& to) const;
+    template <typename Board>
     bool isValidBishopMove(const QPoint& from, const QPoint& to, 
-                           const std::vector<std::vector<ChessPiece>>& board) const;
+                           const Board& board) const;
+    template <typename Board>
     bool isValidQueenMove(const QPoint& from, const QPoint& to, 
-                          const std::vector<std::vector<ChessPiece>>& board) const;
+                          const Board& board) const;
     bool isValidKingMove(const QPoint& from, const QPoint& to) const;
     
+    template <typename Board>
     bool isPathClear(const QPoint& from, const QPoint& to, 
-                     const std::vector<std::vector<ChessPiece>>& board) const;
+                     const Board& board) const;
 };
 
+// 固定大小的棋盤，可以直接放在堆疊上（例如模擬走法時的暫存棋盤）
+using PieceGrid = std::array<std::array<ChessPiece, 8>, 8>;
+
 #endif // CHESSPIECE_H
@@ -0,0 +1,265 @@
+#include "enginepool.h"
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+const int DEFAULT_JOB_DEPTH = 12;      // 工作沒有指定任何限制時使用的搜尋深度
+const int DEFAULT_INFO_UPDATE_HZ = 10;
+}
+
+EnginePool::EnginePool(QObject *parent)
+    : EngineWorkerPool("[EnginePool]", parent)
+    , m_nextJobId(1)
+    , m_nextGroupId(1)
+{
+    setInfoUpdateRate(DEFAULT_INFO_UPDATE_HZ);
+}
+
+EnginePool::~EnginePool()
+{
+    stop();
+}
+
+bool EnginePool::start(const QString& enginePath, int engineCount, int threadsPerEngine)
+{
+    stop();
+
+    if (!startEngines(enginePath, engineCount, threadsPerEngine)) {
+        emit poolError(QString("引擎檔案不存在：%1").arg(enginePath));
+        return false;
+    }
+    return true;
+}
+
+void EnginePool::stop()
+{
+    stopEngines();
+    m_workers.clear();
+    m_queue.clear();
+    m_groups.clear();
+}
+
+void EnginePool::resetWorkers(int count)
+{
+    m_workers.clear();
+    m_workers.resize(count);
+}
+
+bool EnginePool::isIdle() const
+{
+    if (!m_queue.isEmpty()) return false;
+    for (const Worker& worker : m_workers) {
+        if (worker.busy) return false;
+    }
+    return true;
+}
+
+int EnginePool::submit(EngineJob job)
+{
+    job.id = m_nextJobId++;
+
+    // 沒有任何限制的 go 會無限搜尋，工作一定要能結束
+    SearchLimits& limits = job.limits;
+    if (limits.depth <= 0 && limits.nodes <= 0 && limits.moveTimeMs <= 0) {
+        limits.depth = DEFAULT_JOB_DEPTH;
+    }
+    limits.infinite = false;
+    limits.ponder = false;
+
+    enqueue(job);
+    dispatch();
+    return job.id;
+}
+
+int EnginePool::submitGame(const QStringList& moves, const SearchLimits& limits, EngineJobPriority priority)
+{
+    int groupId = m_nextGroupId++;
+    m_groups[groupId].total = moves.size() + 1;
+
+    // 每一步都是獨立的工作，可以同時分派給所有引擎
+    for (int ply = 0; ply <= moves.size(); ++ply) {
+        EngineJob job;
+        job.groupId = groupId;
+        job.ply = ply;
+        job.type = EngineJobType::AnalyseGame;
+        job.priority = priority;
+        job.moves = moves.mid(0, ply);
+        job.limits = limits;
+        submit(job);
+    }
+    return groupId;
+}
+
+void EnginePool::cancel(int jobId)
+{
+    for (int i = 0; i < m_queue.size(); ++i) {
+        if (m_queue[i].id == jobId) {
+            m_queue.removeAt(i);
+            return;
+        }
+    }
+    for (int i = 0; i < m_workers.size(); ++i) {
+        Worker& worker = m_workers[i];
+        if (worker.busy && worker.job.id == jobId) {
+            worker.cancelled = true;
+            engine(i)->stop();
+        }
+    }
+}
+
+void EnginePool::cancelGroup(int groupId)
+{
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [groupId](const EngineJob& job) {
+        return job.groupId == groupId;
+    }), m_queue.end());
+
+    for (int i = 0; i < m_workers.size(); ++i) {
+        Worker& worker = m_workers[i];
+        if (worker.busy && worker.job.groupId == groupId) {
+            worker.cancelled = true;
+            engine(i)->stop();
+        }
+    }
+    m_groups.remove(groupId);
+}
+
+void EnginePool::enqueue(const EngineJob& job, bool atFront)
+{
+    // 依優先順序插入：atFront 時排在同優先順序的最前面（被搶佔的工作）
+    auto position = atFront
+        ? std::find_if(m_queue.begin(), m_queue.end(), [&job](const EngineJob& queued) {
+              return queued.priority <= job.priority;
+          })
+        : std::find_if(m_queue.begin(), m_queue.end(), [&job](const EngineJob& queued) {
+              return queued.priority < job.priority;
+          });
+    m_queue.insert(position, job);
+}
+
+void EnginePool::dispatch()
+{
+    for (int i = 0; i < m_workers.size() && !m_queue.isEmpty(); ++i) {
+        if (m_workers[i].busy || !canDispatch(i)) continue;
+        startJob(i, m_queue.takeFirst());
+    }
+
+    // 仍在等待的互動工作搶佔背景工作（已在中止中的工作會空出一個引擎）
+    int releasing = 0;
+    for (const Worker& worker : m_workers) {
+        if (worker.busy && worker.preempted) releasing++;
+    }
+    for (const EngineJob& job : m_queue) {
+        if (job.priority != EngineJobPriority::Interactive) break;
+        if (releasing > 0) {
+            releasing--;
+            continue;
+        }
+        if (!preemptFor(job)) break;
+    }
+}
+
+void EnginePool::startJob(int workerIndex, const EngineJob& job)
+{
+    Worker& worker = m_workers[workerIndex];
+    worker.job = job;
+    worker.busy = true;
+    worker.preempted = false;
+    worker.cancelled = false;
+
+    if (!job.fen.isEmpty()) {
+        engine(workerIndex)->setPosition(job.fen);
+    } else {
+        engine(workerIndex)->setPositionFromMoves(job.moves);
+    }
+    engine(workerIndex)->requestSearch(job.limits);
+}
+
+bool EnginePool::preemptFor(const EngineJob& job)
+{
+    // 選擇優先順序最低的工作中止
+    int victim = -1;
+    for (int i = 0; i < m_workers.size(); ++i) {
+        const Worker& worker = m_workers[i];
+        if (!worker.busy || worker.preempted || worker.cancelled) continue;
+        if (worker.job.priority >= job.priority) continue;
+        if (victim < 0 || worker.job.priority < m_workers[victim].job.priority) {
+            victim = i;
+        }
+    }
+    if (victim < 0) return false;
+
+    qDebug() << "[EnginePool] Preempting job" << m_workers[victim].job.id << "for job" << job.id;
+    m_workers[victim].preempted = true;
+    engine(victim)->stop();
+    return true;
+}
+
+void EnginePool::onWorkerBestMove(int workerIndex, const QString& move)
+{
+    Worker& worker = m_workers[workerIndex];
+    if (!worker.busy) return;
+
+    EngineJob job = worker.job;
+    worker.busy = false;
+
+    if (worker.preempted) {
+        // 被中止的結果不完整：重新排隊，稍後從頭搜尋
+        worker.preempted = false;
+        enqueue(job, true);
+    } else if (!worker.cancelled) {
+        EngineJobResult result;
+        result.jobId = job.id;
+        result.groupId = job.groupId;
+        result.ply = job.ply;
+        result.fen = job.fen;
+        result.bestMove = move;
+        result.info = engine(workerIndex)->getLastInfo();
+
+        emit jobFinished(result);
+        if (job.groupId > 0) {
+            completeGroupJob(result);
+        }
+    }
+    worker.cancelled = false;
+
+    dispatch();
+}
+
+void EnginePool::releaseJob(int workerIndex)
+{
+    // 進行中的工作交給下一個空出來的引擎
+    Worker& worker = m_workers[workerIndex];
+    if (worker.busy) {
+        worker.busy = false;
+        worker.preempted = false;
+        if (!worker.cancelled) enqueue(worker.job, true);
+    }
+    worker.cancelled = false;
+}
+
+void EnginePool::onWorkerAnalysis(int workerIndex, const QVector<EngineInfo>& lines)
+{
+    const Worker& worker = m_workers[workerIndex];
+    if (worker.busy && !worker.preempted && !worker.cancelled && !lines.isEmpty()) {
+        emit jobInfo(worker.job.id, lines.first());
+    }
+}
+
+void EnginePool::completeGroupJob(const EngineJobResult& result)
+{
+    auto it = m_groups.find(result.groupId);
+    if (it == m_groups.end()) return;
+
+    Group& group = it.value();
+    group.results.append(result);
+    emit groupProgress(result.groupId, group.results.size(), group.total);
+
+    if (group.results.size() >= group.total) {
+        QVector<EngineJobResult> results = group.results;
+        std::sort(results.begin(), results.end(), [](const EngineJobResult& a, const EngineJobResult& b) {
+            return a.ply < b.ply;
+        });
+        m_groups.erase(it);
+        emit gameAnalysed(result.groupId, results);
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef ENGINEPOOL_H
+#define ENGINEPOOL_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QList>
+#include <QMap>
+#include "engineworkerpool.h"
+
+// 引擎工作類型
+enum class EngineJobType {
+    PlayMove,           // 替某一方找出走法（例如提示）
+    AnalysePosition,    // 分析單一局面
+    AnalyseGame         // 分析整盤棋（拆成每一步的局面分析）
+};
+
+// 工作優先順序：較高的優先權可以搶佔正在執行的背景工作
+enum class EngineJobPriority {
+    Background = 0,     // 背景分析（可被搶佔）
+    Normal = 1,
+    Interactive = 2     // 使用者正在等待的工作
+};
+
+// 一個搜尋工作（局面以 FEN 或起始局面加移動列表表示）
+struct EngineJob {
+    int id = 0;
+    int groupId = 0;                // 同一盤棋分析的工作共用群組編號（0 表示不屬於群組）
+    int ply = -1;                   // 在群組中的位置
+    EngineJobType type = EngineJobType::AnalysePosition;
+    EngineJobPriority priority = EngineJobPriority::Normal;
+    QString fen;                    // 非空時使用 position fen
+    QStringList moves;              // fen 為空時使用 position startpos moves ...
+    SearchLimits limits;            // 深度、節點數或固定時間
+};
+
+// 工作結果（評分以該局面的行棋方為準）
+struct EngineJobResult {
+    int jobId = 0;
+    int groupId = 0;
+    int ply = -1;
+    QString fen;
+    QString bestMove;
+    EngineInfo info;                // 最後一次的主要變例資訊
+};
+
+// 引擎池：管理多個引擎行程並以優先佇列分派工作
+// 每個行程使用 threadsPerEngine 個執行緒，預設行程數為核心數 / threadsPerEngine
+class EnginePool : public EngineWorkerPool
+{
+    Q_OBJECT
+
+public:
+    explicit EnginePool(QObject *parent = nullptr);
+    ~EnginePool();
+
+    bool start(const QString& enginePath, int engineCount = 0, int threadsPerEngine = 1);
+    void stop();
+    int pendingJobs() const { return m_queue.size(); }
+    bool isIdle() const;
+
+    // 提交工作，返回工作編號
+    int submit(EngineJob job);
+    // 將整盤棋拆成每一步的局面工作（包含起始局面），返回群組編號
+    int submitGame(const QStringList& moves, const SearchLimits& limits,
+                   EngineJobPriority priority = EngineJobPriority::Background);
+    void cancel(int jobId);
+    void cancelGroup(int groupId);
+
+signals:
+    void jobFinished(const EngineJobResult& result);
+    void jobInfo(int jobId, const EngineInfo& info);     // 搜尋中的主要變例資訊（已節流）
+    void gameAnalysed(int groupId, const QVector<EngineJobResult>& results);  // 依 ply 排序
+    void groupProgress(int groupId, int finished, int total);
+
+private:
+    struct Worker {
+        EngineJob job;
+        bool busy = false;
+        bool preempted = false;     // 已送出 stop，結果需要捨棄並重新排隊
+        bool cancelled = false;     // 已取消，結果直接捨棄
+    };
+
+    struct Group {
+        int total = 0;
+        QVector<EngineJobResult> results;
+    };
+
+    QVector<Worker> m_workers;
+    QList<EngineJob> m_queue;       // 依優先順序排列，同優先順序先進先出
+    QMap<int, Group> m_groups;
+    int m_nextJobId;
+    int m_nextGroupId;
+
+    void enqueue(const EngineJob& job, bool atFront = false);
+    void resetWorkers(int count) override;
+    void dispatch() override;
+    void startJob(int workerIndex, const EngineJob& job);
+    bool preemptFor(const EngineJob& job);
+    void onWorkerBestMove(int workerIndex, const QString& move) override;
+    void releaseJob(int workerIndex) override;
+    void onWorkerAnalysis(int workerIndex, const QVector<EngineInfo>& lines) override;
+    void completeGroupJob(const EngineJobResult& result);
+};
+
+#endif // ENGINEPOOL_H
@@ -0,0 +1,85 @@
+#include "engineresources.h"
+#include <QThread>
+#include <QFile>
+#include <QDebug>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(Q_OS_MACOS)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#endif
+
+namespace {
+const int MAX_THREADS = 8;              // 休閒對弈不需要更多執行緒
+const int MIN_HASH_MB = 16;
+const int MAX_HASH_MB = 1024;
+const int HASH_MEMORY_DIVISOR = 16;     // 置換表最多使用可用記憶體的 1/16
+const int FALLBACK_HASH_MB = 64;        // 無法偵測記憶體時使用的大小
+}
+
+int EngineResourceProfile::detectCoreCount()
+{
+    int cores = QThread::idealThreadCount();
+    return cores > 0 ? cores : 0;
+}
+
+qint64 EngineResourceProfile::detectAvailableMemoryMb()
+{
+#if defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        return static_cast<qint64>(status.ullAvailPhys / (1024 * 1024));
+    }
+    return 0;
+#elif defined(Q_OS_MACOS)
+    // macOS 沒有簡單的可用記憶體查詢，以實體記憶體的一半估計
+    qint64 totalBytes = 0;
+    size_t length = sizeof(totalBytes);
+    if (sysctlbyname("hw.memsize", &totalBytes, &length, nullptr, 0) == 0) {
+        return totalBytes / (1024 * 1024) / 2;
+    }
+    return 0;
+#else
+    // Linux：讀取 /proc/meminfo 的 MemAvailable（單位為 kB）
+    QFile meminfo("/proc/meminfo");
+    if (!meminfo.open(QIODevice::ReadOnly | QIODevice::Text)) return 0;
+    while (!meminfo.atEnd()) {
+        QByteArray line = meminfo.readLine();
+        if (line.startsWith("MemAvailable:")) {
+            QList<QByteArray> fields = line.simplified().split(' ');
+            return fields.size() >= 2 ? fields[1].toLongLong() / 1024 : 0;
+        }
+    }
+    return 0;
+#endif
+}
+
+EngineResourceProfile EngineResourceProfile::detect()
+{
+    EngineResourceProfile profile;
+
+    int cores = detectCoreCount();
+    profile.threads = qBound(1, cores - 1, MAX_THREADS);
+
+    qint64 availableMb = detectAvailableMemoryMb();
+    if (availableMb <= 0) {
+        profile.hashMb = FALLBACK_HASH_MB;
+    } else {
+        // 引擎通常要求 2 的冪次大小
+        qint64 budget = availableMb / HASH_MEMORY_DIVISOR;
+        int hash = MIN_HASH_MB;
+        while (hash * 2 <= budget && hash * 2 <= MAX_HASH_MB) {
+            hash *= 2;
+        }
+        profile.hashMb = hash;
+    }
+
+    qDebug() << "[EngineResourceProfile] Cores:" << cores << "Available memory:" << availableMb << "MB"
+             << "-> Threads" << profile.threads << "Hash" << profile.hashMb << "MB";
+    return profile;
+}
@@ -0,0 +1,21 @@
+#ifndef ENGINERESOURCES_H
+#define ENGINERESOURCES_H
+
+#include <QtGlobal>
+
+// 引擎可使用的硬體資源（對應 UCI 的 Threads 和 Hash 選項）
+struct EngineResourceProfile {
+    int threads = 1;            // 搜尋執行緒數
+    int hashMb = 16;            // 置換表大小（MB）
+
+    // 依據偵測到的核心數和可用記憶體建立設定：
+    // - 保留一個核心給 GUI，最多使用 MAX_THREADS 個執行緒
+    // - 置換表使用可用記憶體的一小部分，取 2 的冪次並限制在上下限之間
+    static EngineResourceProfile detect();
+
+    // 偵測結果（失敗時返回 0）
+    static int detectCoreCount();
+    static qint64 detectAvailableMemoryMb();
+};
+
+#endif // ENGINERESOURCES_H
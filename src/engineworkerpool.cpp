@@ -0,0 +1,107 @@
+#include "engineworkerpool.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <algorithm>
+
+namespace {
+const int MIN_ENGINE_HASH_MB = 16;
+const int ANALYSIS_SKILL_LEVEL = 20;   // 分析使用完整棋力
+}
+
+EngineWorkerPool::EngineWorkerPool(const char* logTag, QObject *parent)
+    : QObject(parent)
+    , m_logTag(logTag)
+    , m_infoUpdateHz(0)
+{
+}
+
+bool EngineWorkerPool::startEngines(const QString& enginePath, int engineCount, int threadsPerEngine)
+{
+    stopEngines();
+
+    if (!QFileInfo::exists(enginePath)) {
+        qWarning() << m_logTag << "Engine not found:" << enginePath;
+        return false;
+    }
+
+    threadsPerEngine = qMax(1, threadsPerEngine);
+    if (engineCount <= 0) {
+        engineCount = qMax(1, EngineResourceProfile::detectCoreCount() / threadsPerEngine);
+    }
+
+    // 所有行程平分可用的置換表記憶體
+    EngineResourceProfile profile = EngineResourceProfile::detect();
+    profile.threads = threadsPerEngine;
+    profile.hashMb = qMax(MIN_ENGINE_HASH_MB, profile.hashMb / engineCount);
+
+    m_engines.resize(engineCount);
+    m_retired.fill(false, engineCount);
+    for (int i = 0; i < engineCount; ++i) {
+        ChessEngine* engine = new ChessEngine(this);
+        engine->setDifficulty(ANALYSIS_SKILL_LEVEL);
+        engine->setResourceProfile(profile);
+        engine->setEvalCache(EvalCache::shared());
+        if (m_infoUpdateHz > 0) {
+            engine->setAnalysisUpdateRate(m_infoUpdateHz);
+        }
+
+        connect(engine, &ChessEngine::engineReady, this, &EngineWorkerPool::dispatch);
+        connect(engine, &ChessEngine::bestMoveFound, this, [this, i](const QString& move) {
+            onWorkerBestMove(i, move);
+        });
+        connect(engine, &ChessEngine::engineError, this, [this, i](const QString& error) {
+            onWorkerError(i, error);
+        });
+        connect(engine, &ChessEngine::analysisUpdated, this, [this, i](const QVector<EngineInfo>& lines) {
+            onWorkerAnalysis(i, lines);
+        });
+
+        m_engines[i] = engine;
+    }
+    // 全部建立後才啟動，子類別在信號到達前已經配置好每個引擎的工作狀態
+    resetWorkers(engineCount);
+    for (ChessEngine* engine : m_engines) {
+        engine->startEngine(enginePath);
+    }
+
+    qDebug() << m_logTag << "Started" << engineCount << "engines with" << threadsPerEngine
+             << "threads and" << profile.hashMb << "MB hash each";
+    return true;
+}
+
+void EngineWorkerPool::stopEngines()
+{
+    for (ChessEngine* engine : m_engines) {
+        engine->disconnect(this);
+        engine->stopEngine();
+        engine->deleteLater();
+    }
+    m_engines.clear();
+    m_retired.clear();
+}
+
+bool EngineWorkerPool::canDispatch(int index) const
+{
+    if (m_retired[index]) return false;
+    return m_engines[index]->isEngineRunning() || m_engines[index]->isEngineStarting();
+}
+
+void EngineWorkerPool::onWorkerAnalysis(int, const QVector<EngineInfo>&)
+{
+}
+
+void EngineWorkerPool::onWorkerError(int index, const QString& error)
+{
+    qWarning() << m_logTag << "Engine" << index << "failed:" << error;
+
+    // 只有監控機制放棄或無法啟動時行程才會停止，其他錯誤只中止了目前的搜尋，引擎繼續使用
+    ChessEngine* failed = m_engines[index];
+    m_retired[index] = !failed->isEngineRunning() && !failed->isEngineStarting();
+    releaseJob(index);
+
+    if (std::all_of(m_retired.cbegin(), m_retired.cend(), [](bool retired) { return retired; })) {
+        emit poolError(error);
+        return;
+    }
+    dispatch();
+}
@@ -0,0 +1,49 @@
+#ifndef ENGINEWORKERPOOL_H
+#define ENGINEWORKERPOOL_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "chessengine.h"
+
+// 引擎池共用的行程管理：啟動多個引擎並平分置換表記憶體、停止，以及引擎錯誤時的淘汰判斷。
+// 工作的排程與結果由子類別（EnginePool、WorkStealingPool）處理
+class EngineWorkerPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    int engineCount() const { return m_engines.size(); }
+    void setInfoUpdateRate(int hz) { m_infoUpdateHz = hz; }  // 分析資訊的最高頻率，需在 start 之前設定（0 表示使用引擎預設值）
+
+signals:
+    void poolError(const QString& error);
+
+protected:
+    EngineWorkerPool(const char* logTag, QObject *parent);
+
+    // 每個行程使用 threadsPerEngine 個執行緒，engineCount <= 0 時為核心數 / threadsPerEngine
+    bool startEngines(const QString& enginePath, int engineCount, int threadsPerEngine);
+    void stopEngines();
+
+    ChessEngine* engine(int index) const { return m_engines[index]; }
+    bool isRetired(int index) const { return m_retired[index]; }
+    bool canDispatch(int index) const;      // 未淘汰，且引擎已就緒或啟動中
+
+    // 子類別的排程
+    virtual void resetWorkers(int count) = 0;  // 引擎建立後、啟動前配置每個引擎的工作狀態
+    virtual void dispatch() = 0;
+    virtual void onWorkerBestMove(int index, const QString& move) = 0;
+    virtual void releaseJob(int index) = 0;  // 引擎錯誤時把進行中的工作放回佇列
+    virtual void onWorkerAnalysis(int index, const QVector<EngineInfo>& lines);
+
+private:
+    const char* m_logTag;
+    QVector<ChessEngine*> m_engines;
+    QVector<bool> m_retired;                // 監控機制已放棄或無法啟動的引擎
+    int m_infoUpdateHz;
+
+    void onWorkerError(int index, const QString& error);
+};
+
+#endif // ENGINEWORKERPOOL_H
@@ -0,0 +1,299 @@
+#include "evalcache.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QStandardPaths>
+#include <cstring>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/file.h>
+#endif
+
+namespace {
+const char CACHE_MAGIC[8] = {'Q', 'C', 'E', 'V', 'A', 'L', '0', '1'};
+const int DEFAULT_CACHE_SIZE_MB = 64;
+const int SLOTS_PER_BUCKET = 4;
+const int AGE_WEIGHT = 4;                  // 淘汰時每舊一個世代相當於少幾層深度
+const int MAX_STORED_DEPTH = 255;
+const int BEST_MOVE_BYTES = 8;
+const int PV_BYTES = 40;
+const int INIT_LOCK_TIMEOUT_MS = 5000;     // 等待其他行程完成開啟的上限，逾時改用私有快取
+
+struct CacheHeader {
+    char magic[8];
+    quint32 bucketCount;
+    quint32 slotsPerBucket;
+    quint8 generation;                     // 每次開啟加一，用來判斷項目多久沒被使用
+    quint8 reserved[47];
+};
+static_assert(sizeof(CacheHeader) == 64, "CacheHeader must stay 64 bytes");
+
+quint64 fnv1a(const void* data, size_t size, quint64 hash = 14695981039346656037ULL)
+{
+    const uchar* bytes = static_cast<const uchar*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 資料檔的使用鎖：開啟快取的行程都持有共享鎖，能取得獨占鎖表示沒有其他行程映射這個檔案。
+// 只在持有初始化鎖檔時呼叫，所以不需要等待
+bool lockInUse(QFile& file, bool exclusive)
+{
+#if defined(Q_OS_WIN)
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()));
+    OVERLAPPED overlapped = {};
+    overlapped.OffsetHigh = 0x7FFFFFFF;    // 鎖在檔案內容以外的位置，不影響映射的讀寫
+    DWORD flags = LOCKFILE_FAIL_IMMEDIATELY | (exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0);
+    return LockFileEx(handle, flags, 0, 1, 0, &overlapped) != 0;
+#else
+    return flock(file.handle(), (exclusive ? LOCK_EX : LOCK_SH) | LOCK_NB) == 0;
+#endif
+}
+
+void unlockInUse(QFile& file)
+{
+#if defined(Q_OS_WIN)
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()));
+    OVERLAPPED overlapped = {};
+    overlapped.OffsetHigh = 0x7FFFFFFF;
+    UnlockFileEx(handle, 0, 1, 0, &overlapped);
+#else
+    flock(file.handle(), LOCK_UN);
+#endif
+}
+
+void copyText(char* dest, int capacity, const QByteArray& text)
+{
+    std::memset(dest, 0, capacity);
+    std::memcpy(dest, text.constData(), qMin(capacity - 1, text.size()));
+}
+}
+
+// 每格 64 位元組；check = 局面雜湊 XOR 內容雜湊
+struct EvalCache::Slot {
+    quint64 check;
+    qint32 scoreCp;
+    qint16 mateIn;
+    quint8 depth;                          // 0 表示空格
+    quint8 generation;
+    char bestMove[BEST_MOVE_BYTES];
+    char pv[PV_BYTES];                     // 以空白分隔的 UCI 走法，只保存完整的走法
+
+    quint64 payloadHash() const { return fnv1a(&scoreCp, sizeof(Slot) - sizeof(check)); }
+    quint64 key() const { return check ^ payloadHash(); }
+    void seal(quint64 positionKey) { check = positionKey ^ payloadHash(); }
+};
+EvalCache::EvalCache()
+    : m_map(nullptr)
+    , m_slots(nullptr)
+    , m_bucketCount(0)
+    , m_generation(0)
+    , m_hits(0)
+    , m_misses(0)
+{
+    static_assert(sizeof(Slot) == 64, "EvalCache::Slot must stay 64 bytes");
+}
+
+EvalCache::~EvalCache()
+{
+    close();
+}
+
+EvalCache* EvalCache::shared()
+{
+    // GUI 和命令列工具使用同一個檔案，分析過的局面可以互相共用
+    static EvalCache cache;
+    static bool initialized = false;
+    if (!initialized) {
+        initialized = true;
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/Qt_Chess";
+        QDir().mkpath(dir);
+        cache.open(dir + "/evalcache.bin", DEFAULT_CACHE_SIZE_MB);
+    }
+    return &cache;
+}
+
+bool EvalCache::open(const QString& path, int sizeMb)
+{
+    close();
+
+    quint32 bucketCount = static_cast<quint32>(
+        (qMax(1, sizeMb) * 1024LL * 1024LL - qint64(sizeof(CacheHeader))) / (SLOTS_PER_BUCKET * sizeof(Slot)));
+    qint64 fileSize = qint64(sizeof(CacheHeader)) + qint64(bucketCount) * SLOTS_PER_BUCKET * qint64(sizeof(Slot));
+
+    // 檢查、重建與世代加一都在鎖檔內進行，同時開啟的行程不會互相覆寫標頭
+    QLockFile initLock(path + ".lock");
+    if (!initLock.tryLock(INIT_LOCK_TIMEOUT_MS)) {
+        qWarning() << "[EvalCache] Timed out waiting for" << initLock.fileName() << ", using a private cache";
+        return openPrivate(bucketCount);
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "[EvalCache] Cannot open" << path << ":" << m_file.errorString();
+        return false;
+    }
+
+    CacheHeader existing = {};
+    bool valid = m_file.size() == fileSize
+                 && m_file.read(reinterpret_cast<char*>(&existing), sizeof(existing)) == qint64(sizeof(existing))
+                 && std::memcmp(existing.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0
+                 && existing.bucketCount == bucketCount && existing.slotsPerBucket == SLOTS_PER_BUCKET;
+    bool exclusive = lockInUse(m_file, true);
+    if (!valid && !exclusive) {
+        // 其他行程正以不同大小映射這個檔案（例如修改了上限）：不能清空或改變大小
+        qWarning() << "[EvalCache]" << path << "is in use with a different layout, using a private cache";
+        m_file.close();
+        return openPrivate(bucketCount);
+    }
+
+    if (!valid && !m_file.resize(fileSize)) {
+        qWarning() << "[EvalCache] Cannot resize" << path << "to" << fileSize << "bytes";
+        m_file.close();
+        return false;
+    }
+
+    m_map = m_file.map(0, fileSize);
+    if (!m_map) {
+        qWarning() << "[EvalCache] Cannot map" << path << ":" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    // 大小或格式不符時清空重建（只有沒有其他行程使用時才會到這裡）
+    CacheHeader* header = reinterpret_cast<CacheHeader*>(m_map);
+    if (!valid) {
+        std::memset(m_map, 0, static_cast<size_t>(fileSize));
+        std::memcpy(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header->bucketCount = bucketCount;
+        header->slotsPerBucket = SLOTS_PER_BUCKET;
+    }
+    header->generation++;
+    m_generation = header->generation;
+
+    // 改持共享鎖，之後開啟的行程就知道這個檔案正在使用
+    if (exclusive) unlockInUse(m_file);
+    if (!lockInUse(m_file, false)) {
+        qWarning() << "[EvalCache] Cannot lock" << path << "for shared use";
+    }
+
+    m_bucketCount = bucketCount;
+    m_slots = reinterpret_cast<Slot*>(m_map + sizeof(CacheHeader));
+    qDebug() << "[EvalCache] Opened" << path << "with" << bucketCount * SLOTS_PER_BUCKET << "slots";
+    return true;
+}
+
+bool EvalCache::openPrivate(quint32 bucketCount)
+{
+    // 只在本行程內有效的快取：大小相同，結束時捨棄
+    m_privateMap.fill('\0', int(sizeof(CacheHeader) + size_t(bucketCount) * SLOTS_PER_BUCKET * sizeof(Slot)));
+    m_map = reinterpret_cast<uchar*>(m_privateMap.data());
+    m_generation = 1;
+    m_bucketCount = bucketCount;
+    m_slots = reinterpret_cast<Slot*>(m_map + sizeof(CacheHeader));
+    return true;
+}
+
+void EvalCache::close()
+{
+    if (m_map && m_file.isOpen()) {
+        m_file.unmap(m_map);
+        unlockInUse(m_file);
+    }
+    m_map = nullptr;
+    m_privateMap.clear();
+    m_slots = nullptr;
+    m_bucketCount = 0;
+    if (m_file.isOpen()) m_file.close();
+}
+
+quint64 EvalCache::positionHash(const QString& fen)
+{
+    // 不含半步和全步計數，相同局面從不同棋局到達也能命中
+    QByteArray key = fen.section(' ', 0, 3).toLatin1();
+    return fnv1a(key.constData(), static_cast<size_t>(key.size()));
+}
+
+EvalCache::Slot* EvalCache::findSlot(quint64 key, Slot*& victim)
+{
+    Slot* bucket = m_slots + (key % m_bucketCount) * SLOTS_PER_BUCKET;
+    victim = nullptr;
+    int victimScore = 0;
+    for (int i = 0; i < SLOTS_PER_BUCKET; ++i) {
+        Slot* slot = bucket + i;
+        if (slot->depth > 0 && slot->key() == key) return slot;
+
+        // 空格優先，其次是深度低且較久沒用到的項目
+        int age = static_cast<quint8>(m_generation - slot->generation);
+        int score = slot->depth == 0 ? -MAX_STORED_DEPTH * AGE_WEIGHT : slot->depth - AGE_WEIGHT * age;
+        if (!victim || score < victimScore) {
+            victim = slot;
+            victimScore = score;
+        }
+    }
+    return nullptr;
+}
+
+bool EvalCache::probe(const QString& fen, EvalCacheEntry& entry)
+{
+    if (!isOpen()) return false;
+
+    quint64 key = positionHash(fen);
+    Slot* victim = nullptr;
+    Slot* slot = findSlot(key, victim);
+    if (!slot) {
+        m_misses++;
+        return false;
+    }
+
+    entry.depth = slot->depth;
+    entry.scoreCp = slot->scoreCp;
+    entry.mateIn = slot->mateIn;
+    entry.bestMove = QString::fromLatin1(slot->bestMove, static_cast<int>(qstrnlen(slot->bestMove, BEST_MOVE_BYTES)));
+    entry.pv = QString::fromLatin1(slot->pv, static_cast<int>(qstrnlen(slot->pv, PV_BYTES))).split(' ', Qt::SkipEmptyParts);
+
+    // 最近使用過的項目不會被淘汰
+    if (slot->generation != m_generation) {
+        slot->generation = m_generation;
+        slot->seal(key);
+    }
+    m_hits++;
+    return !entry.bestMove.isEmpty();
+}
+
+void EvalCache::store(const QString& fen, const EvalCacheEntry& entry)
+{
+    if (!isOpen() || entry.depth <= 0 || entry.bestMove.isEmpty()) return;
+
+    quint64 key = positionHash(fen);
+    Slot* victim = nullptr;
+    Slot* slot = findSlot(key, victim);
+    if (slot && slot->depth > entry.depth) return;  // 已有更深的結果
+    if (!slot) slot = victim;
+
+    // 變例只保存能完整放入的前幾步
+    QByteArray pv;
+    for (const QString& move : entry.pv) {
+        QByteArray next = pv.isEmpty() ? move.toLatin1() : pv + ' ' + move.toLatin1();
+        if (next.size() >= PV_BYTES) break;
+        pv = next;
+    }
+
+    slot->scoreCp = entry.scoreCp;
+    slot->mateIn = static_cast<qint16>(entry.mateIn);
+    slot->depth = static_cast<quint8>(qMin(entry.depth, MAX_STORED_DEPTH));
+    slot->generation = m_generation;
+    copyText(slot->bestMove, BEST_MOVE_BYTES, entry.bestMove.toLatin1());
+    copyText(slot->pv, PV_BYTES, pv);
+    slot->seal(key);
+}
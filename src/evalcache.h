@@ -0,0 +1,59 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+// 快取中的一筆局面評分（分數以行棋方為準，與引擎輸出相同）
+struct EvalCacheEntry {
+    int depth = 0;
+    int scoreCp = 0;
+    int mateIn = 0;
+    QString bestMove;
+    QStringList pv;             // 主要變例的前幾步
+};
+
+// 持久化的局面評分快取：固定大小的記憶體映射檔案
+// - 以 FEN 的前四個欄位雜湊定位到一個桶（每桶 4 格），檔案大小不會超過設定上限
+// - 同一局面只保留較深的結果；桶滿時淘汰「深度低且較久沒用到」的項目
+// - 每格以雜湊驗證內容，多個行程同時映射同一檔案時，寫到一半的項目只會被視為未命中
+// - 檔案正由其他行程使用而格式不符時不會重建，改用本行程私有的快取
+class EvalCache
+{
+public:
+    EvalCache();
+    ~EvalCache();
+
+    bool open(const QString& path, int sizeMb);
+    void close();
+    bool isOpen() const { return m_slots != nullptr; }
+
+    bool probe(const QString& fen, EvalCacheEntry& entry);    // 命中時會更新項目的使用時間
+    void store(const QString& fen, const EvalCacheEntry& entry);
+
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+
+    // 所有引擎共用的快取（第一次使用時開啟；開啟失敗時 isOpen() 為 false）
+    static EvalCache* shared();
+
+private:
+    struct Slot;
+
+    QFile m_file;
+    QByteArray m_privateMap;        // 共用檔案無法使用時的私有快取
+    uchar* m_map;
+    Slot* m_slots;
+    quint32 m_bucketCount;
+    quint8 m_generation;
+    int m_hits;
+    int m_misses;
+
+    bool openPrivate(quint32 bucketCount);
+    Slot* findSlot(quint64 key, Slot*& victim);
+    static quint64 positionHash(const QString& fen);
+};
+
+#endif // EVALCACHE_H
@@ -0,0 +1,217 @@
+#include "gameanalyzer.h"
+#include <QDebug>
+#include <QSet>
+
+namespace {
+const int DEFAULT_ANALYSIS_DEPTH = 14;     // 沒有指定限制時的分析深度
+const int MAX_LOSS_EVAL_CP = 1000;         // 計算損失時評分的上限（避免將殺評分放大損失）
+const int INACCURACY_THRESHOLD_CP = 50;
+const int MISTAKE_THRESHOLD_CP = 100;
+const int BLUNDER_THRESHOLD_CP = 300;
+}
+
+QString MoveAnnotation::qualitySymbol() const
+{
+    switch (quality) {
+        case MoveQuality::Inaccuracy: return "?!";
+        case MoveQuality::Mistake:    return "?";
+        case MoveQuality::Blunder:    return "??";
+        case MoveQuality::Good:       break;
+    }
+    return QString();
+}
+
+QString MoveAnnotation::evalText() const
+{
+    if (mateIn != 0) {
+        return QString("#%1").arg(mateIn);
+    }
+    return QString::number(evalCp / 100.0, 'f', 2);
+}
+
+GameAnalyzer::GameAnalyzer(QObject *parent)
+    : QObject(parent)
+    , m_pool(nullptr)
+    , m_total(0)
+    , m_running(false)
+{
+}
+
+QString GameAnalyzer::positionKey(const QString& fen)
+{
+    return fen.section(' ', 0, 3);
+}
+
+MoveAnnotation GameAnalyzer::annotateMove(bool whiteMoved, const PositionEval& before,
+                                         const PositionEval& after, bool afterIsMate)
+{
+    MoveAnnotation annotation;
+    // 將死後的局面沒有評分可以標示
+    annotation.hasEval = !afterIsMate;
+    annotation.evalCp = qBound(-UCI_MATE_SCORE_CP, after.scoreCp, UCI_MATE_SCORE_CP);
+    annotation.mateIn = after.mateIn;
+    annotation.bestMove = before.bestMove;
+
+    // 走這步的一方損失的評分
+    int beforeCp = qBound(-MAX_LOSS_EVAL_CP, before.scoreCp, MAX_LOSS_EVAL_CP);
+    int afterCp = qBound(-MAX_LOSS_EVAL_CP, after.scoreCp, MAX_LOSS_EVAL_CP);
+    annotation.lossCp = qMax(0, whiteMoved ? beforeCp - afterCp : afterCp - beforeCp);
+
+    if (annotation.lossCp >= BLUNDER_THRESHOLD_CP) {
+        annotation.quality = MoveQuality::Blunder;
+    } else if (annotation.lossCp >= MISTAKE_THRESHOLD_CP) {
+        annotation.quality = MoveQuality::Mistake;
+    } else if (annotation.lossCp >= INACCURACY_THRESHOLD_CP) {
+        annotation.quality = MoveQuality::Inaccuracy;
+    }
+    return annotation;
+}
+
+bool GameAnalyzer::analyse(const std::vector<MoveRecord>& moveHistory, const QString& enginePath,
+                           const SearchLimits& limits)
+{
+    cancel();
+    if (moveHistory.empty()) return false;
+
+    // 引擎池在多次分析之間保留，避免重複啟動行程
+    if (!m_pool || m_poolEnginePath != enginePath) {
+        delete m_pool;
+        m_pool = new EnginePool(this);
+        connect(m_pool, &EnginePool::jobFinished, this, &GameAnalyzer::onJobFinished);
+        connect(m_pool, &EnginePool::poolError, this, &GameAnalyzer::onPoolError);
+        if (!m_pool->start(enginePath)) {
+            delete m_pool;
+            m_pool = nullptr;
+            emit analysisFailed("無法啟動分析引擎");
+            return false;
+        }
+        m_poolEnginePath = enginePath;
+    }
+
+    SearchLimits jobLimits = limits;
+    if (jobLimits.depth <= 0 && jobLimits.nodes <= 0) {
+        jobLimits.depth = DEFAULT_ANALYSIS_DEPTH;
+    }
+    jobLimits.moveTimeMs = 0;
+    m_limitKey = jobLimits.nodes > 0 ? QString("n%1").arg(jobLimits.nodes) : QString("d%1").arg(jobLimits.depth);
+
+    // 重播棋局，取得每一步之後的局面
+    ChessBoard board;
+    board.initializeBoard();
+    m_plyKeys.clear();
+    m_terminalEvals.clear();
+    m_plyKeys.append(positionKey(ChessEngine::boardToFEN(board)) + "|" + m_limitKey);
+    for (const MoveRecord& move : moveHistory) {
+        board.movePiece(move.from, move.to);
+        if (move.isPromotion) {
+            board.promotePawn(move.to, move.promotionType);
+        }
+        m_plyKeys.append(positionKey(ChessEngine::boardToFEN(board)) + "|" + m_limitKey);
+    }
+
+    // 最後的局面若已將死或逼和，直接給分
+    int lastPly = m_plyKeys.size() - 1;
+    PieceColor sideToMove = board.getCurrentPlayer();
+    if (board.isCheckmate(sideToMove)) {
+        PositionEval eval;
+        eval.scoreCp = (sideToMove == PieceColor::White) ? -UCI_MATE_SCORE_CP : UCI_MATE_SCORE_CP;
+        m_terminalEvals.insert(lastPly, eval);
+    } else if (board.isStalemate(sideToMove)) {
+        m_terminalEvals.insert(lastPly, PositionEval());
+    }
+
+    // 每個不同且尚未快取的局面只送出一個工作，所有引擎同時處理
+    QSet<QString> submitted;
+    for (int ply = 0; ply < m_plyKeys.size(); ++ply) {
+        const QString& key = m_plyKeys[ply];
+        if (m_terminalEvals.contains(ply) || m_cache.contains(key) || submitted.contains(key)) continue;
+        submitted.insert(key);
+
+        EngineJob job;
+        job.type = EngineJobType::AnalyseGame;
+        job.priority = EngineJobPriority::Background;
+        job.ply = ply;
+        job.fen = key.section('|', 0, 0) + " 0 1";
+        job.limits = jobLimits;
+        m_jobKeys.insert(m_pool->submit(job), key);
+    }
+
+    m_total = submitted.size();
+    m_running = true;
+    qDebug() << "[GameAnalyzer] Analysing" << m_plyKeys.size() << "positions," << m_total
+             << "need search," << m_pool->engineCount() << "engines";
+
+    if (m_jobKeys.isEmpty()) {
+        finishAnalysis();
+    } else {
+        emit progress(0, m_total);
+    }
+    return true;
+}
+
+void GameAnalyzer::cancel()
+{
+    if (m_pool) {
+        for (auto it = m_jobKeys.constBegin(); it != m_jobKeys.constEnd(); ++it) {
+            m_pool->cancel(it.key());
+        }
+    }
+    m_jobKeys.clear();
+    m_running = false;
+}
+
+void GameAnalyzer::onJobFinished(const EngineJobResult& result)
+{
+    auto it = m_jobKeys.find(result.jobId);
+    if (it == m_jobKeys.end()) return;
+
+    QString key = it.value();
+    m_jobKeys.erase(it);
+
+    // 引擎評分以行棋方為準，快取時轉為白方觀點
+    bool blackToMove = key.section('|', 0, 0).section(' ', 1, 1) == "b";
+    PositionEval eval;
+    eval.scoreCp = result.info.hasScore ? result.info.comparableScore() : 0;
+    eval.mateIn = result.info.mateIn;
+    if (blackToMove) {
+        eval.scoreCp = -eval.scoreCp;
+        eval.mateIn = -eval.mateIn;
+    }
+    eval.bestMove = result.bestMove;
+    m_cache.insert(key, eval);
+
+    emit progress(m_total - m_jobKeys.size(), m_total);
+    if (m_jobKeys.isEmpty()) {
+        finishAnalysis();
+    }
+}
+
+void GameAnalyzer::onPoolError(const QString& error)
+{
+    if (!m_running) return;
+
+    cancel();
+    emit analysisFailed(error);
+}
+
+void GameAnalyzer::finishAnalysis()
+{
+    m_running = false;
+
+    auto evalAt = [this](int ply) {
+        return m_terminalEvals.contains(ply) ? m_terminalEvals.value(ply) : m_cache.value(m_plyKeys[ply]);
+    };
+
+    m_annotations.clear();
+    m_annotations.reserve(m_plyKeys.size() - 1);
+    for (int ply = 0; ply + 1 < m_plyKeys.size(); ++ply) {
+        PositionEval before = evalAt(ply);
+        PositionEval after = evalAt(ply + 1);
+
+        bool afterIsMate = m_terminalEvals.contains(ply + 1) && after.scoreCp != 0;
+        m_annotations.append(annotateMove(ply % 2 == 0, before, after, afterIsMate));
+    }
+
+    qDebug() << "[GameAnalyzer] Analysis finished," << m_cache.size() << "positions cached";
+    emit analysisFinished();
+}
@@ -0,0 +1,88 @@
+#ifndef GAMEANALYZER_H
+#define GAMEANALYZER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <vector>
+#include "chessboard.h"
+#include "enginepool.h"
+
+// 每一步棋的評價
+enum class MoveQuality {
+    Good,
+    Inaccuracy,     // 疑問手（?!）
+    Mistake,        // 錯著（?）
+    Blunder         // 大錯（??）
+};
+
+// 一步棋的分析結果（評分以白方觀點表示）
+struct MoveAnnotation {
+    bool hasEval = false;
+    int evalCp = 0;             // 走完這步後的評分（厘兵）
+    int mateIn = 0;             // 走完這步後的將殺步數（正數為白方將殺，0 表示非將殺評分）
+    int lossCp = 0;             // 走這步的一方損失的評分
+    MoveQuality quality = MoveQuality::Good;
+    QString bestMove;           // 引擎在走這步之前的局面建議的走法（UCI 格式）
+
+    QString qualitySymbol() const;   // "?!"、"?"、"??" 或空字串
+    QString evalText() const;        // PGN [%eval] 格式，例如 "0.35" 或 "#-3"
+};
+
+// 一個局面的評分（白方觀點）
+struct PositionEval {
+    int scoreCp = 0;        // 可比較的分數（將殺已換算）
+    int mateIn = 0;
+    QString bestMove;
+};
+
+// 對局分析器：把整盤棋每一步的局面分派給多個引擎同時分析
+// 相同的局面（包含之前分析過的對局）只搜尋一次
+class GameAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GameAnalyzer(QObject *parent = nullptr);
+
+    // 開始分析；limits 沒有指定深度或節點數時使用預設深度
+    bool analyse(const std::vector<MoveRecord>& moveHistory, const QString& enginePath,
+                 const SearchLimits& limits = SearchLimits());
+    void cancel();
+    bool isRunning() const { return m_running; }
+
+    const QVector<MoveAnnotation>& annotations() const { return m_annotations; }
+    int cacheSize() const { return m_cache.size(); }
+
+    // 快取鍵：FEN 的前四個欄位（不含步數計數）加上搜尋限制
+    static QString positionKey(const QString& fen);
+    // 依走棋前後的評分標註一步棋；afterIsMate 表示走完後對手已被將死
+    static MoveAnnotation annotateMove(bool whiteMoved, const PositionEval& before,
+                                       const PositionEval& after, bool afterIsMate);
+
+signals:
+    void progress(int finished, int total);
+    void analysisFinished();
+    void analysisFailed(const QString& error);
+
+private slots:
+    void onJobFinished(const EngineJobResult& result);
+    void onPoolError(const QString& error);
+
+private:
+    EnginePool* m_pool;
+    QString m_poolEnginePath;
+    QHash<QString, PositionEval> m_cache;
+    QHash<int, QString> m_jobKeys;          // 進行中的工作編號 -> 快取鍵
+    QVector<QString> m_plyKeys;             // 每個局面（ply 0 為起始局面）的快取鍵
+    QHash<int, PositionEval> m_terminalEvals;  // 終局局面（將死或逼和）不需要引擎
+    QVector<MoveAnnotation> m_annotations;
+    QString m_limitKey;
+    int m_total;
+    bool m_running;
+
+    void finishAnalysis();
+};
+
+#endif // GAMEANALYZER_H
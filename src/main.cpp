@@ -1,9 +1,19 @@
 #include "qt_chess.h"
+#include "benchmark.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // 基準測試模式：不開啟視窗，輸出節點簽章後結束（Qt_Chess --bench [引擎路徑]）
+    for (int i = 1; i < argc; ++i) {
+        if (QString(argv[i]) != "--bench") continue;
+        
+        QCoreApplication app(argc, argv);
+        QString enginePath = (i + 1 < argc) ? QString(argv[i + 1]) : Benchmark::defaultEnginePath();
+        return Benchmark::run(enginePath);
+    }
+    
     QApplication a(argc, argv);
     Qt_Chess w;
     w.showFullScreen();
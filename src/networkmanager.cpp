@@ -1,22 +1,53 @@
 #include "networkmanager.h"
+#include "binaryprotocol.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDateTime>
+#include <QTimer>
+#include <QMutexLocker>
 #include <QDebug>
 
-// Server configuration
+// Server configuration（可用 QT_CHESS_SERVER_URL 環境變數覆寫，例如指向 netsim 代理）
 static const QString SERVER_URL = "wss://chess-server-mjg6.onrender.com";
 
+namespace {
+const int CLOCK_SYNC_BURST_PINGS = 5;       // 連線後先快速送出幾次 Ping，盡快取得偏移
+const int CLOCK_SYNC_BURST_INTERVAL_MS = 250;
+const int CLOCK_SYNC_INTERVAL_MS = 2000;
+const int CLOCK_SYNC_WINDOW = 8;            // 滑動視窗的樣本數
+const int RECONNECT_INITIAL_DELAY_MS = 500; // 重新連線的退避時間從 0.5 秒開始加倍
+const int RECONNECT_MAX_DELAY_MS = 8000;
+const int RECONNECT_MAX_ATTEMPTS = 8;       // 總等待時間約 40 秒，短於伺服器保留座位的 60 秒
+}
+
 NetworkManager::NetworkManager(QObject *parent)
     : QObject(parent)
     , m_webSocket(nullptr)
     , m_role(NetworkRole::None)
     , m_status(ConnectionStatus::Disconnected)
-    , m_serverUrl(SERVER_URL)
+    , m_serverUrl(qEnvironmentVariable("QT_CHESS_SERVER_URL", SERVER_URL))
     , m_playerColor(PieceColor::None)
     , m_opponentColor(PieceColor::None)
+    , m_binaryProtocol(false)
+    , m_pingTimer(new QTimer(this))
+    , m_pingsSent(0)
+    , m_clockOffsetMs(0)
+    , m_rttMs(-1)
+    , m_jitterMs(0.0)
+    , m_lastSeq(0)
+    , m_gameInProgress(false)
+    , m_resuming(false)
+    , m_reconnectAttempt(0)
+    , m_reconnectTimer(new QTimer(this))
 {
+    // 信號以佇列連線跨執行緒傳送，參數型別需要註冊
+    qRegisterMetaType<PieceType>("PieceType");
+    qRegisterMetaType<PieceColor>("PieceColor");
+
+    connect(m_pingTimer, &QTimer::timeout, this, &NetworkManager::sendPing);
+    m_reconnectTimer->setSingleShot(true);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &NetworkManager::reconnect);
 }
 
 NetworkManager::~NetworkManager()
@@ -26,20 +57,17 @@ NetworkManager::~NetworkManager()
 
 bool NetworkManager::createRoom()
 {
+    bool created = false;
+    if (dispatchToNetworkThread([this, &created]() { created = createRoom(); }, Qt::BlockingQueuedConnection)) {
+        return created;
+    }
+
     if (m_status != ConnectionStatus::Disconnected) {
         return false;
     }
     
     // 不生成臨時房號，完全依賴伺服器分配
-    m_roomNumber.clear();
-    
-    // 創建 WebSocket 連接
-    m_webSocket = new QWebSocket();
-    connect(m_webSocket, &QWebSocket::connected, this, &NetworkManager::onConnected);
-    connect(m_webSocket, &QWebSocket::disconnected, this, &NetworkManager::onDisconnected);
-    connect(m_webSocket, &QWebSocket::textMessageReceived, this, &NetworkManager::onTextMessageReceived);
-    connect(m_webSocket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), 
-            this, &NetworkManager::onError);
+    setRoomNumber(QString());
     
     m_role = NetworkRole::Host;
     m_status = ConnectionStatus::Connecting;
@@ -51,37 +79,70 @@ bool NetworkManager::createRoom()
     
     // 等待伺服器回應分配房號
     
-    m_webSocket->open(QUrl(m_serverUrl));
+    openSocket();
     return true;
 }
 
 bool NetworkManager::joinRoom(const QString& roomNumber)
 {
+    bool joined = false;
+    if (dispatchToNetworkThread([this, &joined, roomNumber]() { joined = joinRoom(roomNumber); },
+                                Qt::BlockingQueuedConnection)) {
+        return joined;
+    }
+
     if (m_status != ConnectionStatus::Disconnected) {
         return false;
     }
     
+    m_role = NetworkRole::Guest;
+    m_status = ConnectionStatus::Connecting;
+    setRoomNumber(roomNumber);
+    m_playerColor = PieceColor::Black;  // 加入者執黑
+    m_opponentColor = PieceColor::White;
+    
+    qDebug() << "[NetworkManager] Connecting to server:" << m_serverUrl << "to join room:" << roomNumber;
+    openSocket();
+    return true;
+}
+
+QString NetworkManager::getRoomNumber() const
+{
+    QMutexLocker locker(&m_roomNumberMutex);
+    return m_roomNumber;
+}
+
+void NetworkManager::setServerUrl(const QString& url)
+{
+    if (dispatchToNetworkThread([this, url]() { setServerUrl(url); }, Qt::BlockingQueuedConnection)) return;
+
+    m_serverUrl = url;
+}
+
+void NetworkManager::setRoomNumber(const QString& roomNumber)
+{
+    QMutexLocker locker(&m_roomNumberMutex);
+    m_roomNumber = roomNumber;
+}
+
+void NetworkManager::openSocket()
+{
     // 創建 WebSocket 連接
     m_webSocket = new QWebSocket();
     connect(m_webSocket, &QWebSocket::connected, this, &NetworkManager::onConnected);
     connect(m_webSocket, &QWebSocket::disconnected, this, &NetworkManager::onDisconnected);
     connect(m_webSocket, &QWebSocket::textMessageReceived, this, &NetworkManager::onTextMessageReceived);
+    connect(m_webSocket, &QWebSocket::binaryMessageReceived, this, &NetworkManager::onBinaryMessageReceived);
     connect(m_webSocket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), 
             this, &NetworkManager::onError);
     
-    m_role = NetworkRole::Guest;
-    m_status = ConnectionStatus::Connecting;
-    m_roomNumber = roomNumber;
-    m_playerColor = PieceColor::Black;  // 加入者執黑
-    m_opponentColor = PieceColor::White;
-    
-    qDebug() << "[NetworkManager] Connecting to server:" << m_serverUrl << "to join room:" << roomNumber;
     m_webSocket->open(QUrl(m_serverUrl));
-    return true;
 }
 
 void NetworkManager::leaveRoom()
 {
+    if (dispatchToNetworkThread([this]() { leaveRoom(); }, Qt::BlockingQueuedConnection)) return;
+
     qDebug() << "[NetworkManager::leaveRoom] Sending leave room message";
     
     // 發送離開房間通知給伺服器
@@ -101,6 +162,20 @@ void NetworkManager::leaveRoom()
 
 void NetworkManager::closeConnection()
 {
+    if (dispatchToNetworkThread([this]() { closeConnection(); }, Qt::BlockingQueuedConnection)) return;
+
+    stopClockSync();
+
+    // 主動關閉連線不需要續連
+    m_reconnectTimer->stop();
+    m_resuming = false;
+    m_reconnectAttempt = 0;
+    m_gameInProgress = false;
+    m_sessionId.clear();
+    m_lastSeq = 0;
+    m_pendingMessages.clear();
+    m_unackedMove = UnackedMove();
+
     // 發送斷線通知（如果有連接）
     if (m_webSocket && m_webSocket->state() == QAbstractSocket::ConnectedState) {
         QJsonObject message;
@@ -120,13 +195,16 @@ void NetworkManager::closeConnection()
     // 完整重置所有狀態
     m_role = NetworkRole::None;
     m_status = ConnectionStatus::Disconnected;
-    m_roomNumber.clear();
+    setRoomNumber(QString());
     m_playerColor = PieceColor::None;
     m_opponentColor = PieceColor::None;
+    m_binaryProtocol = false;
 }
 
 void NetworkManager::sendMove(const QPoint& from, const QPoint& to, PieceType promotionType)
 {
+    if (dispatchToNetworkThread([=]() { sendMove(from, to, promotionType); })) return;
+
     qDebug() << "[NetworkManager::sendMove] Sending move from" << from << "to" << to 
              << "| Role:" << (m_role == NetworkRole::Host ? "Host" : "Guest")
              << "| Socket connected:" << (m_webSocket && m_webSocket->state() == QAbstractSocket::ConnectedState);
@@ -136,6 +214,24 @@ void NetworkManager::sendMove(const QPoint& from, const QPoint& to, PieceType pr
         return;
     }
     
+    // 收到伺服器轉送之前，斷線可能讓走法遺失在途中，續連後需要判斷是否補送
+    m_unackedMove.from = from;
+    m_unackedMove.to = to;
+    m_unackedMove.promotionType = promotionType;
+    m_unackedMove.valid = true;
+    
+    // 伺服器支援時使用二進位訊框（房號必須是數字）
+    BinaryProtocol::MoveFrame frame;
+    if (m_binaryProtocol && BinaryProtocol::roomIdFromString(m_roomNumber, frame.roomId)
+        && m_webSocket && m_webSocket->state() == QAbstractSocket::ConnectedState) {
+        frame.from = from;
+        frame.to = to;
+        frame.promotionType = promotionType;
+        m_webSocket->sendBinaryMessage(BinaryProtocol::encodeMove(frame));
+        m_webSocket->flush();
+        return;
+    }
+    
     // 使用伺服器期望的格式
     QJsonObject message;
     message["action"] = "move";
@@ -156,6 +252,8 @@ void NetworkManager::sendMove(const QPoint& from, const QPoint& to, PieceType pr
 
 void NetworkManager::sendGameStart(PieceColor playerColor)
 {
+    if (dispatchToNetworkThread([=]() { sendGameStart(playerColor); })) return;
+
     if (m_roomNumber.isEmpty()) {
         qDebug() << "[NetworkManager::sendGameStart] ERROR: Room number is empty";
         return;
@@ -171,6 +269,8 @@ void NetworkManager::sendGameStart(PieceColor playerColor)
 
 void NetworkManager::sendStartGame(int whiteTimeMs, int blackTimeMs, int incrementMs, PieceColor hostColor)
 {
+    if (dispatchToNetworkThread([=]() { sendStartGame(whiteTimeMs, blackTimeMs, incrementMs, hostColor); })) return;
+
     if (m_roomNumber.isEmpty()) {
         qDebug() << "[NetworkManager::sendStartGame] ERROR: Room number is empty";
         return;
@@ -188,6 +288,8 @@ void NetworkManager::sendStartGame(int whiteTimeMs, int blackTimeMs, int increme
 
 void NetworkManager::sendTimeSettings(int whiteTimeMs, int blackTimeMs, int incrementMs)
 {
+    if (dispatchToNetworkThread([=]() { sendTimeSettings(whiteTimeMs, blackTimeMs, incrementMs); })) return;
+
     if (m_roomNumber.isEmpty()) {
         qDebug() << "[NetworkManager::sendTimeSettings] ERROR: Room number is empty";
         return;
@@ -204,6 +306,8 @@ void NetworkManager::sendTimeSettings(int whiteTimeMs, int blackTimeMs, int incr
 
 void NetworkManager::sendSurrender()
 {
+    if (dispatchToNetworkThread([this]() { sendSurrender(); })) return;
+
     if (m_roomNumber.isEmpty()) {
         qDebug() << "[NetworkManager::sendSurrender] ERROR: Room number is empty";
         return;
@@ -217,6 +321,8 @@ void NetworkManager::sendSurrender()
 
 void NetworkManager::sendDrawOffer()
 {
+    if (dispatchToNetworkThread([this]() { sendDrawOffer(); })) return;
+
     if (m_roomNumber.isEmpty()) {
         qDebug() << "[NetworkManager::sendDrawOffer] ERROR: Room number is empty";
         return;
@@ -230,6 +336,8 @@ void NetworkManager::sendDrawOffer()
 
 void NetworkManager::sendDrawResponse(bool accepted)
 {
+    if (dispatchToNetworkThread([=]() { sendDrawResponse(accepted); })) return;
+
     if (m_roomNumber.isEmpty()) {
         qDebug() << "[NetworkManager::sendDrawResponse] ERROR: Room number is empty";
         return;
@@ -244,6 +352,8 @@ void NetworkManager::sendDrawResponse(bool accepted)
 
 void NetworkManager::setPlayerColors(PieceColor playerColor)
 {
+    if (dispatchToNetworkThread([=]() { setPlayerColors(playerColor); })) return;
+
     // 設定玩家顏色和對手顏色
     m_playerColor = playerColor;
     m_opponentColor = (playerColor == PieceColor::White) ? PieceColor::Black : PieceColor::White;
@@ -251,6 +361,8 @@ void NetworkManager::setPlayerColors(PieceColor playerColor)
 
 void NetworkManager::sendGameOver(const QString& result)
 {
+    if (dispatchToNetworkThread([=]() { sendGameOver(result); })) return;
+
     if (m_roomNumber.isEmpty()) {
         qDebug() << "[NetworkManager::sendGameOver] ERROR: Room number is empty";
         return;
@@ -266,6 +378,8 @@ void NetworkManager::sendGameOver(const QString& result)
 
 void NetworkManager::sendChat(const QString& chatMessage)
 {
+    if (dispatchToNetworkThread([=]() { sendChat(chatMessage); })) return;
+
     if (m_roomNumber.isEmpty()) {
         qDebug() << "[NetworkManager::sendChat] ERROR: Room number is empty";
         return;
@@ -283,7 +397,28 @@ void NetworkManager::onConnected()
 {
     qDebug() << "[NetworkManager] Connected to server";
     m_status = ConnectionStatus::Connected;
-    emit connected();
+    if (!m_resuming) {
+        emit connected();
+    }
+    startClockSync();
+    
+    // 協商二進位走棋協議：舊伺服器不會回覆，繼續使用 JSON
+    QJsonObject hello;
+    hello["action"] = "hello";
+    hello["binary"] = BinaryProtocol::VERSION;
+    sendMessage(hello);
+    
+    if (m_resuming) {
+        // 重新連線：回到原本的座位，要求重送最後收到的序號之後的訊息
+        QJsonObject message;
+        message["action"] = "resume";
+        message["room"] = m_roomNumber;
+        message["session"] = m_sessionId;
+        message["lastSeq"] = static_cast<qint64>(m_lastSeq);
+        sendMessage(message);
+        qDebug() << "[NetworkManager] Sent resume request for room:" << m_roomNumber << "after seq" << m_lastSeq.load();
+        return;
+    }
     
     // 根據角色發送相應的請求
     if (m_role == NetworkRole::Host) {
@@ -305,6 +440,16 @@ void NetworkManager::onConnected()
 void NetworkManager::onDisconnected()
 {
     qDebug() << "[NetworkManager] Disconnected from server";
+    stopClockSync();
+    m_binaryProtocol = false;
+
+    // 對局中非預期斷線：先嘗試續連，全部失敗後才通知斷線
+    if (canResume()) {
+        m_status = ConnectionStatus::Disconnected;
+        scheduleReconnect();
+        return;
+    }
+
     emit disconnected();
     emit opponentDisconnected();
     
@@ -323,6 +468,31 @@ void NetworkManager::onTextMessageReceived(const QString& message)
     }
 }
 
+void NetworkManager::onBinaryMessageReceived(const QByteArray& message)
+{
+    BinaryProtocol::MoveRelayFrame frame;
+    if (!BinaryProtocol::decodeMoveRelay(message, frame)) {
+        qDebug() << "[NetworkManager] Ignoring unknown binary frame, opcode" << BinaryProtocol::opcode(message);
+        return;
+    }
+    if (!acceptSequence(frame.seq)) return;
+    m_unackedMove.valid = false;
+
+    // 與 JSON 的 move 訊息相同：先套用走法，再更新計時器
+    emit opponentMove(frame.move.from, frame.move.to, frame.move.promotionType);
+
+    qint64 lastSwitchTimeMs = frame.sinceSwitchMs >= 0 ? frame.serverTimeMs - frame.sinceSwitchMs : 0;
+    emit timerStateReceived(frame.timeA, frame.timeB, frame.whiteToMove ? "White" : "Black",
+                            lastSwitchTimeMs, frame.serverTimeMs);
+
+    switch (frame.result) {
+    case BinaryProtocol::ResultWhiteWins: emit gameOverReceived("1-0"); break;
+    case BinaryProtocol::ResultBlackWins: emit gameOverReceived("0-1"); break;
+    case BinaryProtocol::ResultDraw:      emit gameOverReceived("1/2-1/2"); break;
+    default: break;
+    }
+}
+
 void NetworkManager::onError(QAbstractSocket::SocketError socketError)
 {
     QString errorString;
@@ -333,13 +503,101 @@ void NetworkManager::onError(QAbstractSocket::SocketError socketError)
     }
     
     qDebug() << "[NetworkManager] Socket error:" << errorString;
+
+    // 對局中的連線錯誤交給續連處理；連線失敗（沒有 disconnected 信號）時在這裡排定下一次嘗試
+    if (canResume()) {
+        if (m_webSocket && m_webSocket->state() == QAbstractSocket::UnconnectedState) {
+            m_status = ConnectionStatus::Disconnected;
+            scheduleReconnect();
+        }
+        return;
+    }
+
     emit connectionError(errorString);
     m_status = ConnectionStatus::Error;
 }
 
+void NetworkManager::scheduleReconnect()
+{
+    if (m_reconnectTimer->isActive()) return;
+
+    if (m_reconnectAttempt >= RECONNECT_MAX_ATTEMPTS) {
+        abandonResume(tr("重新連線失敗"));
+        return;
+    }
+
+    int delayMs = qMin(RECONNECT_MAX_DELAY_MS, RECONNECT_INITIAL_DELAY_MS << m_reconnectAttempt);
+    m_reconnectAttempt++;
+    m_resuming = true;
+    qDebug() << "[NetworkManager] Connection lost, reconnect attempt" << m_reconnectAttempt << "in" << delayMs << "ms";
+    emit reconnecting(m_reconnectAttempt, delayMs);
+    m_reconnectTimer->start(delayMs);
+}
+
+void NetworkManager::reconnect()
+{
+    // 舊的連線不再需要：斷開信號，避免延遲到達的 disconnected 再次觸發續連
+    if (m_webSocket) {
+        m_webSocket->disconnect(this);
+        m_webSocket->abort();
+        m_webSocket->deleteLater();
+        m_webSocket = nullptr;
+    }
+
+    m_status = ConnectionStatus::Connecting;
+    qDebug() << "[NetworkManager] Reconnecting to server:" << m_serverUrl;
+    openSocket();
+}
+
+void NetworkManager::abandonResume(const QString& reason)
+{
+    qWarning() << "[NetworkManager] Giving up on resuming room" << m_roomNumber << ":" << reason;
+
+    m_reconnectTimer->stop();
+    m_resuming = false;
+    m_reconnectAttempt = 0;
+    m_gameInProgress = false;
+    m_sessionId.clear();
+    m_pendingMessages.clear();
+    m_unackedMove = UnackedMove();
+    stopClockSync();
+
+    if (m_webSocket) {
+        m_webSocket->disconnect(this);
+        m_webSocket->abort();
+        m_webSocket->deleteLater();
+        m_webSocket = nullptr;
+    }
+    m_status = ConnectionStatus::Disconnected;
+
+    // 與續連功能加入之前的斷線處理相同
+    emit disconnected();
+    emit opponentDisconnected();
+}
+
+bool NetworkManager::acceptSequence(quint64 seq)
+{
+    // 續連後重送的訊息可能已經處理過，以序號去除重複
+    if (seq <= m_lastSeq) {
+        qDebug() << "[NetworkManager] Dropping duplicate game message, seq" << seq << "<=" << m_lastSeq.load();
+        return false;
+    }
+    if (seq != m_lastSeq + 1) {
+        qWarning() << "[NetworkManager] Game message gap: expected seq" << m_lastSeq.load() + 1 << "got" << seq;
+    }
+    m_lastSeq = seq;
+    return true;
+}
+
 void NetworkManager::sendMessage(const QJsonObject& message)
 {
     if (!m_webSocket || m_webSocket->state() != QAbstractSocket::ConnectedState) {
+        // 重新連線期間的對局訊息在續連後補送
+        if (m_resuming && message.contains("action")) {
+            qDebug() << "[NetworkManager::sendMessage] Queueing" << message["action"].toString() << "until the session resumes";
+            m_pendingMessages.append(message);
+            return;
+        }
         qDebug() << "[NetworkManager::sendMessage] ERROR: Cannot send message, socket not connected"
                  << "| Socket:" << m_webSocket 
                  << "| State:" << (m_webSocket ? m_webSocket->state() : -1);
@@ -363,6 +621,12 @@ void NetworkManager::processMessage(const QJsonObject& message)
     qDebug() << "[NetworkManager::processMessage] Received message with action:" << actionStr 
              << "| Role:" << (m_role == NetworkRole::Host ? "Host" : "Guest");
     
+    // 對局訊息帶有伺服器分配的序號（gameStart 為 0，resumed 為伺服器目前的序號）
+    if (message.contains("seq") && actionStr != "gameStart" && actionStr != "resumed"
+        && !acceptSequence(message["seq"].toVariant().toULongLong())) {
+        return;
+    }
+    
     // 處理伺服器的回應格式
     if (actionStr == "roomCreated") {
         // 伺服器確認創建的房間號
@@ -370,7 +634,8 @@ void NetworkManager::processMessage(const QJsonObject& message)
             QString serverRoomNumber = message["room"].toString();
             if (!serverRoomNumber.isEmpty()) {
                 qDebug() << "[NetworkManager] Server created room with number:" << serverRoomNumber;
-                m_roomNumber = serverRoomNumber;
+                setRoomNumber(serverRoomNumber);
+                m_sessionId = message["session"].toString();
                 emit roomCreated(m_roomNumber);
             } else {
                 qDebug() << "[NetworkManager] Server response missing room number";
@@ -387,6 +652,7 @@ void NetworkManager::processMessage(const QJsonObject& message)
     else if (actionStr == "joinedRoom") {
         // 加入房間成功
         qDebug() << "[NetworkManager] Joined room successfully";
+        m_sessionId = message["session"].toString();
         emit opponentJoined();
         
         // 發送遊戲開始確認（使用舊協議格式）
@@ -395,6 +661,9 @@ void NetworkManager::processMessage(const QJsonObject& message)
     else if (actionStr == "gameStart") {
         // 伺服器廣播遊戲開始（同步開始）
         qDebug() << "[NetworkManager] Server broadcast gameStart";
+        m_lastSeq = 0;
+        m_gameInProgress = true;
+        m_unackedMove = UnackedMove();
         
         int whiteTimeMs = message["whiteTimeMs"].toInt();
         int blackTimeMs = message["blackTimeMs"].toInt();
@@ -404,8 +673,9 @@ void NetworkManager::processMessage(const QJsonObject& message)
         qint64 serverTimestamp = message["serverTimestamp"].toVariant().toLongLong();
         
         // 計算伺服器時間偏移（伺服器時間 - 本地時間）
+        // 已完成時鐘同步時使用量測值；serverTimestamp 含有伺服器加上的 500ms 緩衝，只作為備用
         qint64 localTimestamp = QDateTime::currentMSecsSinceEpoch();
-        qint64 serverTimeOffset = serverTimestamp - localTimestamp;
+        qint64 serverTimeOffset = hasClockSync() ? m_clockOffsetMs.load() : serverTimestamp - localTimestamp;
         
         // 根據房主的顏色選擇更新玩家顏色
         if (m_role == NetworkRole::Host) {
@@ -427,18 +697,7 @@ void NetworkManager::processMessage(const QJsonObject& message)
         
         // 如果訊息包含計時器狀態，發送計時器更新
         if (message.contains("timerState")) {
-            QJsonObject timerState = message["timerState"].toObject();
-            qint64 timeA = timerState["timeA"].toVariant().toLongLong();
-            qint64 timeB = timerState["timeB"].toVariant().toLongLong();
-            QString currentPlayer = timerState["currentPlayer"].toString();
-            qint64 lastSwitchTime = timerState["lastSwitchTime"].toVariant().toLongLong();
-            
-            qDebug() << "[NetworkManager] Initial timer state - timeA:" << timeA 
-                     << "| timeB:" << timeB 
-                     << "| currentPlayer:" << currentPlayer 
-                     << "| lastSwitchTime:" << lastSwitchTime;
-            
-            emit timerStateReceived(timeA, timeB, currentPlayer, lastSwitchTime);
+            processTimerState(message["timerState"].toObject());
         }
     }
     else if (actionStr == "error") {
@@ -468,25 +727,78 @@ void NetworkManager::processMessage(const QJsonObject& message)
             promotionType = static_cast<PieceType>(message["promotion"].toInt());
         }
         
+        // 雙方都會收到轉送（走棋方收到的是回傳），已送出的走法確定送達伺服器
+        m_unackedMove.valid = false;
+        
         qDebug() << "[NetworkManager::processMessage] Emitting opponentMove signal";
         emit opponentMove(from, to, promotionType);
         
         // 如果訊息包含計時器狀態，發送計時器更新
         if (message.contains("timerState")) {
-            QJsonObject timerState = message["timerState"].toObject();
-            qint64 timeA = timerState["timeA"].toVariant().toLongLong();
-            qint64 timeB = timerState["timeB"].toVariant().toLongLong();
-            QString currentPlayer = timerState["currentPlayer"].toString();
-            qint64 lastSwitchTime = timerState["lastSwitchTime"].toVariant().toLongLong();
-            
-            qDebug() << "[NetworkManager] Timer state update - timeA:" << timeA 
-                     << "| timeB:" << timeB 
-                     << "| currentPlayer:" << currentPlayer 
-                     << "| lastSwitchTime:" << lastSwitchTime;
-            
-            emit timerStateReceived(timeA, timeB, currentPlayer, lastSwitchTime);
+            processTimerState(message["timerState"].toObject());
+        }
+
+        // 伺服器判定這步棋結束了對局（包含客戶端不判定的重複局面與五十步規則）
+        if (message["gameOver"].isObject()) {
+            emit gameOverReceived(message["gameOver"].toObject()["result"].toString());
         }
     }
+    else if (actionStr == "hello") {
+        // 伺服器確認支援的二進位協議版本
+        m_binaryProtocol = message["binary"].toInt() >= BinaryProtocol::VERSION;
+        qDebug() << "[NetworkManager] Server protocol negotiated, binary moves:" << m_binaryProtocol.load();
+    }
+    else if (actionStr == "resumed") {
+        // 遺漏的訊息已依序重送完畢，補送斷線期間的訊息並同步計時器
+        qDebug() << "[NetworkManager] Session resumed in room" << m_roomNumber << "at seq" << m_lastSeq.load();
+        m_resuming = false;
+        m_reconnectAttempt = 0;
+        const QVector<QJsonObject> pending = m_pendingMessages;
+        m_pendingMessages.clear();
+        bool moveQueued = false;
+        for (const QJsonObject& queued : pending) {
+            moveQueued = moveQueued || queued["action"].toString() == "move";
+            sendMessage(queued);
+        }
+        // 重送的訊息已經處理完，仍然沒有收到轉送表示走法在斷線時遺失，伺服器沒有收到
+        if (m_unackedMove.valid && !moveQueued) {
+            qDebug() << "[NetworkManager] Resending move lost in flight from" << m_unackedMove.from << "to" << m_unackedMove.to;
+            sendMove(m_unackedMove.from, m_unackedMove.to, m_unackedMove.promotionType);
+        }
+        if (message["timerState"].isObject()) {
+            processTimerState(message["timerState"].toObject());
+        }
+        emit sessionResumed();
+    }
+    else if (actionStr == "ack") {
+        // 自己送出的投降或和棋訊息已由伺服器編號（上面已記錄序號），伺服器不會再轉送給自己
+        qDebug() << "[NetworkManager] Server sequenced our message as seq" << m_lastSeq.load();
+    }
+    else if (actionStr == "resumeFailed") {
+        abandonResume(message["reason"].toString());
+    }
+    else if (actionStr == "opponentConnectionLost") {
+        qDebug() << "[NetworkManager] Opponent lost connection, server is holding the seat";
+        emit opponentConnectionLost(message["graceMs"].toInt());
+    }
+    else if (actionStr == "opponentReconnected") {
+        qDebug() << "[NetworkManager] Opponent reconnected";
+        emit opponentReconnected();
+    }
+    else if (actionStr == "moveRejected") {
+        // 伺服器驗證失敗，走法沒有送到對手
+        QPoint from(message["fromCol"].toInt(), message["fromRow"].toInt());
+        QPoint to(message["toCol"].toInt(), message["toRow"].toInt());
+        QString reason = message["reason"].toString();
+        m_unackedMove.valid = false;
+        qWarning() << "[NetworkManager] Server rejected move from" << from << "to" << to << ":" << reason;
+        emit moveRejected(from, to, reason);
+    }
+    else if (actionStr == "actionRejected") {
+        // 伺服器拒絕開始對局、投降或和棋訊息，訊息沒有送到對手
+        qWarning() << "[NetworkManager] Server rejected" << message["request"].toString()
+                   << ":" << message["reason"].toString();
+    }
     else if (actionStr == "surrender") {
         // 收到對手投降訊息（新格式）
         qDebug() << "[NetworkManager] Opponent surrendered";
@@ -533,7 +845,7 @@ void NetworkManager::processMessage(const QJsonObject& message)
                 QString serverRoomNumber = message["roomNumber"].toString();
                 if (!serverRoomNumber.isEmpty()) {
                     qDebug() << "[NetworkManager] Server created room with number:" << serverRoomNumber;
-                    m_roomNumber = serverRoomNumber;
+                    setRoomNumber(serverRoomNumber);
                     emit roomCreated(m_roomNumber);
                 } else {
                     qDebug() << "[NetworkManager] Server response missing room number";
@@ -647,6 +959,10 @@ void NetworkManager::processMessage(const QJsonObject& message)
         break;
     }
     
+    case MessageType::Pong:
+        processPong(message);
+        break;
+        
     case MessageType::PlayerDisconnected:
         // 對手斷線
         qDebug() << "[NetworkManager] Opponent disconnected";
@@ -660,6 +976,93 @@ void NetworkManager::processMessage(const QJsonObject& message)
     }
 }
 
+void NetworkManager::startClockSync()
+{
+    m_pingsSent = 0;
+    m_clockSamples.clear();
+    m_rttMs = -1;
+    m_jitterMs = 0.0;
+    sendPing();
+    m_pingTimer->start(CLOCK_SYNC_BURST_INTERVAL_MS);
+}
+
+void NetworkManager::stopClockSync()
+{
+    m_pingTimer->stop();
+}
+
+void NetworkManager::sendPing()
+{
+    if (!m_webSocket || m_webSocket->state() != QAbstractSocket::ConnectedState) return;
+
+    QJsonObject message;
+    message["type"] = messageTypeToString(MessageType::Ping);
+    message["clientTime"] = QDateTime::currentMSecsSinceEpoch();
+    sendMessage(message);
+
+    if (++m_pingsSent == CLOCK_SYNC_BURST_PINGS) {
+        m_pingTimer->setInterval(CLOCK_SYNC_INTERVAL_MS);
+    }
+}
+
+void NetworkManager::processPong(const QJsonObject& message)
+{
+    // NTP 式估計：假設去程與回程延遲相同，伺服器時間對應本地的往返中點
+    qint64 receivedAt = QDateTime::currentMSecsSinceEpoch();
+    qint64 sentAt = message["clientTime"].toVariant().toLongLong();
+    qint64 serverTime = message["serverTime"].toVariant().toLongLong();
+    if (sentAt <= 0 || serverTime <= 0 || receivedAt < sentAt) return;
+
+    ClockSample sample;
+    sample.rttMs = receivedAt - sentAt;
+    sample.offsetMs = serverTime - (sentAt + receivedAt) / 2;
+
+    // RFC 3550 式的平滑抖動
+    if (m_rttMs >= 0) {
+        double jitterMs = m_jitterMs;
+        m_jitterMs = jitterMs + (qAbs(sample.rttMs - m_rttMs) - jitterMs) / 16.0;
+    }
+    m_rttMs = static_cast<int>(sample.rttMs);
+
+    m_clockSamples.append(sample);
+    if (m_clockSamples.size() > CLOCK_SYNC_WINDOW) {
+        m_clockSamples.removeFirst();
+    }
+
+    // 往返時間最短的樣本受排隊延遲影響最小，偏移誤差上限為其 RTT 的一半
+    const ClockSample* best = &m_clockSamples.first();
+    for (const ClockSample& candidate : m_clockSamples) {
+        if (candidate.rttMs < best->rttMs) best = &candidate;
+    }
+    m_clockOffsetMs = best->offsetMs;
+
+    emit clockSyncUpdated(m_clockOffsetMs, m_rttMs, jitter());
+}
+
+void NetworkManager::processTimerState(const QJsonObject& timerState)
+{
+    qint64 timeA = timerState["timeA"].toVariant().toLongLong();
+    qint64 timeB = timerState["timeB"].toVariant().toLongLong();
+    QString currentPlayer = timerState["currentPlayer"].toString();
+    qint64 serverTimeMs = timerState["serverTimeMs"].toVariant().toLongLong();
+
+    // 新版伺服器以毫秒傳送切換時間；舊版伺服器只有 UNIX 秒數
+    qint64 lastSwitchTimeMs = 0;
+    if (timerState.contains("lastSwitchTimeMs")) {
+        lastSwitchTimeMs = timerState["lastSwitchTimeMs"].toVariant().toLongLong();
+    } else {
+        lastSwitchTimeMs = timerState["lastSwitchTime"].toVariant().toLongLong() * 1000;
+    }
+
+    qDebug() << "[NetworkManager] Timer state - timeA:" << timeA
+             << "| timeB:" << timeB
+             << "| currentPlayer:" << currentPlayer
+             << "| lastSwitchTimeMs:" << lastSwitchTimeMs
+             << "| serverTimeMs:" << serverTimeMs;
+
+    emit timerStateReceived(timeA, timeB, currentPlayer, lastSwitchTimeMs, serverTimeMs);
+}
+
 MessageType NetworkManager::stringToMessageType(const QString& type) const
 {
     static QMap<QString, MessageType> typeMap = {
@@ -7,8 +7,16 @@
 #include <QJsonObject>
 #include <QString>
 #include <QPoint>
+#include <QVector>
+#include <QMutex>
+#include <QThread>
+#include <QMetaType>
+#include <atomic>
+#include <utility>
 #include "chesspiece.h"
 
+class QTimer;
+
 enum class NetworkRole {
     None,
     Host,      // 房主
@@ -40,6 +48,10 @@ enum class MessageType {
     Pong                // 心跳回應
 };
 
+// 線上對戰的網路連線，設計為移到專用的網路執行緒（moveToThread）上執行：
+// 通訊端讀寫、JSON/二進位解碼與 Ping 都在網路執行緒處理，GUI 的對話框或重繪不會延遲收發
+// 公開的操作可以從任何執行緒呼叫（會轉交給網路執行緒），信號以佇列連線送到 UI
+// 查詢函式讀取的狀態只由網路執行緒寫入，以原子變數或互斥鎖保護
 class NetworkManager : public QObject
 {
     Q_OBJECT
@@ -54,7 +66,8 @@ public:
     void leaveRoom();  // 明確離開房間（通知伺服器和對手）
     void closeConnection();
     
-    QString getRoomNumber() const { return m_roomNumber; }
+    QString getRoomNumber() const;
+    void setServerUrl(const QString& url);  // 在 createRoom/joinRoom 之前呼叫（例如連線到本機伺服器）
     NetworkRole getRole() const { return m_role; }
     ConnectionStatus getStatus() const { return m_status; }
     
@@ -74,6 +87,17 @@ public:
     PieceColor getPlayerColor() const { return m_playerColor; }
     void setPlayerColors(PieceColor playerColor);  // 設定玩家顏色（同時設定對手顏色為相反顏色）
 
+    // 時鐘同步（定期 Ping/Pong，取滑動視窗內往返時間最短的樣本估計偏移）
+    bool usesBinaryProtocol() const { return m_binaryProtocol; }
+
+    bool hasClockSync() const { return m_rttMs >= 0; }
+    qint64 serverTimeOffset() const { return m_clockOffsetMs; }  // 伺服器時間 - 本地時間（毫秒）
+    int roundTripTime() const { return m_rttMs; }                 // 最近一次往返時間（毫秒），-1 表示尚未量測
+    int jitter() const { return qRound(m_jitterMs.load()); }       // 往返時間的平滑抖動（毫秒）
+
+    // 斷線續連：對局中非預期斷線時以指數退避重新連線，並要求伺服器重送最後收到的序號之後的訊息
+    bool isReconnecting() const { return m_resuming; }
+    quint64 lastSequence() const { return m_lastSeq; }
 
 signals:
     void connected();
@@ -84,38 +108,100 @@ signals:
     void playerLeft();  // 對手在遊戲開始前離開房間
     void promotedToHost();  // 房主離開，自己被提升為新房主
     void opponentMove(const QPoint& from, const QPoint& to, PieceType promotionType);
+    void moveRejected(const QPoint& from, const QPoint& to, const QString& reason);  // 伺服器判定走法不合法（未轉送給對手）
     void gameStartReceived(PieceColor playerColor);
     void startGameReceived(int whiteTimeMs, int blackTimeMs, int incrementMs, PieceColor hostColor, qint64 serverTimeOffset);  // 收到開始遊戲通知（包含時間設定、房主顏色和伺服器時間偏移）
     void timeSettingsReceived(int whiteTimeMs, int blackTimeMs, int incrementMs);  // 收到時間設定更新
-    void timerStateReceived(qint64 timeA, qint64 timeB, const QString& currentPlayer, qint64 lastSwitchTime);  // 收到伺服器計時器狀態更新
+    // 收到伺服器計時器狀態更新（毫秒）；serverTimeMs 為伺服器送出時的時間，舊版伺服器為 0
+    void timerStateReceived(qint64 timeA, qint64 timeB, const QString& currentPlayer, qint64 lastSwitchTimeMs, qint64 serverTimeMs);
     void surrenderReceived();  // 收到投降訊息
     void drawOfferReceived();  // 收到和棋請求
     void drawResponseReceived(bool accepted);  // 收到和棋回應（接受或拒絕）
     void gameOverReceived(const QString& result);
     void chatReceived(const QString& message);
     void opponentDisconnected();
+    void clockSyncUpdated(qint64 serverTimeOffset, int roundTripTime, int jitter);
+    void reconnecting(int attempt, int delayMs);  // 連線中斷，delayMs 後進行第 attempt 次重新連線
+    void sessionResumed();                        // 重新連線成功，遺漏的訊息已補齊
+    void opponentConnectionLost(int graceMs);     // 對手斷線，伺服器保留座位 graceMs 毫秒
+    void opponentReconnected();
 
 private slots:
     void onConnected();
     void onDisconnected();
     void onTextMessageReceived(const QString& message);
+    void onBinaryMessageReceived(const QByteArray& message);
     void onError(QAbstractSocket::SocketError socketError);
+    void sendPing();
+    void reconnect();
 
 private:
     QWebSocket* m_webSocket;
     
-    NetworkRole m_role;
-    ConnectionStatus m_status;
-    QString m_roomNumber;
+    std::atomic<NetworkRole> m_role;
+    std::atomic<ConnectionStatus> m_status;
+    QString m_roomNumber;                   // 網路執行緒寫入時持有 m_roomNumberMutex
+    mutable QMutex m_roomNumberMutex;
     QString m_serverUrl;
     
-    PieceColor m_playerColor;
-    PieceColor m_opponentColor;
+    std::atomic<PieceColor> m_playerColor;
+    std::atomic<PieceColor> m_opponentColor;
+    std::atomic<bool> m_binaryProtocol;     // 伺服器已確認支援二進位走棋訊框
+
+    struct ClockSample {
+        qint64 rttMs;
+        qint64 offsetMs;
+    };
+    QTimer* m_pingTimer;
+    int m_pingsSent;
+    QVector<ClockSample> m_clockSamples;    // 最近的樣本（滑動視窗）
+    std::atomic<qint64> m_clockOffsetMs;
+    std::atomic<int> m_rttMs;
+    std::atomic<double> m_jitterMs;
+
+    QString m_sessionId;                    // 伺服器分配的續連憑證
+    std::atomic<quint64> m_lastSeq;         // 最後處理的對局訊息序號
+    bool m_gameInProgress;
+    std::atomic<bool> m_resuming;           // 正在重新連線或等待 resumed
+    int m_reconnectAttempt;
+    QTimer* m_reconnectTimer;
+    QVector<QJsonObject> m_pendingMessages; // 重新連線期間送出的對局訊息，續連後補送
+
+    struct UnackedMove {
+        QPoint from;
+        QPoint to;
+        PieceType promotionType = PieceType::None;
+        bool valid = false;
+    };
+    UnackedMove m_unackedMove;              // 最後送出、尚未收到伺服器轉送的走法
     
+    // 從其他執行緒呼叫時把工作交給網路執行緒並返回 true；
+    // 連線管理使用 BlockingQueuedConnection，返回時狀態已經更新
+    template <typename Fn>
+    bool dispatchToNetworkThread(Fn&& fn, Qt::ConnectionType type = Qt::QueuedConnection)
+    {
+        if (QThread::currentThread() == thread()) return false;
+        QMetaObject::invokeMethod(this, std::forward<Fn>(fn), type);
+        return true;
+    }
+
+    void setRoomNumber(const QString& roomNumber);
+    void openSocket();
+    bool canResume() const { return m_gameInProgress && !m_sessionId.isEmpty(); }
+    void scheduleReconnect();
+    void abandonResume(const QString& reason);
+    bool acceptSequence(quint64 seq);
+    void startClockSync();
+    void stopClockSync();
+    void processPong(const QJsonObject& message);
     void sendMessage(const QJsonObject& message);
     void processMessage(const QJsonObject& message);
+    void processTimerState(const QJsonObject& timerState);
     MessageType stringToMessageType(const QString& type) const;
     QString messageTypeToString(MessageType type) const;
 };
 
+Q_DECLARE_METATYPE(PieceType)
+Q_DECLARE_METATYPE(PieceColor)
+
 #endif // NETWORKMANAGER_H
@@ -114,14 +114,9 @@ const int NORMAL_PANEL_FALLBACK_HEIGHT = 100;   // 正常面板的後備高度
 // PGN 格式常數
 const int PGN_MOVES_PER_LINE = 6;            // PGN 檔案中每行的移動回合數
 
-// ELO 評分常數（用於難度顯示）
-const int ELO_BASE = 250;                    // 最低 ELO 評分（對應 Skill Level 0）
-const int ELO_PER_LEVEL = 150;               // 每級增加的 ELO 分數（確保結果能被50整除）
-
-// 計算 ELO 評分的輔助函數
-static int calculateElo(int skillLevel) {
-    return ELO_BASE + skillLevel * ELO_PER_LEVEL;
-}
+// 分析模式常數
+const int ANALYSIS_RESTART_DELAY_MS = 60;    // 局面變化後延遲多久才重新開始分析（合併快速回放）
+const int ANALYSIS_PV_DISPLAY_MOVES = 8;     // 分析結果中每條變例顯示的最多步數
 
 // 根據難度等級取得中文難度名稱
 static QString getDifficultyName(int skillLevel) {
@@ -201,6 +196,7 @@ Qt_Chess::Qt_Chess(QWidget *parent)
     , m_serverTimeB(0)
     , m_serverCurrentPlayer("White")
     , m_serverLastSwitchTime(0)
+    , m_serverTimeAtUpdate(0)
     , m_useServerTimer(false)
     , m_lastServerUpdateTime(0)
     , m_boardContainer(nullptr)
@@ -210,6 +206,8 @@ Qt_Chess::Qt_Chess(QWidget *parent)
     , m_moveListWidget(nullptr)
     , m_exportPGNButton(nullptr)
     , m_copyPGNButton(nullptr)
+    , m_analyseGameButton(nullptr)
+    , m_gameAnalyzer(nullptr)
     , m_moveListPanel(nullptr)
     , m_capturedWhitePanel(nullptr)
     , m_capturedBlackPanel(nullptr)
@@ -240,7 +238,14 @@ Qt_Chess::Qt_Chess(QWidget *parent)
     , m_difficultyLabel(nullptr)
     , m_difficultyValueLabel(nullptr)
     , m_thinkingLabel(nullptr)
+    , m_ponderCheckBox(nullptr)
+    , m_analysisEngine(nullptr)
+    , m_analysisCheckBox(nullptr)
+    , m_multiPvSpinBox(nullptr)
+    , m_analysisLabel(nullptr)
+    , m_analysisRestartTimer(nullptr)
     , m_networkManager(nullptr)
+    , m_networkThread(nullptr)
     , m_onlineModeButton(nullptr)
     , m_exitRoomButton(nullptr)
     , m_createRoomButton(nullptr)
@@ -345,6 +350,18 @@ Qt_Chess::~Qt_Chess()
         delete m_chessEngine;
         m_chessEngine = nullptr;
     }
+    if (m_analysisEngine) {
+        m_analysisEngine->stopEngine();
+        delete m_analysisEngine;
+        m_analysisEngine = nullptr;
+    }
+    
+    // 結束網路執行緒：NetworkManager 在該執行緒中關閉連線並刪除
+    if (m_networkThread) {
+        m_networkThread->quit();
+        m_networkThread->wait();
+        m_networkManager = nullptr;
+    }
     delete ui;
 }
 
@@ -420,6 +437,13 @@ void Qt_Chess::setupUI() {
     connect(m_copyPGNButton, &QPushButton::clicked, this, &Qt_Chess::onCopyPGNClicked);
     moveListLayout->addWidget(m_copyPGNButton);
 
+    // 對局分析按鈕（初始隱藏）
+    m_analyseGameButton = new QPushButton("📊 分析對局", m_moveListPanel);
+    m_analyseGameButton->setToolTip("以多個引擎同時分析每一步，標示疑問手（?!）、錯著（?）和大錯（??）");
+    m_analyseGameButton->hide();
+    connect(m_analyseGameButton, &QPushButton::clicked, this, &Qt_Chess::onAnalyseGameClicked);
+    moveListLayout->addWidget(m_analyseGameButton);
+
     // 回放控制按鈕標題 - 現代科技風格
     m_replayTitle = new QLabel("🎬 回放控制", m_moveListPanel);
     m_replayTitle->setAlignment(Qt::AlignCenter);
@@ -499,6 +523,49 @@ void Qt_Chess::setupUI() {
 
     moveListLayout->addWidget(replayButtonContainer);
 
+    // 分析模式控制：開關和變例數
+    QWidget* analysisContainer = new QWidget(m_moveListPanel);
+    QHBoxLayout* analysisLayout = new QHBoxLayout(analysisContainer);
+    analysisLayout->setContentsMargins(0, 0, 0, 0);
+    analysisLayout->setSpacing(4);
+
+    m_analysisCheckBox = new QCheckBox("🔍 局面分析", analysisContainer);
+    m_analysisCheckBox->setToolTip("引擎持續分析目前（或回放中）的局面");
+    m_analysisCheckBox->setStyleSheet(QString("QCheckBox { color: %1; padding: 3px; }").arg(THEME_TEXT_PRIMARY));
+    connect(m_analysisCheckBox, &QCheckBox::toggled, this, &Qt_Chess::onAnalysisToggled);
+    analysisLayout->addWidget(m_analysisCheckBox);
+
+    m_multiPvSpinBox = new QSpinBox(analysisContainer);
+    m_multiPvSpinBox->setRange(1, 5);
+    m_multiPvSpinBox->setValue(3);
+    m_multiPvSpinBox->setSuffix(" 條");
+    m_multiPvSpinBox->setToolTip("同時顯示的變例數");
+    connect(m_multiPvSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &Qt_Chess::onMultiPvChanged);
+    analysisLayout->addWidget(m_multiPvSpinBox);
+
+    moveListLayout->addWidget(analysisContainer);
+
+    // 分析結果（初始隱藏）
+    m_analysisLabel = new QLabel(m_moveListPanel);
+    m_analysisLabel->setWordWrap(true);
+    m_analysisLabel->setTextFormat(Qt::PlainText);
+    m_analysisLabel->setStyleSheet(QString(
+        "QLabel { "
+        "  color: %1; "
+        "  background-color: %2; "
+        "  border: 1px solid %3; "
+        "  border-radius: 4px; "
+        "  padding: 4px; "
+        "}"
+    ).arg(THEME_TEXT_PRIMARY, THEME_BG_PANEL, THEME_BORDER));
+    m_analysisLabel->hide();
+    moveListLayout->addWidget(m_analysisLabel);
+
+    m_analysisRestartTimer = new QTimer(this);
+    m_analysisRestartTimer->setSingleShot(true);
+    m_analysisRestartTimer->setInterval(ANALYSIS_RESTART_DELAY_MS);
+    connect(m_analysisRestartTimer, &QTimer::timeout, this, &Qt_Chess::restartAnalysis);
+
     // 左側棋譜面板 - 固定寬度，不參與水平伸展
     m_contentLayout->addWidget(m_moveListPanel, 1);  // 固定寬度不伸展
 
@@ -948,6 +1015,7 @@ void Qt_Chess::setupMainMenu() {
     // 與電腦對戰按鈕
     m_mainMenuComputerPlayButton = new QPushButton("🤖 與電腦對戰", m_mainMenuWidget);
     m_mainMenuComputerPlayButton->setStyleSheet(buttonStyle);
+    m_mainMenuComputerPlayButton->installEventFilter(this);  // 滑鼠移入時預先啟動引擎
     connect(m_mainMenuComputerPlayButton, &QPushButton::clicked, 
             this, &Qt_Chess::onMainMenuComputerPlayClicked);
     menuLayout->addWidget(m_mainMenuComputerPlayButton, 0, Qt::AlignCenter);
@@ -1139,7 +1207,7 @@ void Qt_Chess::setupTimeControlUI(QVBoxLayout* timeControlPanelLayout) {
     timeControlLayout->addWidget(m_difficultyLabel);
     
     // 初始值為 0（初學者），顯示 ELO 和中文難度名稱
-    int initialElo = calculateElo(0);
+    int initialElo = skillToElo(0);
     QString initialDiffName = getDifficultyName(0);
     m_difficultyValueLabel = new QLabel(QString("%1 (ELO %2)").arg(initialDiffName).arg(initialElo), this);
     m_difficultyValueLabel->setFont(labelFont);
@@ -1157,6 +1225,14 @@ void Qt_Chess::setupTimeControlUI(QVBoxLayout* timeControlPanelLayout) {
     connect(m_difficultySlider, &QSlider::valueChanged, this, &Qt_Chess::onDifficultyChanged);
     timeControlLayout->addWidget(m_difficultySlider);
     
+    // 預測思考開關：電腦在玩家思考時預先搜尋預測的回應
+    m_ponderCheckBox = new QCheckBox("🧠 利用對手時間思考", this);
+    m_ponderCheckBox->setFont(labelFont);
+    m_ponderCheckBox->setToolTip("尚無預測紀錄");
+    m_ponderCheckBox->setStyleSheet(QString("QCheckBox { color: %1; padding: 3px; }").arg(THEME_TEXT_PRIMARY));
+    connect(m_ponderCheckBox, &QCheckBox::toggled, this, &Qt_Chess::onPonderToggled);
+    timeControlLayout->addWidget(m_ponderCheckBox);
+    
     // 電腦思考中的提示標籤（初始隱藏）- 現代科技風格動畫效果
     m_thinkingLabel = new QLabel("🔄 電腦思考中...", this);
     m_thinkingLabel->setFont(labelFont);
@@ -1181,6 +1257,7 @@ void Qt_Chess::setupTimeControlUI(QVBoxLayout* timeControlPanelLayout) {
     m_difficultyLabel->setVisible(isVsComputer);
     m_difficultyValueLabel->setVisible(isVsComputer);
     m_difficultySlider->setVisible(isVsComputer);
+    m_ponderCheckBox->setVisible(isVsComputer);
 
     // 添加伸展以填充群組框中的剩餘空間
     timeControlLayout->addStretch();
@@ -1758,12 +1835,7 @@ void Qt_Chess::resetGameState() {
     }
     
     // 隱藏 PGN 按鈕
-    if (m_exportPGNButton) {
-        m_exportPGNButton->hide();
-    }
-    if (m_copyPGNButton) {
-        m_copyPGNButton->hide();
-    }
+    setPGNButtonsVisible(false);
     
     // 隱藏右側時間面板
     if (m_rightTimePanel) {
@@ -1795,6 +1867,7 @@ void Qt_Chess::onMainMenuLocalPlayClicked() {
 
 void Qt_Chess::onMainMenuComputerPlayClicked() {
     // 切換到電腦對戰模式
+    ensureEngineStarted();
     showGameContent();
     onComputerModeClicked();  // 設置為電腦模式
     // 不自動開始遊戲，讓使用者在時間控制面板選擇顏色（執白/執黑/隨機）
@@ -1903,6 +1976,9 @@ void Qt_Chess::updateBoard() {
     
     // 更新被吃掉的棋子顯示
     updateCapturedPiecesDisplay();
+    
+    // 分析模式下跟隨棋盤變化重新分析
+    scheduleAnalysis();
 }
 
 void Qt_Chess::updateSquareColor(int displayRow, int displayCol) {
@@ -2374,8 +2450,7 @@ void Qt_Chess::onNewGameClicked() {
     if (m_exitButton) m_exitButton->show();
 
     // 隱藏匯出 PGN 按鈕和複製棋譜按鈕
-    if (m_exportPGNButton) m_exportPGNButton->hide();
-    if (m_copyPGNButton) m_copyPGNButton->hide();
+    setPGNButtonsVisible(false);
 
     // 清空棋譜列表
     if (m_moveListWidget) m_moveListWidget->clear();
@@ -2559,8 +2634,7 @@ void Qt_Chess::onExitClicked() {
     if (m_exitButton) m_exitButton->show();
     
     // 隱藏匯出 PGN 按鈕和複製棋譜按鈕
-    if (m_exportPGNButton) m_exportPGNButton->hide();
-    if (m_copyPGNButton) m_copyPGNButton->hide();
+    setPGNButtonsVisible(false);
     
     // 隱藏電腦思考標籤
     if (m_thinkingLabel) m_thinkingLabel->hide();
@@ -3424,6 +3498,12 @@ void Qt_Chess::keyPressEvent(QKeyEvent *event) {
 }
 
 bool Qt_Chess::eventFilter(QObject *obj, QEvent *event) {
+    // 滑鼠移到「與電腦對戰」時預先啟動引擎，點擊時握手已完成
+    if (obj == m_mainMenuComputerPlayButton && event->type() == QEvent::Enter) {
+        ensureEngineStarted();
+        return QMainWindow::eventFilter(obj, event);
+    }
+
     // 檢查事件是否來自我們的棋盤格子按鈕之一
     QPushButton* button = qobject_cast<QPushButton*>(obj);
     if (!button) {
@@ -3584,12 +3664,18 @@ void Qt_Chess::updateTimeDisplaysFromServer() {
     qint64 currentUnixTimeMs = QDateTime::currentMSecsSinceEpoch();
     
     // 計算距離最後切換經過的時間（毫秒）
-    // m_serverLastSwitchTime 是秒數，需要轉換為毫秒
     // 如果 lastSwitchTime 為 0，表示計時器尚未啟動（等待第一步棋）
     qint64 elapsedMs = 0;
     if (m_serverLastSwitchTime > 0) {
-        qint64 lastSwitchTimeMs = m_serverLastSwitchTime * 1000;
-        elapsedMs = currentUnixTimeMs - lastSwitchTimeMs;
+        if (m_networkManager->hasClockSync()) {
+            // 已量測時鐘偏移：直接換算成伺服器時間
+            elapsedMs = currentUnixTimeMs + m_serverTimeOffset - m_serverLastSwitchTime;
+        } else if (m_serverTimeAtUpdate > 0) {
+            // 伺服器送出狀態時已經過的時間，加上收到之後本地經過的時間（不依賴兩端時鐘一致）
+            elapsedMs = (m_serverTimeAtUpdate - m_serverLastSwitchTime) + (currentUnixTimeMs - m_lastServerUpdateTime);
+        } else {
+            elapsedMs = currentUnixTimeMs - m_serverLastSwitchTime;
+        }
     }
     
     // 確定我是玩家 A (房主) 還是玩家 B (房客)
@@ -3980,6 +4066,11 @@ void Qt_Chess::saveTimeControlSettings() {
 void Qt_Chess::handleGameEnd() {
     // 停止 timer when game ends
     stopTimer();
+    
+    // 遊戲結束後不需要繼續預測思考
+    if (m_chessEngine && m_chessEngine->isPondering()) {
+        m_chessEngine->stopPondering();
+    }
     m_timerStarted = false;
     m_gameStarted = false;  // 標記遊戲已結束
     
@@ -4012,12 +4103,7 @@ void Qt_Chess::handleGameEnd() {
     moveWidgetsForGameEnd();
 
     // 顯示匯出 PGN 按鈕和複製棋譜按鈕
-    if (m_exportPGNButton) {
-        m_exportPGNButton->show();
-    }
-    if (m_copyPGNButton) {
-        m_copyPGNButton->show();
-    }
+    setPGNButtonsVisible(true);
 
     // 更新回放按鈕狀態（遊戲結束後可以回放）
     updateReplayButtons();
@@ -4302,14 +4388,22 @@ void Qt_Chess::updateMoveList() {
     m_moveListWidget->clear();
     const std::vector<MoveRecord>& moveHistory = m_chessBoard.getMoveHistory();
 
+    // 分析完成後在每步棋後面加上評價符號
+    bool annotated = hasMoveAnnotations();
+    auto notation = [&](size_t index) {
+        QString text = moveHistory[index].algebraicNotation;
+        if (annotated) text += m_moveAnnotations[static_cast<int>(index)].qualitySymbol();
+        return text;
+    };
+
     // 每兩步組合成一行（白方和黑方）
     for (size_t i = 0; i < moveHistory.size(); i += 2) {
         int moveNumber = (i / 2) + 1;
-        QString moveText = QString("%1. %2").arg(moveNumber).arg(moveHistory[i].algebraicNotation);
+        QString moveText = QString("%1. %2").arg(moveNumber).arg(notation(i));
 
         // 如果有黑方的移動，添加到同一行
         if (i + 1 < moveHistory.size()) {
-            moveText += QString(" %1").arg(moveHistory[i + 1].algebraicNotation);
+            moveText += QString(" %1").arg(notation(i + 1));
         }
 
         m_moveListWidget->addItem(moveText);
@@ -4384,17 +4478,30 @@ QString Qt_Chess::generatePGN() const {
     }
     pgn += QString("[Result \"%1\"]\n\n").arg(result);
 
-    // 移動列表
+    // 移動列表（分析過的對局附上評價符號和 [%eval] 註解）
     const std::vector<MoveRecord>& moveHistory = m_chessBoard.getMoveHistory();
+    bool annotated = hasMoveAnnotations();
     int moveNumber = 1;
     for (size_t i = 0; i < moveHistory.size(); ++i) {
+        QString move = moveHistory[i].algebraicNotation;
+        QString comment;
+        if (annotated) {
+            const MoveAnnotation& annotation = m_moveAnnotations[static_cast<int>(i)];
+            move += annotation.qualitySymbol();
+            if (annotation.hasEval) comment = QString(" {[%eval %1]}").arg(annotation.evalText());
+        }
+
         if (i % 2 == 0) {
             // 白方移動
             if (i > 0) pgn += " ";
-            pgn += QString("%1. %2").arg(moveNumber).arg(moveHistory[i].algebraicNotation);
+            pgn += QString("%1. %2").arg(moveNumber).arg(move) + comment;
         } else {
-            // 黑方移動
-            pgn += QString(" %1").arg(moveHistory[i].algebraicNotation);
+            // 黑方移動（註解之後需要重新標示回合數）
+            if (annotated && i > 0 && m_moveAnnotations[static_cast<int>(i) - 1].hasEval) {
+                pgn += QString(" %1... %2").arg(moveNumber).arg(move) + comment;
+            } else {
+                pgn += QString(" %1").arg(move) + comment;
+            }
             moveNumber++;
 
             // 每 PGN_MOVES_PER_LINE 個回合換行以提高可讀性
@@ -4413,6 +4520,66 @@ QString Qt_Chess::generatePGN() const {
     return pgn;
 }
 
+bool Qt_Chess::hasMoveAnnotations() const {
+    return !m_moveAnnotations.isEmpty() &&
+           m_moveAnnotations.size() == static_cast<int>(m_chessBoard.getMoveHistory().size());
+}
+
+void Qt_Chess::setPGNButtonsVisible(bool visible) {
+    if (m_exportPGNButton) m_exportPGNButton->setVisible(visible);
+    if (m_copyPGNButton) m_copyPGNButton->setVisible(visible);
+    if (m_analyseGameButton) {
+        m_analyseGameButton->setVisible(visible);
+        m_analyseGameButton->setEnabled(true);
+        m_analyseGameButton->setText("📊 分析對局");
+    }
+
+    // 隱藏時代表棋局重新開始，舊的分析結果不再適用
+    if (!visible) {
+        if (m_gameAnalyzer) m_gameAnalyzer->cancel();
+        m_moveAnnotations.clear();
+    }
+}
+
+void Qt_Chess::onAnalyseGameClicked() {
+    const std::vector<MoveRecord>& moveHistory = m_chessBoard.getMoveHistory();
+    if (moveHistory.empty()) return;
+
+    QString enginePath = getEnginePath();
+    if (enginePath.isEmpty() || !QFile::exists(enginePath)) {
+        QMessageBox::warning(this, "無法分析", "找不到棋局引擎，無法分析對局。");
+        return;
+    }
+
+    if (!m_gameAnalyzer) {
+        m_gameAnalyzer = new GameAnalyzer(this);
+        connect(m_gameAnalyzer, &GameAnalyzer::progress, this, [this](int finished, int total) {
+            if (m_analyseGameButton) {
+                m_analyseGameButton->setText(QString("📊 分析中... %1/%2").arg(finished).arg(total));
+            }
+        });
+        connect(m_gameAnalyzer, &GameAnalyzer::analysisFinished, this, [this]() {
+            m_moveAnnotations = m_gameAnalyzer->annotations();
+            if (m_analyseGameButton) {
+                m_analyseGameButton->setText("📊 分析完成");
+                m_analyseGameButton->setEnabled(true);
+            }
+            updateMoveList();
+        });
+        connect(m_gameAnalyzer, &GameAnalyzer::analysisFailed, this, [this](const QString& error) {
+            if (m_analyseGameButton) {
+                m_analyseGameButton->setText("📊 分析對局");
+                m_analyseGameButton->setEnabled(true);
+            }
+            QMessageBox::warning(this, "分析失敗", error);
+        });
+    }
+
+    m_analyseGameButton->setEnabled(false);
+    m_analyseGameButton->setText("📊 分析中...");
+    m_gameAnalyzer->analyse(moveHistory, enginePath);
+}
+
 // ============================================================================
 // 被吃棋子顯示系統 (Captured Pieces Display)
 // ============================================================================
@@ -4861,13 +5028,39 @@ void Qt_Chess::initializeEngine() {
     connect(m_chessEngine, &ChessEngine::bestMoveFound, this, &Qt_Chess::onEngineBestMove);
     connect(m_chessEngine, &ChessEngine::engineError, this, &Qt_Chess::onEngineError);
     connect(m_chessEngine, &ChessEngine::thinkingStarted, this, [this]() {
-        if (m_thinkingLabel) m_thinkingLabel->show();
+        if (m_thinkingLabel) {
+            m_thinkingLabel->setText("🔄 電腦思考中...");
+            m_thinkingLabel->show();
+        }
+    });
+    connect(m_chessEngine, &ChessEngine::analysisUpdated, this, [this](const QVector<EngineInfo>& lines) {
+        // 在思考提示中顯示目前的搜尋深度和評分（信號已由引擎節流）
+        if (!m_thinkingLabel || lines.isEmpty() || !m_chessEngine->isThinking()) return;
+        const EngineInfo& info = lines.first();
+        m_thinkingLabel->setText(QString("🔄 電腦思考中... 深度 %1 ｜ %2").arg(info.depth).arg(info.scoreText()));
     });
     connect(m_chessEngine, &ChessEngine::thinkingStopped, this, [this]() {
         if (m_thinkingLabel) m_thinkingLabel->hide();
     });
+    connect(m_chessEngine, &ChessEngine::ponderStatsChanged, this, &Qt_Chess::onPonderStatsChanged);
+    connect(m_chessEngine, &ChessEngine::engineRestarted, this, [this](int restartCount, qint64 downtimeMs) {
+        qDebug() << "[Qt_Chess] Engine restarted (" << restartCount << "times ), downtime" << downtimeMs << "ms";
+        if (m_thinkingLabel && m_chessEngine->isThinking()) {
+            m_thinkingLabel->setText("⚠ 引擎已重新啟動，繼續思考中...");
+        }
+    });
+    
+    if (m_ponderCheckBox) {
+        m_chessEngine->setPonderEnabled(m_ponderCheckBox->isChecked());
+    }
+    
+    // 程式啟動時就在背景啟動引擎並完成 UCI 握手，開始對弈時不需等待
+    ensureEngineStarted();
+}
+
+void Qt_Chess::ensureEngineStarted() {
+    if (!m_chessEngine || m_chessEngine->getState() != EngineState::Stopped) return;
     
-    // 嘗試啟動引擎
     QString enginePath = getEnginePath();
     if (!enginePath.isEmpty() && QFile::exists(enginePath)) {
         m_chessEngine->startEngine(enginePath);
@@ -4901,6 +5094,9 @@ void Qt_Chess::onHumanModeClicked() {
 }
 
 void Qt_Chess::onComputerModeClicked() {
+    // 引擎可能因錯誤結束，確保在選邊前已重新啟動
+    ensureEngineStarted();
+    
     // 切換到電腦模式，顯示選邊按鈕
     // 預設選擇執白（如果尚未選擇）
     if (m_currentGameMode == GameMode::HumanVsHuman) {
@@ -5013,7 +5209,7 @@ void Qt_Chess::onDifficultyChanged(int value) {
     if (!m_difficultyValueLabel || !m_chessEngine) return;
     
     // 使用輔助函數計算 ELO 評分和中文難度名稱
-    int elo = calculateElo(value);
+    int elo = skillToElo(value);
     QString diffName = getDifficultyName(value);
     
     // 更新顯示的難度值（顯示中文難度名稱和 ELO）
@@ -5104,6 +5300,11 @@ void Qt_Chess::onEngineBestMove(const QString& move) {
         updateTimeDisplays();
         
         updateStatus();
+        
+        // 在玩家思考時預測其回應
+        if (m_gameStarted) {
+            startEnginePondering();
+        }
     }
 }
 
@@ -5134,14 +5335,156 @@ void Qt_Chess::onEngineError(const QString& error) {
 }
 
 void Qt_Chess::requestEngineMove() {
-    if (!m_chessEngine || !m_chessEngine->isEngineRunning()) return;
+    // 引擎仍在啟動時也可以送出，命令會在就緒後才傳給引擎
+    if (!m_chessEngine) return;
+    if (!m_chessEngine->isEngineRunning() && !m_chessEngine->isEngineStarting()) return;
     if (!m_gameStarted || m_isReplayMode) return;
     
+    SearchLimits clock = currentEngineClock();
+    
+    // 引擎正在預測思考：玩家走了預測的棋則直接轉為正式搜尋
+    if (m_chessEngine->isPondering()) {
+        if (!m_uciMoveHistory.isEmpty() && m_uciMoveHistory.last() == m_chessEngine->getPonderMove()) {
+            m_chessEngine->ponderHit(clock, m_chessBoard.getCurrentPlayer());
+            return;
+        }
+        m_chessEngine->stopPondering();
+    }
+    
     // 使用移動歷史設定當前位置
     m_chessEngine->setPositionFromMoves(m_uciMoveHistory);
     
     // 請求引擎計算最佳走法
-    m_chessEngine->requestMove();
+    m_chessEngine->requestMove(clock, m_chessBoard.getCurrentPlayer());
+}
+
+void Qt_Chess::startEnginePondering() {
+    if (!m_chessEngine || !m_chessEngine->isPonderEnabled()) return;
+    if (!m_gameStarted || m_isReplayMode || isComputerTurn()) return;
+    
+    m_chessEngine->startPondering(m_uciMoveHistory, currentEngineClock());
+}
+
+SearchLimits Qt_Chess::currentEngineClock() const {
+    // 將實際棋鐘傳給引擎（初始時間為 0 的一方不限時）
+    SearchLimits clock;
+    if (m_timeControlEnabled) {
+        if (m_whiteInitialTimeMs > 0) clock.whiteTimeMs = m_whiteTimeMs;
+        if (m_blackInitialTimeMs > 0) clock.blackTimeMs = m_blackTimeMs;
+        clock.whiteIncrementMs = m_incrementMs;
+        clock.blackIncrementMs = m_incrementMs;
+    }
+    return clock;
+}
+
+void Qt_Chess::onPonderToggled(bool enabled) {
+    if (m_chessEngine) {
+        m_chessEngine->setPonderEnabled(enabled);
+    }
+    saveEngineSettings();
+}
+
+void Qt_Chess::onPonderStatsChanged(int hits, int total) {
+    if (!m_ponderCheckBox || total <= 0) return;
+    
+    int rate = hits * 100 / total;
+    m_ponderCheckBox->setToolTip(QString("預測命中率：%1 / %2（%3%）").arg(hits).arg(total).arg(rate));
+    qDebug() << "[Qt_Chess] Ponder hit rate:" << hits << "/" << total;
+}
+
+void Qt_Chess::onAnalysisToggled(bool enabled) {
+    if (!enabled) {
+        m_analysisRestartTimer->stop();
+        if (m_analysisEngine) m_analysisEngine->stopAnalysis();
+        m_analyzedFen.clear();
+        m_analysisLabel->hide();
+        return;
+    }
+    
+    m_analysisLabel->setText("🔄 分析中...");
+    m_analysisLabel->show();
+    
+    // 第一次使用時才啟動分析用的引擎行程
+    if (!m_analysisEngine) {
+        QString enginePath = getEnginePath();
+        if (enginePath.isEmpty() || !QFile::exists(enginePath)) {
+            m_analysisLabel->setText("找不到引擎，無法分析");
+            return;
+        }
+        
+        m_analysisEngine = new ChessEngine(this);
+        m_analysisEngine->setAnalysisUpdateRate(5);
+        m_analysisEngine->setDifficulty(20);  // 分析使用完整棋力，結果才能寫入評分快取
+        m_analysisEngine->setEvalCache(EvalCache::shared());
+        connect(m_analysisEngine, &ChessEngine::analysisUpdated, this, &Qt_Chess::onAnalysisUpdated);
+        connect(m_analysisEngine, &ChessEngine::engineReady, this, &Qt_Chess::restartAnalysis);
+        connect(m_analysisEngine, &ChessEngine::engineError, this, [this](const QString& error) {
+            qWarning() << "[Qt_Chess] Analysis engine error:" << error;
+            m_analyzedFen.clear();
+            if (m_analysisLabel) m_analysisLabel->setText(QString("分析引擎錯誤：%1").arg(error));
+        });
+        m_analysisEngine->startEngine(enginePath);
+        return;
+    }
+    
+    scheduleAnalysis();
+}
+
+void Qt_Chess::onMultiPvChanged(int value) {
+    Q_UNUSED(value);
+    
+    // 變例數改變時需要重新搜尋同一局面
+    m_analyzedFen.clear();
+    scheduleAnalysis();
+}
+
+void Qt_Chess::scheduleAnalysis() {
+    if (!m_analysisCheckBox || !m_analysisCheckBox->isChecked()) return;
+    
+    // 快速連續的局面變化（例如連按回放按鈕）只觸發一次重新分析
+    m_analysisRestartTimer->start();
+}
+
+void Qt_Chess::restartAnalysis() {
+    if (!m_analysisEngine || !m_analysisEngine->isEngineRunning()) return;
+    if (!m_analysisCheckBox || !m_analysisCheckBox->isChecked()) return;
+    
+    // 線上對戰中不提供引擎分析
+    if (m_isOnlineGame && m_gameStarted) {
+        m_analysisEngine->stopAnalysis();
+        m_analyzedFen.clear();
+        m_analysisLabel->setText("線上對戰中無法使用分析");
+        return;
+    }
+    
+    QString fen = ChessEngine::boardToFEN(m_chessBoard);
+    if (fen == m_analyzedFen && m_analysisEngine->isAnalyzing()) return;
+    
+    m_analyzedFen = fen;
+    m_analysisLabel->setText("🔄 分析中...");
+    m_analysisEngine->startAnalysis(fen, m_multiPvSpinBox->value());
+}
+
+void Qt_Chess::onAnalysisUpdated(const QVector<EngineInfo>& lines) {
+    if (!m_analysisLabel || lines.isEmpty()) return;
+    
+    // 引擎的評分以行棋方為準，轉換為白方觀點顯示
+    bool blackToMove = m_analyzedFen.section(' ', 1, 1) == "b";
+    
+    QStringList text;
+    text << QString("深度 %1").arg(lines.first().depth);
+    for (const EngineInfo& line : lines) {
+        EngineInfo whiteView = line;
+        if (blackToMove) {
+            whiteView.scoreCp = -line.scoreCp;
+            whiteView.mateIn = -line.mateIn;
+        }
+        QStringList pv = line.pvMoves();
+        QString moves = pv.mid(0, ANALYSIS_PV_DISPLAY_MOVES).join(" ");
+        if (pv.size() > ANALYSIS_PV_DISPLAY_MOVES) moves += " …";
+        text << QString("%1  %2").arg(whiteView.scoreText(), moves);
+    }
+    m_analysisLabel->setText(text.join("\n"));
 }
 
 bool Qt_Chess::isComputerTurn() const {
@@ -5196,6 +5539,7 @@ void Qt_Chess::loadEngineSettings() {
     
     int gameMode = settings.value("gameMode", static_cast<int>(GameMode::HumanVsHuman)).toInt();
     int difficulty = settings.value("difficulty", 0).toInt();  // 預設初學者
+    bool ponder = settings.value("ponder", false).toBool();
     
     // 設定遊戲模式
     m_currentGameMode = static_cast<GameMode>(gameMode);
@@ -5205,6 +5549,11 @@ void Qt_Chess::loadEngineSettings() {
         m_difficultySlider->setValue(difficulty);
         onDifficultyChanged(difficulty);  // 更新顯示（同時設定搜尋深度）
     }
+    
+    if (m_ponderCheckBox) {
+        QSignalBlocker blocker(m_ponderCheckBox);
+        m_ponderCheckBox->setChecked(ponder);
+    }
 }
 
 void Qt_Chess::saveEngineSettings() {
@@ -5216,6 +5565,10 @@ void Qt_Chess::saveEngineSettings() {
         settings.setValue("difficulty", m_difficultySlider->value());
     }
     
+    if (m_ponderCheckBox) {
+        settings.setValue("ponder", m_ponderCheckBox->isChecked());
+    }
+    
     settings.sync();
 }
 
@@ -5313,6 +5666,7 @@ void Qt_Chess::updateGameModeUI() {
     if (m_difficultyLabel) m_difficultyLabel->setVisible(!isHumanMode);
     if (m_difficultyValueLabel) m_difficultyValueLabel->setVisible(!isHumanMode);
     if (m_difficultySlider) m_difficultySlider->setVisible(!isHumanMode);
+    if (m_ponderCheckBox) m_ponderCheckBox->setVisible(!isHumanMode);
 }
 
 // ============================================================================
@@ -5320,9 +5674,15 @@ void Qt_Chess::updateGameModeUI() {
 // ============================================================================
 
 void Qt_Chess::initializeNetwork() {
-    m_networkManager = new NetworkManager(this);
-    
-    // 連接信號
+    // 網路管理器在專用執行緒上收發與解碼，對話框或重繪不會延遲處理伺服器訊息
+    m_networkThread = new QThread(this);
+    m_networkThread->setObjectName("NetworkThread");
+    m_networkManager = new NetworkManager();
+    m_networkManager->moveToThread(m_networkThread);
+    connect(m_networkThread, &QThread::finished, m_networkManager, &QObject::deleteLater);
+    m_networkThread->start();
+    
+    // 連接信號（跨執行緒，自動使用佇列連線）
     connect(m_networkManager, &NetworkManager::connected, this, &Qt_Chess::onNetworkConnected);
     connect(m_networkManager, &NetworkManager::disconnected, this, &Qt_Chess::onNetworkDisconnected);
     connect(m_networkManager, &NetworkManager::connectionError, this, &Qt_Chess::onNetworkError);
@@ -5331,10 +5691,17 @@ void Qt_Chess::initializeNetwork() {
     connect(m_networkManager, &NetworkManager::playerLeft, this, &Qt_Chess::onPlayerLeft);
     connect(m_networkManager, &NetworkManager::promotedToHost, this, &Qt_Chess::onPromotedToHost);
     connect(m_networkManager, &NetworkManager::opponentMove, this, &Qt_Chess::onOpponentMove);
+    connect(m_networkManager, &NetworkManager::moveRejected, this, &Qt_Chess::onMoveRejected);
+    connect(m_networkManager, &NetworkManager::gameOverReceived, this, &Qt_Chess::onGameOverReceived);
     connect(m_networkManager, &NetworkManager::gameStartReceived, this, &Qt_Chess::onGameStartReceived);
     connect(m_networkManager, &NetworkManager::startGameReceived, this, &Qt_Chess::onStartGameReceived);
     connect(m_networkManager, &NetworkManager::timeSettingsReceived, this, &Qt_Chess::onTimeSettingsReceived);
     connect(m_networkManager, &NetworkManager::timerStateReceived, this, &Qt_Chess::onTimerStateReceived);
+    connect(m_networkManager, &NetworkManager::clockSyncUpdated, this, &Qt_Chess::onClockSyncUpdated);
+    connect(m_networkManager, &NetworkManager::reconnecting, this, &Qt_Chess::onNetworkReconnecting);
+    connect(m_networkManager, &NetworkManager::sessionResumed, this, &Qt_Chess::onSessionResumed);
+    connect(m_networkManager, &NetworkManager::opponentConnectionLost, this, &Qt_Chess::onOpponentConnectionLost);
+    connect(m_networkManager, &NetworkManager::opponentReconnected, this, &Qt_Chess::onOpponentReconnected);
     connect(m_networkManager, &NetworkManager::surrenderReceived, this, &Qt_Chess::onSurrenderReceived);
     connect(m_networkManager, &NetworkManager::drawOfferReceived, this, &Qt_Chess::onDrawOfferReceived);
     connect(m_networkManager, &NetworkManager::drawResponseReceived, this, &Qt_Chess::onDrawResponseReceived);
@@ -5357,11 +5724,12 @@ void Qt_Chess::onOnlineModeClicked() {
     m_difficultyLabel->hide();
     m_difficultyValueLabel->hide();
     m_difficultySlider->hide();
+    m_ponderCheckBox->hide();
     m_gameModeStatusLabel->hide();
     
-    // 停止引擎
+    // 停止搜尋，但保留引擎行程以便之後的電腦對弈不需重新啟動
     if (m_chessEngine) {
-        m_chessEngine->stopEngine();
+        m_chessEngine->stop();
     }
     
     // 顯示創建房間和加入房間按鈕，不再彈出對話框
@@ -5443,7 +5811,7 @@ void Qt_Chess::onJoinRoomButtonClicked() {
     bool ok;
     QString roomNumber = QInputDialog::getText(this, 
         "加入房間", 
-        "請輸入房號（4位數字）：",
+        QString("請輸入房號（%1位數字）：").arg(ROOM_NUMBER_LENGTH),
         QLineEdit::Normal,
         "",
         &ok);
@@ -5455,7 +5823,7 @@ void Qt_Chess::onJoinRoomButtonClicked() {
     // 驗證房號格式
     roomNumber = roomNumber.trimmed();
     if (roomNumber.length() != ROOM_NUMBER_LENGTH) {
-        QMessageBox::warning(this, "輸入錯誤", "房號必須是4位數字");
+        QMessageBox::warning(this, "輸入錯誤", QString("房號必須是%1位數字").arg(ROOM_NUMBER_LENGTH));
         return;
     }
     
@@ -5790,6 +6158,85 @@ void Qt_Chess::onOpponentMove(const QPoint& from, const QPoint& to, PieceType pr
     }
 }
 
+void Qt_Chess::onMoveRejected(const QPoint& from, const QPoint& to, const QString& reason) {
+    // 伺服器保有權威局面：被拒絕的走法不會出現在對手的棋盤上
+    qWarning() << "[Qt_Chess::onMoveRejected] Server rejected move from" << from << "to" << to << ":" << reason;
+
+    // 本地已先走了這步棋，撤回它讓棋盤回到伺服器的局面
+    std::vector<MoveRecord> moveHistory = m_chessBoard.getMoveHistory();
+    if (moveHistory.empty() || moveHistory.back().from != from || moveHistory.back().to != to) {
+        m_connectionStatusLabel->setText(QString("⚠️ 伺服器拒絕了這步棋（%1），棋盤可能與對手不同步").arg(reason));
+        return;
+    }
+    moveHistory.pop_back();
+
+    m_chessBoard.initializeBoard();
+    for (const MoveRecord& move : moveHistory) {
+        m_chessBoard.movePiece(move.from, move.to);
+        if (move.isPromotion) {
+            m_chessBoard.promotePawn(move.to, move.promotionType);
+        }
+    }
+    m_chessBoard.setMoveHistory(moveHistory);
+
+    if (moveHistory.empty()) {
+        m_lastMoveFrom = QPoint(-1, -1);
+        m_lastMoveTo = QPoint(-1, -1);
+    } else {
+        m_lastMoveFrom = moveHistory.back().from;
+        m_lastMoveTo = moveHistory.back().to;
+    }
+
+    clearHighlights();
+    updateBoard();
+    updateStatus();
+    updateMoveList();
+    updateCapturedPiecesDisplay();
+    m_connectionStatusLabel->setText(QString("⚠️ 伺服器拒絕了這步棋（%1），已撤回").arg(reason));
+}
+
+void Qt_Chess::onGameOverReceived(const QString& result) {
+    // 本地已判定結束（將死、逼和等）時不重複處理；伺服器另外判定的和棋規則由這裡結束對局
+    if (!m_gameStarted || m_chessBoard.getGameResult() != GameResult::InProgress) return;
+
+    qDebug() << "[Qt_Chess::onGameOverReceived] Server ended the game:" << result;
+    if (result == "1-0") {
+        m_chessBoard.setGameResult(GameResult::WhiteWins);
+    } else if (result == "0-1") {
+        m_chessBoard.setGameResult(GameResult::BlackWins);
+    } else if (result == "1/2-1/2") {
+        m_chessBoard.setGameResult(GameResult::Draw);
+    } else {
+        return;
+    }
+    handleGameEnd();
+}
+
+void Qt_Chess::onClockSyncUpdated(qint64 serverTimeOffset, int roundTripTime, int jitter) {
+    // 持續以量測值修正時間偏移，取代開局時 serverTimestamp 的估計
+    m_serverTimeOffset = serverTimeOffset;
+    m_connectionStatusLabel->setToolTip(QString("延遲 %1 ms（抖動 %2 ms）| 時鐘偏移 %3 ms")
+                                        .arg(roundTripTime).arg(jitter).arg(serverTimeOffset));
+}
+
+void Qt_Chess::onNetworkReconnecting(int attempt, int delayMs) {
+    // 對局保留在伺服器上，續連成功後會補上斷線期間的棋步
+    m_connectionStatusLabel->setText(QString("🔄 連線中斷，%1 秒後重新連線（第 %2 次）")
+                                     .arg(qMax(1, (delayMs + 999) / 1000)).arg(attempt));
+}
+
+void Qt_Chess::onSessionResumed() {
+    m_connectionStatusLabel->setText("✅ 已重新連線");
+}
+
+void Qt_Chess::onOpponentConnectionLost(int graceMs) {
+    m_connectionStatusLabel->setText(QString("⚠️ 對手連線中斷，等待重新連線（最多 %1 秒）").arg(graceMs / 1000));
+}
+
+void Qt_Chess::onOpponentReconnected() {
+    m_connectionStatusLabel->setText("✅ 對手已重新連線");
+}
+
 void Qt_Chess::onGameStartReceived(PieceColor playerColor) {
     m_connectionStatusLabel->setText("✅ 連線成功！遊戲開始");
     
@@ -6185,18 +6632,20 @@ void Qt_Chess::onTimeSettingsReceived(int whiteTimeMs, int blackTimeMs, int incr
     }
 }
 
-void Qt_Chess::onTimerStateReceived(qint64 timeA, qint64 timeB, const QString& currentPlayer, qint64 lastSwitchTime) {
+void Qt_Chess::onTimerStateReceived(qint64 timeA, qint64 timeB, const QString& currentPlayer, qint64 lastSwitchTimeMs, qint64 serverTimeMs) {
     qDebug() << "[Qt_Chess::onTimerStateReceived] Received timer state"
              << "| timeA:" << timeA
              << "| timeB:" << timeB
              << "| currentPlayer:" << currentPlayer
-             << "| lastSwitchTime:" << lastSwitchTime;
+             << "| lastSwitchTimeMs:" << lastSwitchTimeMs
+             << "| serverTimeMs:" << serverTimeMs;
     
     // 儲存伺服器計時器狀態
     m_serverTimeA = timeA;
     m_serverTimeB = timeB;
     m_serverCurrentPlayer = currentPlayer;
-    m_serverLastSwitchTime = lastSwitchTime;
+    m_serverLastSwitchTime = lastSwitchTimeMs;
+    m_serverTimeAtUpdate = serverTimeMs;
     m_useServerTimer = true;  // 啟用伺服器計時器模式
     m_lastServerUpdateTime = QDateTime::currentMSecsSinceEpoch();  // 記錄更新時間
     
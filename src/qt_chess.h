@@ -18,6 +18,8 @@
 #include <QAction>
 #include <QComboBox>
 #include <QSlider>
+#include <QCheckBox>
+#include <QSpinBox>
 #include <QTimer>
 #include <QRandomGenerator>
 #include <QGroupBox>
@@ -30,6 +32,7 @@
 #include <vector>
 #include "chessboard.h"
 #include "chessengine.h"
+#include "gameanalyzer.h"
 #include "soundsettingsdialog.h"
 #include "pieceiconsettingsdialog.h"
 #include "boardcolorsettingsdialog.h"
@@ -45,9 +48,9 @@ QT_END_NAMESPACE
 
 // Constants for online mode
 constexpr qint64 DRAW_REQUEST_COOLDOWN_MS = 3000;  // 3 seconds cooldown for draw requests
-constexpr int ROOM_NUMBER_MIN = 1000;              // Minimum room number
-constexpr int ROOM_NUMBER_MAX = 9999;              // Maximum room number
-constexpr int ROOM_NUMBER_LENGTH = 4;              // Room number length
+constexpr int ROOM_NUMBER_MIN = 100000;            // Minimum room number
+constexpr int ROOM_NUMBER_MAX = 999999;            // Maximum room number
+constexpr int ROOM_NUMBER_LENGTH = 6;              // Room number length
 
 class Qt_Chess : public QMainWindow
 {
@@ -79,6 +82,7 @@ private slots:
     void onStartButtonClicked();
     void onExportPGNClicked();
     void onCopyPGNClicked();
+    void onAnalyseGameClicked();
     void onToggleBackgroundMusicClicked();
     void onCheckForUpdatesClicked();
     void onUpdateCheckFinished(bool updateAvailable);
@@ -179,7 +183,8 @@ private:
     qint64 m_serverTimeA;                // 玩家 A (房主) 剩餘時間（毫秒）
     qint64 m_serverTimeB;                // 玩家 B (房客) 剩餘時間（毫秒）
     QString m_serverCurrentPlayer;       // 伺服器端當前玩家 ("White" or "Black")
-    qint64 m_serverLastSwitchTime;       // 伺服器最後切換時間（UNIX 秒數）
+    qint64 m_serverLastSwitchTime;       // 伺服器最後切換時間（毫秒）
+    qint64 m_serverTimeAtUpdate;         // 伺服器送出計時器狀態時的伺服器時間（毫秒），舊版伺服器為 0
     bool m_useServerTimer;               // 是否使用伺服器控制的計時器
     qint64 m_lastServerUpdateTime;       // 最後一次收到伺服器更新的本地時間（毫秒）
     
@@ -193,6 +198,9 @@ private:
     QListWidget* m_moveListWidget;
     QPushButton* m_exportPGNButton;
     QPushButton* m_copyPGNButton;
+    QPushButton* m_analyseGameButton;    // 對局分析按鈕（遊戲結束後顯示）
+    GameAnalyzer* m_gameAnalyzer;
+    QVector<MoveAnnotation> m_moveAnnotations;  // 每一步的分析結果（未分析時為空）
     QWidget* m_moveListPanel;
     
     // ========================================
@@ -235,12 +243,22 @@ private:
     QLabel* m_difficultyLabel;
     QLabel* m_difficultyValueLabel;
     QLabel* m_thinkingLabel;             // 顯示「電腦思考中...」
+    QCheckBox* m_ponderCheckBox;         // 預測思考（Ponder）開關
     QStringList m_uciMoveHistory;        // UCI 格式的移動歷史
     
+    // 分析模式（使用獨立的引擎行程，不影響對弈引擎）
+    ChessEngine* m_analysisEngine;
+    QCheckBox* m_analysisCheckBox;       // 分析模式開關
+    QSpinBox* m_multiPvSpinBox;          // 同時顯示的變例數
+    QLabel* m_analysisLabel;             // 顯示分析結果
+    QTimer* m_analysisRestartTimer;      // 合併短時間內的多次局面變化
+    QString m_analyzedFen;               // 目前正在分析的局面
+    
     // ========================================
     // 線上對戰系統 (Online Game System)
     // ========================================
     NetworkManager* m_networkManager;    // 網路管理器
+    QThread* m_networkThread;            // 網路管理器所在的執行緒（不受 GUI 阻塞影響）
     QPushButton* m_onlineModeButton;     // 線上對戰按鈕
     QPushButton* m_exitRoomButton;       // 退出房間按鈕
     QPushButton* m_createRoomButton;     // 創建房間按鈕（右側面板）
@@ -383,6 +401,8 @@ private:
     void exportPGN();
     void copyPGN();
     QString generatePGN() const;
+    bool hasMoveAnnotations() const;
+    void setPGNButtonsVisible(bool visible);
     
     // ========================================
     // 被吃棋子顯示系統 (Captured Pieces Display)
@@ -408,16 +428,26 @@ private:
     // 電腦對弈系統 (Computer Chess Engine)
     // ========================================
     void initializeEngine();
+    void ensureEngineStarted();
     void onHumanModeClicked();
     void onComputerModeClicked();
     void onWhiteColorClicked();
     void onRandomColorClicked();
     void onBlackColorClicked();
     void onDifficultyChanged(int value);
+    void onPonderToggled(bool enabled);
+    void onPonderStatsChanged(int hits, int total);
+    void onAnalysisToggled(bool enabled);
+    void onMultiPvChanged(int value);
+    void onAnalysisUpdated(const QVector<EngineInfo>& lines);
+    void scheduleAnalysis();
+    void restartAnalysis();
     void onEngineBestMove(const QString& move);
     void onEngineReady();
     void onEngineError(const QString& error);
     void requestEngineMove();
+    void startEnginePondering();
+    SearchLimits currentEngineClock() const;
     bool isComputerTurn() const;
     bool isPlayerPiece(PieceColor pieceColor) const;
     GameMode getCurrentGameMode() const;
@@ -441,10 +471,17 @@ private:
     void onPlayerLeft();
     void onPromotedToHost();
     void onOpponentMove(const QPoint& from, const QPoint& to, PieceType promotionType);
+    void onMoveRejected(const QPoint& from, const QPoint& to, const QString& reason);
+    void onGameOverReceived(const QString& result);
+    void onClockSyncUpdated(qint64 serverTimeOffset, int roundTripTime, int jitter);
+    void onNetworkReconnecting(int attempt, int delayMs);
+    void onSessionResumed();
+    void onOpponentConnectionLost(int graceMs);
+    void onOpponentReconnected();
     void onGameStartReceived(PieceColor playerColor);
     void onStartGameReceived(int whiteTimeMs, int blackTimeMs, int incrementMs, PieceColor hostColor, qint64 serverTimeOffset);
     void onTimeSettingsReceived(int whiteTimeMs, int blackTimeMs, int incrementMs);
-    void onTimerStateReceived(qint64 timeA, qint64 timeB, const QString& currentPlayer, qint64 lastSwitchTime);
+    void onTimerStateReceived(qint64 timeA, qint64 timeB, const QString& currentPlayer, qint64 lastSwitchTimeMs, qint64 serverTimeMs);
     void onSurrenderReceived();
     void onDrawOfferReceived();
     void onDrawResponseReceived(bool accepted);
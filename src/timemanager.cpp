@@ -0,0 +1,93 @@
+#include "timemanager.h"
+#include <QtGlobal>
+#include <limits>
+
+namespace {
+const int MOVE_OVERHEAD_MS = 50;          // 預留給行程通訊和 GUI 的時間
+const int DEFAULT_MOVES_TO_GO = 30;       // 突然死亡制時估計的剩餘步數
+const int MAX_MOVES_TO_GO = 50;           // movestogo 的上限
+const int MIN_SOFT_LIMIT_MS = 10;         // 軟性上限的最小值
+const int HARD_LIMIT_MULTIPLIER = 4;      // 硬性上限為軟性上限的倍數
+const double MAX_HARD_FRACTION = 0.5;     // 硬性上限最多使用剩餘時間的比例
+const int STABLE_ITERATIONS = 4;          // 判定最佳走法穩定所需的連續深度數
+const int SCORE_DROP_THRESHOLD_CP = 30;   // 評分下降超過此值時延長思考
+const int MIN_DEPTH_FOR_DECISION = 4;     // 低於此深度時不做提早停止的判斷
+}
+
+TimeManager::TimeManager()
+{
+    reset();
+}
+
+void TimeManager::reset()
+{
+    m_active = false;
+    m_softLimitMs = 0;
+    m_hardLimitMs = 0;
+    m_lastDepth = 0;
+    m_bestScoreCp = std::numeric_limits<int>::min();
+    m_lastBestMove.clear();
+    m_stableIterations = 0;
+}
+
+void TimeManager::start(const SearchLimits& limits, PieceColor side)
+{
+    reset();
+
+    if (!limits.hasClock(side)) {
+        return;
+    }
+
+    int timeLeft = (side == PieceColor::White) ? limits.whiteTimeMs : limits.blackTimeMs;
+    int increment = (side == PieceColor::White) ? limits.whiteIncrementMs : limits.blackIncrementMs;
+    int movesToGo = limits.movesToGo > 0 ? qMin(limits.movesToGo, MAX_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO;
+
+    int available = qMax(1, timeLeft - MOVE_OVERHEAD_MS);
+
+    // 平均分配剩餘時間，並使用大部分的增量
+    int soft = available / movesToGo + (increment * 3) / 4;
+    soft = qBound(MIN_SOFT_LIMIT_MS, soft, qMax(MIN_SOFT_LIMIT_MS, available / 2));
+
+    int hard = qMin(soft * HARD_LIMIT_MULTIPLIER, static_cast<int>(available * MAX_HARD_FRACTION));
+    hard = qMax(hard, soft);
+
+    m_softLimitMs = soft;
+    m_hardLimitMs = hard;
+    m_active = true;
+}
+
+bool TimeManager::onIteration(int depth, int scoreCp, const QString& bestMove, qint64 elapsedMs)
+{
+    if (!m_active) return false;
+
+    // 同一深度的重複資訊（例如 MultiPV 或 seldepth 更新）只處理一次
+    if (depth <= m_lastDepth) return false;
+
+    bool scoreDropped = (m_bestScoreCp != std::numeric_limits<int>::min()) &&
+                        (scoreCp < m_bestScoreCp - SCORE_DROP_THRESHOLD_CP);
+
+    if (bestMove == m_lastBestMove) {
+        m_stableIterations++;
+    } else {
+        m_stableIterations = 0;
+    }
+
+    m_lastDepth = depth;
+    m_lastBestMove = bestMove;
+    m_bestScoreCp = qMax(m_bestScoreCp, scoreCp);
+
+    if (elapsedMs >= m_hardLimitMs) return true;
+    if (depth < MIN_DEPTH_FOR_DECISION) return false;
+
+    // 根據最佳走法穩定度和評分變化調整本步的目標時間
+    double scale = 1.0;
+    if (m_stableIterations >= STABLE_ITERATIONS) {
+        scale *= 0.5;
+    }
+    if (scoreDropped) {
+        scale *= 2.0;
+    }
+
+    qint64 target = qMin(static_cast<qint64>(m_softLimitMs * scale), static_cast<qint64>(m_hardLimitMs));
+    return elapsedMs >= target;
+}
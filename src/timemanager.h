@@ -0,0 +1,57 @@
+#ifndef TIMEMANAGER_H
+#define TIMEMANAGER_H
+
+#include <QString>
+#include "chesspiece.h"
+
+// 搜尋限制（對應 UCI go 命令的參數）
+// 時間欄位為 -1 表示該方沒有時間限制，0 表示不傳送該參數
+struct SearchLimits {
+    int whiteTimeMs = -1;        // wtime：白方剩餘時間（毫秒）
+    int blackTimeMs = -1;        // btime：黑方剩餘時間（毫秒）
+    int whiteIncrementMs = 0;    // winc：白方每步增量（毫秒）
+    int blackIncrementMs = 0;    // binc：黑方每步增量（毫秒）
+    int movesToGo = 0;           // movestogo：距離下次加時的步數（0 表示突然死亡制）
+    int moveTimeMs = 0;          // movetime：固定思考時間（毫秒）
+    int depth = 0;               // depth：最大搜尋深度
+    qint64 nodes = 0;            // nodes：最大搜尋節點數
+    bool infinite = false;       // infinite：無限搜尋直到收到 stop
+    bool ponder = false;         // ponder：在對手的時間預先思考
+
+    // 指定方是否有時鐘限制
+    bool hasClock(PieceColor side) const {
+        return (side == PieceColor::White ? whiteTimeMs : blackTimeMs) > 0;
+    }
+};
+
+// 引擎思考時間管理器
+// 根據棋鐘計算每步的軟性/硬性時間上限，並依據每次迭代的結果決定是否提早停止：
+// - 最佳走法連續數個深度都沒有改變時，在軟性上限的一半即可停止
+// - 評分明顯下降時延長思考時間（但絕不超過硬性上限）
+class TimeManager
+{
+public:
+    TimeManager();
+
+    // 開始新的一步：根據限制和行棋方計算時間預算
+    void start(const SearchLimits& limits, PieceColor side);
+    void reset();
+
+    bool isActive() const { return m_active; }
+    int softLimitMs() const { return m_softLimitMs; }
+    int hardLimitMs() const { return m_hardLimitMs; }
+
+    // 每完成一個搜尋深度時呼叫，返回 true 表示應該停止搜尋
+    bool onIteration(int depth, int scoreCp, const QString& bestMove, qint64 elapsedMs);
+
+private:
+    bool m_active;
+    int m_softLimitMs;          // 軟性上限：一般情況下的思考時間
+    int m_hardLimitMs;          // 硬性上限：無論如何都必須停止的時間
+    int m_lastDepth;
+    int m_bestScoreCp;          // 本次搜尋中的最高評分（用於偵測評分下降）
+    QString m_lastBestMove;
+    int m_stableIterations;     // 最佳走法連續未改變的深度數
+};
+
+#endif // TIMEMANAGER_H
@@ -0,0 +1,119 @@
+#include "ucioptions.h"
+#include "uciprotocol.h"
+#include <QtGlobal>
+#include <algorithm>
+
+namespace {
+// option 行中的欄位關鍵字（名稱和字串值在遇到下一個關鍵字前可以包含空白）
+bool isOptionKeyword(const UciToken& token)
+{
+    return token == "name" || token == "type" || token == "default" ||
+           token == "min" || token == "max" || token == "var";
+}
+
+// 讀取直到下一個關鍵字為止的內容（保留原本的空白）
+QString readValue(UciTokenizer& tokens, UciToken& next)
+{
+    const char* start = nullptr;
+    const char* end = nullptr;
+    for (next = tokens.next(); !next.isEmpty() && !isOptionKeyword(next); next = tokens.next()) {
+        if (!start) start = next.data;
+        end = next.data + next.size;
+    }
+    return start ? QString::fromLatin1(start, static_cast<int>(end - start)) : QString();
+}
+}
+
+bool UciOption::parse(const char* data, int size, UciOption& option)
+{
+    UciTokenizer tokens(data, size);
+    if (tokens.next() != "option") return false;
+
+    option = UciOption();
+    bool hasType = false;
+    UciToken key = tokens.next();
+    while (!key.isEmpty()) {
+        UciToken next;
+        if (key == "name") {
+            option.name = readValue(tokens, next);
+        } else if (key == "type") {
+            UciToken type = tokens.next();
+            hasType = true;
+            if (type == "check") option.type = UciOptionType::Check;
+            else if (type == "spin") option.type = UciOptionType::Spin;
+            else if (type == "combo") option.type = UciOptionType::Combo;
+            else if (type == "button") option.type = UciOptionType::Button;
+            else if (type == "string") option.type = UciOptionType::String;
+            else hasType = false;
+            next = tokens.next();
+        } else if (key == "default") {
+            option.defaultValue = readValue(tokens, next);
+        } else if (key == "min") {
+            option.minValue = tokens.next().toInt();
+            next = tokens.next();
+        } else if (key == "max") {
+            option.maxValue = tokens.next().toInt();
+            next = tokens.next();
+        } else if (key == "var") {
+            option.vars.append(readValue(tokens, next));
+        } else {
+            next = tokens.next();
+        }
+        key = next;
+    }
+
+    return !option.name.isEmpty() && hasType;
+}
+
+void UciOptionRegistry::add(const UciOption& option)
+{
+    m_options.insert(option.name.toLower(), option);
+}
+
+bool UciOptionRegistry::has(const QString& name) const
+{
+    return m_options.contains(name.toLower());
+}
+
+const UciOption* UciOptionRegistry::find(const QString& name) const
+{
+    auto it = m_options.constFind(name.toLower());
+    return it == m_options.constEnd() ? nullptr : &it.value();
+}
+
+QString UciOptionRegistry::setOptionCommand(const QString& name, const QString& value) const
+{
+    const UciOption* option = find(name);
+    if (!option) return QString();
+
+    QString command = QString("setoption name %1").arg(option->name);
+    switch (option->type) {
+        case UciOptionType::Button:
+            return command;
+        case UciOptionType::Check:
+            if (value != "true" && value != "false") return QString();
+            break;
+        case UciOptionType::Spin: {
+            bool ok = false;
+            int number = value.toInt(&ok);
+            if (!ok) return QString();
+            return command + QString(" value %1").arg(qBound(option->minValue, number, option->maxValue));
+        }
+        case UciOptionType::Combo: {
+            // combo 值不分大小寫比對，但使用引擎宣告的寫法
+            auto it = std::find_if(option->vars.cbegin(), option->vars.cend(), [&value](const QString& var) {
+                return var.compare(value, Qt::CaseInsensitive) == 0;
+            });
+            if (it == option->vars.cend()) return QString();
+            return command + QString(" value %1").arg(*it);
+        }
+        case UciOptionType::String:
+            break;
+    }
+    return command + QString(" value %1").arg(value);
+}
+
+QString UciOptionRegistry::setOptionCommand(const QString& name, int value) const
+{
+    return setOptionCommand(name, QString::number(value));
+}
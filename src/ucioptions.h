@@ -0,0 +1,50 @@
+#ifndef UCIOPTIONS_H
+#define UCIOPTIONS_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+
+// UCI 選項類型（對應 option ... type 的值）
+enum class UciOptionType {
+    Check,      // 布林值 true/false
+    Spin,       // 有上下限的整數
+    Combo,      // 從固定清單中選擇
+    Button,     // 無值的動作
+    String      // 任意字串
+};
+
+// 引擎宣告的一個選項（option name ... type ... default ... min ... max ... var ...）
+struct UciOption {
+    QString name;
+    UciOptionType type = UciOptionType::String;
+    QString defaultValue;
+    int minValue = 0;
+    int maxValue = 0;
+    QStringList vars;           // combo 的可選值
+
+    // 解析一行 option 輸出，返回 false 表示格式不正確
+    static bool parse(const char* data, int size, UciOption& option);
+};
+
+// 引擎宣告的選項表（名稱不分大小寫，與 UCI 規範一致）
+class UciOptionRegistry
+{
+public:
+    void clear() { m_options.clear(); }
+    void add(const UciOption& option);
+
+    bool has(const QString& name) const;
+    const UciOption* find(const QString& name) const;
+    int size() const { return m_options.size(); }
+
+    // 產生 setoption 命令；引擎不支援或值不合法時返回空字串
+    // spin 的值會被限制在引擎宣告的範圍內
+    QString setOptionCommand(const QString& name, const QString& value) const;
+    QString setOptionCommand(const QString& name, int value) const;
+
+private:
+    QMap<QString, UciOption> m_options;  // 鍵為小寫名稱
+};
+
+#endif // UCIOPTIONS_H
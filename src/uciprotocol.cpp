@@ -0,0 +1,141 @@
+#include "uciprotocol.h"
+#include <cstring>
+
+bool UciToken::operator==(const char* literal) const
+{
+    int length = static_cast<int>(std::strlen(literal));
+    return length == size && std::memcmp(data, literal, length) == 0;
+}
+
+qint64 UciToken::toInt64() const
+{
+    qint64 value = 0;
+    bool negative = false;
+    int i = 0;
+    if (i < size && (data[i] == '-' || data[i] == '+')) {
+        negative = (data[i] == '-');
+        ++i;
+    }
+    for (; i < size && data[i] >= '0' && data[i] <= '9'; ++i) {
+        value = value * 10 + (data[i] - '0');
+    }
+    return negative ? -value : value;
+}
+
+void UciTokenizer::skipSpaces()
+{
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\r')) {
+        ++m_pos;
+    }
+}
+
+bool UciTokenizer::atEnd()
+{
+    skipSpaces();
+    return m_pos >= m_end;
+}
+
+UciToken UciTokenizer::next()
+{
+    skipSpaces();
+    UciToken token;
+    token.data = m_pos;
+    while (m_pos < m_end && *m_pos != ' ' && *m_pos != '\t' && *m_pos != '\r') {
+        ++m_pos;
+    }
+    token.size = static_cast<int>(m_pos - token.data);
+    return token;
+}
+
+UciToken UciTokenizer::rest()
+{
+    skipSpaces();
+    const char* end = m_end;
+    while (end > m_pos && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        --end;
+    }
+    UciToken token;
+    token.data = m_pos;
+    token.size = static_cast<int>(end - m_pos);
+    m_pos = m_end;
+    return token;
+}
+
+int EngineInfo::comparableScore() const
+{
+    if (mateIn > 0) return UCI_MATE_SCORE_CP - mateIn;
+    if (mateIn < 0) return -UCI_MATE_SCORE_CP - mateIn;
+    return scoreCp;
+}
+
+QString EngineInfo::bestMove() const
+{
+    int space = pv.indexOf(' ');
+    return QString::fromLatin1(space < 0 ? pv : pv.left(space));
+}
+
+QStringList EngineInfo::pvMoves() const
+{
+    return QString::fromLatin1(pv).split(' ', Qt::SkipEmptyParts);
+}
+
+QString EngineInfo::scoreText() const
+{
+    if (mateIn != 0) {
+        return QString("#%1").arg(mateIn);
+    }
+    return QString("%1%2").arg(scoreCp >= 0 ? "+" : "").arg(scoreCp / 100.0, 0, 'f', 2);
+}
+
+bool EngineInfo::parse(const char* data, int size, EngineInfo& info)
+{
+    UciTokenizer tokens(data, size);
+    if (tokens.next() != "info") return false;
+
+    while (!tokens.atEnd()) {
+        UciToken key = tokens.next();
+        if (key == "depth") {
+            info.depth = tokens.next().toInt();
+        } else if (key == "seldepth") {
+            info.selDepth = tokens.next().toInt();
+        } else if (key == "multipv") {
+            info.multiPv = tokens.next().toInt();
+        } else if (key == "score") {
+            UciToken kind = tokens.next();
+            int value = tokens.next().toInt();
+            if (kind == "cp") {
+                info.scoreCp = value;
+                info.mateIn = 0;
+                info.hasScore = true;
+            } else if (kind == "mate") {
+                info.scoreCp = 0;
+                info.mateIn = value;
+                info.hasScore = true;
+            }
+        } else if (key == "lowerbound") {
+            info.lowerBound = true;
+        } else if (key == "upperbound") {
+            info.upperBound = true;
+        } else if (key == "nodes") {
+            info.nodes = tokens.next().toInt64();
+        } else if (key == "nps") {
+            info.nps = tokens.next().toInt64();
+        } else if (key == "time") {
+            info.timeMs = tokens.next().toInt();
+        } else if (key == "hashfull") {
+            info.hashFull = tokens.next().toInt();
+        } else if (key == "pv") {
+            // pv 一定是最後一個欄位
+            UciToken moves = tokens.rest();
+            info.pv = QByteArray(moves.data, moves.size);
+        } else if (key == "string") {
+            // info string 是任意文字，不含搜尋資訊
+            return false;
+        } else if (key == "currmove" || key == "currmovenumber" || key == "tbhits" ||
+                   key == "cpuload" || key == "sbhits") {
+            tokens.next();
+        }
+    }
+
+    return info.hasScore && !info.pv.isEmpty();
+}
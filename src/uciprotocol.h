@@ -0,0 +1,70 @@
+#ifndef UCIPROTOCOL_H
+#define UCIPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QMetaType>
+
+// 將殺評分換算成的分數（再減去到將殺的步數）
+constexpr int UCI_MATE_SCORE_CP = 30000;
+
+// 指向原始位元組的詞（不擁有資料，不做任何配置）
+struct UciToken {
+    const char* data = nullptr;
+    int size = 0;
+
+    bool isEmpty() const { return size == 0; }
+    bool operator==(const char* literal) const;
+    bool operator!=(const char* literal) const { return !(*this == literal); }
+    qint64 toInt64() const;
+    int toInt() const { return static_cast<int>(toInt64()); }
+    QString toString() const { return QString::fromLatin1(data, size); }
+};
+
+// UCI 輸出的零複製分詞器：直接在讀取緩衝區上以空白切出每個詞
+class UciTokenizer
+{
+public:
+    UciTokenizer(const char* data, int size) : m_pos(data), m_end(data + size) {}
+
+    UciToken next();
+    UciToken rest();    // 剩餘的全部內容（去除前後空白），例如 pv 或選項名稱
+    bool atEnd();
+
+private:
+    const char* m_pos;
+    const char* m_end;
+
+    void skipSpaces();
+};
+
+// 引擎搜尋資訊（對應一行 info ... 輸出）
+struct EngineInfo {
+    int depth = 0;
+    int selDepth = 0;
+    int multiPv = 1;
+    int scoreCp = 0;            // 以厘兵為單位的評分（將殺時為 0）
+    int mateIn = 0;             // 將殺步數（正數表示引擎方將殺，0 表示非將殺評分）
+    bool hasScore = false;
+    bool lowerBound = false;
+    bool upperBound = false;
+    qint64 nodes = 0;
+    qint64 nps = 0;
+    int timeMs = 0;
+    int hashFull = 0;           // 置換表使用率（千分比）
+    QByteArray pv;              // 主要變例（以空白分隔的 UCI 走法）
+
+    // 將將殺評分換算為可比較的厘兵分數
+    int comparableScore() const;
+    QString bestMove() const;
+    QStringList pvMoves() const;
+    QString scoreText() const;  // 例如 "+0.35" 或 "#3"
+
+    // 解析一行 info 輸出，返回 true 表示包含評分和主要變例
+    static bool parse(const char* data, int size, EngineInfo& info);
+};
+
+Q_DECLARE_METATYPE(EngineInfo)
+
+#endif // UCIPROTOCOL_H
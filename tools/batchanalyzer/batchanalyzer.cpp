@@ -0,0 +1,443 @@
+#include "batchanalyzer.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QTimer>
+
+namespace {
+const int DEFAULT_ANALYSIS_DEPTH = 14;          // 與對局分析相同的預設深度
+const int GAMES_IN_FLIGHT_PER_ENGINE = 4;       // 每個引擎預先展開的棋局數，讓佇列始終有工作可竊取
+const int PROGRESS_LOG_INTERVAL = 200;          // 每搜尋這麼多個局面輸出一次進度
+const int PGN_LINE_LENGTH = 80;
+const char* CHECKPOINT_FILE_NAME = "batchanalyzer.checkpoint";
+
+// 移除 SAN 後面的評價符號（保留 + 和 #）
+QString stripAnnotationSymbols(QString san)
+{
+    while (!san.isEmpty() && (san.back() == '!' || san.back() == '?')) {
+        san.chop(1);
+    }
+    return san;
+}
+}
+
+BatchAnalyzer::BatchAnalyzer(const BatchOptions& options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_pool(nullptr)
+    , m_readingFile(-1)
+    , m_nextSerial(0)
+    , m_gamesWritten(0)
+    , m_positionsSearched(0)
+    , m_finished(false)
+{
+}
+
+BatchAnalyzer::~BatchAnalyzer()
+{
+    for (FileState& file : m_files) {
+        delete file.output;
+    }
+}
+
+bool BatchAnalyzer::start()
+{
+    QDir inputDir(m_options.inputDir);
+    if (!inputDir.exists()) {
+        qWarning() << "[BatchAnalyzer] Input directory does not exist:" << m_options.inputDir;
+        return false;
+    }
+    if (!QDir().mkpath(m_options.outputDir)) {
+        qWarning() << "[BatchAnalyzer] Cannot create output directory:" << m_options.outputDir;
+        return false;
+    }
+
+    QStringList names = inputDir.entryList(QStringList() << "*.pgn" << "*.PGN", QDir::Files, QDir::Name);
+    for (const QString& name : names) {
+        FileState file;
+        file.name = name;
+        m_files.append(file);
+    }
+
+    if (m_options.limits.depth <= 0 && m_options.limits.nodes <= 0) {
+        m_options.limits.depth = DEFAULT_ANALYSIS_DEPTH;
+    }
+    m_options.limits.moveTimeMs = 0;
+    m_options.limits.infinite = false;
+    m_limitKey = m_options.limits.nodes > 0 ? QString("n%1").arg(m_options.limits.nodes)
+                                            : QString("d%1").arg(m_options.limits.depth);
+
+    if (!loadCheckpoint()) return false;
+
+    m_pool = new WorkStealingPool(this);
+    connect(m_pool, &WorkStealingPool::jobFinished, this, &BatchAnalyzer::onJobFinished);
+    connect(m_pool, &WorkStealingPool::poolError, this, &BatchAnalyzer::onPoolError);
+    if (!m_pool->start(m_options.enginePath, m_options.engines, m_options.threadsPerEngine)) {
+        return false;
+    }
+    if (m_options.maxGamesInFlight <= 0) {
+        m_options.maxGamesInFlight = m_pool->engineCount() * GAMES_IN_FLIGHT_PER_ENGINE;
+    }
+
+    qInfo() << "[BatchAnalyzer]" << m_files.size() << "PGN files," << m_pool->engineCount() << "engines,"
+            << "limit" << m_limitKey << "," << m_evals.size() << "positions restored from checkpoint";
+
+    m_timer.start();
+    QTimer::singleShot(0, this, [this]() { refill(); });
+    return true;
+}
+
+bool BatchAnalyzer::loadCheckpoint()
+{
+    // 檢查點格式（每行以 Tab 分隔）：
+    //   L <搜尋限制>
+    //   E <快取鍵> <分數> <將殺步數> <最佳走法>      一個局面的評分（白方觀點）
+    //   G <檔名> <已寫出棋局數> <輸出檔大小>         依序寫出的棋局進度
+    m_checkpoint.setFileName(QDir(m_options.outputDir).filePath(CHECKPOINT_FILE_NAME));
+
+    QHash<QString, QPair<int, qint64>> written;
+    if (m_checkpoint.exists() && m_checkpoint.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&m_checkpoint);
+        while (!in.atEnd()) {
+            QStringList fields = in.readLine().split('\t');
+            if (fields.isEmpty()) continue;
+
+            if (fields[0] == "L" && fields.size() >= 2 && fields[1] != m_limitKey) {
+                qWarning() << "[BatchAnalyzer] Checkpoint was written with limit" << fields[1]
+                           << "; use the same limit or another output directory";
+                m_checkpoint.close();
+                return false;
+            }
+            if (fields[0] == "E" && fields.size() >= 5) {
+                PositionEval eval;
+                eval.scoreCp = fields[2].toInt();
+                eval.mateIn = fields[3].toInt();
+                eval.bestMove = fields[4];
+                m_evals.insert(fields[1], eval);
+            } else if (fields[0] == "G" && fields.size() >= 4) {
+                // 被中斷時最後一行可能不完整，只採用能解析的數值
+                bool gamesOk = false;
+                bool bytesOk = false;
+                int games = fields[2].toInt(&gamesOk);
+                qint64 bytes = fields[3].toLongLong(&bytesOk);
+                if (gamesOk && bytesOk) written.insert(fields[1], qMakePair(games, bytes));
+            }
+        }
+        m_checkpoint.close();
+    }
+
+    // 輸出檔截斷到最後一次記錄的大小，丟棄寫到一半的棋局
+    for (FileState& file : m_files) {
+        if (!written.contains(file.name)) continue;
+        file.skipGames = written.value(file.name).first;
+        file.nextToWrite = file.skipGames;
+
+        file.output = new QFile(QDir(m_options.outputDir).filePath(file.name));
+        if (!file.output->open(QIODevice::ReadWrite) || !file.output->resize(written.value(file.name).second)) {
+            qWarning() << "[BatchAnalyzer] Cannot resume output file" << file.output->fileName();
+            return false;
+        }
+        file.output->seek(file.output->size());
+        qInfo() << "[BatchAnalyzer] Resuming" << file.name << "after" << file.skipGames << "games";
+    }
+
+    bool fresh = !m_checkpoint.exists() || m_checkpoint.size() == 0;
+    if (!m_checkpoint.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qWarning() << "[BatchAnalyzer] Cannot write checkpoint" << m_checkpoint.fileName();
+        return false;
+    }
+    if (fresh) appendCheckpoint(QString("L\t%1").arg(m_limitKey));
+    return true;
+}
+
+void BatchAnalyzer::appendCheckpoint(const QString& line)
+{
+    m_checkpoint.write(line.toUtf8());
+    m_checkpoint.write("\n");
+    m_checkpoint.flush();
+}
+
+void BatchAnalyzer::refill()
+{
+    // 維持固定數量的棋局在分析中：記憶體用量與輸入大小無關
+    while (!m_finished && m_games.size() < m_options.maxGamesInFlight) {
+        int fileIndex = -1;
+        PgnGame game;
+        if (!readNextGame(fileIndex, game)) break;
+        startGame(fileIndex, game);
+    }
+    checkFinished();
+}
+
+bool BatchAnalyzer::readNextGame(int& fileIndex, PgnGame& game)
+{
+    while (m_readingFile < m_files.size()) {
+        if (m_readingFile >= 0 && !m_reader.atEnd() && m_reader.readGame(game)) {
+            if (game.index < m_files[m_readingFile].skipGames) continue;
+            fileIndex = m_readingFile;
+            return true;
+        }
+
+        // 目前的檔案讀完了，換下一個檔案
+        if (m_readingFile >= 0) {
+            m_reader.close();
+            m_files[m_readingFile].readerDone = true;
+            writeReadyGames(m_readingFile);
+        }
+        m_readingFile++;
+        if (m_readingFile < m_files.size()
+            && !m_reader.open(QDir(m_options.inputDir).filePath(m_files[m_readingFile].name))) {
+            qWarning() << "[BatchAnalyzer] Cannot open" << m_files[m_readingFile].name;
+        }
+    }
+    return false;
+}
+
+void BatchAnalyzer::startGame(int fileIndex, const PgnGame& pgn)
+{
+    GameTask task;
+    task.fileIndex = fileIndex;
+    task.pgn = pgn;
+
+    // 重播棋局，取得每一步之後的局面
+    ChessBoard board;
+    board.initializeBoard();
+    QString startFen = pgn.tag("FEN");
+    if (!startFen.isEmpty()) {
+        if (!board.loadFromFEN(startFen)) {
+            task.error = QString("無法解析 FEN：%1").arg(startFen);
+        }
+        task.firstMoveNumber = qMax(1, startFen.section(' ', 5, 5).toInt());
+        task.blackStarts = board.getCurrentPlayer() == PieceColor::Black;
+    }
+
+    if (task.error.isEmpty()) {
+        task.plyKeys.append(GameAnalyzer::positionKey(ChessEngine::boardToFEN(board)) + "|" + m_limitKey);
+        for (const QString& san : pgn.moves) {
+            QPoint from;
+            QPoint to;
+            PieceType promotionType;
+            if (!board.findMoveFromSAN(san, from, to, promotionType) || !board.movePiece(from, to)) {
+                task.error = QString("第 %1 步不合法：%2").arg(task.sanMoves.size() + 1).arg(san);
+                break;
+            }
+            if (board.needsPromotion(to)) {
+                board.promotePawn(to, promotionType == PieceType::None ? PieceType::Queen : promotionType);
+            }
+            task.sanMoves.append(stripAnnotationSymbols(san));
+            task.plyKeys.append(GameAnalyzer::positionKey(ChessEngine::boardToFEN(board)) + "|" + m_limitKey);
+        }
+    }
+
+    if (!task.error.isEmpty()) {
+        // 無法重播的棋局照原樣寫出，不加評分
+        qWarning() << "[BatchAnalyzer]" << m_files[fileIndex].name << "game" << pgn.index + 1 << ":" << task.error;
+        task.sanMoves.clear();
+        task.plyKeys.clear();
+    } else {
+        // 最後的局面若已將死或逼和，直接給分
+        int lastPly = task.plyKeys.size() - 1;
+        PieceColor sideToMove = board.getCurrentPlayer();
+        if (board.isCheckmate(sideToMove)) {
+            PositionEval eval;
+            eval.scoreCp = (sideToMove == PieceColor::White) ? -UCI_MATE_SCORE_CP : UCI_MATE_SCORE_CP;
+            task.terminalEvals.insert(lastPly, eval);
+        } else if (board.isStalemate(sideToMove)) {
+            task.terminalEvals.insert(lastPly, PositionEval());
+        }
+    }
+
+    int serial = m_nextSerial++;
+    QVector<BatchJob> jobs;
+    for (int ply = 0; ply < task.plyKeys.size(); ++ply) {
+        const QString& key = task.plyKeys[ply];
+        if (task.terminalEvals.contains(ply) || m_evals.contains(key)) continue;
+
+        // 相同的局面（包含其他棋局中的）只搜尋一次
+        task.remaining++;
+        auto waiter = m_waiters.find(key);
+        if (waiter != m_waiters.end()) {
+            waiter.value().append(serial);
+            continue;
+        }
+        m_waiters.insert(key, QVector<int>() << serial);
+
+        BatchJob job;
+        job.key = key;
+        job.fen = key.section('|', 0, 0) + " 0 1";
+        job.limits = m_options.limits;
+        jobs.append(job);
+    }
+
+    m_files[fileIndex].pendingGames++;
+    bool ready = task.remaining == 0;
+    m_games.insert(serial, task);
+
+    if (ready) {
+        gameReady(serial);
+    } else {
+        m_pool->submit(jobs);
+    }
+}
+
+void BatchAnalyzer::onJobFinished(const BatchJobResult& result)
+{
+    // 引擎評分以行棋方為準，儲存時轉為白方觀點
+    const QString& key = result.job.key;
+    bool blackToMove = key.section('|', 0, 0).section(' ', 1, 1) == "b";
+    PositionEval eval;
+    eval.scoreCp = result.info.hasScore ? result.info.comparableScore() : 0;
+    eval.mateIn = result.info.mateIn;
+    if (blackToMove) {
+        eval.scoreCp = -eval.scoreCp;
+        eval.mateIn = -eval.mateIn;
+    }
+    eval.bestMove = result.bestMove;
+    m_evals.insert(key, eval);
+    appendCheckpoint(QString("E\t%1\t%2\t%3\t%4").arg(key).arg(eval.scoreCp).arg(eval.mateIn).arg(eval.bestMove));
+
+    if (++m_positionsSearched % PROGRESS_LOG_INTERVAL == 0) {
+        double seconds = m_timer.elapsed() / 1000.0;
+        qInfo().noquote() << QString("[BatchAnalyzer] %1 positions searched (%2/s), %3 games written, %4 steals")
+                             .arg(m_positionsSearched)
+                             .arg(seconds > 0 ? m_positionsSearched / seconds : 0.0, 0, 'f', 1)
+                             .arg(m_gamesWritten)
+                             .arg(m_pool->stealCount());
+    }
+
+    const QVector<int> waiters = m_waiters.take(key);
+    for (int serial : waiters) {
+        auto it = m_games.find(serial);
+        if (it != m_games.end() && --it.value().remaining == 0) {
+            gameReady(serial);
+        }
+    }
+    refill();
+}
+
+void BatchAnalyzer::onPoolError(const QString& error)
+{
+    if (m_finished) return;
+    m_finished = true;
+
+    qWarning() << "[BatchAnalyzer] All engines failed:" << error << "- rerun to resume from the checkpoint";
+    emit finished(1);
+}
+
+void BatchAnalyzer::gameReady(int serial)
+{
+    const GameTask& task = m_games[serial];
+    int fileIndex = task.fileIndex;
+    m_files[fileIndex].readyGames.insert(task.pgn.index, serial);
+    writeReadyGames(fileIndex);
+}
+
+void BatchAnalyzer::writeReadyGames(int fileIndex)
+{
+    FileState& file = m_files[fileIndex];
+
+    // 棋局完成的順序不固定，依原檔案順序寫出，檢查點才能只記錄已寫出的數量
+    while (file.readyGames.contains(file.nextToWrite)) {
+        int serial = file.readyGames.take(file.nextToWrite);
+
+        if (!file.output) {
+            file.output = new QFile(QDir(m_options.outputDir).filePath(file.name));
+            if (!file.output->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                qWarning() << "[BatchAnalyzer] Cannot write" << file.output->fileName();
+            }
+        }
+        file.output->write(formatGame(m_games.value(serial)).toUtf8());
+        file.output->flush();
+
+        m_games.remove(serial);
+        file.pendingGames--;
+        file.nextToWrite++;
+        m_gamesWritten++;
+        appendCheckpoint(QString("G\t%1\t%2\t%3").arg(file.name).arg(file.nextToWrite).arg(file.output->size()));
+    }
+
+    if (file.readerDone && file.pendingGames == 0 && file.output) {
+        file.output->close();
+        delete file.output;
+        file.output = nullptr;
+    }
+}
+
+QString BatchAnalyzer::formatGame(const GameTask& game) const
+{
+    QString pgn;
+    bool hasAnnotator = false;
+    for (const auto& tag : game.pgn.tags) {
+        QString value = tag.second;
+        value.replace("\"", "\\\"");
+        pgn += QString("[%1 \"%2\"]\n").arg(tag.first, value);
+        if (tag.first == "Annotator") hasAnnotator = true;
+    }
+    if (!hasAnnotator) {
+        pgn += QString("[Annotator \"Qt_Chess batchanalyzer %1\"]\n").arg(m_limitKey);
+    }
+    pgn += "\n";
+
+    // 先組成記號列表，再依行寬換行
+    QStringList tokens;
+    if (!game.error.isEmpty()) {
+        tokens << QString("{%1}").arg(game.error);
+        tokens << game.pgn.moves;
+    } else {
+        auto evalAt = [this, &game](int ply) {
+            return game.terminalEvals.contains(ply) ? game.terminalEvals.value(ply)
+                                                    : m_evals.value(game.plyKeys[ply]);
+        };
+
+        int moveNumber = game.firstMoveNumber;
+        bool previousHasComment = false;
+        for (int i = 0; i < game.sanMoves.size(); ++i) {
+            bool whiteMoved = (i % 2 == 0) != game.blackStarts;
+            bool afterIsMate = game.terminalEvals.contains(i + 1) && game.terminalEvals.value(i + 1).scoreCp != 0;
+            MoveAnnotation annotation = GameAnalyzer::annotateMove(whiteMoved, evalAt(i), evalAt(i + 1), afterIsMate);
+
+            if (whiteMoved) {
+                tokens << QString("%1.").arg(moveNumber);
+            } else if (i == 0 || previousHasComment) {
+                // 黑方先走或註解之後需要重新標示回合數
+                tokens << QString("%1...").arg(moveNumber);
+            }
+            tokens << game.sanMoves[i] + annotation.qualitySymbol();
+            if (annotation.hasEval) {
+                tokens << QString("{[%eval %1]}").arg(annotation.evalText());
+            }
+            previousHasComment = annotation.hasEval;
+            if (!whiteMoved) moveNumber++;
+        }
+    }
+    tokens << game.pgn.result;
+
+    int lineLength = 0;
+    for (const QString& token : tokens) {
+        if (lineLength > 0 && lineLength + 1 + token.size() > PGN_LINE_LENGTH) {
+            pgn += "\n";
+            lineLength = 0;
+        } else if (lineLength > 0) {
+            pgn += " ";
+            lineLength++;
+        }
+        pgn += token;
+        lineLength += token.size();
+    }
+    pgn += "\n\n";
+    return pgn;
+}
+
+void BatchAnalyzer::checkFinished()
+{
+    if (m_finished || m_readingFile < m_files.size() || !m_games.isEmpty()) return;
+    m_finished = true;
+
+    qInfo().noquote() << QString("[BatchAnalyzer] Done: %1 games written, %2 positions searched in %3 s, %4 steals")
+                         .arg(m_gamesWritten)
+                         .arg(m_positionsSearched)
+                         .arg(m_timer.elapsed() / 1000.0, 0, 'f', 1)
+                         .arg(m_pool ? m_pool->stealCount() : 0);
+    emit finished(0);
+}
@@ -0,0 +1,100 @@
+#ifndef BATCHANALYZER_H
+#define BATCHANALYZER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QFile>
+#include <QElapsedTimer>
+#include "gameanalyzer.h"
+#include "pgnreader.h"
+#include "workstealingpool.h"
+
+// 批次分析設定
+struct BatchOptions {
+    QString inputDir;
+    QString outputDir;
+    QString enginePath;
+    SearchLimits limits;            // 沒有指定深度或節點數時使用深度 14
+    int engines = 0;                // 0 表示核心數 / threadsPerEngine
+    int threadsPerEngine = 1;
+    int maxGamesInFlight = 0;       // 同時在分析中的棋局數（0 表示依引擎數自動決定）
+};
+
+// 批次 PGN 分析器：
+// 逐盤串流讀取輸入目錄中的 PGN，把每個局面交給工作竊取引擎池，
+// 完成的棋局依原順序寫成帶 [%eval] 註解的 PGN。
+// 每個局面的評分和已寫出的棋局都記錄在檢查點檔案中，中斷後重新執行會從中斷處繼續。
+class BatchAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BatchAnalyzer(const BatchOptions& options, QObject *parent = nullptr);
+    ~BatchAnalyzer();
+
+    bool start();
+
+signals:
+    void finished(int exitCode);
+
+private slots:
+    void onJobFinished(const BatchJobResult& result);
+    void onPoolError(const QString& error);
+
+private:
+    // 一個輸入檔案的輸出狀態
+    struct FileState {
+        QString name;
+        QFile* output = nullptr;
+        int skipGames = 0;          // 檢查點中已寫出的棋局數
+        int nextToWrite = 0;
+        bool readerDone = false;
+        QMap<int, int> readyGames;  // 棋局索引 -> 已完成的棋局序號（等待依序寫出）
+        int pendingGames = 0;
+    };
+
+    // 一盤分析中的棋局
+    struct GameTask {
+        int fileIndex = 0;
+        PgnGame pgn;
+        QStringList sanMoves;               // 重播成功的移動
+        QStringList plyKeys;                // 每個局面（ply 0 為起始局面）的快取鍵
+        QHash<int, PositionEval> terminalEvals;
+        bool blackStarts = false;
+        int firstMoveNumber = 1;
+        int remaining = 0;                  // 尚未取得評分的局面數
+        QString error;
+    };
+
+    BatchOptions m_options;
+    WorkStealingPool* m_pool;
+    PgnReader m_reader;
+    QVector<FileState> m_files;
+    int m_readingFile;
+    QHash<int, GameTask> m_games;           // 棋局序號 -> 棋局
+    int m_nextSerial;
+    QHash<QString, PositionEval> m_evals;   // 已完成的局面評分（白方觀點）
+    QHash<QString, QVector<int>> m_waiters; // 搜尋中的局面 -> 等待的棋局序號
+    QFile m_checkpoint;
+    QString m_limitKey;
+    QElapsedTimer m_timer;
+    int m_gamesWritten;
+    int m_positionsSearched;
+    bool m_finished;
+
+    bool loadCheckpoint();
+    void appendCheckpoint(const QString& line);
+    void refill();
+    bool readNextGame(int& fileIndex, PgnGame& game);
+    void startGame(int fileIndex, const PgnGame& pgn);
+    void gameReady(int serial);
+    void writeReadyGames(int fileIndex);
+    QString formatGame(const GameTask& game) const;
+    void checkFinished();
+};
+
+#endif // BATCHANALYZER_H
@@ -0,0 +1,16 @@
+# 批次 PGN 分析工具：qmake tools/batchanalyzer/batchanalyzer.pro
+TARGET = batchanalyzer
+TEMPLATE = app
+
+include(../tools.pri)
+
+SOURCES += \
+    main.cpp \
+    pgnreader.cpp \
+    workstealingpool.cpp \
+    batchanalyzer.cpp
+
+HEADERS += \
+    pgnreader.h \
+    workstealingpool.h \
+    batchanalyzer.h
@@ -0,0 +1,55 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include "batchanalyzer.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("batchanalyzer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Annotate every PGN file in a directory with engine evaluations.\n"
+                                     "Rerunning with the same output directory resumes an interrupted run.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Directory containing .pgn files.");
+    parser.addPositionalArgument("output", "Directory for annotated PGN files and the checkpoint.");
+
+    QCommandLineOption engineOption("engine", "UCI engine executable (default: stockfish in PATH).", "path");
+    QCommandLineOption depthOption("depth", "Search depth per position (default 14).", "plies");
+    QCommandLineOption nodesOption("nodes", "Node limit per position instead of depth.", "count");
+    QCommandLineOption enginesOption("engines", "Number of engine processes (default: cores / threads).", "count");
+    QCommandLineOption threadsOption("threads", "Threads per engine process (default 1).", "count", "1");
+    QCommandLineOption gamesOption("games-in-flight", "Games expanded into jobs at once (default: 4 per engine).", "count");
+    parser.addOptions({engineOption, depthOption, nodesOption, enginesOption, threadsOption, gamesOption});
+    parser.process(app);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 2) {
+        parser.showHelp(1);
+    }
+
+    BatchOptions options;
+    options.inputDir = positional[0];
+    options.outputDir = positional[1];
+    options.enginePath = parser.isSet(engineOption) ? parser.value(engineOption)
+                                                    : QStandardPaths::findExecutable("stockfish");
+    options.limits.depth = parser.value(depthOption).toInt();
+    options.limits.nodes = parser.value(nodesOption).toLongLong();
+    options.engines = parser.value(enginesOption).toInt();
+    options.threadsPerEngine = parser.value(threadsOption).toInt();
+    options.maxGamesInFlight = parser.value(gamesOption).toInt();
+
+    if (options.enginePath.isEmpty() || !QFileInfo::exists(options.enginePath)) {
+        qCritical("No engine found; pass --engine <path>");
+        return 1;
+    }
+
+    BatchAnalyzer analyzer(options);
+    QObject::connect(&analyzer, &BatchAnalyzer::finished, &app, &QCoreApplication::exit);
+    if (!analyzer.start()) {
+        return 1;
+    }
+    return app.exec();
+}
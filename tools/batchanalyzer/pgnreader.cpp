@@ -0,0 +1,154 @@
+#include "pgnreader.h"
+#include <QRegularExpression>
+
+QString PgnGame::tag(const QString& name) const
+{
+    for (const auto& tag : tags) {
+        if (tag.first == name) return tag.second;
+    }
+    return QString();
+}
+
+PgnReader::PgnReader()
+    : m_hasPendingLine(false)
+    , m_nextIndex(0)
+{
+}
+
+bool PgnReader::open(const QString& path)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+    m_stream.setDevice(&m_file);
+    return true;
+}
+
+void PgnReader::close()
+{
+    m_stream.setDevice(nullptr);
+    if (m_file.isOpen()) m_file.close();
+    m_hasPendingLine = false;
+    m_nextIndex = 0;
+}
+
+bool PgnReader::atEnd() const
+{
+    return !m_hasPendingLine && (!m_file.isOpen() || m_stream.atEnd());
+}
+
+bool PgnReader::readGame(PgnGame& game)
+{
+    static const QRegularExpression tagPattern("^\\[(\\w+)\\s+\"(.*)\"\\]$");
+
+    game = PgnGame();
+    QString moveText;
+    bool hasContent = false;
+
+    while (m_hasPendingLine || !m_stream.atEnd()) {
+        QString line;
+        if (m_hasPendingLine) {
+            line = m_pendingLine;
+            m_hasPendingLine = false;
+        } else {
+            line = m_stream.readLine().trimmed();
+        }
+        if (line.isEmpty() || line.startsWith('%')) continue;
+
+        if (line.startsWith('[')) {
+            // 已經有移動文字時，標籤行代表下一盤棋的開始
+            if (!moveText.isEmpty()) {
+                m_pendingLine = line;
+                m_hasPendingLine = true;
+                break;
+            }
+            QRegularExpressionMatch match = tagPattern.match(line);
+            if (match.hasMatch()) {
+                QString value = match.captured(2);
+                value.replace("\\\"", "\"");
+                game.tags.append(qMakePair(match.captured(1), value));
+                hasContent = true;
+            }
+            continue;
+        }
+
+        moveText += line;
+        moveText += '\n';
+        hasContent = true;
+    }
+
+    if (!hasContent) return false;
+
+    game.index = m_nextIndex++;
+    parseMoveText(moveText, game);
+    if (game.result == "*" && !game.tag("Result").isEmpty()) {
+        game.result = game.tag("Result");
+    }
+    return true;
+}
+
+void PgnReader::parseMoveText(const QString& text, PgnGame& game)
+{
+    int variationDepth = 0;
+    QString token;
+
+    auto flushToken = [&game, &token]() {
+        if (token.isEmpty()) return;
+        QString move = token;
+        token.clear();
+
+        // 移動編號可能與移動連在一起（例如 "12.e4"、"12...Nf6"）
+        int i = 0;
+        while (i < move.size() && move[i].isDigit()) ++i;
+        if (i < move.size() && move[i] == '.') {
+            while (i < move.size() && move[i] == '.') ++i;
+            move = move.mid(i);
+        } else if (i == move.size()) {
+            return;
+        }
+        if (move.isEmpty() || move.startsWith('$')) return;
+
+        if (move == "1-0" || move == "0-1" || move == "1/2-1/2" || move == "*") {
+            game.result = move;
+            return;
+        }
+        game.moves.append(move);
+    };
+
+    for (int i = 0; i < text.size(); ++i) {
+        QChar c = text[i];
+
+        if (c == '{') {
+            // 大括號註解（不能巢狀）
+            flushToken();
+            int end = text.indexOf('}', i + 1);
+            i = (end < 0) ? text.size() : end;
+            continue;
+        }
+        if (c == ';') {
+            // 單行註解
+            flushToken();
+            int end = text.indexOf('\n', i + 1);
+            i = (end < 0) ? text.size() : end;
+            continue;
+        }
+        if (c == '(') {
+            flushToken();
+            variationDepth++;
+            continue;
+        }
+        if (c == ')') {
+            token.clear();
+            if (variationDepth > 0) variationDepth--;
+            continue;
+        }
+        if (variationDepth > 0) continue;
+
+        if (c.isSpace()) {
+            flushToken();
+        } else {
+            token += c;
+        }
+    }
+    flushToken();
+}
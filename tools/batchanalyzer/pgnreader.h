@@ -0,0 +1,44 @@
+#ifndef PGNREADER_H
+#define PGNREADER_H
+
+#include <QFile>
+#include <QTextStream>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+
+// 一盤 PGN 棋局（只保留主變例）
+struct PgnGame {
+    int index = 0;                              // 在檔案中的順序（從 0 開始）
+    QVector<QPair<QString, QString>> tags;      // 依原順序保存的標籤
+    QStringList moves;                          // SAN 移動（已移除註解、變例及 NAG）
+    QString result = "*";
+
+    QString tag(const QString& name) const;
+};
+
+// 串流式 PGN 讀取器：一次只讀一盤棋，不會把整個檔案載入記憶體
+class PgnReader
+{
+public:
+    PgnReader();
+
+    bool open(const QString& path);
+    void close();
+    bool atEnd() const;
+
+    // 讀取下一盤棋；沒有更多棋局時返回 false
+    bool readGame(PgnGame& game);
+
+private:
+    QFile m_file;
+    QTextStream m_stream;
+    QString m_pendingLine;          // 已讀到但屬於下一盤棋的標籤行
+    bool m_hasPendingLine;
+    int m_nextIndex;
+
+    static void parseMoveText(const QString& text, PgnGame& game);
+};
+
+#endif // PGNREADER_H
@@ -0,0 +1,135 @@
+#include "workstealingpool.h"
+#include <QDebug>
+
+WorkStealingPool::WorkStealingPool(QObject *parent)
+    : EngineWorkerPool("[WorkStealingPool]", parent)
+    , m_stealCount(0)
+{
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    stop();
+}
+
+bool WorkStealingPool::start(const QString& enginePath, int engineCount, int threadsPerEngine)
+{
+    stop();
+
+    return startEngines(enginePath, engineCount, threadsPerEngine);
+}
+
+void WorkStealingPool::stop()
+{
+    stopEngines();
+    m_workers.clear();
+}
+
+void WorkStealingPool::resetWorkers(int count)
+{
+    m_workers.clear();
+    m_workers.resize(count);
+}
+
+int WorkStealingPool::queuedJobs() const
+{
+    int count = 0;
+    for (const Worker& worker : m_workers) {
+        count += static_cast<int>(worker.queue.size()) + (worker.busy ? 1 : 0);
+    }
+    return count;
+}
+
+void WorkStealingPool::submit(const QVector<BatchJob>& jobs)
+{
+    if (jobs.isEmpty() || m_workers.isEmpty()) return;
+
+    Worker& worker = m_workers[leastLoadedWorker()];
+    for (const BatchJob& job : jobs) {
+        worker.queue.push_back(job);
+    }
+    dispatch();
+}
+
+int WorkStealingPool::leastLoadedWorker() const
+{
+    int best = -1;
+    size_t bestLoad = 0;
+    for (int i = 0; i < m_workers.size(); ++i) {
+        if (isRetired(i)) continue;
+        const Worker& worker = m_workers[i];
+        size_t load = worker.queue.size() + (worker.busy ? 1 : 0);
+        if (best < 0 || load < bestLoad) {
+            best = i;
+            bestLoad = load;
+        }
+    }
+    return best < 0 ? 0 : best;
+}
+
+bool WorkStealingPool::takeJob(int workerIndex, BatchJob& job)
+{
+    // 先從自己佇列的前端取（同一盤棋的下一個局面）
+    Worker& worker = m_workers[workerIndex];
+    if (!worker.queue.empty()) {
+        job = worker.queue.front();
+        worker.queue.pop_front();
+        return true;
+    }
+
+    // 自己的佇列空了：從最長佇列的尾端竊取，與擁有者取工作的一端互不干擾
+    int victim = -1;
+    for (int i = 0; i < m_workers.size(); ++i) {
+        if (i == workerIndex || m_workers[i].queue.empty()) continue;
+        if (victim < 0 || m_workers[i].queue.size() > m_workers[victim].queue.size()) {
+            victim = i;
+        }
+    }
+    if (victim < 0) return false;
+
+    job = m_workers[victim].queue.back();
+    m_workers[victim].queue.pop_back();
+    m_stealCount++;
+    return true;
+}
+
+void WorkStealingPool::dispatch()
+{
+    for (int i = 0; i < m_workers.size(); ++i) {
+        Worker& worker = m_workers[i];
+        if (worker.busy || !canDispatch(i)) continue;
+
+        BatchJob job;
+        if (!takeJob(i, job)) continue;
+
+        worker.job = job;
+        worker.busy = true;
+        engine(i)->setPosition(job.fen);
+        engine(i)->requestSearch(job.limits);
+    }
+}
+
+void WorkStealingPool::onWorkerBestMove(int workerIndex, const QString& move)
+{
+    Worker& worker = m_workers[workerIndex];
+    if (!worker.busy) return;
+    worker.busy = false;
+
+    BatchJobResult result;
+    result.job = worker.job;
+    result.bestMove = move;
+    result.info = engine(workerIndex)->getLastInfo();
+    emit jobFinished(result);
+
+    dispatch();
+}
+
+void WorkStealingPool::releaseJob(int workerIndex)
+{
+    // 進行中的工作放回佇列前端；引擎被淘汰時剩下的佇列留給其他引擎竊取
+    Worker& worker = m_workers[workerIndex];
+    if (worker.busy) {
+        worker.busy = false;
+        worker.queue.push_front(worker.job);
+    }
+}
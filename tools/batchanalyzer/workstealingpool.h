@@ -0,0 +1,63 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <QString>
+#include <QVector>
+#include <deque>
+#include "engineworkerpool.h"
+
+// 一個局面的搜尋工作
+struct BatchJob {
+    QString key;            // 快取鍵（局面 + 搜尋限制）
+    QString fen;
+    SearchLimits limits;
+};
+
+// 工作結果（評分以該局面的行棋方為準）
+struct BatchJobResult {
+    BatchJob job;
+    QString bestMove;
+    EngineInfo info;
+};
+
+// 工作竊取引擎池：每個引擎有自己的雙端佇列
+// 同一盤棋的局面放進同一個佇列並依序搜尋，引擎可以重用置換表；
+// 引擎自己的佇列空了就從最長的佇列尾端竊取工作，所有核心都不會閒置
+class WorkStealingPool : public EngineWorkerPool
+{
+    Q_OBJECT
+
+public:
+    explicit WorkStealingPool(QObject *parent = nullptr);
+    ~WorkStealingPool();
+
+    bool start(const QString& enginePath, int engineCount, int threadsPerEngine);
+    void stop();
+    int queuedJobs() const;
+    int stealCount() const { return m_stealCount; }
+
+    // 一組工作（通常是同一盤棋）放進目前最空閒的引擎佇列
+    void submit(const QVector<BatchJob>& jobs);
+
+signals:
+    void jobFinished(const BatchJobResult& result);
+
+private:
+    struct Worker {
+        std::deque<BatchJob> queue;
+        BatchJob job;
+        bool busy = false;
+    };
+
+    QVector<Worker> m_workers;
+    int m_stealCount;
+
+    void resetWorkers(int count) override;
+    void dispatch() override;
+    bool takeJob(int workerIndex, BatchJob& job);
+    int leastLoadedWorker() const;
+    void onWorkerBestMove(int workerIndex, const QString& move) override;
+    void releaseJob(int workerIndex) override;
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -0,0 +1,12 @@
+# 基準測試工具：qmake tools/bench/bench.pro && make && ./bench [引擎路徑]
+TARGET = bench
+TEMPLATE = app
+
+include(../tools.pri)
+
+SOURCES += \
+    main.cpp \
+    $$ENGINE_SRC/benchmark.cpp
+
+HEADERS += \
+    $$ENGINE_SRC/benchmark.h
@@ -0,0 +1,11 @@
+#include <QCoreApplication>
+#include "benchmark.h"
+
+// 與 Qt_Chess --bench 相同的基準測試，不需要連結 GUI
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QString enginePath = argc > 1 ? QString(argv[1]) : Benchmark::defaultEnginePath();
+    return Benchmark::run(enginePath);
+}
@@ -0,0 +1,30 @@
+# 原生 WebSocket 中繼伺服器（與 server.js 相同協議）：qmake tools/chess_server/chess_server.pro
+TARGET = chess_server
+TEMPLATE = app
+
+QT       += core network websockets
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# 與客戶端共用的規則程式碼
+RULES_SRC = $$PWD/../../src
+INCLUDEPATH += $$RULES_SRC
+
+SOURCES += \
+    main.cpp \
+    servergame.cpp \
+    chessserver.cpp \
+    chessservercluster.cpp \
+    $$RULES_SRC/chesspiece.cpp \
+    $$RULES_SRC/chessboard.cpp \
+    $$RULES_SRC/binaryprotocol.cpp
+
+HEADERS += \
+    servergame.h \
+    chessserver.h \
+    chessservercluster.h \
+    $$RULES_SRC/chesspiece.h \
+    $$RULES_SRC/chessboard.h \
+    $$RULES_SRC/binaryprotocol.h
@@ -0,0 +1,958 @@
+#include "chessserver.h"
+#include "binaryprotocol.h"
+#include <QWebSocketServer>
+#include <QWebSocket>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QDebug>
+#include <numeric>
+
+namespace {
+const qint64 ROOM_ID_MIN = 100000;          // 與 server.js 相同的 6 位數房號
+const qint64 ROOM_ID_MAX = 999999;
+const quint64 ROOM_ID_STRIDE = 387799;      // 走訪房號的步長，會調整成與房號數量互質
+const qint64 START_TIMESTAMP_BUFFER_MS = 500;
+const int PING_INTERVAL_MS = 2000;          // 量測每個連線往返時間的間隔
+const qint64 MAX_LAG_COMPENSATION_MS = 500; // 每步最多補償的延遲
+const qint64 LAG_BUDGET_PER_GAME_MS = 10000;  // 每位玩家每盤棋最多補償的延遲總和
+const int RESUME_GRACE_MS = 60000;          // 對局中斷線後保留座位的時間
+const size_t GAME_LOG_RESERVE = 128;
+
+QString serialize(const QJsonObject& message)
+{
+    return QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact));
+}
+}
+
+ChessServer::ChessServer(int shardIndex, int shardCount, QObject *parent)
+    : QObject(parent)
+    , m_server(new QWebSocketServer("chess_server", QWebSocketServer::NonSecureMode, this))
+    , m_shardIndex(shardIndex)
+    , m_shardCount(qMax(1, shardCount))
+    , m_nextClientSerial(0)
+    , m_roomIdCounter(0)
+    , m_roomIdSlots(1)
+    , m_roomIdStride(1)
+    , m_statsTimer(new QTimer(this))
+    , m_pingTimer(new QTimer(this))
+    , m_clockEpochMs(QDateTime::currentMSecsSinceEpoch())
+    , m_messagesIn(0)
+    , m_framesOut(0)
+{
+    m_clock.start();
+    m_shards.append(this);
+
+    // 本分片負責 (房號 - ROOM_ID_MIN) % 分片數 == 分片編號 的房號；
+    // 步長與房號數量互質時，走訪一整輪會經過每個房號恰好一次
+    const quint64 space = static_cast<quint64>(ROOM_ID_MAX - ROOM_ID_MIN + 1);
+    m_roomIdSlots = (space - m_shardIndex + m_shardCount - 1) / m_shardCount;
+    quint64 stride = ROOM_ID_STRIDE;
+    while (std::gcd(stride, m_roomIdSlots) != 1) {
+        stride++;
+    }
+    m_roomIdStride = stride % m_roomIdSlots;
+    m_roomIdCounter = QRandomGenerator::global()->generate64() % m_roomIdSlots;
+
+    connect(m_server, &QWebSocketServer::newConnection, this, &ChessServer::onNewConnection);
+    connect(m_statsTimer, &QTimer::timeout, this, &ChessServer::printStats);
+    connect(m_pingTimer, &QTimer::timeout, this, &ChessServer::pingClients);
+}
+
+ChessServer::~ChessServer()
+{
+    m_server->close();
+}
+
+bool ChessServer::listen(quint16 port)
+{
+    if (!m_server->listen(QHostAddress::Any, port)) {
+        qWarning() << "[ChessServer] Failed to listen on port" << port << ":" << m_server->errorString();
+        return false;
+    }
+    qDebug() << "[ChessServer] WebSocket relay server running on port" << m_server->serverPort();
+    m_pingTimer->start(PING_INTERVAL_MS);
+    return true;
+}
+
+bool ChessServer::listenOnDescriptor(int socketDescriptor)
+{
+    if (!m_server->setSocketDescriptor(socketDescriptor)) {
+        qWarning() << "[ChessServer] Shard" << m_shardIndex << "failed to use listening socket:"
+                   << m_server->errorString();
+        return false;
+    }
+    m_pingTimer->start(PING_INTERVAL_MS);
+    return true;
+}
+
+quint16 ChessServer::port() const
+{
+    return m_server->serverPort();
+}
+
+void ChessServer::setStatsInterval(int seconds)
+{
+    m_statsTimer->stop();
+    if (seconds > 0) {
+        m_statsClock.start();
+        m_statsTimer->start(seconds * 1000);
+    }
+}
+
+void ChessServer::setShards(const QVector<ChessServer*>& shards)
+{
+    m_shards = shards;
+}
+
+void ChessServer::setClock(qint64 epochMs, const QElapsedTimer& clock)
+{
+    m_clockEpochMs = epochMs;
+    m_clock = clock;
+}
+
+int ChessServer::ownerShard(const QString& roomId, int shardCount)
+{
+    bool ok = false;
+    qint64 id = roomId.toLongLong(&ok);
+    if (!ok || id < ROOM_ID_MIN || id > ROOM_ID_MAX) return -1;
+    return static_cast<int>((id - ROOM_ID_MIN) % qMax(1, shardCount));
+}
+
+void ChessServer::onNewConnection()
+{
+    while (QWebSocket* client = m_server->nextPendingConnection()) {
+        connect(client, &QWebSocket::textMessageReceived, this, &ChessServer::onTextMessageReceived);
+        connect(client, &QWebSocket::binaryMessageReceived, this, &ChessServer::onBinaryMessageReceived);
+        connect(client, &QWebSocket::disconnected, this, &ChessServer::onSocketDisconnected);
+        connect(client, &QWebSocket::pong, this, &ChessServer::onPong);
+
+        ClientInfo info;
+        info.id = (static_cast<quint64>(m_shardIndex) << 48) | ++m_nextClientSerial;
+        m_clients.insert(client, info);
+        m_sockets.insert(info.id, client);
+        client->ping();
+    }
+}
+
+void ChessServer::pingClients()
+{
+    for (auto it = m_clients.constBegin(); it != m_clients.constEnd(); ++it) {
+        it.key()->ping();
+    }
+}
+
+void ChessServer::onPong(quint64 elapsedTime)
+{
+    QWebSocket* client = qobject_cast<QWebSocket*>(sender());
+    auto it = m_clients.find(client);
+    if (it == m_clients.end()) return;
+
+    // 指數平滑，單次的網路抖動不會讓補償量大幅跳動
+    qint64 sample = static_cast<qint64>(elapsedTime);
+    ClientInfo& info = it.value();
+    info.rttMs = (info.rttMs < 0) ? sample : (info.rttMs * 7 + sample) / 8;
+}
+
+void ChessServer::onTextMessageReceived(const QString& message)
+{
+    QWebSocket* client = qobject_cast<QWebSocket*>(sender());
+    if (!client) return;
+
+    m_messagesIn++;
+
+    // server.js 遇到無效的 JSON 會直接拋出例外，這裡記錄後忽略
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qWarning() << "[ChessServer] Ignoring malformed message from" << client->peerAddress().toString()
+                   << ":" << error.errorString();
+        return;
+    }
+    handleMessage(client, doc.object(), message);
+}
+
+void ChessServer::onSocketDisconnected()
+{
+    QWebSocket* client = qobject_cast<QWebSocket*>(sender());
+    if (!client) return;
+
+    auto it = m_clients.find(client);
+    if (it == m_clients.end()) return;
+    const ClientInfo info = it.value();
+    m_clients.erase(it);
+    m_sockets.remove(info.id);
+    client->deleteLater();
+
+    // 只通知連線所在的房間：對局進行中保留座位等待續連，其他情況從房間移除
+    const ClientId id = info.id;
+    for (const QString& roomId : info.rooms) {
+        int owner = ownerShard(roomId, m_shardCount);
+        if (owner < 0 || owner == m_shardIndex) {
+            handleClientDisconnected(id, roomId);
+            continue;
+        }
+        ChessServer* shard = m_shards.at(owner);
+        QMetaObject::invokeMethod(shard, [shard, id, roomId]() {
+            shard->handleClientDisconnected(id, roomId);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void ChessServer::printStats()
+{
+    double seconds = qMax<qint64>(1, m_statsClock.restart()) / 1000.0;
+    QString tag = (m_shardCount > 1) ? QString("[ChessServer %1/%2]").arg(m_shardIndex + 1).arg(m_shardCount)
+                                     : QString("[ChessServer]");
+    qDebug().noquote() << QString("%1 clients %2 | rooms %3 | in %4 msg/s | out %5 frames/s")
+                          .arg(tag).arg(m_clients.size()).arg(m_rooms.size())
+                          .arg(m_messagesIn / seconds, 0, 'f', 0)
+                          .arg(m_framesOut / seconds, 0, 'f', 0);
+    m_messagesIn = 0;
+    m_framesOut = 0;
+}
+
+void ChessServer::handleMessage(QWebSocket* client, const QJsonObject& msg, const QString& raw)
+{
+    const QString action = msg.value("action").toString();
+    const QString roomId = msg.value("room").toString();
+    const ClientId id = m_clients.value(client).id;
+
+    // 時鐘同步：立即回覆伺服器時間，客戶端以往返時間估計偏移
+    if (action.isEmpty() && msg.value("type").toString() == "Ping") {
+        QJsonObject pong;
+        pong["type"] = "Pong";
+        pong["clientTime"] = msg.value("clientTime");
+        pong["serverTime"] = serverTimeMs();
+        send(id, pong);
+        return;
+    }
+
+    if (action == "hello") {
+        // 協商二進位走棋協議（房號必須是數字，目前的房號都是）
+        bool binary = msg.value("binary").toInt() >= BinaryProtocol::VERSION;
+        m_clients[client].binary = binary;
+        QJsonObject reply;
+        reply["action"] = "hello";
+        reply["binary"] = binary ? BinaryProtocol::VERSION : 0;
+        send(id, reply);
+    } else if (action == "createRoom") {
+        // 新房間配置在連線所在的分片，不需要轉交
+        handleCreateRoom(contextFor(client));
+    } else if (!action.isEmpty()) {
+        // 先記下可能加入的房間，之後的斷線通知才會送到房間所在的分片；加入失敗時由該分片取消
+        if (action == "joinRoom" || action == "resume") {
+            trackRoom(id, roomId, true);
+        }
+        dispatchRoomMessage(contextFor(client), roomId, msg, raw);
+    }
+}
+
+void ChessServer::dispatchRoomMessage(const ClientContext& context, const QString& roomId,
+                                      const QJsonObject& msg, const QString& raw)
+{
+    int owner = ownerShard(roomId, m_shardCount);
+    if (owner < 0 || owner == m_shardIndex) {
+        handleRoomMessage(context, roomId, msg, raw);
+        return;
+    }
+
+    // 同一個分片送往另一個分片的佇列呼叫依序執行，同一個連線的訊息不會亂序
+    ChessServer* shard = m_shards.at(owner);
+    QMetaObject::invokeMethod(shard, [shard, context, roomId, msg, raw]() {
+        shard->handleRoomMessage(context, roomId, msg, raw);
+    }, Qt::QueuedConnection);
+}
+
+void ChessServer::trackRoom(ClientId client, const QString& roomId, bool member)
+{
+    if (!client) return;
+
+    int shard = shardOf(client);
+    if (shard != m_shardIndex) {
+        ChessServer* target = m_shards.at(shard);
+        QMetaObject::invokeMethod(target, [target, client, roomId, member]() {
+            target->trackRoom(client, roomId, member);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    // 連線已經關閉時不需要記錄
+    auto it = m_clients.find(m_sockets.value(client));
+    if (it == m_clients.end()) return;
+    if (member) {
+        it->rooms.insert(roomId);
+    } else {
+        it->rooms.remove(roomId);
+    }
+}
+
+ClientContext ChessServer::contextFor(QWebSocket* client) const
+{
+    const ClientInfo info = m_clients.value(client);
+    ClientContext context;
+    context.id = info.id;
+    context.rttMs = info.rttMs;
+    context.binary = info.binary;
+    return context;
+}
+
+void ChessServer::handleRoomMessage(const ClientContext& context, const QString& roomId,
+                                    const QJsonObject& msg, const QString& raw)
+{
+    const QString action = msg.value("action").toString();
+
+    if (action == "joinRoom") {
+        handleJoinRoom(context, roomId);
+    } else if (action == "startGame") {
+        handleStartGame(context, roomId, msg);
+    } else if (action == "move") {
+        handleMove(context, roomId, msg, raw);
+    } else if (action == "resume") {
+        handleResume(context, roomId, msg);
+    } else if (action == "leaveRoom") {
+        handlePlayerLeaveRoom(context.id, roomId);
+    } else if (action == "surrender" || action == "drawOffer" || action == "drawResponse") {
+        auto it = m_rooms.find(roomId);
+        if (it != m_rooms.end() && handleGameEndingMessage(context.id, roomId, it.value(), action, msg)) {
+            relayGameMessage(context.id, it.value(), msg);
+        }
+    }
+}
+
+void ChessServer::handleCreateRoom(const ClientContext& context)
+{
+    QString roomId = allocateRoomId();
+    if (roomId.isEmpty()) {
+        QJsonObject reply;
+        reply["action"] = "error";
+        reply["message"] = QString("伺服器房間已滿");
+        send(context.id, reply);
+        return;
+    }
+
+    Seat seat;
+    seat.client = context.id;
+    seat.session = generateSessionId();
+    seat.binary = context.binary;
+    m_rooms[roomId].seats.append(seat);
+    trackRoom(context.id, roomId, true);
+
+    QJsonObject reply;
+    reply["action"] = "roomCreated";
+    reply["room"] = roomId;
+    reply["session"] = seat.session;
+    send(context.id, reply);
+}
+
+void ChessServer::handleJoinRoom(const ClientContext& context, const QString& roomId)
+{
+    auto it = m_rooms.find(roomId);
+    if (it == m_rooms.end()) {
+        trackRoom(context.id, roomId, false);
+        QJsonObject reply;
+        reply["action"] = "error";
+        reply["message"] = QString("房間不存在");
+        send(context.id, reply);
+        return;
+    }
+
+    Room& room = it.value();
+    Seat seat;
+    seat.client = context.id;
+    seat.session = generateSessionId();
+    seat.binary = context.binary;
+    room.seats.append(seat);
+
+    QJsonObject reply;
+    reply["action"] = "joinedRoom";
+    reply["room"] = roomId;
+    reply["session"] = seat.session;
+    send(context.id, reply);
+
+    // 通知房主有玩家加入
+    QJsonObject notice;
+    notice["action"] = "playerJoined";
+    notice["room"] = roomId;
+    send(room.seats.first().client, notice);
+}
+
+void ChessServer::handleStartGame(const ClientContext& context, const QString& roomId, const QJsonObject& msg)
+{
+    auto it = m_rooms.find(roomId);
+    if (it == m_rooms.end()) return;
+
+    // 只有房主能開始對局，進行中的對局不能被重新開始
+    Room& room = it.value();
+    if (room.seats.first().client != context.id) {
+        rejectAction(context.id, roomId, "startGame", "only the host can start the game");
+        return;
+    }
+    if (room.seats.size() != 2) {
+        rejectAction(context.id, roomId, "startGame", "waiting for an opponent");
+        return;
+    }
+    if (room.game.isStarted() && !room.game.isFinished()) {
+        rejectAction(context.id, roomId, "startGame", "game in progress");
+        return;
+    }
+
+    qint64 whiteTimeMs = msg.value("whiteTimeMs").toVariant().toLongLong();
+    qint64 blackTimeMs = msg.value("blackTimeMs").toVariant().toLongLong();
+    QString hostColor = msg.value("hostColor").toString();
+
+    // 確定哪個玩家是 A（房主）和 B（房客）
+    RoomTimer& timer = room.timer;
+    timer.whiteIsA = (hostColor == "White");
+    timer.timeA = timer.whiteIsA ? whiteTimeMs : blackTimeMs;
+    timer.timeB = timer.whiteIsA ? blackTimeMs : whiteTimeMs;
+    timer.currentPlayer = "White";
+    timer.lastSwitchTime = -1;      // 等待第一步棋才開始計時
+    timer.incrementMs = msg.value("incrementMs").toVariant().toLongLong();
+    timer.lagBudgetA = LAG_BUDGET_PER_GAME_MS;
+    timer.lagBudgetB = LAG_BUDGET_PER_GAME_MS;
+    room.game.reset();
+    room.drawOfferSeat = -1;
+    room.lastSeq = 0;
+    room.log.clear();
+    room.log.reserve(GAME_LOG_RESERVE);
+
+    QJsonObject start;
+    start["action"] = "gameStart";
+    start["room"] = roomId;
+    start["whiteTimeMs"] = whiteTimeMs;
+    start["blackTimeMs"] = blackTimeMs;
+    start["incrementMs"] = msg.value("incrementMs");
+    start["hostColor"] = msg.value("hostColor");
+    start["serverTimestamp"] = serverTimeMs() + START_TIMESTAMP_BUFFER_MS;
+    start["timerState"] = timerStateJson(timer);
+    start["seq"] = 0;
+
+    broadcast(room, serialize(start));
+}
+
+void ChessServer::handleMove(const ClientContext& context, const QString& roomId,
+                             const QJsonObject& msg, const QString& raw)
+{
+    auto it = m_rooms.find(roomId);
+    if (it == m_rooms.end()) return;
+
+    if (!it->game.isStarted()) {
+        // 對局尚未開始時只轉送給對手（向後相容）
+        broadcast(it.value(), raw, context.id);
+        return;
+    }
+
+    QPoint from(msg.value("fromCol").toInt(-1), msg.value("fromRow").toInt(-1));
+    QPoint to(msg.value("toCol").toInt(-1), msg.value("toRow").toInt(-1));
+    PieceType promotionType = static_cast<PieceType>(msg.value("promotion").toInt(static_cast<int>(PieceType::None)));
+    processMove(context, roomId, it.value(), from, to, promotionType);
+}
+
+void ChessServer::onBinaryMessageReceived(const QByteArray& message)
+{
+    QWebSocket* client = qobject_cast<QWebSocket*>(sender());
+    if (!client) return;
+
+    m_messagesIn++;
+
+    BinaryProtocol::MoveFrame frame;
+    if (!BinaryProtocol::decodeMove(message, frame)) {
+        qWarning() << "[ChessServer] Ignoring malformed binary frame from" << client->peerAddress().toString();
+        return;
+    }
+
+    // 在連線所在的分片解碼，房間所在的分片只處理走法
+    const ClientContext context = contextFor(client);
+    int owner = ownerShard(QString::number(frame.roomId), m_shardCount);
+    if (owner < 0 || owner == m_shardIndex) {
+        handleBinaryMove(context, frame);
+        return;
+    }
+    ChessServer* shard = m_shards.at(owner);
+    QMetaObject::invokeMethod(shard, [shard, context, frame]() {
+        shard->handleBinaryMove(context, frame);
+    }, Qt::QueuedConnection);
+}
+
+void ChessServer::handleBinaryMove(const ClientContext& context, const BinaryProtocol::MoveFrame& frame)
+{
+    QString roomId = QString::number(frame.roomId);
+    auto it = m_rooms.find(roomId);
+    if (it == m_rooms.end()) return;
+    if (!it->game.isStarted()) {
+        rejectMove(context.id, roomId, frame.from, frame.to, "game not started");
+        return;
+    }
+    processMove(context, roomId, it.value(), frame.from, frame.to, frame.promotionType);
+}
+
+void ChessServer::processMove(const ClientContext& context, const QString& roomId, Room& room,
+                              const QPoint& from, const QPoint& to, PieceType promotionType)
+{
+    // 只有輪到的一方可以走棋，且必須是合法的走法
+    if (playerColor(room, context.id) != room.game.sideToMove()) {
+        rejectMove(context.id, roomId, from, to, room.game.isFinished() ? "game is over" : "not your turn");
+        return;
+    }
+    QString error;
+    if (!room.game.applyMove(from, to, promotionType, error)) {
+        rejectMove(context.id, roomId, from, to, error);
+        return;
+    }
+
+    RoomTimer& timer = room.timer;
+    qint64 currentTime = serverTimeMs();
+    bool whiteMoved = (timer.currentPlayer == "White");
+    bool moverIsA = (whiteMoved == timer.whiteIsA);
+
+    // 第一步棋不扣時間；之後扣除經過時間，但減去走棋方上傳這步棋花費的單程延遲
+    qint64 elapsedMs = 0;
+    if (timer.lastSwitchTime >= 0) {
+        qint64 compensation = lagCompensation(context.rttMs, moverIsA ? timer.lagBudgetA : timer.lagBudgetB);
+        elapsedMs = qMax<qint64>(0, currentTime - timer.lastSwitchTime - compensation);
+    }
+
+    // currentPlayer 剛走完棋：扣除經過時間、加上加秒後切換到對手
+    qint64& moverTime = moverIsA ? timer.timeA : timer.timeB;
+    moverTime = qMax<qint64>(0, moverTime - elapsedMs) + timer.incrementMs;
+    timer.currentPlayer = whiteMoved ? "Black" : "White";
+    timer.lastSwitchTime = currentTime;
+
+    GameLogEntry entry;
+    entry.seq = ++room.lastSeq;
+    entry.from = from;
+    entry.to = to;
+    entry.promotionType = promotionType;
+    entry.timer = timer;
+    if (room.game.isFinished()) {
+        entry.result = room.game.result();
+        entry.reason = room.game.reason();
+    }
+    room.log.push_back(entry);
+
+    // 對手沒有回應就走棋，視為拒絕和棋
+    if (room.drawOfferSeat >= 0 && room.drawOfferSeat != seatIndex(room, context.id)) {
+        room.drawOfferSeat = -1;
+    }
+
+    broadcastMove(roomId, room, entry);
+}
+
+void ChessServer::broadcastMove(const QString& roomId, const Room& room, const GameLogEntry& entry)
+{
+    // 每種編碼最多序列化一次：協商過的玩家收到二進位訊框，其他玩家收到 JSON
+    QString json;
+    QByteArray binary;
+    for (const Seat& seat : room.seats) {
+        if (!seat.client) continue;
+
+        if (seat.binary) {
+            if (binary.isEmpty()) binary = encodeMoveRelay(roomId, entry);
+            sendBinary(seat.client, binary);
+        } else {
+            if (json.isEmpty()) json = serialize(moveJson(roomId, entry));
+            send(seat.client, json);
+        }
+    }
+}
+
+QJsonObject ChessServer::moveJson(const QString& roomId, const GameLogEntry& entry) const
+{
+    QJsonObject msg;
+    msg["action"] = "move";
+    msg["room"] = roomId;
+    msg["seq"] = static_cast<qint64>(entry.seq);
+    msg["fromRow"] = entry.from.y();
+    msg["fromCol"] = entry.from.x();
+    msg["toRow"] = entry.to.y();
+    msg["toCol"] = entry.to.x();
+    if (entry.promotionType != PieceType::None) {
+        msg["promotion"] = static_cast<int>(entry.promotionType);
+    }
+    // 使用這步棋當時的計時器與結果：續連重送多步棋時，每一步都與當初轉送的內容相同
+    msg["timerState"] = timerStateJson(entry.timer);
+    if (!entry.result.isEmpty()) {
+        QJsonObject gameOver;
+        gameOver["result"] = entry.result;
+        gameOver["reason"] = entry.reason;
+        msg["gameOver"] = gameOver;
+    }
+    return msg;
+}
+
+QByteArray ChessServer::encodeMoveRelay(const QString& roomId, const GameLogEntry& entry) const
+{
+    BinaryProtocol::MoveRelayFrame frame;
+    frame.move.roomId = roomId.toULongLong();
+    frame.move.from = entry.from;
+    frame.move.to = entry.to;
+    frame.move.promotionType = entry.promotionType;
+    frame.seq = entry.seq;
+    frame.timeA = entry.timer.timeA;
+    frame.timeB = entry.timer.timeB;
+    frame.whiteToMove = (entry.timer.currentPlayer == "White");
+    frame.serverTimeMs = serverTimeMs();
+    frame.sinceSwitchMs = entry.timer.lastSwitchTime >= 0 ? frame.serverTimeMs - entry.timer.lastSwitchTime : -1;
+
+    const QString& result = entry.result;
+    if (result == "1-0") {
+        frame.result = BinaryProtocol::ResultWhiteWins;
+    } else if (result == "0-1") {
+        frame.result = BinaryProtocol::ResultBlackWins;
+    } else if (!result.isEmpty()) {
+        frame.result = BinaryProtocol::ResultDraw;
+    }
+    return BinaryProtocol::encodeMoveRelay(frame);
+}
+
+bool ChessServer::handleGameEndingMessage(ClientId client, const QString& roomId, Room& room,
+                                          const QString& action, const QJsonObject& msg)
+{
+    // 只接受房間內的玩家，且只在對局進行中
+    PieceColor color = playerColor(room, client);
+    if (color == PieceColor::None) {
+        rejectAction(client, roomId, action, "not a player in this room");
+        return false;
+    }
+    if (!room.game.isStarted() || room.game.isFinished()) {
+        rejectAction(client, roomId, action, room.game.isFinished() ? "game is over" : "game not started");
+        return false;
+    }
+
+    // 投降與接受和棋也會結束伺服器端的對局，之後的走法一律拒絕
+    int seat = seatIndex(room, client);
+    if (action == "surrender") {
+        room.game.finish(color == PieceColor::White ? "0-1" : "1-0", "resignation");
+    } else if (action == "drawOffer") {
+        room.drawOfferSeat = seat;
+    } else {
+        // 只有被提和的一方能回應，而且必須有尚未回應的提和
+        if (room.drawOfferSeat < 0 || room.drawOfferSeat == seat) {
+            rejectAction(client, roomId, action, "no pending draw offer");
+            return false;
+        }
+        room.drawOfferSeat = -1;
+        if (msg.value("accepted").toBool()) {
+            room.game.finish("1/2-1/2", "agreement");
+        }
+    }
+    return true;
+}
+
+void ChessServer::relayGameMessage(ClientId client, Room& room, const QJsonObject& msg)
+{
+    // 加上序號後只序列化一次，記錄與轉送共用同一份資料
+    GameLogEntry entry;
+    entry.seq = ++room.lastSeq;
+    entry.senderSeat = seatIndex(room, client);
+    QJsonObject sequenced = msg;
+    sequenced["seq"] = static_cast<qint64>(entry.seq);
+    entry.payload = serialize(sequenced);
+    room.log.push_back(entry);
+    broadcast(room, entry.payload, client);
+
+    // 送出者收不到自己的訊息：另外回覆序號，讓它的 lastSeq 保持連續
+    QJsonObject ack;
+    ack["action"] = "ack";
+    ack["room"] = msg.value("room");
+    ack["seq"] = static_cast<qint64>(entry.seq);
+    send(client, ack);
+}
+
+void ChessServer::rejectMove(ClientId client, const QString& roomId,
+                             const QPoint& from, const QPoint& to, const QString& reason)
+{
+    qDebug() << "[ChessServer] Rejected move in room" << roomId << ":" << reason;
+
+    QJsonObject reply;
+    reply["action"] = "moveRejected";
+    reply["room"] = roomId;
+    reply["reason"] = reason;
+    reply["fromRow"] = from.y();
+    reply["fromCol"] = from.x();
+    reply["toRow"] = to.y();
+    reply["toCol"] = to.x();
+    send(client, reply);
+}
+
+void ChessServer::rejectAction(ClientId client, const QString& roomId, const QString& action, const QString& reason)
+{
+    qDebug() << "[ChessServer] Rejected" << action << "in room" << roomId << ":" << reason;
+
+    QJsonObject reply;
+    reply["action"] = "actionRejected";
+    reply["room"] = roomId;
+    reply["request"] = action;
+    reply["reason"] = reason;
+    send(client, reply);
+}
+
+int ChessServer::seatIndex(const Room& room, ClientId client)
+{
+    // 等待續連的座位沒有連線，不會對應到任何連線
+    if (!client) return -1;
+    for (int i = 0; i < room.seats.size(); ++i) {
+        if (room.seats.at(i).client == client) return i;
+    }
+    return -1;
+}
+
+PieceColor ChessServer::playerColor(const Room& room, ClientId client)
+{
+    // 房主（A）的顏色由 startGame 的 hostColor 決定
+    int index = seatIndex(room, client);
+    if (index < 0 || index > 1) return PieceColor::None;
+    bool isWhite = (index == 0) == room.timer.whiteIsA;
+    return isWhite ? PieceColor::White : PieceColor::Black;
+}
+
+void ChessServer::handleResume(const ClientContext& context, const QString& roomId, const QJsonObject& msg)
+{
+    // 憑證必須對應一個正在等待續連的座位
+    auto it = m_rooms.find(roomId);
+    const QString session = msg.value("session").toString();
+    int index = -1;
+    if (it != m_rooms.end() && !session.isEmpty()) {
+        for (int i = 0; i < it->seats.size() && index < 0; ++i) {
+            if (it->seats.at(i).session == session) index = i;
+        }
+    }
+    if (index < 0 || it->seats.at(index).client != 0) {
+        trackRoom(context.id, roomId, false);
+        QJsonObject reply;
+        reply["action"] = "resumeFailed";
+        reply["room"] = roomId;
+        reply["reason"] = QString(index < 0 ? "unknown session" : "session already connected");
+        send(context.id, reply);
+        return;
+    }
+
+    Room& room = it.value();
+    room.seats[index].client = context.id;
+    room.seats[index].binary = context.binary;
+    qDebug() << "[ChessServer] Player resumed in room" << roomId;
+
+    // 依序重送客戶端最後收到的序號之後的訊息，最後附上目前的計時器狀態
+    quint64 lastSeen = static_cast<quint64>(qMax<qint64>(0, msg.value("lastSeq").toVariant().toLongLong()));
+    // 投降與和棋訊息當初沒有轉送給送出者，重送時同樣略過
+    for (const GameLogEntry& entry : room.log) {
+        if (entry.seq <= lastSeen || entry.senderSeat == index) continue;
+        send(context.id, entry.payload.isEmpty() ? serialize(moveJson(roomId, entry)) : entry.payload);
+    }
+
+    QJsonObject resumed;
+    resumed["action"] = "resumed";
+    resumed["room"] = roomId;
+    resumed["seq"] = static_cast<qint64>(room.lastSeq);
+    resumed["timerState"] = timerStateJson(room.timer);
+    send(context.id, resumed);
+
+    QJsonObject notice;
+    notice["action"] = "opponentReconnected";
+    notice["room"] = roomId;
+    broadcast(room, serialize(notice), context.id);
+}
+
+void ChessServer::handlePlayerLeaveRoom(ClientId client, const QString& roomId)
+{
+    auto it = m_rooms.find(roomId);
+    if (it == m_rooms.end()) return;
+
+    int index = seatIndex(it.value(), client);
+    if (index >= 0) {
+        removePlayer(roomId, index);
+    }
+}
+
+void ChessServer::handleClientDisconnected(ClientId client, const QString& roomId)
+{
+    auto it = m_rooms.find(roomId);
+    if (it == m_rooms.end()) return;
+
+    // 玩家斷線：對局進行中保留座位等待續連，其他情況從房間移除
+    int index = seatIndex(it.value(), client);
+    if (index < 0) return;
+    if (it->game.isStarted() && !it->game.isFinished()) {
+        suspendPlayer(roomId, it.value(), index);
+    } else {
+        removePlayer(roomId, index);
+    }
+}
+
+void ChessServer::removePlayer(const QString& roomId, int index)
+{
+    auto it = m_rooms.find(roomId);
+    if (it == m_rooms.end()) return;
+
+    Room& room = it.value();
+    ClientId client = room.seats.at(index).client;
+    bool wasHost = (index == 0);
+
+    // 通知房間內其他玩家
+    QJsonObject left;
+    left["action"] = "playerLeft";
+    left["room"] = roomId;
+    broadcast(room, serialize(left), client);
+
+    room.seats.removeAt(index);
+    trackRoom(client, roomId, false);
+
+    // 房主離開且房間內還有其他玩家時，通知新房主
+    if (wasHost && !room.seats.isEmpty()) {
+        QJsonObject promoted;
+        promoted["action"] = "promotedToHost";
+        promoted["room"] = roomId;
+        send(room.seats.first().client, promoted);
+    }
+
+    if (room.seats.isEmpty()) {
+        m_rooms.erase(it);
+    }
+}
+
+void ChessServer::suspendPlayer(const QString& roomId, Room& room, int index)
+{
+    // 保留座位、局面與計時器（時鐘照常走），寬限期內沒有續連才視為離開
+    ClientId client = room.seats.at(index).client;
+    room.seats[index].client = 0;
+    qDebug() << "[ChessServer] Player lost connection in room" << roomId << ", holding seat for"
+             << RESUME_GRACE_MS << "ms";
+
+    QJsonObject notice;
+    notice["action"] = "opponentConnectionLost";
+    notice["room"] = roomId;
+    notice["graceMs"] = RESUME_GRACE_MS;
+    broadcast(room, serialize(notice), client);
+
+    const QString session = room.seats.at(index).session;
+    QTimer::singleShot(RESUME_GRACE_MS, this, [this, roomId, session]() {
+        expireSession(roomId, session);
+    });
+}
+
+void ChessServer::expireSession(const QString& roomId, const QString& session)
+{
+    auto it = m_rooms.find(roomId);
+    if (it == m_rooms.end()) return;
+
+    // 已經續連（或已離開）的座位不處理
+    for (int i = 0; i < it->seats.size(); ++i) {
+        if (it->seats.at(i).session != session) continue;
+        if (it->seats.at(i).client != 0) return;
+
+        qDebug() << "[ChessServer] Resume grace period expired in room" << roomId;
+        removePlayer(roomId, i);
+        return;
+    }
+}
+
+QString ChessServer::allocateRoomId()
+{
+    // 以固定步長走訪本分片的房號：一整輪之內不會重複，繞回之後才需要略過仍在使用的房號
+    for (quint64 attempt = 0; attempt < m_roomIdSlots; ++attempt) {
+        quint64 slot = (m_roomIdCounter % m_roomIdSlots) * m_roomIdStride % m_roomIdSlots;
+        m_roomIdCounter++;
+        QString roomId = QString::number(ROOM_ID_MIN + static_cast<qint64>(slot) * m_shardCount + m_shardIndex);
+        if (!m_rooms.contains(roomId)) return roomId;
+    }
+    return QString();
+}
+
+QString ChessServer::generateSessionId()
+{
+    return QString::number(QRandomGenerator::global()->generate64(), 16).rightJustified(16, '0');
+}
+
+qint64 ChessServer::lagCompensation(qint64 rttMs, qint64& budget)
+{
+    // 半個往返時間，每步與每盤棋都有上限，避免謊報延遲換取時間
+    if (rttMs <= 0 || budget <= 0) return 0;
+
+    qint64 compensation = qMin(qMin(rttMs / 2, MAX_LAG_COMPENSATION_MS), budget);
+    budget -= compensation;
+    return compensation;
+}
+
+QJsonObject ChessServer::timerStateJson(const RoomTimer& timer) const
+{
+    // lastSwitchTime 保留秒數給舊版客戶端；新版客戶端使用毫秒欄位，
+    // 並以 serverTimeMs 計算訊息送出時已經過的時間
+    QJsonObject state;
+    state["timeA"] = timer.timeA;
+    state["timeB"] = timer.timeB;
+    state["currentPlayer"] = timer.currentPlayer;
+    if (timer.lastSwitchTime >= 0) {
+        state["lastSwitchTime"] = (timer.lastSwitchTime + 999) / 1000;
+        state["lastSwitchTimeMs"] = timer.lastSwitchTime;
+    } else {
+        state["lastSwitchTime"] = QJsonValue();
+        state["lastSwitchTimeMs"] = QJsonValue();
+    }
+    state["serverTimeMs"] = serverTimeMs();
+    return state;
+}
+
+void ChessServer::send(ClientId client, const QString& payload)
+{
+    if (!client) return;
+
+    // 連線在其他分片時交給該分片送出（QString 隱式共享，跨執行緒傳遞不會複製）
+    int shard = shardOf(client);
+    if (shard == m_shardIndex) {
+        deliverText(client, payload);
+        return;
+    }
+    ChessServer* target = m_shards.at(shard);
+    QMetaObject::invokeMethod(target, [target, client, payload]() {
+        target->deliverText(client, payload);
+    }, Qt::QueuedConnection);
+}
+
+void ChessServer::send(ClientId client, const QJsonObject& message)
+{
+    send(client, serialize(message));
+}
+
+void ChessServer::sendBinary(ClientId client, const QByteArray& payload)
+{
+    if (!client) return;
+
+    int shard = shardOf(client);
+    if (shard == m_shardIndex) {
+        deliverBinary(client, payload);
+        return;
+    }
+    ChessServer* target = m_shards.at(shard);
+    QMetaObject::invokeMethod(target, [target, client, payload]() {
+        target->deliverBinary(client, payload);
+    }, Qt::QueuedConnection);
+}
+
+void ChessServer::deliverText(ClientId client, const QString& payload)
+{
+    QWebSocket* socket = m_sockets.value(client);
+    if (!socket || socket->state() != QAbstractSocket::ConnectedState) return;
+    socket->sendTextMessage(payload);
+    m_framesOut++;
+}
+
+void ChessServer::deliverBinary(ClientId client, const QByteArray& payload)
+{
+    QWebSocket* socket = m_sockets.value(client);
+    if (!socket || socket->state() != QAbstractSocket::ConnectedState) return;
+    socket->sendBinaryMessage(payload);
+    m_framesOut++;
+}
+
+void ChessServer::broadcast(const Room& room, const QString& payload, ClientId exclude)
+{
+    // payload 為隱式共享，所有接收者使用同一份序列化結果
+    for (const Seat& seat : room.seats) {
+        if (seat.client && seat.client != exclude) {
+            send(seat.client, payload);
+        }
+    }
+}
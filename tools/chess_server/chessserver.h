@@ -0,0 +1,191 @@
+#ifndef CHESSSERVER_H
+#define CHESSSERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <vector>
+#include "servergame.h"
+#include "binaryprotocol.h"
+
+class QWebSocketServer;
+class QWebSocket;
+class QTimer;
+
+// 連線編號：高 16 位元為連線所在的分片，其餘為分片內的流水號（0 表示沒有連線）
+using ClientId = quint64;
+
+// 一盤棋的計時狀態（與 server.js 的 gameTimers 相同，時間皆為毫秒）
+struct RoomTimer {
+    qint64 timeA = 0;               // 房主的剩餘時間
+    qint64 timeB = 0;               // 房客的剩餘時間
+    QString currentPlayer = "White";
+    qint64 lastSwitchTime = -1;     // 伺服器時間（毫秒）；-1 表示尚未開始計時（第一步棋之前）
+    bool whiteIsA = true;           // 白方是否為房主
+    qint64 incrementMs = 0;
+    qint64 lagBudgetA = 0;          // 本局剩餘可補償的延遲（房主）
+    qint64 lagBudgetB = 0;
+};
+
+// 本分片上的一個連線（伺服器定期送出 WebSocket ping 量測延遲）
+struct ClientInfo {
+    ClientId id = 0;
+    qint64 rttMs = -1;              // 平滑後的往返時間，-1 表示尚未量測
+    bool binary = false;            // 已協商二進位走棋訊框
+    QSet<QString> rooms;            // 連線所在的房間（可能由其他分片管理），斷線時只通知這些房間
+};
+
+// 轉交給房間所在分片的訊息附帶的連線資訊
+struct ClientContext {
+    ClientId id = 0;
+    qint64 rttMs = -1;
+    bool binary = false;
+};
+
+// 房間內的一個座位
+struct Seat {
+    ClientId client = 0;            // 0 表示對局中斷線、等待續連
+    QString session;                // 續連憑證
+    bool binary = false;            // 此玩家使用二進位走棋訊框
+};
+
+// 對局訊息記錄的一筆：走棋保留走法與走完當時的計時器和結果，重送時再序列化；投降與和棋保留轉送過的 JSON
+struct GameLogEntry {
+    quint64 seq = 0;
+    QPoint from;
+    QPoint to;
+    PieceType promotionType = PieceType::None;
+    RoomTimer timer;                // 這步棋之後的計時器狀態
+    QString result;                 // 這步棋結束對局時的結果與原因
+    QString reason;
+    QString payload;                // 非走棋訊息的 JSON，走棋時為空
+    int senderSeat = -1;            // 非走棋訊息只轉送給對手，續連時不重送給送出者；走棋會回傳給雙方，為 -1
+};
+
+// 一個房間：seats[0] 始終為房主
+struct Room {
+    QVector<Seat> seats;
+    ServerGame game;                // startGame 之後才開始驗證走法
+    RoomTimer timer;
+    quint64 lastSeq = 0;            // 最後一則對局訊息的序號（gameStart 為 0）
+    int drawOfferSeat = -1;         // 提出和棋且尚未得到回應的座位，-1 表示沒有
+    std::vector<GameLogEntry> log;  // 本局所有帶序號的訊息
+};
+
+// 原生 WebSocket 中繼伺服器，使用與 server.js 相同的 action 協議
+// （createRoom、joinRoom、startGame、move、leaveRoom、surrender、drawOffer、drawResponse）
+// 廣播訊息只序列化一次，所有接收者共用同一份資料
+// 對局開始後伺服器保有權威局面，非法走法以 moveRejected 回覆給送出者，不會轉送給對手；
+// 只有房主能開始對局，投降與和棋只接受房間內的玩家，不符合的訊息以 actionRejected 回覆
+// 以 hello 協商過的客戶端使用二進位走棋訊框（BinaryProtocol），其他客戶端維持 JSON
+// 對局中的訊息都帶有序號；玩家斷線後保留座位一段時間，以 resume 續連並重送遺漏的訊息
+//
+// 一個 ChessServer 是一個分片，在自己的執行緒上處理自己接受的連線與自己配置的房間：
+// 房號決定房間所在的分片，連線與房間不在同一個分片時，訊息以佇列呼叫轉交（見 ChessServerCluster）
+class ChessServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChessServer(int shardIndex = 0, int shardCount = 1, QObject *parent = nullptr);
+    ~ChessServer();
+
+    bool listen(quint16 port);
+    bool listenOnDescriptor(int socketDescriptor);  // 使用已經在監聽的通訊端（多個分片共用同一個埠）
+    quint16 port() const;
+    int roomCount() const { return m_rooms.size(); }
+    int clientCount() const { return m_clients.size(); }
+    void setStatsInterval(int seconds);     // 定期輸出吞吐量統計，0 表示關閉
+
+    // 以下在分片開始處理連線之前設定
+    void setShards(const QVector<ChessServer*>& shards);     // 所有分片（包含自己）
+    void setClock(qint64 epochMs, const QElapsedTimer& clock);  // 所有分片共用同一個伺服器時鐘
+
+    // 房號對應的分片；無效的房號返回 -1
+    static int ownerShard(const QString& roomId, int shardCount);
+
+private slots:
+    void onNewConnection();
+    void onTextMessageReceived(const QString& message);
+    void onBinaryMessageReceived(const QByteArray& message);
+    void onSocketDisconnected();
+    void onPong(quint64 elapsedTime);
+    void pingClients();
+    void printStats();
+
+private:
+    QWebSocketServer* m_server;
+    int m_shardIndex;
+    int m_shardCount;
+    QVector<ChessServer*> m_shards;
+    QHash<QString, Room> m_rooms;               // 本分片配置的房間
+    QHash<QWebSocket*, ClientInfo> m_clients;   // 本分片接受的連線
+    QHash<ClientId, QWebSocket*> m_sockets;
+    quint64 m_nextClientSerial;
+    quint64 m_roomIdCounter;                    // 房號配置：已配置的次數
+    quint64 m_roomIdSlots;                      // 本分片可用的房號數量
+    quint64 m_roomIdStride;                     // 與 m_roomIdSlots 互質的步長
+    QTimer* m_statsTimer;
+    QTimer* m_pingTimer;
+    QElapsedTimer m_statsClock;
+    QElapsedTimer m_clock;          // 單調時鐘，計時不受系統時間調整影響
+    qint64 m_clockEpochMs;          // m_clock 啟動時的 UNIX 毫秒數
+    qint64 m_messagesIn;
+    qint64 m_framesOut;
+
+    // 連線所在的分片：接收、轉交與送出
+    void handleMessage(QWebSocket* client, const QJsonObject& msg, const QString& raw);
+    void dispatchRoomMessage(const ClientContext& context, const QString& roomId,
+                             const QJsonObject& msg, const QString& raw);
+    void trackRoom(ClientId client, const QString& roomId, bool member);
+    void deliverText(ClientId client, const QString& payload);
+    void deliverBinary(ClientId client, const QByteArray& payload);
+    ClientContext contextFor(QWebSocket* client) const;
+
+    // 房間所在的分片：房間邏輯
+    void handleRoomMessage(const ClientContext& context, const QString& roomId,
+                           const QJsonObject& msg, const QString& raw);
+    void handleCreateRoom(const ClientContext& context);
+    void handleJoinRoom(const ClientContext& context, const QString& roomId);
+    void handleStartGame(const ClientContext& context, const QString& roomId, const QJsonObject& msg);
+    void handleMove(const ClientContext& context, const QString& roomId, const QJsonObject& msg, const QString& raw);
+    void handleBinaryMove(const ClientContext& context, const BinaryProtocol::MoveFrame& frame);
+    void processMove(const ClientContext& context, const QString& roomId, Room& room,
+                     const QPoint& from, const QPoint& to, PieceType promotionType);
+    void broadcastMove(const QString& roomId, const Room& room, const GameLogEntry& entry);
+    QJsonObject moveJson(const QString& roomId, const GameLogEntry& entry) const;
+    QByteArray encodeMoveRelay(const QString& roomId, const GameLogEntry& entry) const;
+    void handleResume(const ClientContext& context, const QString& roomId, const QJsonObject& msg);
+    void handlePlayerLeaveRoom(ClientId client, const QString& roomId);
+    void handleClientDisconnected(ClientId client, const QString& roomId);
+    void removePlayer(const QString& roomId, int index);
+    void suspendPlayer(const QString& roomId, Room& room, int index);
+    void expireSession(const QString& roomId, const QString& session);
+    void relayGameMessage(ClientId client, Room& room, const QJsonObject& msg);
+    bool handleGameEndingMessage(ClientId client, const QString& roomId, Room& room,
+                                 const QString& action, const QJsonObject& msg);
+    void rejectMove(ClientId client, const QString& roomId,
+                    const QPoint& from, const QPoint& to, const QString& reason);
+    void rejectAction(ClientId client, const QString& roomId, const QString& action, const QString& reason);
+    static int seatIndex(const Room& room, ClientId client);
+    static PieceColor playerColor(const Room& room, ClientId client);
+
+    QString allocateRoomId();
+    static QString generateSessionId();
+    int shardOf(ClientId client) const { return static_cast<int>(client >> 48); }
+    qint64 serverTimeMs() const { return m_clockEpochMs + m_clock.elapsed(); }
+    static qint64 lagCompensation(qint64 rttMs, qint64& budget);
+    QJsonObject timerStateJson(const RoomTimer& timer) const;
+    void send(ClientId client, const QString& payload);
+    void send(ClientId client, const QJsonObject& message);
+    void sendBinary(ClientId client, const QByteArray& payload);
+    // 同一份序列化後的資料送給房間內的玩家（exclude 不為 0 時略過該玩家）
+    void broadcast(const Room& room, const QString& payload, ClientId exclude = 0);
+};
+
+#endif // CHESSSERVER_H
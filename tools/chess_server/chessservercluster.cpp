@@ -0,0 +1,156 @@
+#include "chessservercluster.h"
+#include "chessserver.h"
+#include <QThread>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+ChessServerCluster::ChessServerCluster(int shardCount, QObject *parent)
+    : QObject(parent)
+{
+#ifndef Q_OS_LINUX
+    if (shardCount > 1) {
+        qWarning() << "[ChessServerCluster] SO_REUSEPORT is not available, using a single thread";
+    }
+    shardCount = 1;
+#endif
+    shardCount = qMax(1, shardCount);
+
+    // 所有分片共用同一個伺服器時鐘，不同分片送出的 serverTimeMs 可以互相比較
+    qint64 epochMs = QDateTime::currentMSecsSinceEpoch();
+    QElapsedTimer clock;
+    clock.start();
+
+    for (int i = 0; i < shardCount; ++i) {
+        ChessServer* shard = new ChessServer(i, shardCount);
+        shard->setClock(epochMs, clock);
+        m_shards.append(shard);
+    }
+    for (ChessServer* shard : m_shards) {
+        shard->setShards(m_shards);
+    }
+
+    // 單一分片留在主執行緒，與原本的行為相同
+    if (shardCount == 1) return;
+
+    for (ChessServer* shard : m_shards) {
+        QThread* thread = new QThread(this);
+        shard->moveToThread(thread);
+        connect(thread, &QThread::finished, shard, &QObject::deleteLater);
+        m_threads.append(thread);
+        thread->start();
+    }
+}
+
+ChessServerCluster::~ChessServerCluster()
+{
+    if (m_threads.isEmpty()) {
+        qDeleteAll(m_shards);
+        return;
+    }
+    for (QThread* thread : m_threads) {
+        thread->quit();
+    }
+    for (QThread* thread : m_threads) {
+        thread->wait();
+    }
+}
+
+bool ChessServerCluster::listen(quint16 port)
+{
+    if (m_shards.size() == 1) {
+        return m_shards.first()->listen(port);
+    }
+
+    for (ChessServer* shard : m_shards) {
+        int descriptor = openReusePortSocket(port);
+        if (descriptor < 0) {
+            qWarning() << "[ChessServerCluster] Failed to listen on port" << port;
+            return false;
+        }
+
+        // 通訊端必須在分片自己的執行緒上交給 QWebSocketServer
+        bool ok = false;
+        QMetaObject::invokeMethod(shard, [shard, descriptor, &ok]() {
+            ok = shard->listenOnDescriptor(descriptor);
+        }, Qt::BlockingQueuedConnection);
+        if (!ok) return false;
+    }
+
+    qDebug() << "[ChessServer] WebSocket relay server running on port" << port
+             << "with" << m_shards.size() << "threads";
+    return true;
+}
+
+void ChessServerCluster::setStatsInterval(int seconds)
+{
+    for (ChessServer* shard : m_shards) {
+        QMetaObject::invokeMethod(shard, [shard, seconds]() {
+            shard->setStatsInterval(seconds);
+        }, Qt::QueuedConnection);
+    }
+}
+
+int ChessServerCluster::openReusePortSocket(quint16& port)
+{
+#ifdef Q_OS_LINUX
+    // 優先使用雙堆疊 IPv6，與 QHostAddress::Any 相同同時接受 IPv4 連線
+    int descriptor = ::socket(AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool ipv6 = (descriptor >= 0);
+    if (!ipv6) {
+        descriptor = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (descriptor < 0) return -1;
+    }
+
+    int on = 1;
+    int off = 0;
+    ::setsockopt(descriptor, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::setsockopt(descriptor, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+        ::close(descriptor);
+        return -1;
+    }
+
+    int result;
+    if (ipv6) {
+        ::setsockopt(descriptor, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+        sockaddr_in6 address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin6_family = AF_INET6;
+        address.sin6_addr = in6addr_any;
+        address.sin6_port = htons(port);
+        result = ::bind(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    } else {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        result = ::bind(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+    if (result < 0 || ::listen(descriptor, SOMAXCONN) < 0) {
+        ::close(descriptor);
+        return -1;
+    }
+
+    // 埠為 0 時由系統選擇，之後的分片使用同一個埠
+    if (port == 0) {
+        sockaddr_storage bound;
+        socklen_t length = sizeof(bound);
+        if (::getsockname(descriptor, reinterpret_cast<sockaddr*>(&bound), &length) == 0) {
+            port = ntohs(bound.ss_family == AF_INET6 ? reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port
+                                                     : reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+        }
+    }
+    return descriptor;
+#else
+    Q_UNUSED(port);
+    return -1;
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef CHESSSERVERCLUSTER_H
+#define CHESSSERVERCLUSTER_H
+
+#include <QObject>
+#include <QVector>
+
+class ChessServer;
+class QThread;
+
+// 多執行緒中繼伺服器：每個分片（ChessServer）在自己的執行緒上執行，
+// 所有分片以 SO_REUSEPORT 監聽同一個埠，由核心平均分配新連線
+// 不支援 SO_REUSEPORT 的平台只使用一個分片
+class ChessServerCluster : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChessServerCluster(int shardCount = 1, QObject *parent = nullptr);
+    ~ChessServerCluster();
+
+    bool listen(quint16 port);
+    int shardCount() const { return m_shards.size(); }
+    void setStatsInterval(int seconds);
+
+private:
+    QVector<ChessServer*> m_shards;
+    QVector<QThread*> m_threads;
+
+    // 建立一個已經在監聽的通訊端（port 為 0 時由系統選擇並寫回），失敗返回 -1
+    static int openReusePortSocket(quint16& port);
+};
+
+#endif // CHESSSERVERCLUSTER_H
@@ -0,0 +1,41 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include "chessservercluster.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("chess_server");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("WebSocket relay for online games (same protocol as server.js).");
+    parser.addHelpOption();
+
+    // 與 server.js 相同：預設使用 PORT 環境變數，否則 3000
+    QString defaultPort = qEnvironmentVariable("PORT", "3000");
+    QCommandLineOption portOption("port", "Listen port (default: $PORT or 3000).", "port", defaultPort);
+    QCommandLineOption statsOption("stats", "Print throughput every N seconds (0 = off).", "seconds", "0");
+    QCommandLineOption threadsOption("threads", "Number of relay threads (0 = one per core, default: 1).", "count", "1");
+    parser.addOptions({portOption, statsOption, threadsOption});
+    parser.process(app);
+
+    bool ok = false;
+    quint16 port = parser.value(portOption).toUShort(&ok);
+    if (!ok) {
+        qCritical("Invalid port: %s", qPrintable(parser.value(portOption)));
+        return 1;
+    }
+
+    int threads = parser.value(threadsOption).toInt();
+    if (threads <= 0) {
+        threads = QThread::idealThreadCount();
+    }
+
+    ChessServerCluster server(threads);
+    if (!server.listen(port)) {
+        return 1;
+    }
+    server.setStatsInterval(parser.value(statsOption).toInt());
+    return app.exec();
+}
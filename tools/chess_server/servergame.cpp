@@ -0,0 +1,140 @@
+#include "servergame.h"
+#include <algorithm>
+
+namespace {
+const int FIFTY_MOVE_PLIES = 100;
+const int MAX_REVERSIBLE_PLIES = 128;       // 預先配置的局面雜湊數量（五十步規則的上限再留一些餘裕）
+const quint64 FNV_OFFSET = 14695981039346656037ULL;
+const quint64 FNV_PRIME = 1099511628211ULL;
+
+bool onBoard(const QPoint& square)
+{
+    return square.x() >= 0 && square.x() < 8 && square.y() >= 0 && square.y() < 8;
+}
+
+quint64 mix(quint64 hash, quint64 value)
+{
+    return (hash ^ value) * FNV_PRIME;
+}
+}
+
+ServerGame::ServerGame()
+    : m_started(false)
+    , m_plyCount(0)
+    , m_halfmoveClock(0)
+{
+    // 伺服器只需要規則判定，不產生棋譜字串
+    m_board.setMoveRecording(false);
+    m_positionKeys.reserve(MAX_REVERSIBLE_PLIES);
+}
+
+void ServerGame::reset()
+{
+    m_board.initializeBoard();
+    m_started = true;
+    m_plyCount = 0;
+    m_halfmoveClock = 0;
+    m_positionKeys.clear();
+    m_positionKeys.push_back(positionKey());
+    m_result.clear();
+    m_reason.clear();
+}
+
+bool ServerGame::applyMove(const QPoint& from, const QPoint& to, PieceType promotionType, QString& error)
+{
+    if (!m_started) {
+        error = "game not started";
+        return false;
+    }
+    if (isFinished()) {
+        error = "game is over";
+        return false;
+    }
+    if (!onBoard(from) || !onBoard(to)) {
+        error = "square off the board";
+        return false;
+    }
+
+    const ChessPiece& piece = m_board.getPiece(from.y(), from.x());
+    bool isPawnMove = piece.getType() == PieceType::Pawn;
+    bool isCapture = m_board.getPiece(to.y(), to.x()).getType() != PieceType::None
+                     || (isPawnMove && to == m_board.getEnPassantTarget());
+
+    // 升變只能選擇后、車、象、馬；客戶端沒有指定時與本機一樣升為后
+    bool promotes = isPawnMove && (to.y() == 0 || to.y() == 7);
+    if (promotes) {
+        if (promotionType == PieceType::None) {
+            promotionType = PieceType::Queen;
+        } else if (promotionType != PieceType::Queen && promotionType != PieceType::Rook
+                   && promotionType != PieceType::Bishop && promotionType != PieceType::Knight) {
+            error = "invalid promotion piece";
+            return false;
+        }
+    }
+
+    if (!m_board.movePiece(from, to)) {
+        error = "illegal move";
+        return false;
+    }
+    if (promotes) {
+        m_board.promotePawn(to, promotionType);
+    }
+
+    m_plyCount++;
+    if (isPawnMove || isCapture) {
+        // 不可逆的走法：之前的局面不可能再出現
+        m_halfmoveClock = 0;
+        m_positionKeys.clear();
+    } else {
+        m_halfmoveClock++;
+    }
+    m_positionKeys.push_back(positionKey());
+
+    checkGameOver();
+    return true;
+}
+
+void ServerGame::finish(const QString& result, const QString& reason)
+{
+    if (isFinished()) return;
+    m_result = result;
+    m_reason = reason;
+}
+
+quint64 ServerGame::positionKey() const
+{
+    // 棋子位置、行棋方、吃過路兵目標與王車的移動狀態（易位權）
+    quint64 hash = FNV_OFFSET;
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            const ChessPiece& piece = m_board.getPiece(row, col);
+            quint64 value = static_cast<quint64>(piece.getType()) * 3 + static_cast<quint64>(piece.getColor());
+            if (piece.getType() == PieceType::King || piece.getType() == PieceType::Rook) {
+                value = value * 2 + (piece.hasMoved() ? 1 : 0);
+            }
+            hash = mix(hash, value);
+        }
+    }
+    QPoint enPassant = m_board.getEnPassantTarget();
+    hash = mix(hash, static_cast<quint64>(m_board.getCurrentPlayer()));
+    hash = mix(hash, static_cast<quint64>(enPassant.x() + 1) * 16 + static_cast<quint64>(enPassant.y() + 1));
+    return hash;
+}
+
+void ServerGame::checkGameOver()
+{
+    PieceColor toMove = m_board.getCurrentPlayer();
+    QString moverWins = (toMove == PieceColor::White) ? "0-1" : "1-0";
+
+    if (m_board.isCheckmate(toMove)) {
+        finish(moverWins, "checkmate");
+    } else if (m_board.isStalemate(toMove)) {
+        finish("1/2-1/2", "stalemate");
+    } else if (m_board.isInsufficientMaterial()) {
+        finish("1/2-1/2", "insufficient material");
+    } else if (m_halfmoveClock >= FIFTY_MOVE_PLIES) {
+        finish("1/2-1/2", "fifty-move rule");
+    } else if (std::count(m_positionKeys.cbegin(), m_positionKeys.cend(), m_positionKeys.back()) >= 3) {
+        finish("1/2-1/2", "threefold repetition");
+    }
+}
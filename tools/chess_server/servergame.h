@@ -0,0 +1,46 @@
+#ifndef SERVERGAME_H
+#define SERVERGAME_H
+
+#include <QString>
+#include <QPoint>
+#include <vector>
+#include "chessboard.h"
+
+// 伺服器端的權威局面：用與客戶端相同的 ChessBoard 規則驗證每一步棋，
+// 並在伺服器端判定將死、逼和、子力不足、五十步規則與三次重複
+class ServerGame
+{
+public:
+    ServerGame();
+
+    void reset();
+    bool isStarted() const { return m_started; }
+    bool isFinished() const { return !m_result.isEmpty(); }
+    PieceColor sideToMove() const { return m_board.getCurrentPlayer(); }
+    int plyCount() const { return m_plyCount; }
+
+    // 驗證並執行一步棋；非法時返回 false 並填入原因，局面不變
+    bool applyMove(const QPoint& from, const QPoint& to, PieceType promotionType, QString& error);
+    // 由規則以外的方式結束（投降、議和）
+    void finish(const QString& result, const QString& reason);
+
+    const QString& result() const { return m_result; }     // "1-0"、"0-1"、"1/2-1/2"，進行中為空
+    const QString& reason() const { return m_reason; }
+
+    const ChessBoard& board() const { return m_board; }
+    // 局面雜湊：棋子位置、行棋方、吃過路兵目標與易位權（相同局面的雜湊相同）
+    quint64 positionKey() const;
+
+private:
+    ChessBoard m_board;
+    bool m_started;
+    int m_plyCount;
+    int m_halfmoveClock;                    // 五十步規則計數（半步）
+    std::vector<quint64> m_positionKeys;    // 最後一次不可逆走法之後每個局面的雜湊
+    QString m_result;
+    QString m_reason;
+
+    void checkGameOver();
+};
+
+#endif // SERVERGAME_H
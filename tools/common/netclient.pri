@@ -0,0 +1,31 @@
+# 網路測試工具（netload、netsim）共用的設定與原始碼：
+# 客戶端的 NetworkManager 與規則程式碼、伺服器端的 ServerGame（比對雙方局面），以及 tools/common 的共用程式
+QT       += core network websockets
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+CLIENT_SRC = $$PWD/../../src
+SERVER_SRC = $$PWD/../chess_server
+INCLUDEPATH += $$PWD $$CLIENT_SRC $$SERVER_SRC
+
+SOURCES += \
+    $$PWD/randommove.cpp \
+    $$PWD/serverprocess.cpp \
+    $$PWD/quietlog.cpp \
+    $$SERVER_SRC/servergame.cpp \
+    $$CLIENT_SRC/networkmanager.cpp \
+    $$CLIENT_SRC/binaryprotocol.cpp \
+    $$CLIENT_SRC/chesspiece.cpp \
+    $$CLIENT_SRC/chessboard.cpp
+
+HEADERS += \
+    $$PWD/randommove.h \
+    $$PWD/serverprocess.h \
+    $$PWD/quietlog.h \
+    $$SERVER_SRC/servergame.h \
+    $$CLIENT_SRC/networkmanager.h \
+    $$CLIENT_SRC/binaryprotocol.h \
+    $$CLIENT_SRC/chesspiece.h \
+    $$CLIENT_SRC/chessboard.h
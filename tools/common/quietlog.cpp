@@ -0,0 +1,17 @@
+#include "quietlog.h"
+#include <QtGlobal>
+
+namespace {
+QtMessageHandler g_defaultMessageHandler = nullptr;
+
+void quietMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    if (type == QtDebugMsg) return;
+    g_defaultMessageHandler(type, context, message);
+}
+}
+
+void installQuietMessageHandler()
+{
+    g_defaultMessageHandler = qInstallMessageHandler(quietMessageHandler);
+}
@@ -0,0 +1,7 @@
+#ifndef QUIETLOG_H
+#define QUIETLOG_H
+
+// NetworkManager 每則訊息都會輸出除錯訊息：安裝後只保留資訊、警告與錯誤
+void installQuietMessageHandler();
+
+#endif // QUIETLOG_H
@@ -0,0 +1,37 @@
+#include "randommove.h"
+#include <QPair>
+#include <QVector>
+
+namespace {
+const PieceType PROMOTION_CHOICES[] = {PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight};
+}
+
+bool chooseRandomMove(const ChessBoard& board, QRandomGenerator& random,
+                      QPoint& from, QPoint& to, PieceType& promotionType)
+{
+    QVector<QPair<QPoint, QPoint>> moves;
+    PieceColor color = board.getCurrentPlayer();
+    for (int fromRow = 0; fromRow < 8; ++fromRow) {
+        for (int fromCol = 0; fromCol < 8; ++fromCol) {
+            if (board.getPiece(fromRow, fromCol).getColor() != color) continue;
+            QPoint source(fromCol, fromRow);
+            for (int toRow = 0; toRow < 8; ++toRow) {
+                for (int toCol = 0; toCol < 8; ++toCol) {
+                    QPoint target(toCol, toRow);
+                    if (board.isValidMove(source, target)) {
+                        moves.append(qMakePair(source, target));
+                    }
+                }
+            }
+        }
+    }
+    if (moves.isEmpty()) return false;
+
+    const QPair<QPoint, QPoint>& move = moves.at(random.bounded(moves.size()));
+    from = move.first;
+    to = move.second;
+
+    bool promotes = board.getPiece(from.y(), from.x()).getType() == PieceType::Pawn && (to.y() == 0 || to.y() == 7);
+    promotionType = promotes ? PROMOTION_CHOICES[random.bounded(4)] : PieceType::None;
+    return true;
+}
@@ -0,0 +1,13 @@
+#ifndef RANDOMMOVE_H
+#define RANDOMMOVE_H
+
+#include <QPoint>
+#include <QRandomGenerator>
+#include "chessboard.h"
+
+// 從所有合法走法中隨機選一步；升變時也隨機選擇棋子，同時測試升變欄位的轉送。
+// 沒有合法走法時返回 false
+bool chooseRandomMove(const ChessBoard& board, QRandomGenerator& random,
+                      QPoint& from, QPoint& to, PieceType& promotionType);
+
+#endif // RANDOMMOVE_H
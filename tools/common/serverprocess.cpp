@@ -0,0 +1,58 @@
+#include "serverprocess.h"
+#include <QDebug>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QStringList>
+#include <QUrl>
+
+namespace {
+const int SERVER_SHUTDOWN_MS = 3000;
+}
+
+ServerProcess::ServerProcess(const char* logTag)
+    : m_logTag(logTag)
+    , m_process(nullptr)
+{
+}
+
+ServerProcess::~ServerProcess()
+{
+    if (m_process && m_process->state() != QProcess::NotRunning) {
+        m_process->kill();
+        m_process->waitForFinished(SERVER_SHUTDOWN_MS);
+    }
+    delete m_process;
+}
+
+bool ServerProcess::start(const QString& command, const QString& serverUrl)
+{
+    QStringList arguments = QProcess::splitCommand(command);
+    if (arguments.isEmpty()) {
+        qWarning() << m_logTag << "Empty server command";
+        return false;
+    }
+    QString program = arguments.takeFirst();
+
+    // server.js 與 chess_server 都以 PORT 環境變數決定監聽的埠
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("PORT", QString::number(QUrl(serverUrl).port(3000)));
+    m_process = new QProcess();
+    m_process->setProcessEnvironment(environment);
+    m_process->setProcessChannelMode(QProcess::ForwardedChannels);
+    m_process->start(program, arguments);
+    if (!m_process->waitForStarted()) {
+        qWarning() << m_logTag << "Cannot start server:" << m_process->errorString();
+        return false;
+    }
+    return true;
+}
+
+void ServerProcess::stop()
+{
+    if (m_process && m_process->state() != QProcess::NotRunning) {
+        m_process->terminate();
+        if (!m_process->waitForFinished(SERVER_SHUTDOWN_MS)) {
+            m_process->kill();
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef SERVERPROCESS_H
+#define SERVERPROCESS_H
+
+#include <QString>
+
+class QProcess;
+
+// 測試工具代為啟動的中繼伺服器（server.js 或 chess_server），以 PORT 環境變數指定埠
+class ServerProcess
+{
+public:
+    static constexpr int STARTUP_MS = 1000;     // 啟動後開始監聽前的等待時間
+
+    explicit ServerProcess(const char* logTag);
+    ~ServerProcess();                       // 仍在執行時強制結束
+
+    // command 例如 "node server.js"；埠取自 serverUrl（預設 3000）
+    bool start(const QString& command, const QString& serverUrl);
+    void stop();                            // 先要求結束，逾時才強制終止
+
+    bool isStarted() const { return m_process != nullptr; }
+    QProcess* process() const { return m_process; }
+
+private:
+    const char* m_logTag;
+    QProcess* m_process;
+};
+
+#endif // SERVERPROCESS_H
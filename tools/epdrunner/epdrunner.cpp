@@ -0,0 +1,147 @@
+#include "epdrunner.h"
+#include <QDebug>
+
+namespace {
+const int INFO_UPDATE_HZ = 60;          // 解題時間的精確度取決於搜尋資訊的頻率
+}
+
+EpdRunner::EpdRunner(const EpdSuite& suite, const EpdRunOptions& options, QObject *parent)
+    : QObject(parent)
+    , m_suite(suite)
+    , m_options(options)
+    , m_pool(nullptr)
+    , m_finishedCount(0)
+{
+}
+
+bool EpdRunner::start()
+{
+    const QVector<EpdPosition>& positions = m_suite.positions();
+    if (positions.isEmpty()) {
+        qWarning() << "[EpdRunner] Suite has no usable positions";
+        return false;
+    }
+
+    m_pool = new EnginePool(this);
+    m_pool->setInfoUpdateRate(INFO_UPDATE_HZ);
+    connect(m_pool, &EnginePool::jobInfo, this, &EpdRunner::onJobInfo);
+    connect(m_pool, &EnginePool::jobFinished, this, &EpdRunner::onJobFinished);
+    connect(m_pool, &EnginePool::poolError, this, &EpdRunner::onPoolError);
+    if (!m_pool->start(m_options.enginePath, m_options.engines, m_options.threadsPerEngine)) {
+        return false;
+    }
+
+    // 每個局面都是獨立的工作，引擎空出來就取下一個
+    m_results.resize(positions.size());
+    for (int i = 0; i < positions.size(); ++i) {
+        EngineJob job;
+        job.type = EngineJobType::AnalysePosition;
+        job.fen = positions[i].fen;
+        job.limits = m_options.limits;
+        m_jobPositions.insert(m_pool->submit(job), i);
+    }
+
+    qInfo().noquote() << QString("[EpdRunner] %1 positions on %2 engines")
+                         .arg(positions.size()).arg(m_pool->engineCount());
+    m_timer.start();
+    return true;
+}
+
+void EpdRunner::onJobInfo(int jobId, const EngineInfo& info)
+{
+    auto it = m_jobPositions.constFind(jobId);
+    if (it == m_jobPositions.constEnd() || info.lowerBound || info.upperBound) return;
+
+    // 解題時間是「最後一次」改為正確走法的時刻：之後又改變想法就重新計算
+    const EpdPosition& position = m_suite.positions()[it.value()];
+    PositionResult& result = m_results[it.value()];
+    if (position.accepts(info.bestMove())) {
+        if (result.solveTimeMs < 0) {
+            result.solveTimeMs = info.timeMs;
+            result.solveNodes = info.nodes;
+        }
+    } else {
+        result.solveTimeMs = -1;
+        result.solveNodes = -1;
+    }
+}
+
+void EpdRunner::onJobFinished(const EngineJobResult& result)
+{
+    auto it = m_jobPositions.find(result.jobId);
+    if (it == m_jobPositions.end()) return;
+
+    int index = it.value();
+    m_jobPositions.erase(it);
+
+    const EpdPosition& position = m_suite.positions()[index];
+    PositionResult& positionResult = m_results[index];
+    positionResult.done = true;
+    positionResult.move = result.bestMove;
+    positionResult.solved = position.accepts(result.bestMove);
+    positionResult.nodes = result.info.nodes;
+    positionResult.timeMs = result.info.timeMs;
+    positionResult.depth = result.info.depth;
+    if (!positionResult.solved) {
+        positionResult.solveTimeMs = -1;
+        positionResult.solveNodes = -1;
+    } else if (positionResult.solveTimeMs < 0) {
+        // 資訊被節流而沒有收到：以最後的結果為準
+        positionResult.solveTimeMs = result.info.timeMs;
+        positionResult.solveNodes = result.info.nodes;
+    }
+
+    if (m_options.verbose) {
+        QString expected = !position.bestMovesSan.isEmpty() ? "bm " + position.bestMovesSan.join(' ')
+                                                           : "am " + position.avoidMovesSan.join(' ');
+        qInfo().noquote() << QString("%1 %2 %3 (%4) depth %5 time %6 ms nodes %7")
+                             .arg(positionResult.solved ? "+" : "-", position.id, result.bestMove, expected)
+                             .arg(positionResult.depth)
+                             .arg(positionResult.solved ? positionResult.solveTimeMs : positionResult.timeMs)
+                             .arg(positionResult.solved ? positionResult.solveNodes : positionResult.nodes);
+    }
+
+    if (++m_finishedCount == m_results.size()) {
+        report();
+        m_pool->stop();
+        emit finished(0);
+    }
+}
+
+void EpdRunner::onPoolError(const QString& error)
+{
+    qWarning() << "[EpdRunner] Engine pool failed:" << error;
+    emit finished(1);
+}
+
+void EpdRunner::report()
+{
+    int solved = 0;
+    qint64 totalNodes = 0;
+    qint64 totalSearchMs = 0;
+    qint64 solveTimeSum = 0;
+    qint64 solveNodesSum = 0;
+    for (const PositionResult& result : m_results) {
+        totalNodes += result.nodes;
+        totalSearchMs += result.timeMs;
+        if (!result.solved) continue;
+        solved++;
+        solveTimeSum += result.solveTimeMs;
+        solveNodesSum += result.solveNodes;
+    }
+
+    qint64 wallMs = m_timer.elapsed();
+    int total = m_results.size();
+    qInfo().noquote() << QString("Solved: %1 / %2 (%3%)")
+                         .arg(solved).arg(total).arg(100.0 * solved / total, 0, 'f', 1);
+    if (solved > 0) {
+        qInfo().noquote() << QString("Average time to solve: %1 ms, average nodes to solve: %2")
+                             .arg(solveTimeSum / solved).arg(solveNodesSum / solved);
+    }
+    // 搜尋速度以引擎自己回報的時間計算；總時間反映引擎池的平行效率
+    qInfo().noquote() << QString("Total nodes: %1, engine nps: %2, wall time: %3 s, aggregate nps: %4")
+                         .arg(totalNodes)
+                         .arg(totalSearchMs > 0 ? totalNodes * 1000 / totalSearchMs : 0)
+                         .arg(wallMs / 1000.0, 0, 'f', 1)
+                         .arg(wallMs > 0 ? totalNodes * 1000 / wallMs : 0);
+}
@@ -0,0 +1,64 @@
+#ifndef EPDRUNNER_H
+#define EPDRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QElapsedTimer>
+#include "enginepool.h"
+#include "epdsuite.h"
+
+// 執行設定
+struct EpdRunOptions {
+    QString enginePath;
+    SearchLimits limits;            // 每個局面固定時間或節點數
+    int engines = 0;                // 0 表示核心數 / threadsPerEngine
+    int threadsPerEngine = 1;
+    bool verbose = false;           // 逐一列出每個局面的結果
+};
+
+// EPD 測試套件執行器：所有局面同時送入引擎池，
+// 記錄每個局面是否解出、以及最後一次改為正確走法時的時間和節點數
+class EpdRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    EpdRunner(const EpdSuite& suite, const EpdRunOptions& options, QObject *parent = nullptr);
+
+    bool start();
+
+signals:
+    void finished(int exitCode);
+
+private slots:
+    void onJobInfo(int jobId, const EngineInfo& info);
+    void onJobFinished(const EngineJobResult& result);
+    void onPoolError(const QString& error);
+
+private:
+    // 一個局面的結果
+    struct PositionResult {
+        bool done = false;
+        bool solved = false;
+        QString move;
+        qint64 solveTimeMs = -1;    // 找到並保持正確走法的時間（-1 表示未解出）
+        qint64 solveNodes = -1;
+        qint64 nodes = 0;
+        qint64 timeMs = 0;
+        int depth = 0;
+    };
+
+    const EpdSuite& m_suite;
+    EpdRunOptions m_options;
+    EnginePool* m_pool;
+    QHash<int, int> m_jobPositions;     // 工作編號 -> 局面索引
+    QVector<PositionResult> m_results;
+    QElapsedTimer m_timer;
+    int m_finishedCount;
+
+    void report();
+};
+
+#endif // EPDRUNNER_H
@@ -0,0 +1,14 @@
+# EPD 測試套件工具：qmake tools/epdrunner/epdrunner.pro
+TARGET = epdrunner
+TEMPLATE = app
+
+include(../tools.pri)
+
+SOURCES += \
+    main.cpp \
+    epdsuite.cpp \
+    epdrunner.cpp
+
+HEADERS += \
+    epdsuite.h \
+    epdrunner.h
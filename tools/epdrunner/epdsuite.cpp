@@ -0,0 +1,102 @@
+#include "epdsuite.h"
+#include "chessboard.h"
+#include "chessengine.h"
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+
+namespace {
+// 把 SAN 列表轉為 UCI；任何一個無法解析就返回 false
+bool sanListToUci(const ChessBoard& board, const QStringList& sanMoves, QStringList& uciMoves)
+{
+    for (const QString& san : sanMoves) {
+        QPoint from;
+        QPoint to;
+        PieceType promotionType;
+        if (!board.findMoveFromSAN(san, from, to, promotionType)) return false;
+        uciMoves.append(ChessEngine::moveToUCI(from, to, promotionType));
+    }
+    return true;
+}
+}
+
+bool EpdPosition::accepts(const QString& uciMove) const
+{
+    if (!bestMoves.isEmpty() && !bestMoves.contains(uciMove)) return false;
+    return !avoidMoves.contains(uciMove);
+}
+
+bool EpdSuite::load(const QString& path)
+{
+    m_positions.clear();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        m_error = QString("Cannot open %1").arg(path);
+        return false;
+    }
+
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        lineNumber++;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        EpdPosition position;
+        if (!parseLine(line, position)) {
+            qWarning().noquote() << QString("[EpdSuite] %1:%2 skipped (no usable bm/am)").arg(path).arg(lineNumber);
+            continue;
+        }
+        if (position.id.isEmpty()) position.id = QString::number(lineNumber);
+        m_positions.append(position);
+    }
+    return true;
+}
+
+bool EpdSuite::parseLine(const QString& line, EpdPosition& position)
+{
+    QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+    if (fields.size() < 4) return false;
+
+    position = EpdPosition();
+    position.fen = fields.mid(0, 4).join(' ') + " 0 1";
+
+    // 操作碼以分號分隔，字串值可以包含空白和分號（以引號包住）
+    QString rest = fields.mid(4).join(' ');
+    QString current;
+    bool inQuotes = false;
+    QStringList operations;
+    for (QChar c : rest) {
+        if (c == '"') inQuotes = !inQuotes;
+        if (c == ';' && !inQuotes) {
+            operations.append(current.trimmed());
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    if (!current.trimmed().isEmpty()) operations.append(current.trimmed());
+
+    for (const QString& operation : operations) {
+        QString opcode = operation.section(' ', 0, 0);
+        QString operand = operation.section(' ', 1).trimmed();
+        if (opcode.isEmpty()) continue;
+
+        if (opcode == "bm") {
+            position.bestMovesSan = operand.split(' ', Qt::SkipEmptyParts);
+        } else if (opcode == "am") {
+            position.avoidMovesSan = operand.split(' ', Qt::SkipEmptyParts);
+        } else if (opcode == "id") {
+            position.id = operand.remove('"');
+        } else {
+            position.opcodes.insert(opcode, operand);
+        }
+    }
+
+    ChessBoard board;
+    if (!board.loadFromFEN(position.fen)) return false;
+    if (!sanListToUci(board, position.bestMovesSan, position.bestMoves)) return false;
+    if (!sanListToUci(board, position.avoidMovesSan, position.avoidMoves)) return false;
+    return !position.bestMoves.isEmpty() || !position.avoidMoves.isEmpty();
+}
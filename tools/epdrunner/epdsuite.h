@@ -0,0 +1,39 @@
+#ifndef EPDSUITE_H
+#define EPDSUITE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+
+// EPD 中的一個局面
+struct EpdPosition {
+    QString id;                     // id 操作碼（沒有時為行號）
+    QString fen;                    // 完整 FEN（補上步數計數）
+    QStringList bestMoves;          // bm（已轉為 UCI）
+    QStringList avoidMoves;         // am（已轉為 UCI）
+    QStringList bestMovesSan;       // 原始 SAN，用於報告
+    QStringList avoidMovesSan;
+    QMap<QString, QString> opcodes; // 其餘操作碼
+
+    // 走法是否符合 bm / am 的要求
+    bool accepts(const QString& uciMove) const;
+};
+
+// EPD 測試套件（例如 WAC、STS）
+class EpdSuite
+{
+public:
+    bool load(const QString& path);
+    const QVector<EpdPosition>& positions() const { return m_positions; }
+    QString errorString() const { return m_error; }
+
+    // 解析一行 EPD；無法解析或沒有 bm / am 時返回 false
+    static bool parseLine(const QString& line, EpdPosition& position);
+
+private:
+    QVector<EpdPosition> m_positions;
+    QString m_error;
+};
+
+#endif // EPDSUITE_H
@@ -0,0 +1,59 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include "epdrunner.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("epdrunner");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Run an EPD test suite (bm/am) through the engine pool.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("suite", "EPD file, e.g. WAC or STS.");
+
+    QCommandLineOption engineOption("engine", "UCI engine executable (default: stockfish in PATH).", "path");
+    QCommandLineOption movetimeOption("movetime", "Time per position (default 1000).", "ms");
+    QCommandLineOption nodesOption("nodes", "Node limit per position instead of time.", "count");
+    QCommandLineOption enginesOption("engines", "Number of engine processes (default: cores / threads).", "count");
+    QCommandLineOption threadsOption("threads", "Threads per engine process (default 1).", "count", "1");
+    QCommandLineOption verboseOption("verbose", "Print the result of every position.");
+    parser.addOptions({engineOption, movetimeOption, nodesOption, enginesOption, threadsOption, verboseOption});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    EpdSuite suite;
+    if (!suite.load(parser.positionalArguments().first())) {
+        qCritical("%s", qPrintable(suite.errorString()));
+        return 1;
+    }
+
+    EpdRunOptions options;
+    options.enginePath = parser.isSet(engineOption) ? parser.value(engineOption)
+                                                    : QStandardPaths::findExecutable("stockfish");
+    options.limits.nodes = parser.value(nodesOption).toLongLong();
+    options.limits.moveTimeMs = parser.value(movetimeOption).toInt();
+    if (options.limits.nodes <= 0 && options.limits.moveTimeMs <= 0) {
+        options.limits.moveTimeMs = 1000;
+    }
+    options.engines = parser.value(enginesOption).toInt();
+    options.threadsPerEngine = parser.value(threadsOption).toInt();
+    options.verbose = parser.isSet(verboseOption);
+
+    if (options.enginePath.isEmpty() || !QFileInfo::exists(options.enginePath)) {
+        qCritical("No engine found; pass --engine <path>");
+        return 1;
+    }
+
+    EpdRunner runner(suite, options);
+    QObject::connect(&runner, &EpdRunner::finished, &app, &QCoreApplication::exit);
+    if (!runner.start()) {
+        return 1;
+    }
+    return app.exec();
+}
@@ -0,0 +1,94 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include "matchrunner.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("matchrunner");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Play an engine-vs-engine match and report Elo and SPRT.");
+    parser.addHelpOption();
+
+    QList<QCommandLineOption> engineOptions;
+    for (int i = 1; i <= 2; ++i) {
+        QString n = QString::number(i);
+        engineOptions << QCommandLineOption("engine" + n, QString("Engine %1 executable.").arg(n), "path")
+                      << QCommandLineOption("name" + n, QString("Engine %1 name in PGN and reports.").arg(n), "name")
+                      << QCommandLineOption("skill" + n, QString("Engine %1 skill level 0-20 (default 20).").arg(n), "level", "20")
+                      << QCommandLineOption("threads" + n, QString("Engine %1 threads (default 1).").arg(n), "count", "1")
+                      << QCommandLineOption("hash" + n, QString("Engine %1 hash in MB (default 16).").arg(n), "mb", "16");
+    }
+    parser.addOptions(engineOptions);
+
+    QCommandLineOption gamesOption("games", "Number of games (default 100).", "count", "100");
+    QCommandLineOption concurrencyOption("concurrency", "Games played at once (default: cores / threads).", "count");
+    QCommandLineOption openingsOption("openings", "FEN or EPD file with one opening per line.", "file");
+    QCommandLineOption pgnOption("pgn", "Append finished games to this PGN file.", "file");
+    QCommandLineOption movetimeOption("movetime", "Fixed time per move.", "ms");
+    QCommandLineOption nodesOption("nodes", "Fixed node budget per move.", "count");
+    QCommandLineOption depthOption("depth", "Fixed depth per move.", "plies");
+    QCommandLineOption tcOption("tc", "Clock as base+increment in seconds, e.g. 10+0.1.", "tc");
+    QCommandLineOption sprtOption("sprt", "Run SPRT and stop when decided: elo0,elo1[,alpha,beta].", "bounds");
+    parser.addOptions({gamesOption, concurrencyOption, openingsOption, pgnOption,
+                       movetimeOption, nodesOption, depthOption, tcOption, sprtOption});
+    parser.process(app);
+
+    MatchOptions options;
+    for (int i = 0; i < 2; ++i) {
+        QString n = QString::number(i + 1);
+        MatchEngineConfig& config = options.engines[i];
+        // 沒有指定引擎 2 時與引擎 1 使用同一個執行檔（比較不同難度或資源設定）
+        config.path = parser.value("engine" + n);
+        if (config.path.isEmpty() && i == 1) config.path = options.engines[0].path;
+        config.skillLevel = qBound(0, parser.value("skill" + n).toInt(), 20);
+        config.threads = qMax(1, parser.value("threads" + n).toInt());
+        config.hashMb = qMax(1, parser.value("hash" + n).toInt());
+        config.name = parser.value("name" + n);
+        if (config.name.isEmpty()) {
+            config.name = QString("%1 (skill %2, %3t, %4MB)").arg(QFileInfo(config.path).baseName())
+                          .arg(config.skillLevel).arg(config.threads).arg(config.hashMb);
+        }
+    }
+    if (options.engines[0].path.isEmpty()) {
+        qCritical("Missing --engine1 <path>");
+        return 1;
+    }
+
+    options.games = qMax(1, parser.value(gamesOption).toInt());
+    options.concurrency = parser.value(concurrencyOption).toInt();
+    options.openingsFile = parser.value(openingsOption);
+    options.pgnPath = parser.value(pgnOption);
+    options.limits.moveTimeMs = parser.value(movetimeOption).toInt();
+    options.limits.nodes = parser.value(nodesOption).toLongLong();
+    options.limits.depth = parser.value(depthOption).toInt();
+
+    if (parser.isSet(tcOption)) {
+        QStringList parts = parser.value(tcOption).split('+');
+        options.baseTimeMs = static_cast<int>(parts.value(0).toDouble() * 1000);
+        options.incrementMs = static_cast<int>(parts.value(1).toDouble() * 1000);
+    }
+    if (options.baseTimeMs <= 0 && options.limits.moveTimeMs <= 0
+        && options.limits.nodes <= 0 && options.limits.depth <= 0) {
+        qCritical("Specify --tc, --movetime, --nodes or --depth");
+        return 1;
+    }
+
+    if (parser.isSet(sprtOption)) {
+        QStringList bounds = parser.value(sprtOption).split(',');
+        options.sprt = true;
+        options.elo0 = bounds.value(0).toDouble();
+        options.elo1 = bounds.value(1, "5").toDouble();
+        options.alpha = bounds.value(2, "0.05").toDouble();
+        options.beta = bounds.value(3, "0.05").toDouble();
+    }
+
+    MatchRunner runner(options);
+    QObject::connect(&runner, &MatchRunner::finished, &app, &QCoreApplication::exit);
+    if (!runner.start()) {
+        return 1;
+    }
+    return app.exec();
+}
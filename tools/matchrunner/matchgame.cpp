@@ -0,0 +1,271 @@
+#include "matchgame.h"
+#include <QDate>
+#include <QDebug>
+
+namespace {
+const int FLAG_MARGIN_MS = 1000;        // 超過剩餘時間多久才強制停止引擎
+const int FIFTY_MOVE_PLIES = 100;
+const int MAX_GAME_PLIES = 600;         // 超過此長度直接判和
+const int WIN_ADJUDICATION_CP = 1000;   // 雙方都認同的懸殊評分
+const int WIN_ADJUDICATION_PLIES = 6;
+const int DRAW_ADJUDICATION_CP = 10;
+const int DRAW_ADJUDICATION_PLIES = 10;
+const int DRAW_ADJUDICATION_MIN_PLY = 80;
+const int PGN_LINE_LENGTH = 80;
+}
+
+MatchGame::MatchGame(const MatchGameSetup& setup, ChessEngine* white, ChessEngine* black, QObject *parent)
+    : QObject(parent)
+    , m_setup(setup)
+    , m_halfmoveClock(0)
+    , m_flagTimer(new QTimer(this))
+    , m_flagged(false)
+    , m_winAdjudicationPlies(0)
+    , m_winSign(0)
+    , m_drawAdjudicationPlies(0)
+    , m_finished(false)
+{
+    m_engines[0] = white;
+    m_engines[1] = black;
+    m_clockMs[0] = setup.baseTimeMs;
+    m_clockMs[1] = setup.baseTimeMs;
+
+    m_flagTimer->setSingleShot(true);
+    connect(m_flagTimer, &QTimer::timeout, this, &MatchGame::onFlagTimeout);
+
+    for (int side = 0; side < 2; ++side) {
+        connect(m_engines[side], &ChessEngine::bestMoveFound, this, [this, side](const QString& move) {
+            onBestMove(side, move);
+        });
+        connect(m_engines[side], &ChessEngine::engineError, this, [this, side](const QString& error) {
+            onEngineError(side, error);
+        });
+    }
+}
+
+void MatchGame::start()
+{
+    m_board.initializeBoard();
+    if (!m_setup.openingFen.isEmpty() && m_board.loadFromFEN(m_setup.openingFen)) {
+        m_startFen = m_setup.openingFen;
+        m_halfmoveClock = m_startFen.section(' ', 4, 4).toInt();
+    }
+    m_repetitions[ChessEngine::boardToFEN(m_board).section(' ', 0, 3)]++;
+
+    for (ChessEngine* engine : m_engines) {
+        engine->newGame();
+    }
+    requestNextMove();
+}
+
+void MatchGame::requestNextMove()
+{
+    int side = sideIndex(m_board.getCurrentPlayer());
+    ChessEngine* engine = m_engines[side];
+
+    SearchLimits limits = m_setup.limits;
+    if (m_setup.baseTimeMs > 0) {
+        limits.whiteTimeMs = qMax(1, m_clockMs[0]);
+        limits.blackTimeMs = qMax(1, m_clockMs[1]);
+        limits.whiteIncrementMs = m_setup.incrementMs;
+        limits.blackIncrementMs = m_setup.incrementMs;
+        m_flagTimer->start(m_clockMs[side] + FLAG_MARGIN_MS);
+    }
+
+    engine->setPositionFromMoves(m_uciMoves, m_startFen);
+    m_moveClock.start();
+    engine->requestSearch(limits);
+}
+
+void MatchGame::onFlagTimeout()
+{
+    // 引擎超過剩餘時間仍未走棋：要求停止，收到 bestmove 後判負
+    m_flagged = true;
+    m_engines[sideIndex(m_board.getCurrentPlayer())]->stop();
+}
+
+void MatchGame::onBestMove(int side, const QString& move)
+{
+    if (m_finished || side != sideIndex(m_board.getCurrentPlayer())) return;
+    m_flagTimer->stop();
+
+    QString loss = side == 0 ? "0-1" : "1-0";
+    if (m_setup.baseTimeMs > 0) {
+        m_clockMs[side] -= static_cast<int>(m_moveClock.elapsed());
+        if (m_flagged || m_clockMs[side] < 0) {
+            endGame(loss, "time forfeit");
+            return;
+        }
+        m_clockMs[side] += m_setup.incrementMs;
+    }
+
+    QPoint from;
+    QPoint to;
+    PieceType promotionType = PieceType::None;
+    ChessEngine::uciToMove(move, from, to, promotionType);
+    auto onBoard = [](const QPoint& square) {
+        return square.x() >= 0 && square.x() < 8 && square.y() >= 0 && square.y() < 8;
+    };
+    if (!onBoard(from) || !onBoard(to)) {
+        qWarning() << "[MatchGame] Invalid move" << move << "from" << (side == 0 ? m_setup.whiteName : m_setup.blackName);
+        endGame(loss, "illegal move");
+        return;
+    }
+
+    bool isPawnMove = m_board.getPiece(from.y(), from.x()).getType() == PieceType::Pawn;
+    bool isCapture = m_board.getPiece(to.y(), to.x()).getType() != PieceType::None;
+    if (!m_board.movePiece(from, to)) {
+        qWarning() << "[MatchGame] Illegal move" << move << "from" << (side == 0 ? m_setup.whiteName : m_setup.blackName);
+        endGame(loss, "illegal move");
+        return;
+    }
+    if (m_board.needsPromotion(to)) {
+        m_board.promotePawn(to, promotionType == PieceType::None ? PieceType::Queen : promotionType);
+    }
+    m_uciMoves.append(move);
+    m_halfmoveClock = (isPawnMove || isCapture) ? 0 : m_halfmoveClock + 1;
+    m_repetitions[ChessEngine::boardToFEN(m_board).section(' ', 0, 3)]++;
+
+    if (!checkGameOver(side)) {
+        requestNextMove();
+    }
+}
+
+void MatchGame::onEngineError(int side, const QString& error)
+{
+    if (m_finished) return;
+
+    // 引擎監控已放棄恢復：該引擎判負
+    qWarning() << "[MatchGame]" << (side == 0 ? m_setup.whiteName : m_setup.blackName) << "failed:" << error;
+    endGame(side == 0 ? "0-1" : "1-0", "abandoned");
+}
+
+bool MatchGame::checkGameOver(int moverSide)
+{
+    QString moverWins = moverSide == 0 ? "1-0" : "0-1";
+    PieceColor toMove = m_board.getCurrentPlayer();
+
+    // 規則判定
+    if (m_board.isCheckmate(toMove)) {
+        endGame(moverWins, "checkmate");
+        return true;
+    }
+    if (m_board.isStalemate(toMove)) {
+        endGame("1/2-1/2", "stalemate");
+        return true;
+    }
+    if (m_board.isInsufficientMaterial()) {
+        endGame("1/2-1/2", "insufficient material");
+        return true;
+    }
+    if (m_halfmoveClock >= FIFTY_MOVE_PLIES) {
+        endGame("1/2-1/2", "fifty-move rule");
+        return true;
+    }
+    if (m_repetitions.value(ChessEngine::boardToFEN(m_board).section(' ', 0, 3)) >= 3) {
+        endGame("1/2-1/2", "threefold repetition");
+        return true;
+    }
+    if (m_uciMoves.size() >= MAX_GAME_PLIES) {
+        endGame("1/2-1/2", "max game length");
+        return true;
+    }
+
+    // 評分判定：雙方引擎連續數步都認同的結果（評分以剛走棋的一方為準，轉為白方觀點）
+    EngineInfo info = m_engines[moverSide]->getLastInfo();
+    if (!info.hasScore) {
+        m_winAdjudicationPlies = 0;
+        m_winSign = 0;
+        m_drawAdjudicationPlies = 0;
+        return false;
+    }
+    int whiteScore = moverSide == 0 ? info.comparableScore() : -info.comparableScore();
+
+    int sign = whiteScore >= WIN_ADJUDICATION_CP ? 1 : (whiteScore <= -WIN_ADJUDICATION_CP ? -1 : 0);
+    if (sign != 0 && sign == m_winSign) {
+        m_winAdjudicationPlies++;
+    } else {
+        m_winAdjudicationPlies = (sign != 0) ? 1 : 0;
+    }
+    m_winSign = sign;
+    if (m_winAdjudicationPlies >= WIN_ADJUDICATION_PLIES) {
+        endGame(sign > 0 ? "1-0" : "0-1", "adjudication");
+        return true;
+    }
+
+    bool drawish = m_uciMoves.size() >= DRAW_ADJUDICATION_MIN_PLY && qAbs(whiteScore) <= DRAW_ADJUDICATION_CP;
+    m_drawAdjudicationPlies = drawish ? m_drawAdjudicationPlies + 1 : 0;
+    if (m_drawAdjudicationPlies >= DRAW_ADJUDICATION_PLIES) {
+        endGame("1/2-1/2", "adjudication");
+        return true;
+    }
+    return false;
+}
+
+void MatchGame::endGame(const QString& result, const QString& termination)
+{
+    if (m_finished) return;
+    m_finished = true;
+    m_flagTimer->stop();
+
+    MatchGameResult gameResult;
+    gameResult.round = m_setup.round;
+    gameResult.result = result;
+    gameResult.termination = termination;
+    gameResult.plies = m_uciMoves.size();
+    gameResult.pgn = generatePGN(result, termination);
+    emit finished(gameResult);
+}
+
+QString MatchGame::generatePGN(const QString& result, const QString& termination) const
+{
+    QString pgn;
+    pgn += "[Event \"Qt_Chess engine match\"]\n";
+    pgn += "[Site \"Qt_Chess\"]\n";
+    pgn += QString("[Date \"%1\"]\n").arg(QDate::currentDate().toString("yyyy.MM.dd"));
+    pgn += QString("[Round \"%1\"]\n").arg(m_setup.round);
+    pgn += QString("[White \"%1\"]\n").arg(m_setup.whiteName);
+    pgn += QString("[Black \"%1\"]\n").arg(m_setup.blackName);
+    pgn += QString("[Result \"%1\"]\n").arg(result);
+    if (!m_startFen.isEmpty()) {
+        pgn += "[SetUp \"1\"]\n";
+        pgn += QString("[FEN \"%1\"]\n").arg(m_startFen);
+    }
+    if (m_setup.baseTimeMs > 0) {
+        pgn += QString("[TimeControl \"%1+%2\"]\n").arg(m_setup.baseTimeMs / 1000.0).arg(m_setup.incrementMs / 1000.0);
+    }
+    pgn += QString("[Termination \"%1\"]\n\n").arg(termination);
+
+    // 起始局面可能輪到黑方，回合數也可能不是 1
+    bool blackStarts = m_startFen.section(' ', 1, 1) == "b";
+    int moveNumber = m_startFen.isEmpty() ? 1 : qMax(1, m_startFen.section(' ', 5, 5).toInt());
+
+    QStringList tokens;
+    const std::vector<MoveRecord>& history = m_board.getMoveHistory();
+    for (size_t i = 0; i < history.size(); ++i) {
+        bool whiteMoved = (i % 2 == 0) != blackStarts;
+        if (whiteMoved) {
+            tokens << QString("%1.").arg(moveNumber);
+        } else if (i == 0) {
+            tokens << QString("%1...").arg(moveNumber);
+        }
+        tokens << history[i].algebraicNotation;
+        if (!whiteMoved) moveNumber++;
+    }
+    tokens << result;
+
+    int lineLength = 0;
+    for (const QString& token : tokens) {
+        if (lineLength > 0 && lineLength + 1 + token.size() > PGN_LINE_LENGTH) {
+            pgn += "\n";
+            lineLength = 0;
+        } else if (lineLength > 0) {
+            pgn += " ";
+            lineLength++;
+        }
+        pgn += token;
+        lineLength += token.size();
+    }
+    pgn += "\n\n";
+    return pgn;
+}
@@ -0,0 +1,75 @@
+#ifndef MATCHGAME_H
+#define MATCHGAME_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QTimer>
+#include "chessboard.h"
+#include "chessengine.h"
+
+// 一盤對局的設定
+struct MatchGameSetup {
+    int round = 1;
+    QString openingFen;             // 空字串表示標準初始局面
+    QString whiteName;
+    QString blackName;
+    SearchLimits limits;            // 固定時間、節點數或深度（每步）
+    int baseTimeMs = 0;             // 大於 0 時使用棋鐘（基本時間 + 每步增量）
+    int incrementMs = 0;
+};
+
+// 對局結果
+struct MatchGameResult {
+    int round = 0;
+    QString result;                 // "1-0"、"0-1" 或 "1/2-1/2"
+    QString termination;
+    QString pgn;
+    int plies = 0;
+};
+
+// 兩個引擎之間的一盤棋：輪流要求走法、檢查合法性並依規則或評分判定結果
+class MatchGame : public QObject
+{
+    Q_OBJECT
+
+public:
+    MatchGame(const MatchGameSetup& setup, ChessEngine* white, ChessEngine* black, QObject *parent = nullptr);
+
+    void start();
+
+signals:
+    void finished(const MatchGameResult& result);
+
+private slots:
+    void onFlagTimeout();
+
+private:
+    MatchGameSetup m_setup;
+    ChessEngine* m_engines[2];      // [0] 白方，[1] 黑方
+    ChessBoard m_board;
+    QString m_startFen;
+    QStringList m_uciMoves;
+    QHash<QString, int> m_repetitions;  // 局面（FEN 前四欄）出現次數
+    int m_halfmoveClock;
+    int m_clockMs[2];
+    QElapsedTimer m_moveClock;
+    QTimer* m_flagTimer;
+    bool m_flagged;
+    int m_winAdjudicationPlies;     // 連續評分懸殊（同一方領先）的半步數
+    int m_winSign;                  // 上一步懸殊評分的方向（1 白方領先，-1 黑方領先）
+    int m_drawAdjudicationPlies;    // 連續評分接近 0 的半步數
+    bool m_finished;
+
+    static int sideIndex(PieceColor color) { return color == PieceColor::White ? 0 : 1; }
+    void requestNextMove();
+    void onBestMove(int side, const QString& move);
+    void onEngineError(int side, const QString& error);
+    bool checkGameOver(int moverSide);
+    void endGame(const QString& result, const QString& termination);
+    QString generatePGN(const QString& result, const QString& termination) const;
+};
+
+#endif // MATCHGAME_H
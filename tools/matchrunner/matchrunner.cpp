@@ -0,0 +1,234 @@
+#include "matchrunner.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QTimer>
+
+MatchRunner::MatchRunner(const MatchOptions& options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_nextRound(1)
+    , m_stopping(false)
+    , m_finished(false)
+{
+}
+
+bool MatchRunner::start()
+{
+    for (const MatchEngineConfig& config : m_options.engines) {
+        if (!QFileInfo::exists(config.path)) {
+            qWarning() << "[MatchRunner] Engine not found:" << config.path;
+            return false;
+        }
+    }
+    if (!loadOpenings()) return false;
+
+    if (!m_options.pgnPath.isEmpty()) {
+        m_pgnFile.setFileName(m_options.pgnPath);
+        if (!m_pgnFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            qWarning() << "[MatchRunner] Cannot write" << m_options.pgnPath;
+            return false;
+        }
+    }
+
+    // 每盤棋同時執行兩個引擎，但只有行棋方在思考
+    int threadsPerGame = qMax(m_options.engines[0].threads, m_options.engines[1].threads);
+    int concurrency = m_options.concurrency > 0
+        ? m_options.concurrency
+        : qMax(1, EngineResourceProfile::detectCoreCount() / threadsPerGame);
+    concurrency = qMin(concurrency, m_options.games);
+
+    m_slots.resize(concurrency);
+    for (Slot& slot : m_slots) {
+        slot.engines[0] = createEngine(m_options.engines[0]);
+        slot.engines[1] = createEngine(m_options.engines[1]);
+    }
+
+    qInfo().noquote() << QString("[MatchRunner] %1 vs %2: %3 games, %4 concurrent, %5 openings")
+                         .arg(m_options.engines[0].name, m_options.engines[1].name)
+                         .arg(m_options.games).arg(concurrency).arg(m_openings.size());
+
+    // 引擎啟動中送出的命令會排隊，可以立即開始對局
+    QTimer::singleShot(0, this, [this]() {
+        for (int i = 0; i < m_slots.size(); ++i) {
+            startNextGame(i);
+        }
+    });
+    return true;
+}
+
+bool MatchRunner::loadOpenings()
+{
+    if (m_options.openingsFile.isEmpty()) return true;
+
+    QFile file(m_options.openingsFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "[MatchRunner] Cannot open openings file" << m_options.openingsFile;
+        return false;
+    }
+
+    // EPD 只有前四個欄位（後面是操作碼），補上步數計數；FEN 則原樣使用
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+        if (fields.size() < 4) continue;
+
+        bool halfmoveOk = false;
+        bool fullmoveOk = false;
+        if (fields.size() >= 6) {
+            fields[4].toInt(&halfmoveOk);
+            fields[5].toInt(&fullmoveOk);
+        }
+        QString fen = (halfmoveOk && fullmoveOk) ? fields.mid(0, 6).join(' ') : fields.mid(0, 4).join(' ') + " 0 1";
+
+        ChessBoard board;
+        if (!board.loadFromFEN(fen)) {
+            qWarning() << "[MatchRunner] Skipping invalid opening:" << line;
+            continue;
+        }
+        m_openings.append(fen);
+    }
+
+    if (m_openings.isEmpty()) {
+        qWarning() << "[MatchRunner] No usable openings in" << m_options.openingsFile;
+        return false;
+    }
+    return true;
+}
+
+ChessEngine* MatchRunner::createEngine(const MatchEngineConfig& config)
+{
+    EngineResourceProfile profile;
+    profile.threads = config.threads;
+    profile.hashMb = config.hashMb;
+
+    ChessEngine* engine = new ChessEngine(this);
+    engine->setDifficulty(config.skillLevel);
+    engine->setResourceProfile(profile);
+    engine->startEngine(config.path);
+    return engine;
+}
+
+void MatchRunner::startNextGame(int slotIndex)
+{
+    Slot& slot = m_slots[slotIndex];
+    if (m_stopping || slot.failed || slot.game) return;
+    if (m_nextRound > m_options.games) {
+        m_stopping = true;
+        return;
+    }
+
+    // 每個開局連續下兩盤並交換顏色，抵銷開局本身的優劣
+    int round = m_nextRound++;
+    slot.engine1White = (round % 2 == 1);
+
+    MatchGameSetup setup;
+    setup.round = round;
+    if (!m_openings.isEmpty()) {
+        setup.openingFen = m_openings[((round - 1) / 2) % m_openings.size()];
+    }
+    setup.limits = m_options.limits;
+    setup.baseTimeMs = m_options.baseTimeMs;
+    setup.incrementMs = m_options.incrementMs;
+
+    int white = slot.engine1White ? 0 : 1;
+    setup.whiteName = m_options.engines[white].name;
+    setup.blackName = m_options.engines[1 - white].name;
+
+    slot.game = new MatchGame(setup, slot.engines[white], slot.engines[1 - white], this);
+    connect(slot.game, &MatchGame::finished, this, [this, slotIndex](const MatchGameResult& result) {
+        onGameFinished(slotIndex, result);
+    });
+    slot.game->start();
+}
+
+void MatchRunner::onGameFinished(int slotIndex, const MatchGameResult& result)
+{
+    Slot& slot = m_slots[slotIndex];
+    slot.game->deleteLater();
+    slot.game = nullptr;
+
+    // 換算為引擎 1 的得分
+    double whiteScore = result.result == "1-0" ? 1.0 : (result.result == "0-1" ? 0.0 : 0.5);
+    m_stats.addResult(slot.engine1White ? whiteScore : 1.0 - whiteScore);
+
+    if (m_pgnFile.isOpen()) {
+        m_pgnFile.write(result.pgn.toUtf8());
+        m_pgnFile.flush();
+    }
+
+    qInfo().noquote() << QString("[MatchRunner] Round %1: %2 (%3, %4 plies)")
+                         .arg(result.round).arg(result.result, result.termination).arg(result.plies);
+    report();
+
+    // 引擎已無法恢復時，這個槽位不再使用
+    if (result.termination == "abandoned") {
+        slot.failed = true;
+        qWarning() << "[MatchRunner] Slot" << slotIndex << "retired after an engine failure";
+    }
+
+    if (m_options.sprt) {
+        double llr = m_stats.llr(m_options.elo0, m_options.elo1);
+        if (llr <= MatchStats::lowerBound(m_options.alpha, m_options.beta)
+            || llr >= MatchStats::upperBound(m_options.alpha, m_options.beta)) {
+            m_stopping = true;
+        }
+    }
+
+    startNextGame(slotIndex);
+    checkFinished();
+}
+
+void MatchRunner::report()
+{
+    QString line = QString("Score of %1 vs %2: %3 - %4 - %5 [%6] %7")
+                   .arg(m_options.engines[0].name, m_options.engines[1].name)
+                   .arg(m_stats.wins()).arg(m_stats.losses()).arg(m_stats.draws())
+                   .arg(m_stats.score(), 0, 'f', 3).arg(m_stats.games());
+    line += QString("\nElo difference: %1 +/- %2")
+            .arg(m_stats.eloDifference(), 0, 'f', 1).arg(m_stats.eloError95(), 0, 'f', 1);
+    if (m_options.sprt) {
+        line += QString("\nSPRT: llr %1 (%2, %3) [%4, %5]")
+                .arg(m_stats.llr(m_options.elo0, m_options.elo1), 0, 'f', 2)
+                .arg(MatchStats::lowerBound(m_options.alpha, m_options.beta), 0, 'f', 2)
+                .arg(MatchStats::upperBound(m_options.alpha, m_options.beta), 0, 'f', 2)
+                .arg(m_options.elo0).arg(m_options.elo1);
+    }
+    qInfo().noquote() << line;
+}
+
+void MatchRunner::checkFinished()
+{
+    if (m_finished) return;
+
+    bool anyRunning = false;
+    bool anyUsable = false;
+    for (const Slot& slot : m_slots) {
+        if (slot.game) anyRunning = true;
+        if (!slot.failed) anyUsable = true;
+    }
+    if (anyRunning) return;
+    if (!m_stopping && anyUsable) return;
+
+    m_finished = true;
+    if (m_options.sprt) {
+        double llr = m_stats.llr(m_options.elo0, m_options.elo1);
+        if (llr >= MatchStats::upperBound(m_options.alpha, m_options.beta)) {
+            qInfo() << "[MatchRunner] SPRT: H1 accepted";
+        } else if (llr <= MatchStats::lowerBound(m_options.alpha, m_options.beta)) {
+            qInfo() << "[MatchRunner] SPRT: H0 accepted";
+        } else {
+            qInfo() << "[MatchRunner] SPRT: inconclusive";
+        }
+    }
+
+    for (Slot& slot : m_slots) {
+        for (ChessEngine* engine : slot.engines) {
+            engine->stopEngine();
+        }
+    }
+    emit finished(anyUsable ? 0 : 1);
+}
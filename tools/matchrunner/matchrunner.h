@@ -0,0 +1,77 @@
+#ifndef MATCHRUNNER_H
+#define MATCHRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QFile>
+#include "chessengine.h"
+#include "matchgame.h"
+#include "matchstats.h"
+
+// 參賽引擎設定
+struct MatchEngineConfig {
+    QString name;
+    QString path;
+    int skillLevel = 20;
+    int threads = 1;
+    int hashMb = 16;
+};
+
+// 對戰設定
+struct MatchOptions {
+    MatchEngineConfig engines[2];
+    QString openingsFile;           // FEN 或 EPD，每行一個開局；每個開局雙方各執白一次
+    QString pgnPath;
+    int games = 100;
+    int concurrency = 0;            // 同時進行的對局數（0 表示依核心數決定）
+    SearchLimits limits;
+    int baseTimeMs = 0;
+    int incrementMs = 0;
+    bool sprt = false;
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+// 對戰執行器：K 個對局槽位各自擁有兩個引擎行程，輪流執行下一盤棋
+class MatchRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MatchRunner(const MatchOptions& options, QObject *parent = nullptr);
+
+    bool start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    struct Slot {
+        ChessEngine* engines[2] = {nullptr, nullptr};   // 依 MatchOptions::engines 的順序
+        MatchGame* game = nullptr;
+        bool engine1White = true;
+        bool failed = false;
+    };
+
+    MatchOptions m_options;
+    QVector<Slot> m_slots;
+    QStringList m_openings;
+    QFile m_pgnFile;
+    MatchStats m_stats;
+    int m_nextRound;
+    bool m_stopping;                // SPRT 已有結論或所有對局已分派，不再開始新對局
+    bool m_finished;
+
+    bool loadOpenings();
+    ChessEngine* createEngine(const MatchEngineConfig& config);
+    void startNextGame(int slotIndex);
+    void onGameFinished(int slotIndex, const MatchGameResult& result);
+    void report();
+    void checkFinished();
+};
+
+#endif // MATCHRUNNER_H
@@ -0,0 +1,16 @@
+# 引擎對戰工具：qmake tools/matchrunner/matchrunner.pro
+TARGET = matchrunner
+TEMPLATE = app
+
+include(../tools.pri)
+
+SOURCES += \
+    main.cpp \
+    matchstats.cpp \
+    matchgame.cpp \
+    matchrunner.cpp
+
+HEADERS += \
+    matchstats.h \
+    matchgame.h \
+    matchrunner.h
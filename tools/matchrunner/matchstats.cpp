@@ -0,0 +1,82 @@
+#include "matchstats.h"
+#include <QtMath>
+
+namespace {
+const double Z_95 = 1.959964;          // 95% 雙尾常態分位數
+const double MIN_SCORE = 1e-6;          // 全勝或全敗時避免 Elo 無限大
+}
+
+MatchStats::MatchStats()
+    : m_wins(0)
+    , m_draws(0)
+    , m_losses(0)
+{
+}
+
+void MatchStats::addResult(double score)
+{
+    if (score > 0.75) {
+        m_wins++;
+    } else if (score < 0.25) {
+        m_losses++;
+    } else {
+        m_draws++;
+    }
+}
+
+double MatchStats::score() const
+{
+    return games() > 0 ? (m_wins + 0.5 * m_draws) / games() : 0.5;
+}
+
+double MatchStats::eloToScore(double elo)
+{
+    return 1.0 / (1.0 + qPow(10.0, -elo / 400.0));
+}
+
+double MatchStats::scoreToElo(double score)
+{
+    score = qBound(MIN_SCORE, score, 1.0 - MIN_SCORE);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+double MatchStats::eloDifference() const
+{
+    return scoreToElo(score());
+}
+
+double MatchStats::variance() const
+{
+    if (games() == 0) return 0.0;
+
+    double s = score();
+    return (m_wins * qPow(1.0 - s, 2) + m_draws * qPow(0.5 - s, 2) + m_losses * qPow(s, 2)) / games();
+}
+
+double MatchStats::eloError95() const
+{
+    if (games() < 2) return 0.0;
+
+    double margin = Z_95 * qSqrt(variance() / games());
+    return (scoreToElo(score() + margin) - scoreToElo(score() - margin)) / 2.0;
+}
+
+double MatchStats::llr(double elo0, double elo1) const
+{
+    double var = variance();
+    if (games() == 0 || var <= 0.0) return 0.0;
+
+    double s0 = eloToScore(elo0);
+    double s1 = eloToScore(elo1);
+    return (s1 - s0) * (2.0 * score() - s0 - s1) * games() / (2.0 * var);
+}
+
+double MatchStats::lowerBound(double alpha, double beta)
+{
+    return qLn(beta / (1.0 - alpha));
+}
+
+double MatchStats::upperBound(double alpha, double beta)
+{
+    return qLn((1.0 - beta) / alpha);
+}
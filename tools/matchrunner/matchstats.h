@@ -0,0 +1,38 @@
+#ifndef MATCHSTATS_H
+#define MATCHSTATS_H
+
+#include <QString>
+
+// 對戰統計（以引擎 1 的觀點）：Elo 差距、95% 信賴區間和 SPRT 對數概似比
+class MatchStats
+{
+public:
+    MatchStats();
+
+    void addResult(double score);   // 1 勝、0.5 和、0 負
+    int games() const { return m_wins + m_draws + m_losses; }
+    int wins() const { return m_wins; }
+    int draws() const { return m_draws; }
+    int losses() const { return m_losses; }
+
+    double score() const;           // 平均得分（0-1）
+    double eloDifference() const;
+    double eloError95() const;      // 95% 信賴區間的半寬
+
+    // 三項分布的 GSPRT 近似：H0 為 elo0，H1 為 elo1
+    double llr(double elo0, double elo1) const;
+    static double lowerBound(double alpha, double beta);    // LLR 低於此值接受 H0
+    static double upperBound(double alpha, double beta);    // LLR 高於此值接受 H1
+
+    static double eloToScore(double elo);
+    static double scoreToElo(double score);
+
+private:
+    int m_wins;
+    int m_draws;
+    int m_losses;
+
+    double variance() const;        // 每盤得分的變異數
+};
+
+#endif // MATCHSTATS_H
@@ -0,0 +1,215 @@
+#include "loadgame.h"
+#include "networkmanager.h"
+#include "randommove.h"
+#include <QTimer>
+#include <QDebug>
+
+LoadGame::LoadGame(const LoadGameSetup& setup, QObject *parent)
+    : QObject(parent)
+    , m_setup(setup)
+    , m_random(setup.seed)
+    , m_moveTimer(new QTimer(this))
+    , m_stallTimer(new QTimer(this))
+    , m_moverSide(-1)
+    , m_sentAtNs(0)
+    , m_pendingDeliveries(0)
+    , m_finished(false)
+{
+    m_result.index = setup.index;
+    m_moveTimer->setSingleShot(true);
+    m_stallTimer->setSingleShot(true);
+    connect(m_moveTimer, &QTimer::timeout, this, &LoadGame::playMove);
+    connect(m_stallTimer, &QTimer::timeout, this, [this]() {
+        fail("timeout", QString("no progress for %1 ms").arg(m_setup.timeoutMs));
+    });
+}
+
+void LoadGame::start()
+{
+    // NetworkManager 在這個物件的執行緒上建立，公開函式直接在同一個執行緒執行
+    m_clock.start();
+    for (int i = 0; i < 2; ++i) {
+        m_sides[i].network = new NetworkManager(this);
+        m_sides[i].network->setServerUrl(m_setup.serverUrl);
+        connectSide(i);
+    }
+    progress();
+    m_sides[0].network->createRoom();
+}
+
+void LoadGame::connectSide(int side)
+{
+    NetworkManager* network = m_sides[side].network;
+
+    if (side == 0) {
+        connect(network, &NetworkManager::roomCreated, this, [this](const QString& roomNumber) {
+            progress();
+            m_sides[1].network->joinRoom(roomNumber);
+        });
+        connect(network, &NetworkManager::opponentJoined, this, [this]() {
+            progress();
+            PieceColor hostColor = m_setup.hostWhite ? PieceColor::White : PieceColor::Black;
+            m_sides[0].network->sendStartGame(m_setup.baseTimeMs, m_setup.baseTimeMs, m_setup.incrementMs, hostColor);
+        });
+    }
+
+    connect(network, &NetworkManager::startGameReceived, this, [this, side]() {
+        onStartGameReceived(side);
+    });
+    connect(network, &NetworkManager::opponentMove, this,
+            [this, side](const QPoint& from, const QPoint& to, PieceType promotionType) {
+        onMoveReceived(side, from, to, promotionType);
+    });
+    connect(network, &NetworkManager::moveRejected, this, [this](const QPoint&, const QPoint&, const QString& reason) {
+        fail("error", QString("move rejected: %1").arg(reason));
+    });
+    connect(network, &NetworkManager::connectionError, this, [this](const QString& error) {
+        fail("error", error);
+    });
+    connect(network, &NetworkManager::playerLeft, this, [this]() {
+        fail("error", "opponent left the room");
+    });
+    connect(network, &NetworkManager::surrenderReceived, this, [this]() {
+        if (m_surrenderTermination.isEmpty()) {
+            fail("error", "unexpected surrender");
+        } else {
+            endGame(m_surrenderTermination);
+        }
+    });
+    connect(network, &NetworkManager::reconnecting, this, [this]() {
+        m_result.reconnects++;
+    });
+}
+
+void LoadGame::onStartGameReceived(int side)
+{
+    progress();
+    m_sides[side].started = true;
+    m_sides[side].game.reset();
+    if (m_sides[0].started && m_sides[1].started) {
+        scheduleNextMove();
+    }
+}
+
+void LoadGame::onMoveReceived(int side, const QPoint& from, const QPoint& to, PieceType promotionType)
+{
+    if (m_finished) return;
+    if (m_moverSide < 0) {
+        fail("desync", "received a move that was not sent", true);
+        return;
+    }
+    progress();
+
+    // 雙方都只套用伺服器轉送的走法（走棋方收到的是回傳），不合法表示局面已經不同步
+    QString error;
+    if (!m_sides[side].game.applyMove(from, to, promotionType, error)) {
+        fail("desync", QString("relayed move is illegal locally: %1").arg(error), true);
+        return;
+    }
+    if (side != m_moverSide) {
+        m_result.latenciesUs.append((m_clock.nsecsElapsed() - m_sentAtNs) / 1000);
+    }
+    if (--m_pendingDeliveries > 0) return;
+
+    m_moverSide = -1;
+    m_result.plies = m_sides[0].game.plyCount();
+    if (m_sides[0].game.positionKey() != m_sides[1].game.positionKey()) {
+        fail("desync", QString("positions differ after ply %1").arg(m_result.plies), true);
+        return;
+    }
+    if (m_sides[0].game.isFinished()) {
+        endGame(m_sides[0].game.reason());
+        return;
+    }
+    scheduleNextMove();
+}
+
+void LoadGame::scheduleNextMove()
+{
+    // 間隔在平均值的 0.5 到 1.5 倍之間，避免所有對局同時走棋
+    int delayMs = static_cast<int>(m_setup.moveIntervalMs * (0.5 + m_random.generateDouble()));
+    m_moveTimer->start(delayMs);
+}
+
+void LoadGame::playMove()
+{
+    if (m_finished) return;
+
+    int mover = sideToMove();
+    const ServerGame& game = m_sides[mover].game;
+    int ply = game.plyCount();
+
+    // 到達步數上限或劇本結束時由行棋方投降，對手收到投降訊息才算結束
+    QString surrenderTermination;
+    if (ply >= m_setup.maxPlies) {
+        surrenderTermination = "max plies";
+    } else if (!m_setup.script.isEmpty() && ply >= m_setup.script.size()) {
+        surrenderTermination = "script end";
+    }
+    if (!surrenderTermination.isEmpty()) {
+        m_surrenderTermination = surrenderTermination;
+        m_sides[mover].network->sendSurrender();
+        return;
+    }
+
+    QPoint from;
+    QPoint to;
+    PieceType promotionType = PieceType::None;
+    if (!m_setup.script.isEmpty()) {
+        if (!game.board().findMoveFromSAN(m_setup.script.at(ply), from, to, promotionType)) {
+            fail("error", QString("script move %1 (%2) is not legal").arg(ply + 1).arg(m_setup.script.at(ply)));
+            return;
+        }
+    } else if (!chooseRandomMove(game.board(), m_random, from, to, promotionType)) {
+        fail("error", "no legal move in an unfinished game");
+        return;
+    }
+
+    m_moverSide = mover;
+    m_pendingDeliveries = 2;
+    m_sentAtNs = m_clock.nsecsElapsed();
+    m_sides[mover].network->sendMove(from, to, promotionType);
+}
+
+int LoadGame::sideToMove() const
+{
+    bool whiteToMove = m_sides[0].game.sideToMove() == PieceColor::White;
+    return (whiteToMove == m_setup.hostWhite) ? 0 : 1;
+}
+
+void LoadGame::progress()
+{
+    m_stallTimer->start(m_setup.timeoutMs);
+}
+
+void LoadGame::fail(const QString& termination, const QString& error, bool desync)
+{
+    if (m_finished) return;
+
+    if (desync) {
+        m_result.desyncs++;
+    } else {
+        m_result.errors++;
+    }
+    m_result.error = error;
+    endGame(termination);
+}
+
+void LoadGame::endGame(const QString& termination)
+{
+    if (m_finished) return;
+    m_finished = true;
+
+    m_moveTimer->stop();
+    m_stallTimer->stop();
+    m_result.termination = termination;
+    m_result.plies = m_sides[0].game.plyCount();
+
+    // 明確離開房間，伺服器不會為已結束的測試保留座位
+    for (Side& side : m_sides) {
+        if (!side.network) continue;
+        side.network->disconnect(this);
+        side.network->leaveRoom();
+    }
+    emit finished(m_result);
+}
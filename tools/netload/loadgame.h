@@ -0,0 +1,90 @@
+#ifndef LOADGAME_H
+#define LOADGAME_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QPoint>
+#include "servergame.h"
+
+class NetworkManager;
+class QTimer;
+
+// 一盤壓力測試對局的設定
+struct LoadGameSetup {
+    int index = 0;
+    QString serverUrl;
+    quint32 seed = 1;               // 隨機走法與思考時間的種子（同一個種子得到同一盤棋）
+    bool hostWhite = true;
+    QStringList script;             // 以 SAN 表示的走法；空白時每步隨機選擇合法走法
+    int moveIntervalMs = 1000;      // 平均每步的間隔
+    int maxPlies = 80;              // 到達上限時由行棋方投降結束對局
+    int baseTimeMs = 600000;
+    int incrementMs = 0;
+    int timeoutMs = 10000;          // 這段時間內沒有任何進展視為失敗
+};
+
+// 對局結果與量測值
+struct LoadGameResult {
+    int index = 0;
+    QString termination;            // checkmate、stalemate、max plies、timeout、error、desync 等
+    QString error;                  // 第一個錯誤的說明
+    int plies = 0;
+    int errors = 0;                 // 連線錯誤、被拒絕的走法與逾時
+    int desyncs = 0;                // 收到的走法在本地局面不合法，或雙方局面不一致
+    int reconnects = 0;
+    QVector<qint64> latenciesUs;    // 每步從送出到對手收到的時間（微秒）
+};
+
+// 一對虛擬玩家（房主與房客各一個 NetworkManager）：建立並加入房間、開始對局，
+// 依設定的速度輪流走棋；雙方各自以 ServerGame 套用伺服器轉送的走法並互相比對局面
+// 物件與兩個 NetworkManager 位於同一個執行緒，可以直接比較兩邊的時間
+class LoadGame : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoadGame(const LoadGameSetup& setup, QObject *parent = nullptr);
+
+    void start();
+
+signals:
+    void finished(const LoadGameResult& result);
+
+private:
+    struct Side {
+        NetworkManager* network = nullptr;
+        ServerGame game;
+        bool started = false;
+    };
+
+    LoadGameSetup m_setup;
+    LoadGameResult m_result;
+    Side m_sides[2];                // [0] 房主，[1] 房客
+    QRandomGenerator m_random;
+    QElapsedTimer m_clock;
+    QTimer* m_moveTimer;
+    QTimer* m_stallTimer;
+    int m_moverSide;                // 正在等待轉送的走法是哪一方送出的，-1 表示沒有
+    qint64 m_sentAtNs;
+    int m_pendingDeliveries;        // 這步棋還有幾方沒有收到（轉送給對手加上回傳給走棋方）
+    QString m_surrenderTermination; // 已送出投降，對手收到後以此結束；空白表示沒有
+    bool m_finished;
+
+    void connectSide(int side);
+    void onStartGameReceived(int side);
+    void onMoveReceived(int side, const QPoint& from, const QPoint& to, PieceType promotionType);
+    void scheduleNextMove();
+    void playMove();
+    int sideToMove() const;
+    void progress();
+    void fail(const QString& termination, const QString& error, bool desync = false);
+    void endGame(const QString& termination);
+};
+
+Q_DECLARE_METATYPE(LoadGameResult)
+
+#endif // LOADGAME_H
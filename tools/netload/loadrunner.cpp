@@ -0,0 +1,305 @@
+#include "loadrunner.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+LoadRunner::LoadRunner(const LoadOptions& options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_server("[LoadRunner]")
+    , m_reportTimer(new QTimer(this))
+    , m_gamesStarted(0)
+    , m_finished(false)
+    , m_gamesFinished(0)
+    , m_moves(0)
+    , m_movesAtLastReport(0)
+    , m_errors(0)
+    , m_desyncs(0)
+    , m_reconnects(0)
+    , m_erroredGames(0)
+    , m_desyncedGames(0)
+    , m_serverCpuStartMs(-1)
+    , m_serverCpuLastMs(-1)
+    , m_selfCpuStartMs(-1)
+{
+    // 對局結果從虛擬玩家的執行緒以佇列連線送回
+    qRegisterMetaType<LoadGameResult>("LoadGameResult");
+    connect(m_reportTimer, &QTimer::timeout, this, &LoadRunner::reportProgress);
+}
+
+LoadRunner::~LoadRunner()
+{
+    for (QThread* thread : m_threads) {
+        thread->quit();
+    }
+    for (QThread* thread : m_threads) {
+        thread->wait();
+    }
+}
+
+bool LoadRunner::start()
+{
+    if (!loadScripts()) return false;
+
+    if (m_options.games <= 0) m_options.games = m_options.pairs;
+    m_options.pairs = qBound(1, m_options.pairs, m_options.games);
+    int threads = m_options.threads > 0 ? m_options.threads : QThread::idealThreadCount();
+    threads = qBound(1, threads, m_options.pairs);
+
+    if (!m_options.spawnCommand.isEmpty()) {
+        if (!m_server.start(m_options.spawnCommand, m_options.serverUrl)) return false;
+        m_options.serverPid = m_server.process()->processId();
+        connect(m_server.process(), QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this](int exitCode) {
+            if (!m_finished) {
+                qWarning() << "[LoadRunner] Server exited during the run with code" << exitCode;
+            }
+        });
+    }
+
+    // 虛擬玩家平均分配到各執行緒；同一對玩家在同一個執行緒，延遲量測不需要跨執行緒的時鐘
+    for (int i = 0; i < threads; ++i) {
+        QThread* thread = new QThread(this);
+        thread->start();
+        m_threads.append(thread);
+    }
+    m_slots.fill(nullptr, m_options.pairs);
+
+    qInfo().noquote() << QString("[LoadRunner] %1: %2 games, %3 concurrent (%4 connections), %5 threads, %6 moves/s per game%7")
+                         .arg(m_options.serverUrl).arg(m_options.games).arg(m_options.pairs)
+                         .arg(m_options.pairs * 2).arg(threads).arg(m_options.movesPerSecond)
+                         .arg(m_scripts.isEmpty() ? QString(", random moves")
+                                                  : QString(", %1 scripted games").arg(m_scripts.size()));
+
+    QTimer::singleShot(m_server.isStarted() ? ServerProcess::STARTUP_MS : 0, this, &LoadRunner::beginLoad);
+    return true;
+}
+
+bool LoadRunner::loadScripts()
+{
+    if (m_options.scriptFile.isEmpty()) return true;
+
+    QFile file(m_options.scriptFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "[LoadRunner] Cannot open script file" << m_options.scriptFile;
+        return false;
+    }
+
+    // 每行一盤棋的 SAN 走法，可以包含步數編號（1. e4 或 1.e4）與結果
+    static const QRegularExpression moveNumber("^\\d+\\.+");
+    static const QRegularExpression result("^(1-0|0-1|1/2-1/2|\\*)$");
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList moves;
+        for (QString token : line.split(' ', Qt::SkipEmptyParts)) {
+            token.remove(moveNumber);
+            if (token.isEmpty() || result.match(token).hasMatch()) continue;
+            moves.append(token);
+        }
+        if (!moves.isEmpty()) m_scripts.append(moves);
+    }
+
+    if (m_scripts.isEmpty()) {
+        qWarning() << "[LoadRunner] No games in script file" << m_options.scriptFile;
+        return false;
+    }
+    return true;
+}
+
+void LoadRunner::beginLoad()
+{
+    m_serverCpuStartMs = processCpuMs(m_options.serverPid);
+    m_serverCpuLastMs = m_serverCpuStartMs;
+    m_selfCpuStartMs = processCpuMs(QCoreApplication::applicationPid());
+    m_wallClock.start();
+    m_intervalClock.start();
+    if (m_options.reportIntervalSec > 0) {
+        m_reportTimer->start(m_options.reportIntervalSec * 1000);
+    }
+
+    for (int i = 0; i < m_slots.size(); ++i) {
+        QTimer::singleShot(i * m_options.rampMs, this, [this, i]() { startNextGame(i); });
+    }
+}
+
+void LoadRunner::startNextGame(int slotIndex)
+{
+    if (m_finished || m_gamesStarted >= m_options.games) {
+        checkFinished();
+        return;
+    }
+
+    // 每盤棋的種子只由 --seed 與對局編號決定，同樣的參數重跑得到同樣的走法
+    LoadGameSetup setup;
+    setup.index = m_gamesStarted++;
+    setup.serverUrl = m_options.serverUrl;
+    setup.seed = m_options.seed * 1000003u + static_cast<quint32>(setup.index);
+    setup.hostWhite = (setup.index % 2 == 0);
+    if (!m_scripts.isEmpty()) {
+        setup.script = m_scripts.at(setup.index % m_scripts.size());
+    }
+    setup.moveIntervalMs = qMax(1, qRound(1000.0 / m_options.movesPerSecond));
+    setup.maxPlies = m_options.maxPlies;
+    setup.baseTimeMs = m_options.baseTimeMs;
+    setup.incrementMs = m_options.incrementMs;
+    setup.timeoutMs = m_options.timeoutMs;
+
+    LoadGame* game = new LoadGame(setup);
+    game->moveToThread(m_threads.at(slotIndex % m_threads.size()));
+    connect(game, &LoadGame::finished, this, [this, slotIndex](const LoadGameResult& result) {
+        onGameFinished(slotIndex, result);
+    });
+    m_slots[slotIndex] = game;
+    QMetaObject::invokeMethod(game, [game]() { game->start(); }, Qt::QueuedConnection);
+}
+
+void LoadRunner::onGameFinished(int slotIndex, const LoadGameResult& result)
+{
+    LoadGame* game = m_slots.at(slotIndex);
+    m_slots[slotIndex] = nullptr;
+    if (game) game->deleteLater();
+
+    m_gamesFinished++;
+    m_moves += result.plies;
+    m_latenciesUs += result.latenciesUs;
+    m_errors += result.errors;
+    m_desyncs += result.desyncs;
+    m_reconnects += result.reconnects;
+    if (result.errors > 0) m_erroredGames++;
+    if (result.desyncs > 0) m_desyncedGames++;
+
+    if (!result.error.isEmpty()) {
+        m_lastError = result.error;
+        if (result.desyncs > 0) {
+            qWarning().noquote() << QString("[LoadRunner] Game %1 desynced after %2 plies: %3")
+                                    .arg(result.index).arg(result.plies).arg(result.error);
+        }
+    }
+
+    startNextGame(slotIndex);
+}
+
+void LoadRunner::reportProgress()
+{
+    double seconds = qMax<qint64>(1, m_intervalClock.restart()) / 1000.0;
+    int running = static_cast<int>(std::count_if(m_slots.cbegin(), m_slots.cend(), [](LoadGame* game) {
+        return game != nullptr;
+    }));
+
+    // CPU 使用率以單一核心為 100%
+    QString serverCpu = "n/a";
+    qint64 serverCpuMs = processCpuMs(m_options.serverPid);
+    if (serverCpuMs >= 0 && m_serverCpuLastMs >= 0) {
+        serverCpu = QString("%1%").arg((serverCpuMs - m_serverCpuLastMs) / 10.0 / seconds, 0, 'f', 0);
+    }
+    m_serverCpuLastMs = serverCpuMs;
+
+    // 步數在對局結束時才計入
+    qInfo().noquote() << QString("[LoadRunner] %1 s: %2 running, %3/%4 games done, %5 moves/s, server CPU %6, errors %7, desyncs %8")
+                         .arg(m_wallClock.elapsed() / 1000).arg(running)
+                         .arg(m_gamesFinished).arg(m_options.games)
+                         .arg((m_moves - m_movesAtLastReport) / seconds, 0, 'f', 0)
+                         .arg(serverCpu).arg(m_errors).arg(m_desyncs);
+    m_movesAtLastReport = m_moves;
+}
+
+void LoadRunner::reportSummary()
+{
+    double seconds = qMax<qint64>(1, m_wallClock.elapsed()) / 1000.0;
+    std::sort(m_latenciesUs.begin(), m_latenciesUs.end());
+    auto ms = [](qint64 us) { return QString::number(us / 1000.0, 'f', 2); };
+
+    QString line = QString("[LoadRunner] Done: %1 games, %2 moves in %3 s (%4 moves/s)")
+                   .arg(m_gamesFinished).arg(m_moves).arg(seconds, 0, 'f', 1).arg(m_moves / seconds, 0, 'f', 0);
+    if (!m_latenciesUs.isEmpty()) {
+        line += QString("\nRelay latency (ms): p50 %1 | p95 %2 | p99 %3 | max %4 (%5 samples)")
+                .arg(ms(percentile(m_latenciesUs, 0.50)), ms(percentile(m_latenciesUs, 0.95)),
+                     ms(percentile(m_latenciesUs, 0.99)), ms(m_latenciesUs.last()))
+                .arg(m_latenciesUs.size());
+    }
+
+    double games = qMax(1, m_gamesFinished);
+    line += QString("\nErrors: %1 in %2 games (%3%) | desyncs: %4 in %5 games (%6%) | reconnects: %7")
+            .arg(m_errors).arg(m_erroredGames).arg(100.0 * m_erroredGames / games, 0, 'f', 2)
+            .arg(m_desyncs).arg(m_desyncedGames).arg(100.0 * m_desyncedGames / games, 0, 'f', 2)
+            .arg(m_reconnects);
+    if (!m_lastError.isEmpty()) {
+        line += QString("\nLast error: %1").arg(m_lastError);
+    }
+
+    // netload 自己的 CPU 接近核心數時，量測到的延遲包含客戶端的排隊時間
+    qint64 serverCpuMs = processCpuMs(m_options.serverPid);
+    qint64 selfCpuMs = processCpuMs(QCoreApplication::applicationPid());
+    QString serverCpu = (serverCpuMs >= 0 && m_serverCpuStartMs >= 0)
+        ? QString("%1%").arg((serverCpuMs - m_serverCpuStartMs) / 10.0 / seconds, 0, 'f', 1) : QString("n/a");
+    QString selfCpu = (selfCpuMs >= 0 && m_selfCpuStartMs >= 0)
+        ? QString("%1%").arg((selfCpuMs - m_selfCpuStartMs) / 10.0 / seconds, 0, 'f', 1) : QString("n/a");
+    line += QString("\nCPU (100% = one core): server %1 | netload %2").arg(serverCpu, selfCpu);
+
+    qInfo().noquote() << line;
+}
+
+void LoadRunner::checkFinished()
+{
+    if (m_finished || m_gamesStarted < m_options.games) return;
+    for (LoadGame* game : m_slots) {
+        if (game) return;
+    }
+
+    m_finished = true;
+    m_reportTimer->stop();
+    reportSummary();
+    m_server.stop();
+    double erroredPercent = 100.0 * m_erroredGames / qMax(1, m_gamesFinished);
+    bool passed = m_desyncs == 0 && (m_erroredGames == 0 || erroredPercent <= m_options.maxErrorPercent);
+    if (!passed) {
+        qWarning().noquote() << QString("[LoadRunner] FAILED: %1 desyncs, %2% of games with errors (allowed %3%)")
+                                .arg(m_desyncs).arg(erroredPercent, 0, 'f', 2).arg(m_options.maxErrorPercent);
+    }
+    emit finished(passed ? 0 : 1);
+}
+
+qint64 LoadRunner::percentile(QVector<qint64>& sorted, double fraction)
+{
+    // 最近序位法（nearest rank）
+    if (sorted.isEmpty()) return 0;
+    int rank = qBound(1, static_cast<int>(std::ceil(fraction * sorted.size())), sorted.size());
+    return sorted.at(rank - 1);
+}
+
+qint64 LoadRunner::processCpuMs(qint64 pid)
+{
+#ifdef Q_OS_LINUX
+    if (pid <= 0) return -1;
+
+    QFile file(QString("/proc/%1/stat").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) return -1;
+
+    // 行程名稱可能包含空白，從最後一個 ')' 之後開始計算欄位：utime 與 stime 是第 14、15 欄
+    QByteArray stat = file.readAll();
+    int nameEnd = stat.lastIndexOf(')');
+    if (nameEnd < 0) return -1;
+    QList<QByteArray> fields = stat.mid(nameEnd + 2).split(' ');
+    if (fields.size() < 13) return -1;
+
+    qint64 ticks = fields.at(11).toLongLong() + fields.at(12).toLongLong();
+    long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    return ticksPerSecond > 0 ? ticks * 1000 / ticksPerSecond : -1;
+#else
+    Q_UNUSED(pid);
+    return -1;
+#endif
+}
@@ -0,0 +1,88 @@
+#ifndef LOADRUNNER_H
+#define LOADRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QElapsedTimer>
+#include "loadgame.h"
+#include "serverprocess.h"
+
+class QThread;
+class QTimer;
+
+// 壓力測試設定
+struct LoadOptions {
+    QString serverUrl = "ws://127.0.0.1:3000";
+    QString spawnCommand;           // 非空時先啟動伺服器（例如 "node server.js"），以 PORT 環境變數指定埠
+    qint64 serverPid = 0;           // 量測 CPU 的伺服器行程；使用 spawnCommand 時自動設定
+    int pairs = 100;                // 同時進行的對局數（每局兩個連線）
+    int games = 0;                  // 總對局數（0 表示與 pairs 相同）
+    int threads = 0;                // 虛擬玩家使用的執行緒數（0 表示依核心數決定）
+    double movesPerSecond = 1.0;    // 每盤棋每秒的平均步數
+    int maxPlies = 80;
+    int baseTimeMs = 600000;
+    int incrementMs = 0;
+    int timeoutMs = 10000;
+    int rampMs = 5;                 // 相鄰兩個對局開始的間隔，避免同時建立所有連線
+    quint32 seed = 1;
+    QString scriptFile;             // 每行一盤棋的 SAN 走法；空白時隨機走棋
+    int reportIntervalSec = 5;
+    double maxErrorPercent = 0.0;   // 出錯對局的比例超過此值（百分比）時結束代碼為 1；不同步一律失敗
+};
+
+// 壓力測試執行器：pairs 個槽位各自執行一對虛擬玩家（LoadGame），對局結束後開始下一盤，
+// 彙整轉送延遲的百分位數、錯誤與不同步的比例，以及伺服器行程的 CPU 使用率
+class LoadRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoadRunner(const LoadOptions& options, QObject *parent = nullptr);
+    ~LoadRunner();
+
+    bool start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    LoadOptions m_options;
+    QVector<QStringList> m_scripts;
+    QVector<QThread*> m_threads;
+    QVector<LoadGame*> m_slots;
+    ServerProcess m_server;
+    QTimer* m_reportTimer;
+    QElapsedTimer m_wallClock;
+    QElapsedTimer m_intervalClock;
+    int m_gamesStarted;
+    bool m_finished;
+
+    // 累計的量測值
+    QVector<qint64> m_latenciesUs;
+    int m_gamesFinished;
+    qint64 m_moves;
+    qint64 m_movesAtLastReport;
+    int m_errors;
+    int m_desyncs;
+    int m_reconnects;
+    int m_erroredGames;
+    int m_desyncedGames;
+    QString m_lastError;
+    qint64 m_serverCpuStartMs;
+    qint64 m_serverCpuLastMs;
+    qint64 m_selfCpuStartMs;
+
+    bool loadScripts();
+    void beginLoad();
+    void startNextGame(int slotIndex);
+    void onGameFinished(int slotIndex, const LoadGameResult& result);
+    void reportProgress();
+    void reportSummary();
+    void checkFinished();
+    static qint64 percentile(QVector<qint64>& sorted, double fraction);
+    static qint64 processCpuMs(qint64 pid);     // 行程累計使用的 CPU 時間，無法取得時返回 -1
+};
+
+#endif // LOADRUNNER_H
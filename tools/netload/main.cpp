@@ -0,0 +1,75 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "loadrunner.h"
+#include "quietlog.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("netload");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Load-test a relay server (server.js or chess_server) with virtual online games.");
+    parser.addHelpOption();
+
+    QCommandLineOption urlOption("url", "Server URL (default: ws://127.0.0.1:3000).", "url", "ws://127.0.0.1:3000");
+    QCommandLineOption spawnOption("spawn", "Start the server with this command, e.g. \"node server.js\".", "command");
+    QCommandLineOption pidOption("server-pid", "Measure CPU of this server process.", "pid");
+    QCommandLineOption pairsOption("pairs", "Concurrent games, two connections each (default 100).", "count", "100");
+    QCommandLineOption gamesOption("games", "Total games (default: same as --pairs).", "count", "0");
+    QCommandLineOption threadsOption("threads", "Client threads (default: one per core).", "count", "0");
+    QCommandLineOption rateOption("rate", "Average moves per second in each game (default 1).", "moves", "1");
+    QCommandLineOption pliesOption("max-plies", "Resign after this many plies (default 80).", "plies", "80");
+    QCommandLineOption tcOption("tc", "Clock as base+increment in seconds (default 600+0).", "tc", "600+0");
+    QCommandLineOption timeoutOption("timeout", "Fail a game after this long without progress (default 10000).", "ms", "10000");
+    QCommandLineOption rampOption("ramp", "Delay between starting games (default 5).", "ms", "5");
+    QCommandLineOption seedOption("seed", "Seed for random moves and think times (default 1).", "seed", "1");
+    QCommandLineOption scriptOption("script", "Play the SAN games in this file (one per line) instead of random moves.", "file");
+    QCommandLineOption reportOption("report", "Print progress every N seconds (0 = off, default 5).", "seconds", "5");
+    QCommandLineOption maxErrorsOption("max-error-rate", "Fail when more than this percent of games have errors (default 0).", "percent", "0");
+    QCommandLineOption verboseOption("verbose", "Show NetworkManager debug output.");
+    parser.addOptions({urlOption, spawnOption, pidOption, pairsOption, gamesOption, threadsOption, rateOption,
+                       pliesOption, tcOption, timeoutOption, rampOption, seedOption, scriptOption, reportOption,
+                       maxErrorsOption, verboseOption});
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        installQuietMessageHandler();
+    }
+
+    LoadOptions options;
+    options.serverUrl = parser.value(urlOption);
+    options.spawnCommand = parser.value(spawnOption);
+    options.serverPid = parser.value(pidOption).toLongLong();
+    options.pairs = qMax(1, parser.value(pairsOption).toInt());
+    options.games = parser.value(gamesOption).toInt();
+    options.threads = parser.value(threadsOption).toInt();
+    options.movesPerSecond = parser.value(rateOption).toDouble();
+    options.maxPlies = qMax(1, parser.value(pliesOption).toInt());
+    options.timeoutMs = qMax(100, parser.value(timeoutOption).toInt());
+    options.rampMs = qMax(0, parser.value(rampOption).toInt());
+    options.seed = parser.value(seedOption).toUInt();
+    options.scriptFile = parser.value(scriptOption);
+    options.reportIntervalSec = qMax(0, parser.value(reportOption).toInt());
+    options.maxErrorPercent = qMax(0.0, parser.value(maxErrorsOption).toDouble());
+
+    QStringList tc = parser.value(tcOption).split('+');
+    options.baseTimeMs = static_cast<int>(tc.value(0).toDouble() * 1000);
+    options.incrementMs = static_cast<int>(tc.value(1).toDouble() * 1000);
+
+    if (options.movesPerSecond <= 0.0) {
+        qCritical("Invalid --rate: %s", qPrintable(parser.value(rateOption)));
+        return 1;
+    }
+    if (options.baseTimeMs <= 0) {
+        qCritical("Invalid --tc: %s", qPrintable(parser.value(tcOption)));
+        return 1;
+    }
+
+    LoadRunner runner(options);
+    QObject::connect(&runner, &LoadRunner::finished, &app, &QCoreApplication::exit);
+    if (!runner.start()) {
+        return 1;
+    }
+    return app.exec();
+}
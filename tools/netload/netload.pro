@@ -0,0 +1,14 @@
+# 中繼伺服器壓力測試工具（server.js 或 chess_server）：qmake tools/netload/netload.pro
+TARGET = netload
+TEMPLATE = app
+
+include(../common/netclient.pri)
+
+SOURCES += \
+    main.cpp \
+    loadgame.cpp \
+    loadrunner.cpp
+
+HEADERS += \
+    loadgame.h \
+    loadrunner.h
@@ -0,0 +1,335 @@
+#include "impairmentproxy.h"
+#include <QWebSocket>
+#include <QWebSocketServer>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QTimer>
+#include <QUrl>
+#include <QDebug>
+#include <cmath>
+
+ImpairmentProxy::ImpairmentProxy(const QString& upstreamUrl, const ImpairmentProfile& profile, QObject *parent)
+    : QObject(parent)
+    , m_upstreamUrl(upstreamUrl)
+    , m_profile(profile)
+    , m_server(new QWebSocketServer(QStringLiteral("netsim"), QWebSocketServer::NonSecureMode, this))
+    , m_serverClockOffsetMs(0)
+    , m_serverClockSamples(0)
+    , m_framesForwarded(0)
+    , m_framesRetransmitted(0)
+    , m_framesReordered(0)
+    , m_framesDropped(0)
+    , m_forcedDisconnects(0)
+{
+    m_clock.start();
+    connect(m_server, &QWebSocketServer::newConnection, this, &ImpairmentProxy::onNewConnection);
+}
+
+ImpairmentProxy::~ImpairmentProxy()
+{
+    // 通訊端是這個物件的子物件，先斷開信號，避免刪除時的 disconnected 存取已釋放的連線
+    for (Connection* connection : m_connections) {
+        if (!connection) continue;
+        if (connection->client) connection->client->disconnect(this);
+        if (connection->server) connection->server->disconnect(this);
+        delete connection;
+    }
+    m_connections.clear();
+    freeClosedConnections();
+}
+
+ImpairmentProxy::Connection::~Connection()
+{
+    for (Lane& lane : lanes) {
+        delete lane.timer;
+    }
+    delete disconnectTimer;
+}
+
+bool ImpairmentProxy::listen(quint16 port)
+{
+    return m_server->listen(QHostAddress::LocalHost, port);
+}
+
+QString ImpairmentProxy::url() const
+{
+    return QString("ws://127.0.0.1:%1").arg(m_server->serverPort());
+}
+
+QString ImpairmentProxy::errorString() const
+{
+    return m_server->errorString();
+}
+
+void ImpairmentProxy::setProfile(const ImpairmentProfile& profile)
+{
+    m_profile = profile;
+    for (Connection* connection : m_connections) {
+        if (connection) armDisconnect(connection);
+    }
+}
+
+bool ImpairmentProxy::isConnectionOpen(int index) const
+{
+    return index >= 0 && index < m_connections.size() && m_connections.at(index) != nullptr;
+}
+
+void ImpairmentProxy::disconnectClient(int index)
+{
+    if (!isConnectionOpen(index)) return;
+    m_forcedDisconnects++;
+    closeConnection(m_connections.at(index), true);
+}
+
+void ImpairmentProxy::stall(int index, int durationMs)
+{
+    if (!isConnectionOpen(index)) return;
+
+    // 已排程的訊框延後到暫停結束，之後到達的訊框也不早於這個時間；先後順序不變
+    qint64 until = nowMs() + durationMs;
+    for (Lane& lane : m_connections.at(index)->lanes) {
+        std::multimap<qint64, Frame> shifted;
+        for (auto& entry : lane.queue) {
+            shifted.emplace(qMax(entry.first, until), std::move(entry.second));
+        }
+        lane.queue.swap(shifted);
+        lane.lastDeliverAt = qMax(lane.lastDeliverAt, until);
+        lane.stalledUntil = qMax(lane.stalledUntil, until);
+        scheduleLane(lane);
+    }
+}
+
+void ImpairmentProxy::onNewConnection()
+{
+    while (QWebSocket* client = m_server->nextPendingConnection()) {
+        Connection* connection = new Connection;
+        connection->index = m_connections.size();
+        connection->client = client;
+        connection->server = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+        client->setParent(this);
+
+        const quint32 index = static_cast<quint32>(connection->index);
+        for (int direction = Upstream; direction <= Downstream; ++direction) {
+            Lane& lane = connection->lanes[direction];
+            lane.random = QRandomGenerator({m_profile.seed, index, static_cast<quint32>(direction)});
+            lane.timer = new QTimer(this);
+            lane.timer->setSingleShot(true);
+            lane.timer->setTimerType(Qt::PreciseTimer);     // 預設的粗略計時器可能晚 5%，會超出設定的延遲範圍
+            connect(lane.timer, &QTimer::timeout, this, [this, connection, direction]() {
+                deliverDue(connection, static_cast<Direction>(direction));
+            });
+        }
+        connection->disconnectRandom = QRandomGenerator({m_profile.seed, index, 2u});
+        connection->disconnectTimer = new QTimer(this);
+        connection->disconnectTimer->setSingleShot(true);
+        connect(connection->disconnectTimer, &QTimer::timeout, this, [this, connection]() {
+            qDebug() << "[ImpairmentProxy] Scheduled disconnect of connection" << connection->index;
+            m_forcedDisconnects++;
+            closeConnection(connection, true);
+        });
+
+        // 客戶端 -> 伺服器
+        connect(client, &QWebSocket::textMessageReceived, this, [this, connection](const QString& message) {
+            enqueue(connection, Upstream, Frame{message.toUtf8(), false, false});
+        });
+        connect(client, &QWebSocket::binaryMessageReceived, this, [this, connection](const QByteArray& message) {
+            enqueue(connection, Upstream, Frame{message, true, false});
+        });
+        connect(client, &QWebSocket::disconnected, this, [this, connection]() {
+            enqueue(connection, Upstream, Frame{QByteArray(), false, true});
+        });
+
+        // 伺服器 -> 客戶端；Pong 在加入延遲之前記錄，作為實際的伺服器時鐘
+        connect(connection->server, &QWebSocket::connected, this, [this, connection]() {
+            connection->serverOpen = true;
+            const QVector<Frame> waiting = connection->awaitingServer;
+            connection->awaitingServer.clear();
+            for (const Frame& frame : waiting) {
+                sendFrame(connection, Upstream, frame);
+            }
+        });
+        connect(connection->server, &QWebSocket::textMessageReceived, this, [this, connection](const QString& message) {
+            QByteArray payload = message.toUtf8();
+            observeDownstream(payload);
+            enqueue(connection, Downstream, Frame{payload, false, false});
+        });
+        connect(connection->server, &QWebSocket::binaryMessageReceived, this, [this, connection](const QByteArray& message) {
+            enqueue(connection, Downstream, Frame{message, true, false});
+        });
+        connect(connection->server, &QWebSocket::disconnected, this, [this, connection]() {
+            enqueue(connection, Downstream, Frame{QByteArray(), false, true});
+        });
+
+        m_connections.append(connection);
+        qDebug() << "[ImpairmentProxy] Client connected as connection" << connection->index;
+        connection->server->open(QUrl(m_upstreamUrl));
+        armDisconnect(connection);
+        emit clientConnected(connection->index);
+    }
+}
+
+void ImpairmentProxy::enqueue(Connection* connection, Direction direction, const Frame& frame)
+{
+    if (connection->closed) return;
+
+    Lane& lane = connection->lanes[direction];
+    const LinkImpairment& link = (direction == Upstream) ? m_profile.upstream : m_profile.downstream;
+
+    // 每個訊框固定抽取四個亂數，時間表只取決於種子與訊框順序，不受比例設定影響
+    double lossDraw = lane.random.generateDouble();
+    double reorderDraw = lane.random.generateDouble();
+    double dropDraw = lane.random.generateDouble();
+    int jitterMs = static_cast<int>(lane.random.bounded(static_cast<quint32>(qMax(0, link.jitterMs)) + 1));
+
+    qint64 now = nowMs();
+    qint64 deliverAt = qMax(now + link.latencyMs + jitterMs, lane.stalledUntil);
+
+    if (frame.close) {
+        // 關閉在所有已排程的訊框之後執行
+        if (!lane.queue.empty()) {
+            deliverAt = qMax(deliverAt, lane.queue.rbegin()->first);
+        }
+        deliverAt = qMax(deliverAt, lane.lastDeliverAt);
+    } else if (dropDraw < link.dropRate) {
+        m_framesDropped++;
+        return;
+    } else {
+        if (lossDraw < link.lossRate) {
+            deliverAt += link.retransmitMs;
+            m_framesRetransmitted++;
+        }
+        if (reorderDraw < link.reorderRate) {
+            m_framesReordered++;
+        } else {
+            // TCP 依序送達：遺失重傳的訊框也會擋住後面的訊框
+            deliverAt = qMax(deliverAt, lane.lastDeliverAt);
+            lane.lastDeliverAt = deliverAt;
+        }
+    }
+
+    lane.queue.emplace(deliverAt, frame);
+    scheduleLane(lane);
+}
+
+void ImpairmentProxy::deliverDue(Connection* connection, Direction direction)
+{
+    Lane& lane = connection->lanes[direction];
+    qint64 now = nowMs();
+    while (!connection->closed && !lane.queue.empty() && lane.queue.begin()->first <= now) {
+        Frame frame = std::move(lane.queue.begin()->second);
+        lane.queue.erase(lane.queue.begin());
+        sendFrame(connection, direction, frame);
+    }
+    if (!connection->closed) {
+        scheduleLane(lane);
+    }
+}
+
+void ImpairmentProxy::scheduleLane(Lane& lane)
+{
+    if (lane.queue.empty()) {
+        lane.timer->stop();
+        return;
+    }
+    lane.timer->start(static_cast<int>(qMax<qint64>(0, lane.queue.begin()->first - nowMs())));
+}
+
+void ImpairmentProxy::sendFrame(Connection* connection, Direction direction, const Frame& frame)
+{
+    if (frame.close) {
+        closeConnection(connection, false);
+        return;
+    }
+    if (direction == Upstream && !connection->serverOpen) {
+        connection->awaitingServer.append(frame);
+        return;
+    }
+
+    QWebSocket* target = (direction == Upstream) ? connection->server : connection->client;
+    if (frame.binary) {
+        target->sendBinaryMessage(frame.payload);
+    } else {
+        target->sendTextMessage(QString::fromUtf8(frame.payload));
+    }
+    m_framesForwarded++;
+}
+
+void ImpairmentProxy::armDisconnect(Connection* connection)
+{
+    if (connection->closed) return;
+    if (m_profile.disconnectMeanMs <= 0) {
+        connection->disconnectTimer->stop();
+        return;
+    }
+
+    // 指數分布的中斷間隔
+    double u = connection->disconnectRandom.generateDouble();
+    int delayMs = qMax(1, static_cast<int>(-m_profile.disconnectMeanMs * std::log(1.0 - u)));
+    connection->disconnectTimer->start(delayMs);
+}
+
+void ImpairmentProxy::observeDownstream(const QByteArray& payload)
+{
+    if (!payload.contains("\"Pong\"")) return;
+
+    QJsonObject message = QJsonDocument::fromJson(payload).object();
+    if (message["type"].toString() != "Pong") return;
+    qint64 serverTime = message["serverTime"].toVariant().toLongLong();
+    if (serverTime <= 0) return;
+
+    // 伺服器時間是 UNIX 毫秒，與本地的系統時間比較；伺服器到代理的延遲只會讓樣本偏小，取最大值
+    qint64 offsetMs = serverTime - QDateTime::currentMSecsSinceEpoch();
+    if (m_serverClockSamples == 0 || offsetMs > m_serverClockOffsetMs) {
+        m_serverClockOffsetMs = offsetMs;
+    }
+    m_serverClockSamples++;
+}
+
+void ImpairmentProxy::closeConnection(Connection* connection, bool forced)
+{
+    if (connection->closed) return;
+    connection->closed = true;
+
+    for (Lane& lane : connection->lanes) {
+        lane.timer->stop();
+        lane.queue.clear();
+    }
+    connection->disconnectTimer->stop();
+    connection->awaitingServer.clear();
+
+    // 強制中斷時兩端都直接中止（客戶端看到的是網路錯誤）；正常關閉時轉達關閉
+    for (QWebSocket* socket : {connection->client, connection->server}) {
+        socket->disconnect(this);
+        if (forced) {
+            socket->abort();
+        } else {
+            socket->close();
+        }
+        socket->deleteLater();
+    }
+    connection->client = nullptr;
+    connection->server = nullptr;
+
+    // 只保留編號；連線可能正在自己的計時器或 deliverDue 中關閉，回到事件迴圈後才釋放
+    m_connections[connection->index] = nullptr;
+    m_closing.append(connection);
+    if (m_closing.size() == 1) {
+        QTimer::singleShot(0, this, &ImpairmentProxy::freeClosedConnections);
+    }
+
+    qDebug() << "[ImpairmentProxy] Connection" << connection->index << (forced ? "aborted" : "closed");
+    emit clientDisconnected(connection->index, forced);
+}
+
+void ImpairmentProxy::freeClosedConnections()
+{
+    qDeleteAll(m_closing);
+    m_closing.clear();
+}
+
+qint64 ImpairmentProxy::nowMs() const
+{
+    return m_clock.elapsed();
+}
@@ -0,0 +1,130 @@
+#ifndef IMPAIRMENTPROXY_H
+#define IMPAIRMENTPROXY_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+#include <map>
+
+class QWebSocket;
+class QWebSocketServer;
+class QTimer;
+
+// 單一方向的網路狀況
+struct LinkImpairment {
+    int latencyMs = 0;              // 固定的單程延遲
+    int jitterMs = 0;               // 額外延遲，在 0 到 jitterMs 之間均勻分布
+    double lossRate = 0.0;          // 封包遺失率：以 TCP 重傳處理，訊框延後 retransmitMs 且阻擋後面的訊框
+    int retransmitMs = 200;
+    double reorderRate = 0.0;       // 訊框不受先後順序限制、可能超越前面訊框的比例（TCP 上不會發生，用於測試防禦性處理）
+    double dropRate = 0.0;          // 訊框直接丟棄的比例（TCP 上不會發生，用於測試防禦性處理）
+};
+
+// 代理的網路狀況設定：同一個種子與同樣的連線順序得到同樣的延遲、遺失與斷線時間表
+struct ImpairmentProfile {
+    LinkImpairment upstream;        // 客戶端 -> 伺服器
+    LinkImpairment downstream;      // 伺服器 -> 客戶端
+    int disconnectMeanMs = 0;       // 每個連線平均多久被強制中斷（指數分布），0 表示不中斷
+    quint32 seed = 1;
+};
+
+// 介於 NetworkManager 與中繼伺服器之間的 WebSocket 代理：每個客戶端連線對應一個上游連線，
+// 兩個方向的訊框依設定的延遲、抖動與遺失排程後轉送，並可依時間表或手動中斷連線
+// 排程使用單調時鐘，不受系統時間調整影響；亂數依（種子, 連線編號, 方向）產生，與其他連線的流量無關
+class ImpairmentProxy : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImpairmentProxy(const QString& upstreamUrl, const ImpairmentProfile& profile, QObject *parent = nullptr);
+    ~ImpairmentProxy();
+
+    bool listen(quint16 port = 0);
+    QString url() const;            // 客戶端連線用的位址
+    QString errorString() const;
+
+    ImpairmentProfile profile() const { return m_profile; }
+    void setProfile(const ImpairmentProfile& profile);  // 之後排程的訊框與斷線時間表使用新設定
+
+    // 依連線建立順序編號（從 0 開始）；斷線後重新連線會得到新的編號，關閉的連線只保留編號
+    int connectionCount() const { return m_connections.size(); }
+    bool isConnectionOpen(int index) const;
+    void disconnectClient(int index);           // 模擬網路中斷：兩端直接中止，還在途中的訊框全部遺失
+    void stall(int index, int durationMs);      // 兩個方向暫停傳送一段時間（訊框延後，不遺失）
+
+    // 從伺服器的 Pong 量測的實際時鐘偏移（伺服器時間 - 本地時間），代理與伺服器之間沒有加入延遲
+    bool hasServerClock() const { return m_serverClockSamples > 0; }
+    qint64 serverClockOffset() const { return m_serverClockOffsetMs; }
+
+    // 統計
+    qint64 framesForwarded() const { return m_framesForwarded; }
+    qint64 framesRetransmitted() const { return m_framesRetransmitted; }
+    qint64 framesReordered() const { return m_framesReordered; }
+    qint64 framesDropped() const { return m_framesDropped; }
+    int forcedDisconnects() const { return m_forcedDisconnects; }
+
+signals:
+    void clientConnected(int index);
+    void clientDisconnected(int index, bool forced);
+
+private:
+    enum Direction { Upstream = 0, Downstream = 1 };
+
+    struct Frame {
+        QByteArray payload;
+        bool binary = false;
+        bool close = false;         // 來源端正常關閉：前面的訊框送完後關閉另一端
+    };
+
+    struct Lane {
+        QRandomGenerator random;
+        std::multimap<qint64, Frame> queue;     // 預定送達時間（m_clock 的毫秒）-> 訊框
+        qint64 lastDeliverAt = 0;               // 依序送達的訊框不早於前一個
+        qint64 stalledUntil = 0;                // stall() 暫停傳送到這個時間
+        QTimer* timer = nullptr;
+    };
+
+    struct Connection {
+        int index = 0;
+        QWebSocket* client = nullptr;
+        QWebSocket* server = nullptr;
+        bool serverOpen = false;
+        QVector<Frame> awaitingServer;          // 上游連線建立前到達的訊框
+        Lane lanes[2];
+        QTimer* disconnectTimer = nullptr;
+        QRandomGenerator disconnectRandom;
+        bool closed = false;
+
+        ~Connection();                          // 釋放計時器（通訊端在關閉時已交給 deleteLater）
+    };
+
+    QString m_upstreamUrl;
+    ImpairmentProfile m_profile;
+    QWebSocketServer* m_server;
+    QVector<Connection*> m_connections;     // 依編號排列，已關閉的連線為 nullptr
+    QVector<Connection*> m_closing;         // 已關閉、等目前的信號處理完才釋放
+    QElapsedTimer m_clock;
+    qint64 m_serverClockOffsetMs;
+    int m_serverClockSamples;
+    qint64 m_framesForwarded;
+    qint64 m_framesRetransmitted;
+    qint64 m_framesReordered;
+    qint64 m_framesDropped;
+    int m_forcedDisconnects;
+
+    void onNewConnection();
+    void enqueue(Connection* connection, Direction direction, const Frame& frame);
+    void deliverDue(Connection* connection, Direction direction);
+    void scheduleLane(Lane& lane);
+    void sendFrame(Connection* connection, Direction direction, const Frame& frame);
+    void armDisconnect(Connection* connection);
+    void observeDownstream(const QByteArray& payload);
+    void closeConnection(Connection* connection, bool forced);
+    void freeClosedConnections();
+    qint64 nowMs() const;
+};
+
+#endif // IMPAIRMENTPROXY_H
@@ -0,0 +1,114 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "impairmentproxy.h"
+#include "scenariorunner.h"
+#include "quietlog.h"
+
+namespace {
+// "120" 表示兩個方向相同，"120/40" 分別為去程（客戶端 -> 伺服器）與回程
+bool parsePair(const QString& value, double& up, double& down)
+{
+    QStringList parts = value.split('/');
+    bool okUp = false;
+    bool okDown = true;
+    up = parts.value(0).toDouble(&okUp);
+    down = parts.size() > 1 ? parts.value(1).toDouble(&okDown) : up;
+    return parts.size() <= 2 && okUp && okDown && up >= 0.0 && down >= 0.0;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("netsim");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Deterministic network impairment proxy for the chess client.\n"
+        "Without --listen, runs the client scenarios through a proxy against the relay server.\n"
+        "With --listen, runs the proxy alone; point the client at it with QT_CHESS_SERVER_URL=ws://127.0.0.1:<port>.");
+    parser.addHelpOption();
+
+    QCommandLineOption upstreamOption("upstream", "Relay server URL (default: ws://127.0.0.1:3000).", "url", "ws://127.0.0.1:3000");
+    QCommandLineOption spawnOption("spawn", "Start the server with this command, e.g. \"node server.js\".", "command");
+    QCommandLineOption scenarioOption("scenario", "Run only this scenario (repeatable).", "name");
+    QCommandLineOption listOption("list", "List the scenarios and exit.");
+    QCommandLineOption seedOption("seed", "Seed for the impairment schedule and moves (default 1).", "seed", "1");
+    QCommandLineOption timeoutOption("timeout", "Fail a scenario after this long (default 60000).", "ms", "60000");
+    QCommandLineOption listenOption("listen", "Run the proxy alone on this port.", "port");
+    QCommandLineOption latencyOption("latency", "One-way latency, \"both\" or \"up/down\" (default 0).", "ms", "0");
+    QCommandLineOption jitterOption("jitter", "Extra random delay up to this much (default 0).", "ms", "0");
+    QCommandLineOption lossOption("loss", "Fraction of frames delayed by a retransmit (default 0).", "rate", "0");
+    QCommandLineOption retransmitOption("retransmit", "Retransmit delay for lost frames (default 200).", "ms", "200");
+    QCommandLineOption reorderOption("reorder", "Fraction of frames that may overtake earlier ones (default 0).", "rate", "0");
+    QCommandLineOption dropOption("drop", "Fraction of frames discarded outright (default 0).", "rate", "0");
+    QCommandLineOption disconnectOption("disconnect-mean", "Abort each connection after a random time with this mean (default 0 = never).", "ms", "0");
+    QCommandLineOption verboseOption("verbose", "Show debug output.");
+    parser.addOptions({upstreamOption, spawnOption, scenarioOption, listOption, seedOption, timeoutOption,
+                       listenOption, latencyOption, jitterOption, lossOption, retransmitOption, reorderOption,
+                       dropOption, disconnectOption, verboseOption});
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        installQuietMessageHandler();
+    }
+
+    if (parser.isSet(listOption)) {
+        QTextStream out(stdout);
+        for (const QString& name : ScenarioRunner::scenarioNames()) {
+            out << name << "\n    " << ScenarioRunner::scenarioDescription(name) << "\n";
+        }
+        return 0;
+    }
+
+    quint32 seed = parser.value(seedOption).toUInt();
+
+    if (parser.isSet(listenOption)) {
+        ImpairmentProfile profile;
+        profile.seed = seed;
+        profile.disconnectMeanMs = qMax(0, parser.value(disconnectOption).toInt());
+
+        const QCommandLineOption* pairOptions[] = {&latencyOption, &jitterOption, &lossOption, &reorderOption, &dropOption};
+        double values[5][2];
+        for (int i = 0; i < 5; ++i) {
+            if (!parsePair(parser.value(*pairOptions[i]), values[i][0], values[i][1])) {
+                qCritical("Invalid --%s: %s", qPrintable(pairOptions[i]->names().first()),
+                          qPrintable(parser.value(*pairOptions[i])));
+                return 1;
+            }
+        }
+        LinkImpairment* links[2] = {&profile.upstream, &profile.downstream};
+        for (int direction = 0; direction < 2; ++direction) {
+            links[direction]->latencyMs = static_cast<int>(values[0][direction]);
+            links[direction]->jitterMs = static_cast<int>(values[1][direction]);
+            links[direction]->lossRate = values[2][direction];
+            links[direction]->retransmitMs = qMax(0, parser.value(retransmitOption).toInt());
+            links[direction]->reorderRate = values[3][direction];
+            links[direction]->dropRate = values[4][direction];
+        }
+
+        ImpairmentProxy proxy(parser.value(upstreamOption), profile);
+        if (!proxy.listen(static_cast<quint16>(parser.value(listenOption).toUInt()))) {
+            qCritical("Cannot listen on port %s: %s", qPrintable(parser.value(listenOption)), qPrintable(proxy.errorString()));
+            return 1;
+        }
+        qInfo().noquote() << QString("[Netsim] Proxy on %1 -> %2 (seed %3)")
+                             .arg(proxy.url(), parser.value(upstreamOption)).arg(seed);
+        return app.exec();
+    }
+
+    ScenarioOptions options;
+    options.upstreamUrl = parser.value(upstreamOption);
+    options.spawnCommand = parser.value(spawnOption);
+    options.scenarios = parser.values(scenarioOption);
+    options.seed = seed;
+    options.timeoutMs = qMax(1000, parser.value(timeoutOption).toInt());
+
+    ScenarioRunner runner(options);
+    QObject::connect(&runner, &ScenarioRunner::finished, &app, &QCoreApplication::exit);
+    if (!runner.start()) {
+        return 1;
+    }
+    return app.exec();
+}
@@ -0,0 +1,16 @@
+# 網路狀況模擬代理與客戶端情境測試：qmake tools/netsim/netsim.pro
+TARGET = netsim
+TEMPLATE = app
+
+include(../common/netclient.pri)
+
+SOURCES += \
+    main.cpp \
+    impairmentproxy.cpp \
+    simplayers.cpp \
+    scenariorunner.cpp
+
+HEADERS += \
+    impairmentproxy.h \
+    simplayers.h \
+    scenariorunner.h
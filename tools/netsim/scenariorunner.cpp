@@ -0,0 +1,474 @@
+#include "scenariorunner.h"
+#include "simplayers.h"
+#include "networkmanager.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QTimer>
+
+namespace {
+const int SCENARIO_DRAIN_MS = 1000;         // 情境結束後等待離開房間的訊息經過代理送達
+const int CLOCK_TOLERANCE_MS = 15;          // 計時器排程與毫秒取整造成的誤差
+const int CLOCK_SYNC_SAMPLES = 6;           // 快速同步的 5 次加上第一次定期 Ping
+const int BASE_TIME_MS = 300000;
+
+// 單一方向的延遲、抖動與遺失
+LinkImpairment link(int latencyMs, int jitterMs, double lossRate = 0.0)
+{
+    LinkImpairment impairment;
+    impairment.latencyMs = latencyMs;
+    impairment.jitterMs = jitterMs;
+    impairment.lossRate = lossRate;
+    return impairment;
+}
+}
+
+ScenarioRunner::ScenarioRunner(const ScenarioOptions& options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_current(-1)
+    , m_server("[Netsim]")
+    , m_proxy(nullptr)
+    , m_players(nullptr)
+    , m_deadline(new QTimer(this))
+    , m_scenarioDone(true)
+    , m_phase(0)
+    , m_clockSamples(0)
+    , m_maxClockErrorMs(0)
+    , m_passed(0)
+{
+    m_deadline->setSingleShot(true);
+    connect(m_deadline, &QTimer::timeout, this, [this]() {
+        fail(QString("timed out after %1 ms (phase %2, ply %3)")
+             .arg(m_options.timeoutMs).arg(m_phase).arg(m_players ? m_players->plyCount() : 0));
+    });
+}
+
+const QVector<ScenarioRunner::Scenario>& ScenarioRunner::scenarios()
+{
+    static const QVector<Scenario> list = {
+        {"clock-jitter", "Symmetric 80 ms links with 60 ms jitter: the offset estimate stays within half the jitter.",
+         &ScenarioRunner::runClockJitter},
+        {"clock-asymmetric", "150 ms upstream, 30 ms downstream: the offset estimate is biased by half the asymmetry, no more.",
+         &ScenarioRunner::runClockAsymmetric},
+        {"timer-sync", "Start and play a game over jittery links: both sides hold the same timer state and display the true clock.",
+         &ScenarioRunner::runTimerSync},
+        {"reconnect", "Cut the host's connection mid-game: it resumes, the guest sees the outage, play continues in sync.",
+         &ScenarioRunner::runReconnect},
+        {"resume-draw-offer", "Offer a draw, lose the connection and resume: the offer is not echoed back, the reply is replayed.",
+         &ScenarioRunner::runResumeDrawOffer},
+        {"lossy", "5% packet loss with 200 ms retransmits in both directions: the game completes without a desync.",
+         &ScenarioRunner::runLossy},
+        {"flaky", "Random disconnects (mean 2 s) during play: every outage is resumed and no move is lost.",
+         &ScenarioRunner::runFlaky},
+    };
+    return list;
+}
+
+QStringList ScenarioRunner::scenarioNames()
+{
+    QStringList names;
+    for (const Scenario& scenario : scenarios()) {
+        names.append(scenario.name);
+    }
+    return names;
+}
+
+QString ScenarioRunner::scenarioDescription(const QString& name)
+{
+    for (const Scenario& scenario : scenarios()) {
+        if (scenario.name == name) return scenario.description;
+    }
+    return QString();
+}
+
+bool ScenarioRunner::start()
+{
+    for (const QString& name : m_options.scenarios) {
+        if (!scenarioNames().contains(name)) {
+            qWarning() << "[Netsim] Unknown scenario:" << name;
+            return false;
+        }
+    }
+    for (const Scenario& scenario : scenarios()) {
+        if (m_options.scenarios.isEmpty() || m_options.scenarios.contains(scenario.name)) {
+            m_queue.append(scenario);
+        }
+    }
+
+    if (!m_options.spawnCommand.isEmpty() && !m_server.start(m_options.spawnCommand, m_options.upstreamUrl)) {
+        return false;
+    }
+
+    qInfo().noquote() << QString("[Netsim] %1 scenarios against %2, seed %3")
+                         .arg(m_queue.size()).arg(m_options.upstreamUrl).arg(m_options.seed);
+    QTimer::singleShot(m_server.isStarted() ? ServerProcess::STARTUP_MS : 0, this, &ScenarioRunner::runNext);
+    return true;
+}
+
+void ScenarioRunner::runNext()
+{
+    if (++m_current >= m_queue.size()) {
+        reportSummary();
+        m_server.stop();
+        emit finished(m_failures.isEmpty() ? 0 : 1);
+        return;
+    }
+
+    const Scenario& scenario = m_queue.at(m_current);
+    qInfo().noquote() << QString("[Netsim] Running %1: %2").arg(scenario.name, scenario.description);
+    m_scenarioDone = false;
+    m_phase = 0;
+    m_clockSamples = 0;
+    m_maxClockErrorMs = 0;
+    m_scenarioClock.start();
+    m_deadline->start(m_options.timeoutMs);
+    (this->*scenario.run)();
+}
+
+// ---- 情境 ----
+
+void ScenarioRunner::runClockJitter()
+{
+    ImpairmentProfile profile;
+    profile.upstream = link(80, 60);
+    profile.downstream = link(80, 60);
+    runClockScenario(profile);
+}
+
+void ScenarioRunner::runClockAsymmetric()
+{
+    ImpairmentProfile profile;
+    profile.upstream = link(150, 10);
+    profile.downstream = link(30, 10);
+    runClockScenario(profile);
+}
+
+void ScenarioRunner::runClockScenario(const ImpairmentProfile& profile)
+{
+    if (!startProxy(profile)) return;
+
+    // 只需要房主的連線：建立房間後持續 Ping，累積足夠的樣本再與代理記錄的實際偏移比較
+    m_players = new SimPlayers(m_proxy->url(), m_options.seed, this);
+    NetworkManager* host = m_players->network(0);
+    connect(host, &NetworkManager::clockSyncUpdated, this, [this, host](qint64 serverTimeOffset, int roundTripTime) {
+        if (m_scenarioDone || ++m_clockSamples < CLOCK_SYNC_SAMPLES) return;
+        if (!checkClockError("host offset", serverTimeOffset)) return;
+
+        const ImpairmentProfile configured = m_proxy->profile();
+        int minimumRttMs = configured.upstream.latencyMs + configured.downstream.latencyMs;
+        if (roundTripTime < minimumRttMs - CLOCK_TOLERANCE_MS) {
+            fail(QString("round trip %1 ms is shorter than the configured %2 ms").arg(roundTripTime).arg(minimumRttMs));
+            return;
+        }
+        pass(QString("offset error %1 ms after %2 samples, rtt %3 ms, jitter %4 ms")
+             .arg(m_maxClockErrorMs).arg(m_clockSamples).arg(roundTripTime).arg(host->jitter()));
+    });
+    connect(m_players, &SimPlayers::failed, this, &ScenarioRunner::fail);
+    host->createRoom();
+}
+
+void ScenarioRunner::runTimerSync()
+{
+    ImpairmentProfile profile;
+    profile.upstream = link(60, 40);
+    profile.downstream = link(60, 40);
+    if (!startProxy(profile)) return;
+    startPlayers(BASE_TIME_MS);
+
+    connect(m_players, &SimPlayers::gameStarted, this, [this]() {
+        // onStartGameReceived 收到的偏移決定開局時的顯示
+        for (int side = 0; side < 2; ++side) {
+            QString what = QString("%1 start offset").arg(side == 0 ? "host" : "guest");
+            if (!checkClockError(what, m_players->events(side).startOffsetMs)) return;
+        }
+        m_players->play(12, 300);
+    });
+    connect(m_players, &SimPlayers::plyCompleted, this, [this]() {
+        if (checkTimerViews()) checkDisplayedClocks();
+    });
+    connect(m_players, &SimPlayers::playFinished, this, [this]() {
+        pass(QString("%1 plies, max clock error %2 ms").arg(m_players->plyCount()).arg(m_maxClockErrorMs));
+    });
+}
+
+void ScenarioRunner::runReconnect()
+{
+    ImpairmentProfile profile;
+    profile.upstream = link(40, 20);
+    profile.downstream = link(40, 20);
+    if (!startProxy(profile)) return;
+    startPlayers(BASE_TIME_MS);
+
+    // 房主先連線建立房間，代理上的第 0 個連線就是房主
+    auto checkResumed = [this]() {
+        if (m_phase != 1) return;
+        if (m_players->events(0).sessionResumed == 0 || m_players->events(1).opponentReconnected == 0) return;
+        m_phase = 2;
+        m_players->play(6, 200);
+    };
+    connect(m_players->network(0), &NetworkManager::sessionResumed, this, checkResumed);
+    connect(m_players->network(1), &NetworkManager::opponentReconnected, this, checkResumed);
+
+    connect(m_players, &SimPlayers::gameStarted, this, [this]() {
+        m_players->play(6, 200);
+    });
+    connect(m_players, &SimPlayers::plyCompleted, this, [this]() {
+        checkTimerViews();
+    });
+    connect(m_players, &SimPlayers::playFinished, this, [this]() {
+        if (m_phase == 0) {
+            m_phase = 1;
+            m_proxy->disconnectClient(0);
+            return;
+        }
+        const SideEvents& host = m_players->events(0);
+        const SideEvents& guest = m_players->events(1);
+        if (host.reconnecting == 0 || guest.opponentConnectionLost == 0) {
+            fail(QString("outage not reported (host reconnecting %1, guest opponentConnectionLost %2)")
+                 .arg(host.reconnecting).arg(guest.opponentConnectionLost));
+            return;
+        }
+        pass(QString("resumed after %1 attempt(s), %2 plies in sync")
+             .arg(host.reconnecting).arg(m_players->plyCount()));
+    });
+}
+
+void ScenarioRunner::runResumeDrawOffer()
+{
+    ImpairmentProfile profile;
+    profile.upstream = link(40, 20);
+    profile.downstream = link(40, 20);
+    if (!startProxy(profile)) return;
+    startPlayers(BASE_TIME_MS);
+
+    // 房主提和後斷線，房客在房主斷線期間拒絕；續連時房主只應收到房客的回應，不會收到自己的提和
+    NetworkManager* host = m_players->network(0);
+    NetworkManager* guest = m_players->network(1);
+    connect(guest, &NetworkManager::drawOfferReceived, this, [this]() {
+        if (m_phase != 1) return;
+        m_phase = 2;
+        m_proxy->disconnectClient(0);
+    });
+    connect(guest, &NetworkManager::opponentConnectionLost, this, [this, guest]() {
+        if (m_phase == 2) guest->sendDrawResponse(false);
+    });
+    connect(host, &NetworkManager::sessionResumed, this, [this]() {
+        if (m_phase != 2) return;
+        m_phase = 3;
+        m_players->play(4, 200);
+    });
+
+    connect(m_players, &SimPlayers::gameStarted, this, [this]() {
+        m_players->play(4, 200);
+    });
+    connect(m_players, &SimPlayers::plyCompleted, this, [this]() {
+        checkTimerViews();
+    });
+    connect(m_players, &SimPlayers::playFinished, this, [this, host, guest]() {
+        if (m_phase == 0) {
+            m_phase = 1;
+            host->sendDrawOffer();
+            return;
+        }
+        const SideEvents& hostEvents = m_players->events(0);
+        const SideEvents& guestEvents = m_players->events(1);
+        if (hostEvents.drawOffers != 0) {
+            fail(QString("host received its own draw offer %1 time(s) after resuming").arg(hostEvents.drawOffers));
+        } else if (guestEvents.drawOffers != 1 || hostEvents.drawResponses != 1) {
+            fail(QString("guest saw %1 draw offer(s), host saw %2 draw response(s), expected 1 each")
+                 .arg(guestEvents.drawOffers).arg(hostEvents.drawResponses));
+        } else if (host->lastSequence() != guest->lastSequence()) {
+            fail(QString("sequence numbers differ: host %1, guest %2").arg(host->lastSequence()).arg(guest->lastSequence()));
+        } else {
+            pass(QString("%1 plies, both sides at seq %2").arg(m_players->plyCount()).arg(host->lastSequence()));
+        }
+    });
+}
+
+void ScenarioRunner::runLossy()
+{
+    ImpairmentProfile profile;
+    profile.upstream = link(30, 30, 0.05);
+    profile.downstream = link(30, 30, 0.05);
+    if (!startProxy(profile)) return;
+    startPlayers(BASE_TIME_MS);
+
+    connect(m_players, &SimPlayers::gameStarted, this, [this]() {
+        m_players->play(30, 100);
+    });
+    connect(m_players, &SimPlayers::plyCompleted, this, [this]() {
+        checkTimerViews();
+    });
+    connect(m_players, &SimPlayers::playFinished, this, [this]() {
+        pass(QString("%1 plies, %2 of %3 frames retransmitted")
+             .arg(m_players->plyCount()).arg(m_proxy->framesRetransmitted())
+             .arg(m_proxy->framesForwarded()));
+    });
+}
+
+void ScenarioRunner::runFlaky()
+{
+    ImpairmentProfile profile;
+    profile.upstream = link(25, 15);
+    profile.downstream = link(25, 15);
+    if (!startProxy(profile)) return;
+    startPlayers(BASE_TIME_MS);
+
+    // 對局開始之後才排定斷線：開局前的斷線不會續連，不在這個情境的範圍內
+    connect(m_players, &SimPlayers::gameStarted, this, [this]() {
+        ImpairmentProfile flaky = m_proxy->profile();
+        flaky.disconnectMeanMs = 2000;
+        m_proxy->setProfile(flaky);
+        m_players->play(40, 100);
+    });
+    connect(m_players, &SimPlayers::plyCompleted, this, [this]() {
+        checkTimerViews();
+    });
+    connect(m_players, &SimPlayers::playFinished, this, [this]() {
+        ImpairmentProfile calm = m_proxy->profile();
+        calm.disconnectMeanMs = 0;
+        m_proxy->setProfile(calm);
+        pass(QString("%1 plies, %2 forced disconnects, %3 host and %4 guest resumes")
+             .arg(m_players->plyCount()).arg(m_proxy->forcedDisconnects())
+             .arg(m_players->events(0).sessionResumed).arg(m_players->events(1).sessionResumed));
+    });
+}
+
+// ---- 共用 ----
+
+bool ScenarioRunner::startProxy(const ImpairmentProfile& profile)
+{
+    ImpairmentProfile seeded = profile;
+    seeded.seed = m_options.seed;
+    m_proxy = new ImpairmentProxy(m_options.upstreamUrl, seeded, this);
+    if (!m_proxy->listen()) {
+        fail(QString("proxy cannot listen: %1").arg(m_proxy->errorString()));
+        return false;
+    }
+    return true;
+}
+
+void ScenarioRunner::startPlayers(int baseTimeMs)
+{
+    m_players = new SimPlayers(m_proxy->url(), m_options.seed, this);
+    connect(m_players, &SimPlayers::failed, this, &ScenarioRunner::fail);
+    m_players->start(baseTimeMs, 0);
+}
+
+bool ScenarioRunner::checkClockError(const QString& what, qint64 estimatedOffsetMs)
+{
+    if (!m_proxy->hasServerClock()) {
+        fail(QString("%1: the proxy has not seen a Pong yet").arg(what));
+        return false;
+    }
+
+    // NTP 式估計的誤差為（去程延遲 - 回程延遲）/ 2，兩個方向各自在 [延遲, 延遲 + 抖動 (+ 重傳)] 之間
+    const ImpairmentProfile profile = m_proxy->profile();
+    const LinkImpairment& up = profile.upstream;
+    const LinkImpairment& down = profile.downstream;
+    int upMaxMs = up.latencyMs + up.jitterMs + (up.lossRate > 0.0 ? up.retransmitMs : 0);
+    int downMaxMs = down.latencyMs + down.jitterMs + (down.lossRate > 0.0 ? down.retransmitMs : 0);
+    double lowMs = (up.latencyMs - downMaxMs) / 2.0 - CLOCK_TOLERANCE_MS;
+    double highMs = (upMaxMs - down.latencyMs) / 2.0 + CLOCK_TOLERANCE_MS;
+
+    qint64 errorMs = estimatedOffsetMs - m_proxy->serverClockOffset();
+    if (qAbs(errorMs) > qAbs(m_maxClockErrorMs)) {
+        m_maxClockErrorMs = errorMs;
+    }
+    if (errorMs < lowMs || errorMs > highMs) {
+        fail(QString("%1 is off by %2 ms, expected %3..%4 ms")
+             .arg(what).arg(errorMs).arg(qRound(lowMs)).arg(qRound(highMs)));
+        return false;
+    }
+    return true;
+}
+
+bool ScenarioRunner::checkTimerViews()
+{
+    // 雙方收到同一步棋的計時器狀態，內容必須相同（Qt_Chess::onTimerStateReceived 保存的欄位）
+    const TimerView& host = m_players->timerView(0);
+    const TimerView& guest = m_players->timerView(1);
+    if (!host.valid || !guest.valid) {
+        fail(QString("no timer state after ply %1").arg(m_players->plyCount()));
+        return false;
+    }
+    if (host.timeA != guest.timeA || host.timeB != guest.timeB || host.currentPlayer != guest.currentPlayer
+        || host.lastSwitchTimeMs != guest.lastSwitchTimeMs) {
+        fail(QString("timer states differ after ply %1: host %2/%3 %4 @%5, guest %6/%7 %8 @%9")
+             .arg(m_players->plyCount())
+             .arg(host.timeA).arg(host.timeB).arg(host.currentPlayer).arg(host.lastSwitchTimeMs)
+             .arg(guest.timeA).arg(guest.timeB).arg(guest.currentPlayer).arg(guest.lastSwitchTimeMs));
+        return false;
+    }
+    QString expectedPlayer = (m_players->plyCount() % 2 == 0) ? "White" : "Black";
+    if (host.currentPlayer != expectedPlayer) {
+        fail(QString("timer runs for %1 after ply %2").arg(host.currentPlayer).arg(m_players->plyCount()));
+        return false;
+    }
+    return true;
+}
+
+bool ScenarioRunner::checkDisplayedClocks()
+{
+    // 顯示的行棋方時間與以實際偏移算出的值相差的就是偏移的誤差（符號相反）
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    qint64 trueOffsetMs = m_proxy->serverClockOffset();
+    for (int side = 0; side < 2; ++side) {
+        qint64 displayedMs = m_players->displayedMoverTimeMs(side, nowMs);
+        qint64 trueMs = m_players->moverTimeMs(side, nowMs, trueOffsetMs);
+        QString what = QString("%1 clock display after ply %2").arg(side == 0 ? "host" : "guest").arg(m_players->plyCount());
+        if (!checkClockError(what, trueOffsetMs + (trueMs - displayedMs))) return false;
+    }
+    return true;
+}
+
+void ScenarioRunner::pass(const QString& detail)
+{
+    if (m_scenarioDone) return;
+    m_passed++;
+    qInfo().noquote() << QString("[Netsim] PASS %1 (%2 s): %3")
+                         .arg(m_queue.at(m_current).name)
+                         .arg(m_scenarioClock.elapsed() / 1000.0, 0, 'f', 1).arg(detail);
+    endScenario();
+}
+
+void ScenarioRunner::fail(const QString& reason)
+{
+    if (m_scenarioDone) return;
+    QString name = m_queue.at(m_current).name;
+    m_failures.append(QString("%1: %2").arg(name, reason));
+    qWarning().noquote() << QString("[Netsim] FAIL %1 (%2 s): %3")
+                            .arg(name).arg(m_scenarioClock.elapsed() / 1000.0, 0, 'f', 1).arg(reason);
+    endScenario();
+}
+
+void ScenarioRunner::endScenario()
+{
+    m_scenarioDone = true;
+    m_deadline->stop();
+
+    // 先離開房間，等訊息經過代理的延遲送達伺服器之後再關閉代理
+    SimPlayers* players = m_players;
+    ImpairmentProxy* proxy = m_proxy;
+    m_players = nullptr;
+    m_proxy = nullptr;
+    if (players) {
+        players->disconnect(this);
+        players->network(0)->disconnect(this);
+        players->network(1)->disconnect(this);
+        players->finish();
+    }
+    QTimer::singleShot(SCENARIO_DRAIN_MS, this, [this, players, proxy]() {
+        delete players;
+        delete proxy;
+        runNext();
+    });
+}
+
+void ScenarioRunner::reportSummary()
+{
+    qInfo().noquote() << QString("[Netsim] %1 passed, %2 failed").arg(m_passed).arg(m_failures.size());
+    for (const QString& failure : m_failures) {
+        qInfo().noquote() << "[Netsim]   " << failure;
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef SCENARIORUNNER_H
+#define SCENARIORUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QElapsedTimer>
+#include "impairmentproxy.h"
+#include "serverprocess.h"
+
+class QTimer;
+class SimPlayers;
+
+// 情境測試設定
+struct ScenarioOptions {
+    QString upstreamUrl = "ws://127.0.0.1:3000";
+    QString spawnCommand;           // 非空時先啟動伺服器（例如 "node server.js"），以 PORT 環境變數指定埠
+    QStringList scenarios;          // 空白表示全部
+    quint32 seed = 1;
+    int timeoutMs = 60000;          // 每個情境的時間上限
+};
+
+// 依序執行網路情境：每個情境建立自己的代理（ImpairmentProxy）與一對玩家（SimPlayers），
+// 檢查時鐘同步的誤差、雙方計時器狀態，以及斷線後的續連與局面一致，任何情境失敗時結束代碼為 1
+class ScenarioRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScenarioRunner(const ScenarioOptions& options, QObject *parent = nullptr);
+
+    static QStringList scenarioNames();
+    static QString scenarioDescription(const QString& name);
+
+    bool start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    struct Scenario {
+        QString name;
+        QString description;
+        void (ScenarioRunner::*run)();
+    };
+    static const QVector<Scenario>& scenarios();
+
+    ScenarioOptions m_options;
+    QVector<Scenario> m_queue;
+    int m_current;
+    ServerProcess m_server;
+    ImpairmentProxy* m_proxy;
+    SimPlayers* m_players;
+    QTimer* m_deadline;
+    QElapsedTimer m_scenarioClock;
+    bool m_scenarioDone;
+    int m_phase;                    // 情境內部的步驟
+    int m_clockSamples;
+    qint64 m_maxClockErrorMs;       // 目前情境中與實際偏移相差最多的量測值
+    QStringList m_failures;
+    int m_passed;
+
+    // 情境
+    void runClockJitter();
+    void runClockAsymmetric();
+    void runTimerSync();
+    void runReconnect();
+    void runResumeDrawOffer();
+    void runLossy();
+    void runFlaky();
+
+    void runNext();
+    void runClockScenario(const ImpairmentProfile& profile);
+    bool startProxy(const ImpairmentProfile& profile);
+    void startPlayers(int baseTimeMs);
+    bool checkClockError(const QString& what, qint64 estimatedOffsetMs);
+    bool checkTimerViews();
+    bool checkDisplayedClocks();
+    void pass(const QString& detail);
+    void fail(const QString& reason);
+    void endScenario();
+    void reportSummary();
+};
+
+#endif // SCENARIORUNNER_H
@@ -0,0 +1,237 @@
+#include "simplayers.h"
+#include "networkmanager.h"
+#include "randommove.h"
+#include <QDateTime>
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+const int SYNC_POLL_INTERVAL_MS = 50;       // 等待雙方完成時鐘同步的輪詢間隔
+}
+
+SimPlayers::SimPlayers(const QString& serverUrl, quint32 seed, QObject *parent)
+    : QObject(parent)
+    , m_random(seed)
+    , m_moveTimer(new QTimer(this))
+    , m_syncWaitTimer(new QTimer(this))
+    , m_baseTimeMs(0)
+    , m_incrementMs(0)
+    , m_targetPly(0)
+    , m_thinkMs(0)
+    , m_moverSide(-1)
+    , m_pendingDeliveries(0)
+    , m_playing(false)
+    , m_finished(false)
+{
+    m_moveTimer->setSingleShot(true);
+    connect(m_moveTimer, &QTimer::timeout, this, &SimPlayers::playMove);
+    m_syncWaitTimer->setInterval(SYNC_POLL_INTERVAL_MS);
+    connect(m_syncWaitTimer, &QTimer::timeout, this, &SimPlayers::startWhenSynced);
+
+    for (int i = 0; i < 2; ++i) {
+        m_sides[i].network = new NetworkManager(this);
+        m_sides[i].network->setServerUrl(serverUrl);
+        connectSide(i);
+    }
+}
+
+void SimPlayers::start(int baseTimeMs, int incrementMs)
+{
+    m_baseTimeMs = baseTimeMs;
+    m_incrementMs = incrementMs;
+    m_sides[0].network->createRoom();
+}
+
+void SimPlayers::play(int plies, int thinkMs)
+{
+    m_targetPly = plyCount() + plies;
+    m_thinkMs = thinkMs;
+    m_playing = true;
+    scheduleNextMove();
+}
+
+void SimPlayers::finish()
+{
+    if (m_finished) return;
+    m_finished = true;
+    m_playing = false;
+    m_moveTimer->stop();
+    m_syncWaitTimer->stop();
+    for (Side& side : m_sides) {
+        side.network->disconnect(this);
+        side.network->leaveRoom();
+    }
+}
+
+qint64 SimPlayers::displayedMoverTimeMs(int side, qint64 nowMs) const
+{
+    const TimerView& view = m_sides[side].timer;
+    NetworkManager* network = m_sides[side].network;
+    if (network->hasClockSync() || view.serverTimeMs <= 0) {
+        return moverTimeMs(side, nowMs, network->serverTimeOffset());
+    }
+
+    // 尚未同步時鐘：伺服器送出時已經過的時間加上收到之後本地經過的時間
+    bool hostToMove = view.currentPlayer == "White";
+    qint64 remainingMs = hostToMove ? view.timeA : view.timeB;
+    if (view.lastSwitchTimeMs <= 0) return remainingMs;
+    return remainingMs - ((view.serverTimeMs - view.lastSwitchTimeMs) + (nowMs - view.receivedAtMs));
+}
+
+qint64 SimPlayers::moverTimeMs(int side, qint64 nowMs, qint64 offsetMs) const
+{
+    const TimerView& view = m_sides[side].timer;
+    // 房主固定執白：白方行棋時扣房主（A）的時間
+    bool hostToMove = view.currentPlayer == "White";
+    qint64 remainingMs = hostToMove ? view.timeA : view.timeB;
+    if (view.lastSwitchTimeMs <= 0) return remainingMs;
+    return remainingMs - (nowMs + offsetMs - view.lastSwitchTimeMs);
+}
+
+void SimPlayers::connectSide(int side)
+{
+    NetworkManager* network = m_sides[side].network;
+    SideEvents& events = m_sides[side].events;
+
+    if (side == 0) {
+        connect(network, &NetworkManager::roomCreated, this, [this](const QString& roomNumber) {
+            m_sides[1].network->joinRoom(roomNumber);
+        });
+        connect(network, &NetworkManager::opponentJoined, this, [this]() {
+            m_syncWaitTimer->start();
+        });
+    }
+
+    connect(network, &NetworkManager::startGameReceived, this,
+            [this, side](int, int, int, PieceColor, qint64 serverTimeOffset) {
+        onStartGameReceived(side, serverTimeOffset);
+    });
+    connect(network, &NetworkManager::timerStateReceived, this,
+            [this, side](qint64 timeA, qint64 timeB, const QString& currentPlayer, qint64 lastSwitchTimeMs, qint64 serverTimeMs) {
+        TimerView& view = m_sides[side].timer;
+        view.valid = true;
+        view.timeA = timeA;
+        view.timeB = timeB;
+        view.currentPlayer = currentPlayer;
+        view.lastSwitchTimeMs = lastSwitchTimeMs;
+        view.serverTimeMs = serverTimeMs;
+        view.receivedAtMs = QDateTime::currentMSecsSinceEpoch();
+    });
+    connect(network, &NetworkManager::opponentMove, this,
+            [this, side](const QPoint& from, const QPoint& to, PieceType promotionType) {
+        onMoveReceived(side, from, to, promotionType);
+    });
+    connect(network, &NetworkManager::moveRejected, this, [this](const QPoint&, const QPoint&, const QString& reason) {
+        fail(QString("move rejected: %1").arg(reason));
+    });
+    connect(network, &NetworkManager::connectionError, this, [this, side](const QString& error) {
+        fail(QString("%1: %2").arg(side == 0 ? "host" : "guest", error));
+    });
+    connect(network, &NetworkManager::playerLeft, this, [this]() {
+        fail("opponent left the room");
+    });
+
+    connect(network, &NetworkManager::reconnecting, this, [&events]() { events.reconnecting++; });
+    connect(network, &NetworkManager::sessionResumed, this, [&events]() { events.sessionResumed++; });
+    connect(network, &NetworkManager::opponentConnectionLost, this, [&events]() { events.opponentConnectionLost++; });
+    connect(network, &NetworkManager::opponentReconnected, this, [&events]() { events.opponentReconnected++; });
+    connect(network, &NetworkManager::drawOfferReceived, this, [&events]() { events.drawOffers++; });
+    connect(network, &NetworkManager::drawResponseReceived, this, [&events]() { events.drawResponses++; });
+    connect(network, &NetworkManager::surrenderReceived, this, [&events]() { events.surrenders++; });
+    connect(network, &NetworkManager::opponentDisconnected, this, [this, side]() {
+        m_sides[side].events.opponentDisconnected++;
+        fail(QString("%1 reported the opponent as disconnected").arg(side == 0 ? "host" : "guest"));
+    });
+}
+
+void SimPlayers::startWhenSynced()
+{
+    // 與真實玩家相同：開始時雙方通常已完成時鐘同步，startGameReceived 帶的是量測值
+    if (!m_sides[0].network->hasClockSync() || !m_sides[1].network->hasClockSync()) return;
+    m_syncWaitTimer->stop();
+    m_sides[0].network->sendStartGame(m_baseTimeMs, m_baseTimeMs, m_incrementMs, PieceColor::White);
+}
+
+void SimPlayers::onStartGameReceived(int side, qint64 serverTimeOffset)
+{
+    m_sides[side].started = true;
+    m_sides[side].game.reset();
+    m_sides[side].events.startOffsetMs = serverTimeOffset;
+    if (m_sides[0].started && m_sides[1].started) {
+        emit gameStarted();
+    }
+}
+
+void SimPlayers::onMoveReceived(int side, const QPoint& from, const QPoint& to, PieceType promotionType)
+{
+    if (m_finished) return;
+    if (m_moverSide < 0) {
+        fail(QString("%1 received a move that was not sent").arg(side == 0 ? "host" : "guest"));
+        return;
+    }
+
+    QString error;
+    if (!m_sides[side].game.applyMove(from, to, promotionType, error)) {
+        fail(QString("relayed move is illegal for the %1: %2").arg(side == 0 ? "host" : "guest", error));
+        return;
+    }
+
+    // 計時器狀態緊接在走法之後發出，等目前的訊息處理完再結算，讓檢查看到這步棋的計時器
+    QTimer::singleShot(0, this, &SimPlayers::onDelivered);
+}
+
+void SimPlayers::onDelivered()
+{
+    if (m_finished || --m_pendingDeliveries > 0) return;
+
+    m_moverSide = -1;
+    int ply = plyCount();
+    if (m_sides[0].game.positionKey() != m_sides[1].game.positionKey()) {
+        fail(QString("positions differ after ply %1").arg(ply));
+        return;
+    }
+    emit plyCompleted(ply);
+    if (!m_finished && m_playing) {
+        scheduleNextMove();
+    }
+}
+
+void SimPlayers::scheduleNextMove()
+{
+    if (isGameOver() || plyCount() >= m_targetPly) {
+        m_playing = false;
+        emit playFinished();
+        return;
+    }
+    int delayMs = static_cast<int>(m_thinkMs * (0.5 + m_random.generateDouble()));
+    m_moveTimer->start(delayMs);
+}
+
+void SimPlayers::playMove()
+{
+    if (m_finished) return;
+
+    const ServerGame& game = m_sides[0].game;
+    const ChessBoard& board = game.board();
+    PieceColor color = board.getCurrentPlayer();
+
+    QPoint from;
+    QPoint to;
+    PieceType promotionType = PieceType::None;
+    if (!chooseRandomMove(board, m_random, from, to, promotionType)) {
+        fail("no legal move in an unfinished game");
+        return;
+    }
+
+    m_moverSide = (color == PieceColor::White) ? 0 : 1;
+    m_pendingDeliveries = 2;
+    m_sides[m_moverSide].network->sendMove(from, to, promotionType);
+}
+
+void SimPlayers::fail(const QString& error)
+{
+    if (m_finished) return;
+    qWarning() << "[SimPlayers]" << error;
+    finish();
+    emit failed(error);
+}
@@ -0,0 +1,101 @@
+#ifndef SIMPLAYERS_H
+#define SIMPLAYERS_H
+
+#include <QObject>
+#include <QString>
+#include <QRandomGenerator>
+#include <QPoint>
+#include "servergame.h"
+
+class NetworkManager;
+class QTimer;
+
+// 一方最後收到的伺服器計時器狀態（與 Qt_Chess::onTimerStateReceived 保存的欄位相同）
+struct TimerView {
+    bool valid = false;
+    qint64 timeA = 0;               // 房主剩餘時間
+    qint64 timeB = 0;               // 房客剩餘時間
+    QString currentPlayer;
+    qint64 lastSwitchTimeMs = 0;    // 0 表示計時器尚未啟動
+    qint64 serverTimeMs = 0;
+    qint64 receivedAtMs = 0;        // 收到時的本地時間
+};
+
+// 每一方觀察到的事件次數
+struct SideEvents {
+    qint64 startOffsetMs = 0;       // startGameReceived 帶來的伺服器時間偏移
+    int reconnecting = 0;
+    int sessionResumed = 0;
+    int opponentConnectionLost = 0;
+    int opponentReconnected = 0;
+    int opponentDisconnected = 0;
+    int drawOffers = 0;
+    int drawResponses = 0;
+    int surrenders = 0;
+};
+
+// 情境測試用的一對玩家：房主（白方）與房客各一個 NetworkManager，經由代理連線。
+// 建立房間並等到雙方完成時鐘同步才開始對局，依種子選擇走法；雙方以 ServerGame 套用轉送的走法，
+// 每一步在雙方都收到之後比對局面。GUI 不參與，Qt_Chess 的槽函式改以這裡記錄的信號內容檢查
+class SimPlayers : public QObject
+{
+    Q_OBJECT
+
+public:
+    SimPlayers(const QString& serverUrl, quint32 seed, QObject *parent = nullptr);
+
+    NetworkManager* network(int side) const { return m_sides[side].network; }
+    const ServerGame& game(int side) const { return m_sides[side].game; }
+    const TimerView& timerView(int side) const { return m_sides[side].timer; }
+    const SideEvents& events(int side) const { return m_sides[side].events; }
+    int plyCount() const { return m_sides[0].game.plyCount(); }
+    bool isGameOver() const { return m_sides[0].game.isFinished(); }
+
+    void start(int baseTimeMs, int incrementMs);    // 建立房間並開始對局，完成後發出 gameStarted
+    void play(int plies, int thinkMs);              // 再走 plies 步，每步思考 0.5 到 1.5 倍 thinkMs
+    void finish();                                  // 離開房間並停止所有動作
+
+    // 依 Qt_Chess::updateTimeDisplaysFromServer 的算法，在 nowMs 時 side 顯示的行棋方剩餘時間
+    qint64 displayedMoverTimeMs(int side, qint64 nowMs) const;
+    // 以指定的時鐘偏移計算同一個值（傳入實際偏移即為正確答案）
+    qint64 moverTimeMs(int side, qint64 nowMs, qint64 offsetMs) const;
+
+signals:
+    void gameStarted();
+    void plyCompleted(int ply);
+    void playFinished();
+    void failed(const QString& error);
+
+private:
+    struct Side {
+        NetworkManager* network = nullptr;
+        ServerGame game;
+        TimerView timer;
+        SideEvents events;
+        bool started = false;
+    };
+
+    Side m_sides[2];                // [0] 房主（白方），[1] 房客
+    QRandomGenerator m_random;
+    QTimer* m_moveTimer;
+    QTimer* m_syncWaitTimer;
+    int m_baseTimeMs;
+    int m_incrementMs;
+    int m_targetPly;
+    int m_thinkMs;
+    int m_moverSide;                // 等待轉送的走法是哪一方送出的，-1 表示沒有
+    int m_pendingDeliveries;
+    bool m_playing;
+    bool m_finished;
+
+    void connectSide(int side);
+    void startWhenSynced();
+    void onStartGameReceived(int side, qint64 serverTimeOffset);
+    void onMoveReceived(int side, const QPoint& from, const QPoint& to, PieceType promotionType);
+    void onDelivered();
+    void scheduleNextMove();
+    void playMove();
+    void fail(const QString& error);
+};
+
+#endif // SIMPLAYERS_H
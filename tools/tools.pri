@@ -0,0 +1,35 @@
+# 命令列工具共用的引擎原始碼（不含 GUI）
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+ENGINE_SRC = $$PWD/../src
+INCLUDEPATH += $$ENGINE_SRC
+
+SOURCES += \
+    $$ENGINE_SRC/chesspiece.cpp \
+    $$ENGINE_SRC/chessboard.cpp \
+    $$ENGINE_SRC/chessengine.cpp \
+    $$ENGINE_SRC/timemanager.cpp \
+    $$ENGINE_SRC/uciprotocol.cpp \
+    $$ENGINE_SRC/ucioptions.cpp \
+    $$ENGINE_SRC/engineresources.cpp \
+    $$ENGINE_SRC/evalcache.cpp \
+    $$ENGINE_SRC/engineworkerpool.cpp \
+    $$ENGINE_SRC/enginepool.cpp \
+    $$ENGINE_SRC/gameanalyzer.cpp
+
+HEADERS += \
+    $$ENGINE_SRC/chesspiece.h \
+    $$ENGINE_SRC/chessboard.h \
+    $$ENGINE_SRC/chessengine.h \
+    $$ENGINE_SRC/timemanager.h \
+    $$ENGINE_SRC/uciprotocol.h \
+    $$ENGINE_SRC/ucioptions.h \
+    $$ENGINE_SRC/engineresources.h \
+    $$ENGINE_SRC/evalcache.h \
+    $$ENGINE_SRC/engineworkerpool.h \
+    $$ENGINE_SRC/enginepool.h \
+    $$ENGINE_SRC/gameanalyzer.h